@@ -0,0 +1,37 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <Benchmarks.h>
+
+// Usage: VulkanBench <benchmark> [arguments]
+int main(int argc, char *argv[]) {
+	const std::string benchmark = argc > 1 ? argv[1] : "recording";
+	std::vector<std::string> args;
+	for (int i = 2; i < argc; i++) {
+		args.push_back(argv[i]);
+	}
+
+	try
+	{
+		if (benchmark == "recording") {
+			return VulkanBench::RunRecordingBenchmark(args);
+		}
+		if (benchmark == "mesh") {
+			return VulkanBench::RunMeshBenchmark(args);
+		}
+		if (benchmark == "quantize") {
+			return VulkanBench::RunQuantizationBenchmark(args);
+		}
+		if (benchmark == "frames") {
+			return VulkanBench::RunFrameBenchmark(args);
+		}
+
+		std::cout << "Unknown benchmark " << benchmark << ", available: recording, mesh, quantize, frames\n";
+	}
+	catch (const std::exception &e)
+	{
+		std::cout << e.what();
+	}
+
+	return 1;
+}
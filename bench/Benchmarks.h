@@ -0,0 +1,20 @@
+#pragma once
+#include <string>
+#include <vector>
+
+/*
+Benchmarks:
+Every benchmark runs on a headless core, parses its own arguments
+and prints its results to the standard output.
+*/
+
+namespace VulkanBench {
+	// Secondary command buffer recording time over thread counts
+	int RunRecordingBenchmark(const std::vector<std::string> &args);
+	// Post-transform cache and vertex fetch statistics before and after mesh optimization
+	int RunMeshBenchmark(const std::vector<std::string> &args);
+	// Float to compact vertex format conversion throughput per instruction set
+	int RunQuantizationBenchmark(const std::vector<std::string> &args);
+	// Offscreen frame throughput of scripted workloads, optionally checked against a baseline
+	int RunFrameBenchmark(const std::vector<std::string> &args);
+}
@@ -0,0 +1,801 @@
+#include <Benchmarks.h>
+#include <CVulkanCore.h>
+#include <CVulkanPass.h>
+#include <CVulkanPipeline.h>
+#include <CVulkanShaderCache.h>
+#include <EmbeddedShaders.h>
+#include <CVulkanBuffer.h>
+#include <CVulkanOffscreenTarget.h>
+#include <CVulkanFrameRing.h>
+#include <CVulkanUploader.h>
+#include <CVulkanGpuProfiler.h>
+#include <CVulkanDrawList.h>
+#include <CVulkanRingBuffer.h>
+#include <CVulkanDescriptorCache.h>
+#include <CVulkanDescriptorAllocator.h>
+#include <CVulkanPipelineLibrary.h>
+#include <SampleVertex.h>
+#include <CRollingStats.h>
+#include <Utilities.h>
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+
+// CMake points it into the source tree, Visual Studio starts the benchmarks in the project directory bench/
+#ifndef VULKANAPP_BASELINE_DIR
+#define VULKANAPP_BASELINE_DIR "baselines"
+#endif
+
+namespace {
+	enum class WorkloadType {
+		Triangles, // One indexed draw of a mesh with the given number of triangles
+		Draws, // One draw call per triangle instance, transform in push constants, tint in a per frame uniform
+		Instanced, // The same instances as a single instanced draw
+		Churn, // Instance buffers created and destroyed every frame
+		Stream, // The same instances written every frame into the streaming ring buffer
+		Materials // One draw per instance, each with a pipeline variant compiled in the background by the pipeline library
+	};
+
+	struct Workload {
+		std::string m_name;
+		WorkloadType m_type = WorkloadType::Triangles;
+		uint32_t m_count = 1u; // Triangles, draws, instances or buffers per frame
+	};
+
+	// Created once and shared by every workload
+	struct BenchPipelines {
+		const VulkanApp::CVulkanPipeline *m_pPipeline = nullptr; // VertexShader.glsl with the instance stream
+		const VulkanApp::CVulkanPipeline *m_pTransformPipeline = nullptr; // TransformVertexShader.glsl, push constants and set 0
+		VulkanApp::GraphicsPipelineState m_materialState; // Same interface as m_pPipeline, varied per material
+	};
+
+	struct WorkloadResult {
+		std::string m_name;
+		uint32_t m_frameCount = 0u;
+		double m_framesPerSecond = 0.0;
+		double m_cpuMs[3] = {}; // p50, p95, p99
+		double m_gpuMs[3] = {}; // Zero without timestamp support
+		uint32_t m_gpuFrameCount = 0u; // Measured frames the GPU percentiles cover
+	};
+
+	struct BaselineComparison {
+		uint32_t m_comparedCount = 0u; // Workloads found in both the results and the baseline
+		uint32_t m_missingCount = 0u; // Baseline workloads that were not run
+		uint32_t m_regressionCount = 0u;
+	};
+
+	constexpr double cexp_percentiles[3] = { 50.0, 95.0, 99.0 };
+	constexpr uint32_t cexp_churnInstances = 256u; // Instances in every buffer of the churn and stream workloads
+	constexpr uint32_t cexp_streamRingFrames = 3u; // Ring size in frames of data, one more than in flight so it wraps regularly
+	constexpr VkFormat cexp_targetFormat = VK_FORMAT_R8G8B8A8_UNORM; // Offscreen target of every workload, as in HeadlessApplication
+	constexpr uint32_t cexp_materialVariants = 30u; // Distinct pipelines of the materials workload, further materials repeat them
+
+	// Every combination of color channels, written opaque or added to the target
+	VulkanApp::GraphicsPipelineState GetMaterialState(const VulkanApp::GraphicsPipelineState &baseState, const uint32_t material) {
+		const uint32_t variant = material % cexp_materialVariants;
+		VulkanApp::GraphicsPipelineState state = baseState;
+		state.m_colorWriteMask = static_cast<VkColorComponentFlags>(variant % 15u + 1u);
+		if (variant >= 15u) {
+			state.m_blendEnable = VK_TRUE;
+			state.m_srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
+			state.m_dstColorBlendFactor = VK_BLEND_FACTOR_ONE;
+		}
+		return state;
+	}
+
+	// Small triangles tiling clip space, count rounded up to full grid rows
+	void CreateGrid(const uint32_t triangleCount, std::vector<VulkanApp::SampleVertex> &vertices, std::vector<uint32_t> &indices) {
+		const uint32_t quadCount = (triangleCount + 1u) / 2u;
+		const uint32_t side = std::max(static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(quadCount)))), 1u);
+		const float cellSize = 2.0f / static_cast<float>(side);
+
+		vertices.clear();
+		vertices.reserve(static_cast<size_t>(side + 1u) * (side + 1u));
+		for (uint32_t y = 0u; y <= side; y++) {
+			for (uint32_t x = 0u; x <= side; x++) {
+				const float u = static_cast<float>(x) / static_cast<float>(side);
+				const float v = static_cast<float>(y) / static_cast<float>(side);
+				vertices.push_back({ { -1.0f + cellSize * x, -1.0f + cellSize * y, 0.0f }, { u, v, 1.0f - u } });
+			}
+		}
+
+		indices.clear();
+		indices.reserve(static_cast<size_t>(triangleCount) * 3u);
+		for (uint32_t triangle = 0u; triangle < triangleCount; triangle++) {
+			const uint32_t quad = triangle / 2u;
+			const uint32_t v0 = (quad / side) * (side + 1u) + quad % side;
+			if (triangle % 2u == 0u) {
+				indices.insert(indices.end(), { v0, v0 + 1u, v0 + side + 1u });
+			}
+			else {
+				indices.insert(indices.end(), { v0 + 1u, v0 + side + 2u, v0 + side + 1u });
+			}
+		}
+	}
+
+	// Instances tile clip space in a square grid, each one scaled down to its cell
+	std::vector<VulkanApp::SampleInstance> CreateInstances(const uint32_t instanceCount) {
+		const uint32_t side = std::max(static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(instanceCount)))), 1u);
+		const float cellSize = 2.0f / static_cast<float>(side);
+
+		std::vector<VulkanApp::SampleInstance> instances(instanceCount);
+		for (uint32_t i = 0u; i < instanceCount; i++) {
+			instances[i].m_transform[0] = -1.0f + cellSize * (static_cast<float>(i % side) + 0.5f);
+			instances[i].m_transform[1] = -1.0f + cellSize * (static_cast<float>(i / side) + 0.5f);
+			instances[i].m_transform[2] = 1.0f / static_cast<float>(side);
+			instances[i].m_transform[3] = 0.0f;
+		}
+		return instances;
+	}
+
+	// Set 0 of TransformVertexShader.glsl, the cache hands out the same layout to every caller
+	VkDescriptorSetLayout GetFrameDataSetLayout(const VulkanApp::CVulkanCore &core) {
+		return core.GetDescriptorCache()->GetSetLayout({ { 0u, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1u, VK_SHADER_STAGE_VERTEX_BIT, nullptr } });
+	}
+
+	std::unique_ptr<VulkanApp::CVulkanBuffer> CreateVertexBuffer(const VulkanApp::CVulkanCore &core, const void *data, const size_t byteSize) {
+		return std::make_unique<VulkanApp::CVulkanBuffer>(&core, data, static_cast<uint32_t>(byteSize),
+			VulkanApp::BufferUsage{ VkBufferUsageFlagBits::VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VulkanApp::BufferMemory::DeviceLocal });
+	}
+
+	// Renders warmup plus measured frames of one workload into the offscreen target, the frame loop of HeadlessApplication
+	WorkloadResult RunWorkload(const VulkanApp::CVulkanCore &core, VulkanApp::CVulkanPass &pass, const BenchPipelines &pipelines,
+		const VulkanApp::CVulkanOffscreenTarget &target, const Workload &workload, const uint32_t frameCount, const uint32_t warmupCount) {
+
+		const VulkanApp::SampleVertex triangleVertices[] = {
+			{ {  0.0f,-1.0f, 0.0f }, { 1.0f, 0.5f, 0.5f } },
+			{ {  1.0f, 1.0f, 0.0f }, { 0.1f, 1.0f, 0.4f } },
+			{ { -1.0f, 1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f } } };
+		const uint32_t triangleIndices[] = { 0, 1, 2 };
+		const VulkanApp::SampleInstance identity = { { 0.0f, 0.0f, 1.0f, 0.0f } };
+
+		// Static geometry of the workload, uploaded before the first frame. Owned by the scope, so a failed
+		// upload or a throwing constructor further down does not leak what was already created.
+		std::unique_ptr<VulkanApp::CVulkanBuffer> pVertexBuffer;
+		std::unique_ptr<VulkanApp::CVulkanIndexBuffer> pIndexBuffer;
+		std::unique_ptr<VulkanApp::CVulkanBuffer> pInstanceBuffer;
+		std::vector<VulkanApp::SampleInstance> frameInstances; // Written every frame by churn and stream, pushed by draws
+
+		if (workload.m_type == WorkloadType::Triangles) {
+			std::vector<VulkanApp::SampleVertex> vertices;
+			std::vector<uint32_t> indices;
+			CreateGrid(workload.m_count, vertices, indices);
+			pVertexBuffer = CreateVertexBuffer(core, vertices.data(), vertices.size() * sizeof(VulkanApp::SampleVertex));
+			core.GetUploader()->FlushAndWait();
+			pIndexBuffer = std::make_unique<VulkanApp::CVulkanIndexBuffer>(&core, indices.data(), static_cast<uint32_t>(indices.size()), static_cast<uint32_t>(vertices.size()));
+			core.GetUploader()->FlushAndWait();
+			pInstanceBuffer = CreateVertexBuffer(core, &identity, sizeof(identity));
+		}
+		else {
+			pVertexBuffer = CreateVertexBuffer(core, triangleVertices, sizeof(triangleVertices));
+			pIndexBuffer = std::make_unique<VulkanApp::CVulkanIndexBuffer>(&core, triangleIndices, 3u, 3u);
+			if (workload.m_type == WorkloadType::Churn || workload.m_type == WorkloadType::Stream) {
+				frameInstances = CreateInstances(workload.m_count * cexp_churnInstances);
+			}
+			else if (workload.m_type == WorkloadType::Draws) {
+				// Pushed with every draw, there is no instance stream
+				frameInstances = CreateInstances(workload.m_count);
+			}
+			else {
+				const std::vector<VulkanApp::SampleInstance> instances = CreateInstances(workload.m_count);
+				pInstanceBuffer = CreateVertexBuffer(core, instances.data(), instances.size() * sizeof(VulkanApp::SampleInstance));
+			}
+		}
+		core.GetUploader()->FlushAndWait();
+
+		VulkanApp::CVulkanFrameRing frameRing(&core, 2u, target.GetImageCount());
+		// Sized to the measured frames, the warmup frames before them drop out of the window
+		VulkanApp::CVulkanGpuProfiler profiler(&core, frameRing.GetFramesInFlight(), VulkanApp::CVulkanGpuProfiler::cexp_defaultMaxScopes,
+			std::max(frameCount, 1u));
+		const uint32_t drawCapacity = workload.m_type == WorkloadType::Draws || workload.m_type == WorkloadType::Churn ||
+			workload.m_type == WorkloadType::Stream || workload.m_type == WorkloadType::Materials ? workload.m_count : 1u;
+		VulkanApp::CVulkanDrawList drawList(&core, frameRing.GetFramesInFlight(), drawCapacity, false);
+
+		// Every frame allocates the same amount, so the ring wraps around every few frames
+		const VkDeviceSize streamBytesPerBuffer = cexp_churnInstances * sizeof(VulkanApp::SampleInstance);
+		std::unique_ptr<VulkanApp::CVulkanRingBuffer> pStreamRing;
+		if (workload.m_type == WorkloadType::Stream) {
+			pStreamRing = std::make_unique<VulkanApp::CVulkanRingBuffer>(&core, streamBytesPerBuffer * workload.m_count * cexp_streamRingFrames,
+				VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, frameRing.GetFramesInFlight());
+		}
+
+		// The draws workload takes its tint from a uniform written every frame, in a set from the pools of the slot
+		const VkDeviceSize uniformAlignment = core.GetDeviceCaps().m_properties.limits.minUniformBufferOffsetAlignment;
+		std::unique_ptr<VulkanApp::CVulkanRingBuffer> pUniformRing;
+		std::unique_ptr<VulkanApp::CVulkanDescriptorAllocator> pDescriptors;
+		if (workload.m_type == WorkloadType::Draws) {
+			pUniformRing = std::make_unique<VulkanApp::CVulkanRingBuffer>(&core, VulkanApp::CVulkanRingBuffer::cexp_maxAlignment * cexp_streamRingFrames,
+				VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, frameRing.GetFramesInFlight());
+			pDescriptors = std::make_unique<VulkanApp::CVulkanDescriptorAllocator>(&core, frameRing.GetFramesInFlight());
+		}
+
+		// Materials are queued before the first frame, their draws use the fallback until their pipeline is ready.
+		// A new library per run, so every run compiles its materials again. The measured frames wait for all of
+		// them, when workers finish would otherwise decide how many draws switch pipelines while measuring.
+		const VkPipeline materialFallback = pipelines.m_pPipeline->GetHandle();
+		std::unique_ptr<VulkanApp::CVulkanPipelineLibrary> pLibrary;
+		std::vector<VulkanApp::GraphicsPipelineState> materialStates;
+		uint32_t fallbackDraws = 0u;
+		uint32_t fallbackFrames = 0u;
+		if (workload.m_type == WorkloadType::Materials) {
+			pLibrary = std::make_unique<VulkanApp::CVulkanPipelineLibrary>(&core);
+			for (uint32_t i = 0u; i < workload.m_count; i++) {
+				materialStates.push_back(GetMaterialState(pipelines.m_materialState, i));
+				pLibrary->Prepare(materialStates.back());
+			}
+		}
+
+		// Buffers of the churn workload live until their slot comes around again
+		std::vector<std::vector<std::unique_ptr<VulkanApp::CVulkanBuffer>>> slotBuffers(frameRing.GetFramesInFlight());
+
+		VulkanApp::CRollingStats cpuFrameTimes(std::max(frameCount, 1u));
+		std::chrono::steady_clock::time_point measureStart = std::chrono::steady_clock::now();
+		uint32_t renderedFrames = 0u;
+		std::string error;
+
+		try {
+			for (uint32_t frameIndex = 0u; frameIndex < warmupCount + frameCount; frameIndex++) {
+				if (frameIndex == warmupCount) {
+					if (pLibrary) {
+						pLibrary->WaitIdle();
+					}
+					// Warmup frames still in flight count towards the measured time, as they would in a real run
+					measureStart = std::chrono::steady_clock::now();
+				}
+				const auto frameStart = std::chrono::steady_clock::now();
+
+				VulkanApp::FrameContext &frame = frameRing.BeginFrame();
+				const uint32_t slot = frameRing.GetCurrentSlot();
+				frameRing.SetImageIndex(slot);
+
+				VulkanApp::DrawPacket packet;
+				packet.m_pipeline = pipelines.m_pPipeline->GetHandle();
+				packet.SetVertexBuffer(0u, pVertexBuffer->GetHandle());
+				packet.m_indexBuffer = pIndexBuffer->GetHandle();
+				packet.m_indexType = pIndexBuffer->GetIndexType();
+				packet.m_count = pIndexBuffer->GetIndexCount();
+
+				drawList.Clear();
+				switch (workload.m_type)
+				{
+				case WorkloadType::Triangles:
+					packet.SetVertexBuffer(1u, pInstanceBuffer->GetHandle());
+					drawList.Add(packet);
+					break;
+
+				case WorkloadType::Draws:
+				{
+					// The fence of the slot has been waited, the sets and uniforms of its last frame are free again
+					pDescriptors->BeginFrame(slot);
+					pUniformRing->BeginFrame(slot);
+
+					const float pulse = 0.75f + 0.25f * std::sin(static_cast<float>(frameIndex) * 0.05f);
+					const VulkanApp::SampleFrameData frameData = { { pulse, pulse, pulse, 1.0f } };
+					const VulkanApp::RingAllocation uniform = pUniformRing->Push(&frameData, sizeof(frameData), uniformAlignment);
+					pUniformRing->Flush();
+
+					VkDescriptorBufferInfo bufferInfo = {};
+					bufferInfo.buffer = uniform.m_vkBuffer;
+					bufferInfo.offset = uniform.m_offset;
+					bufferInfo.range = uniform.m_size;
+
+					VkWriteDescriptorSet descriptorWrite = {};
+					descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+					descriptorWrite.dstSet = pDescriptors->Allocate(GetFrameDataSetLayout(core));
+					descriptorWrite.dstBinding = 0u;
+					descriptorWrite.descriptorCount = 1u;
+					descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+					descriptorWrite.pBufferInfo = &bufferInfo;
+					vkUpdateDescriptorSets(core.GetVkLogicalDevice(), 1u, &descriptorWrite, 0u, nullptr);
+
+					packet.m_pipeline = pipelines.m_pTransformPipeline->GetHandle();
+					packet.m_pipelineLayout = pipelines.m_pTransformPipeline->GetLayout();
+					packet.m_descriptorSet = descriptorWrite.dstSet;
+					for (uint32_t i = 0u; i < workload.m_count; i++) {
+						drawList.Add(packet, frameInstances[i].m_transform, sizeof(VulkanApp::SampleDrawConstants), VK_SHADER_STAGE_VERTEX_BIT);
+					}
+					break;
+				}
+
+				case WorkloadType::Instanced:
+					packet.SetVertexBuffer(1u, pInstanceBuffer->GetHandle());
+					packet.m_instanceCount = workload.m_count;
+					drawList.Add(packet);
+					break;
+
+				case WorkloadType::Churn:
+					// The fence of the slot has been waited, its buffers are no longer read
+					slotBuffers[slot].clear();
+
+					packet.m_instanceCount = cexp_churnInstances;
+					for (uint32_t i = 0u; i < workload.m_count; i++) {
+						slotBuffers[slot].push_back(CreateVertexBuffer(core, frameInstances.data() + static_cast<size_t>(i) * cexp_churnInstances,
+							cexp_churnInstances * sizeof(VulkanApp::SampleInstance)));
+						packet.SetVertexBuffer(1u, slotBuffers[slot].back()->GetHandle());
+						drawList.Add(packet);
+					}
+					break;
+
+				case WorkloadType::Stream:
+					// The fence of the slot has been waited, the ring space of its last frame is free again
+					pStreamRing->BeginFrame(slot);
+
+					packet.m_instanceCount = cexp_churnInstances;
+					for (uint32_t i = 0u; i < workload.m_count; i++) {
+						const VulkanApp::RingAllocation allocation = pStreamRing->Push(frameInstances.data() + static_cast<size_t>(i) * cexp_churnInstances,
+							streamBytesPerBuffer);
+						packet.SetVertexBuffer(1u, allocation.m_vkBuffer, allocation.m_offset);
+						drawList.Add(packet);
+					}
+					pStreamRing->Flush();
+					break;
+
+				case WorkloadType::Materials:
+				{
+					packet.SetVertexBuffer(1u, pInstanceBuffer->GetHandle());
+					const uint32_t fallbackDrawsBefore = fallbackDraws;
+					for (uint32_t i = 0u; i < workload.m_count; i++) {
+						packet.m_firstInstance = i;
+						packet.m_pipeline = pLibrary->Get(materialStates[i], materialFallback);
+						fallbackDraws += packet.m_pipeline == materialFallback ? 1u : 0u;
+						drawList.Add(packet);
+					}
+					fallbackFrames += fallbackDraws != fallbackDrawsBefore ? 1u : 0u;
+					break;
+				}
+				}
+				drawList.Build(slot);
+
+				VkSemaphore uploadSem = core.GetUploader()->Flush(slot);
+
+				VkCommandBufferBeginInfo beginInfoCI = {};
+				beginInfoCI.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+				beginInfoCI.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+				VkResult result = vkBeginCommandBuffer(frame.m_vkCommandBuffer, &beginInfoCI);
+				if (result != VK_SUCCESS) {
+					throw std::runtime_error(UTIL_EXC_MSG_EX("Failed to begin a command buffer", result));
+				}
+
+				pass.RecordWorkload(frame.m_vkCommandBuffer, drawList, target.GetFramebuffer(slot), { {0, 0}, target.GetExtent() }, &profiler, slot);
+
+				result = vkEndCommandBuffer(frame.m_vkCommandBuffer);
+				if (result != VK_SUCCESS) {
+					throw std::runtime_error(UTIL_EXC_MSG_EX("Failed to end a command buffer", result));
+				}
+
+				VulkanApp::CVulkanPass::SubmitCommandBuffer(core.m_vkQueue, frame.m_vkCommandBuffer, VK_NULL_HANDLE, uploadSem, VK_NULL_HANDLE, frame.m_vkInFlightFence);
+				frameRing.EndFrame();
+
+				if (frameIndex >= warmupCount) {
+					cpuFrameTimes.Add(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frameStart).count());
+					renderedFrames++;
+				}
+			}
+		}
+		catch (const std::exception &e) {
+			error = e.what();
+		}
+
+		// The buffers are released when the scope ends, after every frame that reads them has finished
+		frameRing.WaitIdle();
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - measureStart).count();
+		profiler.ResolveAll();
+
+		if (pLibrary) {
+			pLibrary->WaitIdle();
+			std::string materialError;
+			for (const auto &state : materialStates) {
+				if (pLibrary->GetStatus(state, &materialError) == VulkanApp::PipelineStatus::Failed) {
+					break;
+				}
+			}
+			std::cout << "[FRAMES] " << workload.m_name << ": " << pLibrary->GetPipelineCount() << " pipelines for " << workload.m_count
+				<< " materials compiled in " << pLibrary->GetTotalCompileTime() << " ms on " << pLibrary->GetWorkerCount() << " workers, "
+				<< fallbackDraws << " draws in " << fallbackFrames << " warmup frames used the fallback\n";
+			if (!materialError.empty() && error.empty()) {
+				error = materialError;
+			}
+		}
+
+		if (!error.empty()) {
+			throw std::runtime_error(error);
+		}
+
+		WorkloadResult workloadResult;
+		workloadResult.m_name = workload.m_name;
+		workloadResult.m_frameCount = renderedFrames;
+		workloadResult.m_framesPerSecond = seconds > 0.0 ? renderedFrames / seconds : 0.0;
+		for (uint32_t i = 0u; i < 3u; i++) {
+			workloadResult.m_cpuMs[i] = cpuFrameTimes.GetPercentile(cexp_percentiles[i]);
+		}
+
+		// The whole pass over the measured frames, fewer when some timestamps were not written
+		const auto &gpuStatistics = profiler.GetStatistics();
+		const auto passItr = gpuStatistics.find("RenderPass");
+		if (passItr != gpuStatistics.end() && passItr->second.GetCount() > 0u) {
+			workloadResult.m_gpuFrameCount = passItr->second.GetCount();
+			for (uint32_t i = 0u; i < 3u; i++) {
+				workloadResult.m_gpuMs[i] = passItr->second.GetPercentile(cexp_percentiles[i]);
+			}
+		}
+		return workloadResult;
+	}
+
+	std::string EscapeJson(const std::string &text) {
+		std::string escaped;
+		for (const char c : text) {
+			if (c == '"' || c == '\\') {
+				escaped += '\\';
+			}
+			escaped += c;
+		}
+		return escaped;
+	}
+
+	bool WriteResults(const std::string &filePath, const std::string &deviceName, const uint32_t frameCount, const std::vector<WorkloadResult> &results) {
+		std::ofstream file(filePath, std::ios::out | std::ios::trunc);
+		if (!file.is_open()) {
+			return false;
+		}
+
+		// One workload per line and no nesting within a workload, see ReadResults()
+		file << std::setprecision(6) << std::fixed;
+		file << "{\n\t\"device\": \"" << EscapeJson(deviceName) << "\",\n\t\"frames\": " << frameCount << ",\n\t\"workloads\": [\n";
+		for (size_t i = 0u; i < results.size(); i++) {
+			const WorkloadResult &result = results[i];
+			file << "\t\t{ \"name\": \"" << EscapeJson(result.m_name) << "\", \"frames\": " << result.m_frameCount
+				<< ", \"fps\": " << result.m_framesPerSecond
+				<< ", \"cpu_p50_ms\": " << result.m_cpuMs[0] << ", \"cpu_p95_ms\": " << result.m_cpuMs[1] << ", \"cpu_p99_ms\": " << result.m_cpuMs[2]
+				<< ", \"gpu_p50_ms\": " << result.m_gpuMs[0] << ", \"gpu_p95_ms\": " << result.m_gpuMs[1] << ", \"gpu_p99_ms\": " << result.m_gpuMs[2]
+				<< ", \"gpu_frames\": " << result.m_gpuFrameCount
+				<< " }" << (i + 1u < results.size() ? "," : "") << "\n";
+		}
+		file << "\t]\n}\n";
+		return file.good();
+	}
+
+	// Numeric fields of every workload object by workload name, only the flat objects WriteResults() produces are understood
+	bool ReadResults(const std::string &filePath, std::map<std::string, std::map<std::string, double>> &workloads) {
+		std::ifstream file(filePath);
+		if (!file.is_open()) {
+			return false;
+		}
+		std::stringstream stream;
+		stream << file.rdbuf();
+		const std::string text = stream.str();
+
+		size_t position = text.find("\"workloads\"");
+		if (position == std::string::npos) {
+			return false;
+		}
+
+		auto readString = [&text](size_t &pos, std::string &value) -> bool {
+			if (pos >= text.size() || text[pos] != '"') {
+				return false;
+			}
+			value.clear();
+			for (pos++; pos < text.size() && text[pos] != '"'; pos++) {
+				if (text[pos] == '\\' && pos + 1u < text.size()) {
+					pos++;
+				}
+				value += text[pos];
+			}
+			pos++;
+			return pos <= text.size();
+		};
+		auto skipSpace = [&text](size_t &pos) {
+			while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\t' || text[pos] == '\n' || text[pos] == '\r')) {
+				pos++;
+			}
+		};
+
+		while ((position = text.find('{', position)) != std::string::npos) {
+			position++;
+			std::string name;
+			std::map<std::string, double> fields;
+
+			skipSpace(position);
+			while (position < text.size() && text[position] != '}') {
+				std::string key;
+				if (!readString(position, key)) {
+					return false;
+				}
+				skipSpace(position);
+				if (position >= text.size() || text[position] != ':') {
+					return false;
+				}
+				position++;
+				skipSpace(position);
+
+				if (position < text.size() && text[position] == '"') {
+					std::string value;
+					if (!readString(position, value)) {
+						return false;
+					}
+					if (key == "name") {
+						name = value;
+					}
+				}
+				else {
+					char *pEnd = nullptr;
+					const double value = std::strtod(text.c_str() + position, &pEnd);
+					if (pEnd == text.c_str() + position) {
+						return false;
+					}
+					fields[key] = value;
+					position = static_cast<size_t>(pEnd - text.c_str());
+				}
+
+				skipSpace(position);
+				if (position < text.size() && text[position] == ',') {
+					position++;
+					skipSpace(position);
+				}
+			}
+
+			if (!name.empty()) {
+				workloads[name] = fields;
+			}
+		}
+		return true;
+	}
+
+	// Percent change from the baseline, positive is always worse
+	double GetRegression(const double baseline, const double current, const bool higherIsBetter) {
+		if (baseline <= 0.0) {
+			return 0.0;
+		}
+		return (higherIsBetter ? baseline - current : current - baseline) / baseline * 100.0;
+	}
+
+	// Returns the number of metrics beyond the tolerance, workloads missing on either side are reported and skipped
+	BaselineComparison CompareWithBaseline(const std::vector<WorkloadResult> &results, const std::map<std::string, std::map<std::string, double>> &baseline,
+		const double tolerancePercent) {
+
+		BaselineComparison comparison;
+		for (const WorkloadResult &result : results) {
+			const auto baseItr = baseline.find(result.m_name);
+			if (baseItr == baseline.end()) {
+				std::cout << "[FRAMES] " << result.m_name << " has no baseline\n";
+				continue;
+			}
+			comparison.m_comparedCount++;
+
+			const std::map<std::string, double> &base = baseItr->second;
+			const std::pair<const char*, double> higherIsWorse[] = {
+				{ "cpu_p95_ms", result.m_cpuMs[1] },
+				{ "gpu_p95_ms", result.m_gpuMs[1] } };
+
+			auto check = [&](const char *metric, const double current, const bool higherIsBetter) {
+				const auto fieldItr = base.find(metric);
+				// Zero when the metric was not available, e.g. without timestamps
+				if (fieldItr == base.end() || fieldItr->second <= 0.0 || current <= 0.0) {
+					return;
+				}
+				const double change = GetRegression(fieldItr->second, current, higherIsBetter);
+				if (change > tolerancePercent) {
+					std::cout << "[FRAMES] REGRESSION " << result.m_name << " " << metric << " " << fieldItr->second << " -> " << current
+						<< " (" << change << "% worse, tolerance " << tolerancePercent << "%)\n";
+					comparison.m_regressionCount++;
+				}
+			};
+
+			check("fps", result.m_framesPerSecond, true);
+			for (const auto &metric : higherIsWorse) {
+				check(metric.first, metric.second, false);
+			}
+		}
+
+		for (const auto &entry : baseline) {
+			if (std::none_of(results.begin(), results.end(), [&entry](const WorkloadResult &result) { return result.m_name == entry.first; })) {
+				std::cout << "[FRAMES] " << entry.first << " is in the baseline but was not run\n";
+				comparison.m_missingCount++;
+			}
+		}
+		return comparison;
+	}
+
+	// Lower case letters and digits of the device name, anything else becomes a dash
+	std::string GetDefaultBaselinePath(const std::string &deviceName) {
+		std::string fileName;
+		for (const char c : deviceName) {
+			const bool keep = std::isalnum(static_cast<unsigned char>(c)) != 0;
+			if (keep || (!fileName.empty() && fileName.back() != '-')) {
+				fileName += keep ? static_cast<char>(std::tolower(static_cast<unsigned char>(c))) : '-';
+			}
+		}
+		while (!fileName.empty() && fileName.back() == '-') {
+			fileName.pop_back();
+		}
+		return std::string(VULKANAPP_BASELINE_DIR) + "/" + (fileName.empty() ? "device" : fileName) + ".json";
+	}
+
+	std::vector<Workload> CreateWorkloads(const uint32_t drawCount, const uint32_t churnBuffers) {
+		std::vector<Workload> workloads;
+		for (const uint32_t triangles : { 1u, 1000u, 100000u, 1000000u }) {
+			workloads.push_back({ "triangles-" + std::to_string(triangles), WorkloadType::Triangles, triangles });
+		}
+		workloads.push_back({ "draws-" + std::to_string(drawCount), WorkloadType::Draws, drawCount });
+		workloads.push_back({ "instanced-" + std::to_string(drawCount), WorkloadType::Instanced, drawCount });
+		workloads.push_back({ "churn-" + std::to_string(churnBuffers), WorkloadType::Churn, churnBuffers });
+		workloads.push_back({ "stream-" + std::to_string(churnBuffers), WorkloadType::Stream, churnBuffers });
+		workloads.push_back({ "materials-" + std::to_string(cexp_materialVariants * 2u), WorkloadType::Materials, cexp_materialVariants * 2u });
+		return workloads;
+	}
+}
+
+// Usage: VulkanBench frames [--frames <count>] [--warmup <count>] [--size <width> <height>] [--draws <count>] [--churn <buffers>]
+//                           [--only <name part>] [--output <results.json>] [--baseline <results.json> | --no-baseline] [--tolerance <percent>]
+// Without --baseline the results are compared with the baseline of the device in bench/baselines, named after the device
+// in lower case with dashes, e.g. bench/baselines/nvidia-geforce-rtx-3060.json. The run prints the path, a device without
+// a baseline is only reported; record one with --output <that path> on an otherwise idle machine and commit it.
+// Fails when a workload of the baseline got slower than the tolerance allows, in fps or p95 CPU or GPU frame time.
+// Also fails when no workload could be compared, or when a baseline workload was not run without --only.
+int VulkanBench::RunFrameBenchmark(const std::vector<std::string> &args) {
+	uint32_t frameCount = 500u;
+	uint32_t warmupCount = 50u;
+	uint32_t width = 512u;
+	uint32_t height = 512u;
+	uint32_t drawCount = 10000u;
+	uint32_t churnBuffers = 16u;
+	double tolerancePercent = 10.0;
+	std::string filter;
+	std::string outputPath;
+	std::string baselinePath;
+	const bool useBaseline = std::find(args.begin(), args.end(), "--no-baseline") == args.end();
+
+	for (size_t i = 0u; i + 1u < args.size(); i++) {
+		if (args[i] == "--frames") {
+			frameCount = std::max(static_cast<uint32_t>(std::stoul(args[++i])), 1u);
+		}
+		else if (args[i] == "--warmup") {
+			warmupCount = static_cast<uint32_t>(std::stoul(args[++i]));
+		}
+		else if (args[i] == "--size" && i + 2u < args.size()) {
+			width = std::max(static_cast<uint32_t>(std::stoul(args[++i])), 1u);
+			height = std::max(static_cast<uint32_t>(std::stoul(args[++i])), 1u);
+		}
+		else if (args[i] == "--draws") {
+			drawCount = std::max(static_cast<uint32_t>(std::stoul(args[++i])), 1u);
+		}
+		else if (args[i] == "--churn") {
+			churnBuffers = std::max(static_cast<uint32_t>(std::stoul(args[++i])), 1u);
+		}
+		else if (args[i] == "--only") {
+			filter = args[++i];
+		}
+		else if (args[i] == "--output") {
+			outputPath = args[++i];
+		}
+		else if (args[i] == "--baseline") {
+			baselinePath = args[++i];
+		}
+		else if (args[i] == "--tolerance") {
+			tolerancePercent = std::max(std::stod(args[++i]), 0.0);
+		}
+	}
+
+	VulkanApp::CVulkanCore core("VulkanBench", true);
+
+	const std::string deviceName = core.GetDeviceCaps().m_properties.deviceName;
+
+	// Read before the workloads, a broken baseline should not cost a whole run. An explicit baseline has to exist,
+	// the one of the device may not have been recorded yet.
+	std::map<std::string, std::map<std::string, double>> baseline;
+	if (baselinePath.empty() && useBaseline) {
+		baselinePath = GetDefaultBaselinePath(deviceName);
+		if (!std::ifstream(baselinePath).is_open()) {
+			std::cout << "[FRAMES] No baseline for " << deviceName << " at " << baselinePath << ", record one with --output\n";
+			baselinePath.clear();
+		}
+	}
+	if (!baselinePath.empty() && !ReadResults(baselinePath, baseline)) {
+		std::cout << "[FRAMES] Cannot read the baseline " << baselinePath << "\n";
+		return 1;
+	}
+
+	VulkanApp::CVulkanPass pass(&core, cexp_targetFormat, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+
+	VkPipelineShaderStageCreateInfo shaderStageCI[2] = {};
+	// SPIR-V embedded at build time, the core owns the modules
+	VulkanApp::CVulkanShaderCache *pShaderCache = core.GetShaderCache();
+	shaderStageCI[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	shaderStageCI[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+	shaderStageCI[0].module = pShaderCache->Create(VulkanApp::EmbeddedShaders::cexp_vertexShader, sizeof(VulkanApp::EmbeddedShaders::cexp_vertexShader));
+	shaderStageCI[0].pName = "main";
+
+	shaderStageCI[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	shaderStageCI[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+	shaderStageCI[1].module = pShaderCache->Create(VulkanApp::EmbeddedShaders::cexp_fragmentShader, sizeof(VulkanApp::EmbeddedShaders::cexp_fragmentShader));
+	shaderStageCI[1].pName = "main";
+
+	// The UNORM target stores the output as it is, it is encoded in the shader as an sRGB target would
+	VulkanApp::CSpecializationConstants fragmentConstants;
+	fragmentConstants.Set(VulkanApp::SampleFragmentConstants::cexp_encodeSrgb, !VulkanApp::IsSrgbFormat(cexp_targetFormat));
+	shaderStageCI[1].pSpecializationInfo = fragmentConstants.GetInfo();
+
+	// Same fragment stage, the vertex stage reads its transform from push constants and its tint from set 0
+	VkPipelineShaderStageCreateInfo transformStageCI[2] = { shaderStageCI[0], shaderStageCI[1] };
+	transformStageCI[0].module = pShaderCache->Create(VulkanApp::EmbeddedShaders::cexp_transformVertexShader,
+		sizeof(VulkanApp::EmbeddedShaders::cexp_transformVertexShader));
+	const VkPipelineLayout transformLayout = core.GetDescriptorCache()->GetPipelineLayout({ GetFrameDataSetLayout(core) },
+		{ { VK_SHADER_STAGE_VERTEX_BIT, 0u, static_cast<uint32_t>(sizeof(VulkanApp::SampleDrawConstants)) } });
+
+	std::vector<WorkloadResult> results;
+	{
+		VulkanApp::CVulkanPipeline pipeline(&core, &pass, shaderStageCI, VulkanApp::SampleVertexLayout::cexp_inputState);
+		VulkanApp::CVulkanPipeline transformPipeline(&core, &pass, transformStageCI, VulkanApp::SampleMeshLayout::cexp_inputState, transformLayout);
+
+		BenchPipelines pipelines;
+		pipelines.m_pPipeline = &pipeline;
+		pipelines.m_pTransformPipeline = &transformPipeline;
+		pipelines.m_materialState.m_vertexShader = shaderStageCI[0].module;
+		pipelines.m_materialState.m_fragmentShader = shaderStageCI[1].module;
+		pipelines.m_materialState.m_fragmentSpecialization = fragmentConstants;
+		pipelines.m_materialState.SetVertexInput(VulkanApp::SampleVertexLayout::cexp_inputState);
+		pipelines.m_materialState.m_layout = pipeline.GetLayout();
+		pipelines.m_materialState.m_renderPass = pass.GetHandle();
+		// One image per frame slot, as in HeadlessApplication
+		VulkanApp::CVulkanOffscreenTarget target(&core, pass.GetHandle(), cexp_targetFormat, width, height, 2u, false);
+
+		std::cout << "[FRAMES] " << deviceName << ", " << width << "x" << height << ", " << frameCount << " frames after "
+			<< warmupCount << " warmup frames\n";
+		std::cout << std::fixed << std::setprecision(3);
+
+		for (const Workload &workload : CreateWorkloads(drawCount, churnBuffers)) {
+			if (!filter.empty() && workload.m_name.find(filter) == std::string::npos) {
+				continue;
+			}
+
+			const WorkloadResult result = RunWorkload(core, pass, pipelines, target, workload, frameCount, warmupCount);
+			results.push_back(result);
+
+			std::cout << "[FRAMES] " << std::left << std::setw(18) << result.m_name << std::right << " " << std::setw(10) << result.m_framesPerSecond
+				<< " fps, CPU p50 " << result.m_cpuMs[0] << " p95 " << result.m_cpuMs[1] << " p99 " << result.m_cpuMs[2] << " ms";
+			if (result.m_gpuMs[0] > 0.0) {
+				std::cout << ", GPU p50 " << result.m_gpuMs[0] << " p95 " << result.m_gpuMs[1] << " p99 " << result.m_gpuMs[2] << " ms over "
+					<< result.m_gpuFrameCount << " frames";
+			}
+			std::cout << "\n";
+		}
+	}
+
+	if (!outputPath.empty()) {
+		if (!WriteResults(outputPath, deviceName, frameCount, results)) {
+			std::cout << "[FRAMES] Cannot write " << outputPath << "\n";
+			return 1;
+		}
+		std::cout << "[FRAMES] Results written to " << outputPath << "\n";
+	}
+
+	if (!baselinePath.empty()) {
+		const BaselineComparison comparison = CompareWithBaseline(results, baseline, tolerancePercent);
+		if (comparison.m_comparedCount == 0u) {
+			std::cout << "[FRAMES] No workload was compared against " << baselinePath << "\n";
+			return 1;
+		}
+		// --only skips baseline workloads on purpose, otherwise the baseline belongs to different settings
+		if (comparison.m_missingCount > 0u && filter.empty()) {
+			std::cout << "[FRAMES] " << comparison.m_missingCount << " workloads of " << baselinePath << " were not run\n";
+			return 1;
+		}
+		if (comparison.m_regressionCount > 0u) {
+			std::cout << "[FRAMES] " << comparison.m_regressionCount << " regressions against " << baselinePath << "\n";
+			return 1;
+		}
+		std::cout << "[FRAMES] No regressions against " << baselinePath << "\n";
+	}
+
+	return 0;
+}
@@ -0,0 +1,85 @@
+#include <Benchmarks.h>
+#include <CMeshOptimizer.h>
+#include <CVulkanBuffer.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+namespace {
+	void PrintStatistics(const char *label, const VulkanApp::MeshStatistics &statistics) {
+		std::cout << "[MESH] " << label << " ACMR " << statistics.m_acmr << ", ATVR " << statistics.m_atvr
+			<< ", overfetch " << statistics.m_overfetch << "\n";
+	}
+}
+
+// Usage: VulkanBench mesh [--grid <quads per side>] [--cache <entries>] [--seed <value>]
+// The grid is shuffled to stand in for the unordered output of exporters and tessellators
+int VulkanBench::RunMeshBenchmark(const std::vector<std::string> &args) {
+	uint32_t gridSize = 512u;
+	uint32_t cacheSize = VulkanApp::CMeshOptimizer::cexp_defaultCacheSize;
+	uint32_t seed = 1u;
+
+	for (size_t i = 0u; i + 1u < args.size(); i++) {
+		if (args[i] == "--grid") {
+			gridSize = std::max(static_cast<uint32_t>(std::stoul(args[++i])), 1u);
+		}
+		else if (args[i] == "--cache") {
+			cacheSize = std::max(static_cast<uint32_t>(std::stoul(args[++i])), 3u);
+		}
+		else if (args[i] == "--seed") {
+			seed = static_cast<uint32_t>(std::stoul(args[++i]));
+		}
+	}
+
+	// Position and color, the layout used by the sample pipeline
+	constexpr uint32_t vertexStride = 6u * sizeof(float);
+	const uint32_t side = gridSize + 1u;
+	const uint32_t vertexCount = side * side;
+
+	std::vector<uint8_t> vertices(static_cast<size_t>(vertexCount) * vertexStride);
+	for (uint32_t y = 0u; y < side; y++) {
+		for (uint32_t x = 0u; x < side; x++) {
+			const float vertex[6] = { static_cast<float>(x), static_cast<float>(y), 0.0f, 1.0f, 1.0f, 1.0f };
+			memcpy(vertices.data() + static_cast<size_t>(y * side + x) * vertexStride, vertex, vertexStride);
+		}
+	}
+
+	std::vector<std::array<uint32_t, 3>> triangles;
+	triangles.reserve(static_cast<size_t>(gridSize) * gridSize * 2u);
+	for (uint32_t y = 0u; y < gridSize; y++) {
+		for (uint32_t x = 0u; x < gridSize; x++) {
+			const uint32_t v0 = y * side + x;
+			triangles.push_back({ v0, v0 + 1u, v0 + side });
+			triangles.push_back({ v0 + 1u, v0 + side + 1u, v0 + side });
+		}
+	}
+
+	std::mt19937 random(seed);
+	std::shuffle(triangles.begin(), triangles.end(), random);
+
+	std::vector<uint32_t> indices;
+	indices.reserve(triangles.size() * 3u);
+	for (const auto &triangle : triangles) {
+		indices.insert(indices.end(), triangle.begin(), triangle.end());
+	}
+
+	std::cout << std::fixed << std::setprecision(3);
+	std::cout << "[MESH] " << vertexCount << " vertices, " << triangles.size() << " triangles, cache " << cacheSize << " entries\n";
+
+	const VulkanApp::MeshOptimizationReport report = VulkanApp::CMeshOptimizer::Optimize(vertices, vertexStride, indices, cacheSize);
+	PrintStatistics("before", report.m_before);
+	PrintStatistics("after ", report.m_after);
+
+	// Vertex shader invocations follow ACMR, so this is the share of them which is saved
+	const double saved = report.m_before.m_acmr > 0.0f ? 1.0 - report.m_after.m_acmr / report.m_before.m_acmr : 0.0;
+	std::cout << "[MESH] " << saved * 100.0 << " % fewer vertex shader invocations, optimized in " << report.m_optimizationMs << " ms\n";
+
+	const VkIndexType indexType = VulkanApp::CVulkanIndexBuffer::SelectIndexType(report.m_vertexCount);
+	std::cout << "[MESH] index buffer " << (indexType == VK_INDEX_TYPE_UINT16 ? "uint16" : "uint32") << ", "
+		<< indices.size() * VulkanApp::CVulkanIndexBuffer::GetIndexSize(indexType) << " bytes\n";
+	return 0;
+}
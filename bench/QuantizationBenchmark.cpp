@@ -0,0 +1,92 @@
+#include <Benchmarks.h>
+#include <CVertexQuantizer.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+namespace {
+	struct QuantizedType {
+		VulkanApp::BufferAttribute::ShaderDataType m_type;
+		const char *m_name;
+	};
+
+	constexpr QuantizedType cexp_types[] = {
+		{ VulkanApp::BufferAttribute::ShaderDataType::half2, "half2" },
+		{ VulkanApp::BufferAttribute::ShaderDataType::half4, "half4" },
+		{ VulkanApp::BufferAttribute::ShaderDataType::snorm16x2, "snorm16x2" },
+		{ VulkanApp::BufferAttribute::ShaderDataType::snorm16x4, "snorm16x4" },
+		{ VulkanApp::BufferAttribute::ShaderDataType::unorm16x2, "unorm16x2" },
+		{ VulkanApp::BufferAttribute::ShaderDataType::unorm16x4, "unorm16x4" },
+		{ VulkanApp::BufferAttribute::ShaderDataType::unorm8x4, "unorm8x4" },
+		{ VulkanApp::BufferAttribute::ShaderDataType::unorm10x3a2, "unorm10x3a2" }
+	};
+}
+
+// Usage: VulkanBench quantize [--vertices <count>] [--iterations <count>]
+// Throughput is given in GB/s of float input, every level is checked against the scalar output
+int VulkanBench::RunQuantizationBenchmark(const std::vector<std::string> &args) {
+	size_t vertexCount = 4u * 1024u * 1024u;
+	uint32_t iterations = 10u;
+
+	for (size_t i = 0u; i + 1u < args.size(); i++) {
+		if (args[i] == "--vertices") {
+			vertexCount = std::max(static_cast<size_t>(std::stoull(args[++i])), static_cast<size_t>(1u));
+		}
+		else if (args[i] == "--iterations") {
+			iterations = std::max(static_cast<uint32_t>(std::stoul(args[++i])), 1u);
+		}
+	}
+
+	// Slightly out of range values exercise the clamping as well
+	std::vector<float> src(vertexCount * 4u);
+	std::mt19937 random(1u);
+	std::uniform_real_distribution<float> distribution(-1.1f, 1.1f);
+	for (auto &value : src) {
+		value = distribution(random);
+	}
+
+	const VulkanApp::QuantizerIsa supportedIsa = VulkanApp::CVertexQuantizer::GetSupportedIsa();
+	std::cout << "[QUANTIZE] " << vertexCount << " vertices, " << iterations << " iterations, up to "
+		<< VulkanApp::CVertexQuantizer::GetIsaName(supportedIsa) << "\n";
+	std::cout << std::fixed << std::setprecision(3);
+
+	int exitCode = 0;
+	for (const auto &type : cexp_types) {
+		const uint32_t componentCount = VulkanApp::CVertexQuantizer::GetComponentCount(type.m_type);
+		const size_t srcBytes = vertexCount * componentCount * sizeof(float);
+		const size_t dstBytes = vertexCount * VulkanApp::BufferAttribute::GetTypeSize(type.m_type);
+
+		std::vector<uint8_t> reference(dstBytes);
+		std::vector<uint8_t> dst(dstBytes);
+		VulkanApp::CVertexQuantizer::Quantize(type.m_type, reference.data(), src.data(), vertexCount, VulkanApp::QuantizerIsa::Scalar);
+
+		for (uint32_t level = 0u; level <= static_cast<uint32_t>(supportedIsa); level++) {
+			const auto isa = static_cast<VulkanApp::QuantizerIsa>(level);
+
+			// Best iteration, the first one also faults the destination pages in
+			double bestSeconds = 0.0;
+			for (uint32_t iteration = 0u; iteration < iterations; iteration++) {
+				const auto start = std::chrono::steady_clock::now();
+				VulkanApp::CVertexQuantizer::Quantize(type.m_type, dst.data(), src.data(), vertexCount, isa);
+				const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+				bestSeconds = iteration == 0u ? seconds : std::min(bestSeconds, seconds);
+			}
+
+			const bool matches = memcmp(dst.data(), reference.data(), dstBytes) == 0;
+			if (!matches) {
+				exitCode = 1;
+			}
+
+			std::cout << "[QUANTIZE] " << std::left << std::setw(12) << type.m_name << std::setw(7) << VulkanApp::CVertexQuantizer::GetIsaName(isa)
+				<< std::right << std::setw(9) << (bestSeconds > 0.0 ? srcBytes / bestSeconds * 1e-9 : 0.0) << " GB/s, "
+				<< componentCount * sizeof(float) << " -> " << VulkanApp::BufferAttribute::GetTypeSize(type.m_type) << " bytes per vertex"
+				<< (matches ? "" : ", MISMATCH") << "\n";
+		}
+	}
+
+	return exitCode;
+}
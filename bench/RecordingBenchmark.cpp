@@ -0,0 +1,205 @@
+#include <Benchmarks.h>
+#include <CVulkanCore.h>
+#include <CVulkanPass.h>
+#include <CVulkanPipeline.h>
+#include <CVulkanShaderCache.h>
+#include <EmbeddedShaders.h>
+#include <CVulkanBuffer.h>
+#include <CVulkanOffscreenTarget.h>
+#include <CVulkanParallelRecorder.h>
+#include <CVulkanDrawList.h>
+#include <SampleVertex.h>
+#include <CRollingStats.h>
+#include <Utilities.h>
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+	struct RecordingResult {
+		double m_averageMs = 0.0;
+		double m_medianMs = 0.0;
+		double m_minMs = 0.0;
+	};
+
+	// Measures CPU time of recording the whole pass into a primary command buffer, nothing is submitted
+	RecordingResult MeasureRecording(const VulkanApp::CVulkanCore &core, VulkanApp::CVulkanPass &pass, const VulkanApp::CVulkanDrawList &drawList,
+		const VulkanApp::CVulkanOffscreenTarget &target, const VkCommandPool commandPool, const VkCommandBuffer commandBuffer,
+		VulkanApp::CVulkanParallelRecorder *pRecorder, const uint32_t iterations) {
+
+		constexpr uint32_t warmupIterations = 5u;
+		VulkanApp::CRollingStats samples(iterations);
+		const VkRect2D renderArea = { {0, 0}, target.GetExtent() };
+
+		for (uint32_t i = 0u; i < warmupIterations + iterations; i++) {
+			const auto start = std::chrono::steady_clock::now();
+
+			if (pRecorder) {
+				pRecorder->BeginFrame(0u);
+			}
+
+			VkResult result = vkResetCommandPool(core.GetVkLogicalDevice(), commandPool, 0);
+			if (result != VK_SUCCESS) {
+				throw std::runtime_error(UTIL_EXC_MSG_EX("Cannot reset the command pool", result));
+			}
+
+			VkCommandBufferBeginInfo beginInfoCI = {};
+			beginInfoCI.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+			beginInfoCI.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+			result = vkBeginCommandBuffer(commandBuffer, &beginInfoCI);
+			if (result != VK_SUCCESS) {
+				throw std::runtime_error(UTIL_EXC_MSG_EX("Failed to begin a command buffer", result));
+			}
+
+			pass.RecordWorkload(commandBuffer, drawList, target.GetFramebuffer(0u), renderArea, nullptr, 0u, pRecorder);
+
+			result = vkEndCommandBuffer(commandBuffer);
+			if (result != VK_SUCCESS) {
+				throw std::runtime_error(UTIL_EXC_MSG_EX("Failed to end a command buffer", result));
+			}
+
+			if (i >= warmupIterations) {
+				samples.Add(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+			}
+		}
+
+		return { samples.GetAverage(), samples.GetPercentile(50.0), samples.GetMin() };
+	}
+}
+
+// Usage: VulkanBench recording [--draws <count>] [--iterations <count>] [--max-threads <count>]
+int VulkanBench::RunRecordingBenchmark(const std::vector<std::string> &args) {
+	uint32_t drawCount = 50000u;
+	uint32_t iterations = 50u;
+	uint32_t maxThreads = std::max(std::thread::hardware_concurrency(), 1u);
+
+	for (size_t i = 0u; i + 1u < args.size(); i++) {
+		if (args[i] == "--draws") {
+			drawCount = static_cast<uint32_t>(std::stoul(args[++i]));
+		}
+		else if (args[i] == "--iterations") {
+			iterations = std::max(static_cast<uint32_t>(std::stoul(args[++i])), 1u);
+		}
+		else if (args[i] == "--max-threads") {
+			maxThreads = std::max(static_cast<uint32_t>(std::stoul(args[++i])), 1u);
+		}
+	}
+
+	VulkanApp::CVulkanCore core("VulkanBench", true);
+	VulkanApp::CVulkanPass pass(&core, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+
+	VkPipelineShaderStageCreateInfo shaderStageCI[2] = {};
+	// SPIR-V embedded at build time, the core owns the modules
+	VulkanApp::CVulkanShaderCache *pShaderCache = core.GetShaderCache();
+	shaderStageCI[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	shaderStageCI[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+	shaderStageCI[0].module = pShaderCache->Create(VulkanApp::EmbeddedShaders::cexp_vertexShader, sizeof(VulkanApp::EmbeddedShaders::cexp_vertexShader));
+	shaderStageCI[0].pName = "main";
+
+	shaderStageCI[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	shaderStageCI[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+	shaderStageCI[1].module = pShaderCache->Create(VulkanApp::EmbeddedShaders::cexp_fragmentShader, sizeof(VulkanApp::EmbeddedShaders::cexp_fragmentShader));
+	shaderStageCI[1].pName = "main";
+
+	VkCommandPool commandPool = VK_NULL_HANDLE;
+	int exitCode = 0;
+	{
+		VulkanApp::CVulkanPipeline pipeline(&core, &pass, shaderStageCI, VulkanApp::SampleVertexLayout::cexp_inputState);
+		VulkanApp::CVulkanOffscreenTarget target(&core, pass.GetHandle(), VK_FORMAT_R8G8B8A8_UNORM, 256u, 256u, 1u, false);
+
+		const VulkanApp::SampleVertex vertices[] = {
+			{ {  0.0f,-1.0f, 0.0f }, { 1.0f, 0.5f, 0.5f } },
+			{ {  1.0f, 1.0f, 0.0f }, { 0.1f, 1.0f, 0.4f } },
+			{ { -1.0f, 1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f } } };
+		VulkanApp::CVulkanBuffer vertexBuffer(&core, vertices, sizeof(vertices),
+			{ VkBufferUsageFlagBits::VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VulkanApp::BufferMemory::HostVisible });
+
+		const VulkanApp::SampleInstance instance = { { 0.0f, 0.0f, 1.0f, 0.0f } };
+		VulkanApp::CVulkanBuffer instanceBuffer(&core, &instance, sizeof(instance),
+			{ VkBufferUsageFlagBits::VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VulkanApp::BufferMemory::HostVisible });
+
+		VkCommandPoolCreateInfo commandPoolCI = {};
+		commandPoolCI.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		commandPoolCI.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+		commandPoolCI.queueFamilyIndex = core.GetQueueFamilyIndex();
+
+		VkResult result = vkCreateCommandPool(core.GetVkLogicalDevice(), &commandPoolCI, nullptr, &commandPool);
+		if (result != VK_SUCCESS) {
+			throw std::runtime_error(UTIL_EXC_MSG_EX("Cannot create a command pool", result));
+		}
+
+		VkCommandBufferAllocateInfo commandBufferAI = {};
+		commandBufferAI.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		commandBufferAI.commandPool = commandPool;
+		commandBufferAI.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		commandBufferAI.commandBufferCount = 1u;
+
+		VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+		result = vkAllocateCommandBuffers(core.GetVkLogicalDevice(), &commandBufferAI, &commandBuffer);
+		if (result != VK_SUCCESS) {
+			vkDestroyCommandPool(core.GetVkLogicalDevice(), commandPool, nullptr);
+			throw std::runtime_error(UTIL_EXC_MSG_EX("Cannot allocate a command buffer", result));
+		}
+
+		std::cout << "[RECORDING] " << drawCount << " draws, " << iterations << " iterations\n";
+		std::cout << std::fixed << std::setprecision(3);
+
+		try {
+			// Same scene as direct draws and as one multi-draw indirect batch
+			VulkanApp::CVulkanDrawList directList(&core, 1u, drawCount, false);
+			VulkanApp::CVulkanDrawList indirectList(&core, 1u, drawCount, true);
+
+			VulkanApp::DrawPacket triangle;
+			triangle.m_pipeline = pipeline.GetHandle();
+			triangle.SetVertexBuffer(0u, vertexBuffer.GetHandle());
+			triangle.SetVertexBuffer(1u, instanceBuffer.GetHandle());
+			triangle.m_count = 3u;
+			for (uint32_t i = 0u; i < drawCount; i++) {
+				directList.Add(triangle);
+				indirectList.Add(triangle);
+			}
+			directList.Build(0u);
+			indirectList.Build(0u);
+
+			const RecordingResult inlineResult = MeasureRecording(core, pass, directList, target, commandPool, commandBuffer, nullptr, iterations);
+			std::cout << "[RECORDING] inline     avg " << inlineResult.m_averageMs << " ms, p50 " << inlineResult.m_medianMs
+				<< " ms, min " << inlineResult.m_minMs << " ms\n";
+
+			if (indirectList.UsesIndirect()) {
+				const RecordingResult indirectResult = MeasureRecording(core, pass, indirectList, target, commandPool, commandBuffer, nullptr, iterations);
+				std::cout << "[RECORDING] indirect   avg " << indirectResult.m_averageMs << " ms, p50 " << indirectResult.m_medianMs
+					<< " ms, min " << indirectResult.m_minMs << " ms, " << indirectList.GetBatchCount() << " batches\n";
+			}
+			else {
+				std::cout << "[RECORDING] indirect   skipped, multiDrawIndirect is not supported\n";
+			}
+
+			// Thread counts double up to the limit, the limit itself is always measured
+			double singleThreadMs = 0.0;
+			for (uint32_t threads = 1u; threads <= maxThreads; threads = (threads == maxThreads) ? threads + 1u : std::min(threads * 2u, maxThreads)) {
+				// Splitting is forced even for small draw counts so every thread gets a share
+				VulkanApp::CVulkanParallelRecorder recorder(&core, 1u, threads, std::max(drawCount / (2u * threads), 1u));
+				const RecordingResult result = MeasureRecording(core, pass, directList, target, commandPool, commandBuffer, &recorder, iterations);
+
+				if (threads == 1u) {
+					singleThreadMs = result.m_medianMs;
+				}
+
+				std::cout << "[RECORDING] " << std::setw(2) << threads << " threads avg " << result.m_averageMs << " ms, p50 " << result.m_medianMs
+					<< " ms, min " << result.m_minMs << " ms, speedup " << (result.m_medianMs > 0.0 ? singleThreadMs / result.m_medianMs : 0.0) << "x\n";
+			}
+		}
+		catch (const std::exception &e) {
+			std::cout << e.what();
+			exitCode = 1;
+		}
+
+		vkDestroyCommandPool(core.GetVkLogicalDevice(), commandPool, nullptr);
+	}
+
+	return exitCode;
+}
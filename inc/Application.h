@@ -1,54 +1,125 @@
 #pragma once
 #include <stdint.h>
+#include <atomic>
 #include <string>
+#include <thread>
 #include <vector>
 
-#define VK_USE_PLATFORM_WIN32_KHR
-#include <vulkan\vulkan.h>
+#include <vulkan/vulkan_core.h>
 
 #include <CVulkanCore.h>
+#include <CVulkanSwapchain.h>
+#include <CFrameLimiter.h>
+#include <CRollingStats.h>
+#include <CSpecializationConstants.h>
 #include <CWindow.h>
+#include <TSpscQueue.h>
 
 /*
 The application design aims to reflect actual Vulkan
 resources dependencies
+
+Frames are rendered on a thread of their own, the thread running the
+window only forwards events and settings through a lock-free queue.
+The render thread applies them between frames, so a burst of resize
+events ends in one swapchain recreation and the window never waits
+for a frame.
 */
 
 namespace VulkanApp {
 	class CVulkanPass;
 	class CVulkanPipeline;
-	class CVulkanSwapchain;
 	class CVulkanBuffer;
+	class CVulkanIndexBuffer;
+	class CVulkanFrameRing;
+	class CVulkanGpuProfiler;
+	class CVulkanParallelRecorder;
+	class CVulkanDrawList;
 	class Application : public CWindow::IEventListener {
 	public:
-		Application(const HWND windowHandle);
+		Application(const CWindow &window, const uint32_t framesInFlight = 2u,
+			const PresentPolicy presentPolicy = PresentPolicy::PowerSaving, const double frameRateLimit = 0.0);
 		~Application();
-		bool RenderFrame();
+		// Renders until the window is closed, a frame fails or Stop() is called
+		void Start();
+		void Stop();
+		bool IsRunning() const { return m_running.load(std::memory_order_acquire); };
+
+		// Called from the thread which runs the window, applied before the next frame
+		void SetPresentPolicy(const PresentPolicy policy);
+		void SetFrameRateLimit(const double frameRate);
+		// Read after Stop()
+		const CRollingStats& GetPresentLatency() const { return m_presentLatency; };
+
+		static constexpr uint32_t cexp_traceFrameCount = 120u; // Frames written to the trace file on exit
+		static constexpr uint32_t cexp_commandQueueSize = 64u;
+		static constexpr uint32_t cexp_idleSleepMs = 5u; // Polling interval of the queue while minimized
 
 	private:
+		enum class RenderCommandType : uint32_t {
+			Resize,
+			Close,
+			PresentPolicy,
+			FrameRateLimit
+		};
+
+		struct RenderCommand {
+			RenderCommandType m_type = RenderCommandType::Resize;
+			uint32_t m_width = 0u;
+			uint32_t m_height = 0u;
+			PresentPolicy m_presentPolicy = PresentPolicy::PowerSaving;
+			double m_frameRate = 0.0;
+		};
+
+		// Window thread
 		void OnSizeChanged(const uint32_t width, const uint32_t height) override;
 		void OnClose() override;
+		void PushCommand(const RenderCommand &command);
 
-		// Window properties
+		// Render thread
+		void RenderThreadProcedure();
+		void ProcessCommands();
+		bool RenderFrame();
+		bool RecreateSwapchain();
+
+		std::thread m_renderThread;
+		std::atomic<bool> m_running = false;
+		std::atomic<bool> m_stopRequested = false;
+		TSpscQueue<RenderCommand, cexp_commandQueueSize> m_commands;
+
+		// Window properties, owned by the render thread once it runs
 		bool m_windowMinimized = false;
 		bool m_windowClosed = false;
+		bool m_swapchainDirty = false; // Swapchain is recreated before the next acquire
 		uint32_t m_windowWidth = 0u;
 		uint32_t m_windowHeight = 0u;
 
+		// CPU trace written on exit, enabled by the VULKANAPP_TRACE environment variable.
+		// Declared before the core, so its creation is traced as well.
+		std::string m_tracePath;
+
 		CVulkanCore m_core;
 		CVulkanPass *m_pPass = nullptr;
 		CVulkanPipeline *m_pPipeline = nullptr;
 		CVulkanSwapchain *m_pSwapchain = nullptr;
 		CVulkanBuffer* m_pVertexBuffer = nullptr;
+		CVulkanIndexBuffer* m_pIndexBuffer = nullptr;
+		CVulkanBuffer* m_pInstanceBuffer = nullptr;
+		CVulkanFrameRing *m_pFrameRing = nullptr;
+		CVulkanGpuProfiler *m_pGpuProfiler = nullptr;
+		CVulkanParallelRecorder *m_pRecorder = nullptr;
+		CVulkanDrawList *m_pDrawList = nullptr;
+
+		// Frame pacing
+		CFrameLimiter m_frameLimiter;
+		CRollingStats m_presentLatency; // Acquire to present on the CPU, in milliseconds
 
 		// Window surface
 		VkSurfaceKHR m_vkSurface = VK_NULL_HANDLE;
 		VkSurfaceFormatKHR m_vkSurfaceFormat;
 
 		// Pipeline
-		VkPipelineShaderStageCreateInfo m_shaderStageCI[2];
-		VkSemaphore m_vkImgRdySem = VK_NULL_HANDLE;
-		std::vector<VkSemaphore> m_vkRenderDoneSemVec = { VK_NULL_HANDLE };
-		VkFence m_vkFence = VK_NULL_HANDLE;
+		VkPipelineShaderStageCreateInfo m_shaderStageCI[2] = {};
+		CSpecializationConstants m_fragmentConstants; // Behind m_shaderStageCI[1].pSpecializationInfo
 	};
 }
\ No newline at end of file
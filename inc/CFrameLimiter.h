@@ -0,0 +1,37 @@
+#ifndef C_FRAME_LIMITER_H_
+#define C_FRAME_LIMITER_H_
+
+#include <chrono>
+#include <cstdint>
+
+/*
+Frame limiter:
+Paces the render loop on the CPU. Sleeping covers most of the
+frame period, the remainder is spun because the system timer is
+too coarse for sub-millisecond deadlines. Deadlines advance by a
+fixed period, so a late frame does not shift the following ones,
+unless it is late by more than a whole period.
+*/
+
+namespace VulkanApp {
+
+	class CFrameLimiter {
+	public:
+		using Clock = std::chrono::steady_clock;
+
+		static constexpr std::chrono::microseconds cexp_spinThreshold = std::chrono::microseconds(2000);
+
+		explicit CFrameLimiter(const double targetFrameRate = 0.0);
+		void SetTargetFrameRate(const double targetFrameRate);
+		double GetTargetFrameRate() const { return m_targetFrameRate; };
+		bool IsEnabled() const { return m_period.count() > 0; };
+		void Wait();
+
+	private:
+		double m_targetFrameRate = 0.0;
+		Clock::duration m_period = Clock::duration::zero();
+		Clock::time_point m_deadline;
+	};
+}
+
+#endif // !C_FRAME_LIMITER_H_
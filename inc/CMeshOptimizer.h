@@ -0,0 +1,53 @@
+#ifndef C_MESH_OPTIMIZER_H_
+#define C_MESH_OPTIMIZER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+Mesh preprocessing:
+Triangles are reordered with Tipsify (Sander, Nehab, Barczak 2007)
+so recently transformed vertices are reused while they are still in
+the post-transform cache. Vertices are then renumbered in order of
+first use, so the vertex fetch walks memory mostly forward. Both run
+in linear time and are meant to be applied once, when assets are
+imported, not every frame.
+*/
+
+namespace VulkanApp {
+
+	struct MeshStatistics {
+		float m_acmr = 0.0f; // Vertex shader invocations per triangle, 0.5 to 3.0
+		float m_atvr = 0.0f; // Vertex shader invocations per referenced vertex, 1.0 is optimal
+		float m_overfetch = 0.0f; // Vertex bytes read from memory per byte of referenced vertices
+	};
+
+	struct MeshOptimizationReport {
+		MeshStatistics m_before;
+		MeshStatistics m_after;
+		uint32_t m_vertexCount = 0u; // Unreferenced vertices are dropped
+		double m_optimizationMs = 0.0;
+	};
+
+	class CMeshOptimizer {
+	public:
+		static constexpr uint32_t cexp_defaultCacheSize = 16u; // FIFO entries, a conservative value for current GPUs
+		static constexpr uint32_t cexp_cacheLineSize = 64u;
+
+		// Simulated FIFO post-transform cache and a small direct mapped cache in front of the vertex buffer
+		static MeshStatistics Analyze(const uint32_t *pIndices, const size_t indexCount, const uint32_t vertexCount, const uint32_t vertexStride,
+			const uint32_t cacheSize = cexp_defaultCacheSize);
+		// Triangle order only, pDstIndices must not alias pIndices
+		static void OptimizeVertexCache(uint32_t *pDstIndices, const uint32_t *pIndices, const size_t indexCount, const uint32_t vertexCount,
+			const uint32_t cacheSize = cexp_defaultCacheSize);
+		// Vertex order only, indices are remapped in place, returns the number of vertices written to pDstVertices
+		static uint32_t OptimizeVertexFetch(void *pDstVertices, uint32_t *pIndices, const size_t indexCount, const void *pVertices,
+			const uint32_t vertexCount, const uint32_t vertexStride);
+		// Both passes in the recommended order, with statistics of the input and the result
+		static MeshOptimizationReport Optimize(std::vector<uint8_t> &vertices, const uint32_t vertexStride, std::vector<uint32_t> &indices,
+			const uint32_t cacheSize = cexp_defaultCacheSize);
+	};
+}
+
+#endif // !C_MESH_OPTIMIZER_H_
@@ -0,0 +1,26 @@
+#ifndef C_NULL_WINDOW_H_
+#define C_NULL_WINDOW_H_
+
+#include <CWindow.h>
+
+/*
+Null window:
+No system window and no surface, events only come from PushEvent().
+Lets the event handling of an application run on machines without a
+display, e.g. to replay recorded input.
+*/
+
+class CNullWindow : public CWindow {
+public:
+	CNullWindow(const uint32_t width, const uint32_t height);
+	WindowBackend GetBackend() const override { return WindowBackend::Null; };
+	void Show(bool /*isVisible*/) override {};
+	VkResult CreateSurface(const VkInstance instance, VkSurfaceKHR *pSurface) const override;
+
+private:
+	void DrainSystemEvents() override {};
+	// Nothing can arrive, sleeps for the whole timeout
+	void WaitSystemEvents(const uint32_t timeoutMs) override;
+};
+
+#endif // !C_NULL_WINDOW_H_
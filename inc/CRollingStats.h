@@ -0,0 +1,32 @@
+#ifndef C_ROLLING_STATS_H_
+#define C_ROLLING_STATS_H_
+
+#include <cstdint>
+#include <vector>
+
+namespace VulkanApp {
+
+	// Statistics over a fixed window of the most recent samples
+	class CRollingStats {
+	public:
+		static constexpr uint32_t cexp_defaultWindow = 256u;
+
+		explicit CRollingStats(const uint32_t window = cexp_defaultWindow);
+		void Add(const double value);
+		void Reset();
+		uint32_t GetCount() const { return m_count; };
+		double GetLast() const;
+		double GetMin() const;
+		double GetMax() const;
+		double GetAverage() const;
+		double GetPercentile(const double percentile) const;
+
+	private:
+		std::vector<double> m_samples;
+		uint32_t m_next = 0u;
+		uint32_t m_count = 0u;
+		double m_sum = 0.0;
+	};
+}
+
+#endif // !C_ROLLING_STATS_H_
@@ -0,0 +1,59 @@
+#ifndef C_SPECIALIZATION_CONSTANTS_H_
+#define C_SPECIALIZATION_CONSTANTS_H_
+
+#include <vulkan/vulkan_core.h>
+
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+/*
+Specialization constants:
+Values for the constant_id declarations of a shader stage, the driver
+folds them into the code when the pipeline is created, so variants
+cost no branches at runtime. bool is stored as a 32-bit VkBool32.
+
+	CSpecializationConstants constants;
+	constants.Set(0u, true).Set(1u, 4u);
+	shaderStageCI.pSpecializationInfo = constants.GetInfo();
+*/
+
+namespace VulkanApp {
+	class CSpecializationConstants {
+	public:
+		template <typename T>
+		CSpecializationConstants& Set(const uint32_t constantId, const T value) {
+			static_assert(std::is_same_v<T, bool> || std::is_same_v<T, int32_t> || std::is_same_v<T, uint32_t> ||
+				std::is_same_v<T, float> || std::is_same_v<T, double> || std::is_same_v<T, int64_t> || std::is_same_v<T, uint64_t>,
+				"Specialization constants are scalars of 32 or 64 bits or bool");
+
+			if constexpr (std::is_same_v<T, bool>) {
+				const VkBool32 boolValue = value ? VK_TRUE : VK_FALSE;
+				SetRaw(constantId, &boolValue, sizeof(boolValue));
+			}
+			else {
+				SetRaw(constantId, &value, sizeof(value));
+			}
+			return *this;
+		}
+
+		// Setting a constant again replaces its value, it has to keep its size
+		void SetRaw(const uint32_t constantId, const void *data, const uint32_t byteSize);
+		// Replaces the constants with a copy of the info, null clears them
+		void Assign(const VkSpecializationInfo *pInfo);
+		void Clear();
+
+		// Null without constants, the pointer stays valid until the next change
+		const VkSpecializationInfo* GetInfo();
+		bool IsEmpty() const { return m_entries.empty(); };
+		uint64_t GetHash(const uint64_t seed) const;
+		bool operator==(const CSpecializationConstants &other) const;
+
+	private:
+		std::vector<VkSpecializationMapEntry> m_entries;
+		std::vector<uint8_t> m_data;
+		VkSpecializationInfo m_info = {};
+	};
+}
+
+#endif // !C_SPECIALIZATION_CONSTANTS_H_
@@ -0,0 +1,88 @@
+#ifndef C_TRACER_H_
+#define C_TRACER_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+/*
+CPU tracing:
+TRACE_SCOPE records the duration of the enclosing scope into a
+fixed size ring buffer owned by the calling thread, so recording
+takes no lock and never allocates. Old events are overwritten.
+Rings are written out as Chrome trace JSON (chrome://tracing,
+Perfetto). Building with VULKANAPP_TRACING=0 removes the scopes,
+at runtime a disabled tracer costs one relaxed atomic load.
+*/
+
+#ifndef VULKANAPP_TRACING
+#define VULKANAPP_TRACING 1
+#endif
+
+namespace VulkanApp {
+
+	struct TraceEvent {
+		const char *m_name = nullptr; // Must outlive the tracer, string literals only
+		int64_t m_beginNs = 0;
+		int64_t m_durationNs = 0;
+		uint64_t m_frame = 0u;
+	};
+
+	class CTracer {
+	public:
+		static constexpr uint32_t cexp_eventsPerThread = 16u * 1024u;
+
+		static void SetEnabled(const bool enabled) { s_enabled.store(enabled, std::memory_order_relaxed); };
+		static bool IsEnabled() { return s_enabled.load(std::memory_order_relaxed); };
+		static void NextFrame() { s_frame.fetch_add(1u, std::memory_order_relaxed); };
+		static uint64_t GetFrame() { return s_frame.load(std::memory_order_relaxed); };
+		static int64_t Now();
+		static void Record(const char *name, const int64_t beginNs, const int64_t endNs);
+
+		// Events of the last frameCount frames, zero writes everything still in the rings.
+		// Threads should not be recording while the trace is written.
+		static bool WriteChromeTrace(const std::string &filePath, const uint32_t frameCount = 0u);
+
+		// Average cost of an empty scope in nanoseconds, in the current enabled state
+		static double MeasureScopeOverhead(const uint32_t iterations = 100000u);
+
+		// Enables tracing when the variable names an output file and returns that path, empty otherwise.
+		// Call it before the objects to be traced are created.
+		static std::string EnableFromEnvironment(const char *variable = "VULKANAPP_TRACE");
+
+	private:
+		static std::atomic<bool> s_enabled;
+		static std::atomic<uint64_t> s_frame;
+	};
+
+	class CTraceScope {
+	public:
+		explicit CTraceScope(const char *name)
+			: m_name(CTracer::IsEnabled() ? name : nullptr), m_beginNs(m_name ? CTracer::Now() : 0) {}
+		~CTraceScope() {
+			if (m_name) {
+				CTracer::Record(m_name, m_beginNs, CTracer::Now());
+			}
+		}
+		CTraceScope(const CTraceScope&) = delete;
+		CTraceScope& operator=(const CTraceScope&) = delete;
+
+	private:
+		const char *const m_name;
+		const int64_t m_beginNs;
+	};
+}
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+
+#if VULKANAPP_TRACING
+#define TRACE_SCOPE(name) VulkanApp::CTraceScope TRACE_CONCAT(traceScope_, __LINE__)(name)
+#define TRACE_NEXT_FRAME() VulkanApp::CTracer::NextFrame()
+#else
+#define TRACE_SCOPE(name) ((void)0)
+#define TRACE_NEXT_FRAME() ((void)0)
+#endif
+
+#endif // !C_TRACER_H_
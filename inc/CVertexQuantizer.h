@@ -0,0 +1,49 @@
+#ifndef C_VERTEX_QUANTIZER_H_
+#define C_VERTEX_QUANTIZER_H_
+
+#include <CVulkanBuffer.h>
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+Vertex quantization:
+Float vertex streams are converted into the compact attribute types
+of CBufferLayout when assets are imported or generated. Normalized
+types are clamped to their range and rounded to nearest, NaN maps to
+the lower bound, halfs round to nearest even. Every instruction set
+level produces bit identical output for all values but NaN payloads,
+the widest one supported by the CPU is used unless another is requested.
+*/
+
+namespace VulkanApp {
+
+	enum class QuantizerIsa {
+		Scalar,
+		SSE2,
+		AVX2 // Together with F16C
+	};
+
+	class CVertexQuantizer {
+	public:
+		static QuantizerIsa GetSupportedIsa();
+		static const char* GetIsaName(const QuantizerIsa isa);
+		// Float components read per vertex, 0 for types which are not quantized
+		static uint32_t GetComponentCount(const BufferAttribute::ShaderDataType dstType);
+		static bool IsQuantized(const BufferAttribute::ShaderDataType dstType) { return GetComponentCount(dstType) != 0u; };
+
+		// Tightly packed streams, GetComponentCount() floats in and one dstType out per vertex
+		static void Quantize(const BufferAttribute::ShaderDataType dstType, void *pDst, const float *pSrc, const size_t vertexCount);
+		static void Quantize(const BufferAttribute::ShaderDataType dstType, void *pDst, const float *pSrc, const size_t vertexCount,
+			const QuantizerIsa isa);
+		// Interleaved streams, e.g. a single attribute of a vertex buffer, strides are in bytes
+		static void QuantizeStrided(const BufferAttribute::ShaderDataType dstType, void *pDst, const size_t dstStride,
+			const float *pSrc, const size_t srcStride, const size_t vertexCount);
+
+		// Single values, the reference every vectorized path has to match
+		static uint16_t FloatToHalf(const float value);
+		static float HalfToFloat(const uint16_t value);
+	};
+}
+
+#endif // !C_VERTEX_QUANTIZER_H_
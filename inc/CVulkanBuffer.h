@@ -5,6 +5,8 @@
 #include <vulkan/vulkan.h>
 #endif
 
+#include <CVulkanMemoryAllocator.h>
+
 #include <string>
 #include <vector>
 
@@ -21,45 +23,155 @@ namespace VulkanApp {
 			uint4,
 			float2,
 			float3,
-			float4
+			float4,
+			// Compact formats, 3 component variants are left out as few devices fetch them
+			half2,
+			half4,
+			snorm16x2,
+			snorm16x4,
+			unorm16x2,
+			unorm16x4,
+			unorm8x4,
+			unorm10x3a2	// A2B10G10R10, one 32 bit word
 		};
 
 		std::string m_name;
 		ShaderDataType m_shaderDataType;
 		uint32_t m_size;
 		uint32_t m_offset;
+		uint32_t m_binding;
+		uint32_t m_location;
 
 		BufferAttribute(ShaderDataType shaderDataType, const std::string name);
+		static constexpr uint32_t GetTypeSize(ShaderDataType shaderDataType);
+		static constexpr VkFormat GetVkFormat(ShaderDataType shaderDataType);
 	};
 
+	constexpr uint32_t BufferAttribute::GetTypeSize(ShaderDataType shaderDataType) {
+		switch (shaderDataType)
+		{
+		case BufferAttribute::ShaderDataType::int2:			return 4 * 2;
+		case BufferAttribute::ShaderDataType::int3:			return 4 * 3;
+		case BufferAttribute::ShaderDataType::int4:			return 4 * 4;
+		case BufferAttribute::ShaderDataType::uint2:		return 4 * 2;
+		case BufferAttribute::ShaderDataType::uint3:		return 4 * 3;
+		case BufferAttribute::ShaderDataType::uint4:		return 4 * 4;
+		case BufferAttribute::ShaderDataType::float2:		return 4 * 2;
+		case BufferAttribute::ShaderDataType::float3:		return 4 * 3;
+		case BufferAttribute::ShaderDataType::float4:		return 4 * 4;
+		case BufferAttribute::ShaderDataType::half2:		return 2 * 2;
+		case BufferAttribute::ShaderDataType::half4:		return 2 * 4;
+		case BufferAttribute::ShaderDataType::snorm16x2:	return 2 * 2;
+		case BufferAttribute::ShaderDataType::snorm16x4:	return 2 * 4;
+		case BufferAttribute::ShaderDataType::unorm16x2:	return 2 * 2;
+		case BufferAttribute::ShaderDataType::unorm16x4:	return 2 * 4;
+		case BufferAttribute::ShaderDataType::unorm8x4:		return 1 * 4;
+		case BufferAttribute::ShaderDataType::unorm10x3a2:	return 4;
+		default: break;
+		}
+		return 0;
+	}
+
+	constexpr VkFormat BufferAttribute::GetVkFormat(ShaderDataType shaderDataType) {
+		switch (shaderDataType)
+		{
+		case BufferAttribute::ShaderDataType::int2:			return VK_FORMAT_R32G32_SINT;
+		case BufferAttribute::ShaderDataType::int3:			return VK_FORMAT_R32G32B32_SINT;
+		case BufferAttribute::ShaderDataType::int4:			return VK_FORMAT_R32G32B32A32_SINT;
+		case BufferAttribute::ShaderDataType::uint2:		return VK_FORMAT_R32G32_UINT;
+		case BufferAttribute::ShaderDataType::uint3:		return VK_FORMAT_R32G32B32_UINT;
+		case BufferAttribute::ShaderDataType::uint4:		return VK_FORMAT_R32G32B32A32_UINT;
+		case BufferAttribute::ShaderDataType::float2:		return VK_FORMAT_R32G32_SFLOAT;
+		case BufferAttribute::ShaderDataType::float3:		return VK_FORMAT_R32G32B32_SFLOAT;
+		case BufferAttribute::ShaderDataType::float4:		return VK_FORMAT_R32G32B32A32_SFLOAT;
+		case BufferAttribute::ShaderDataType::half2:		return VK_FORMAT_R16G16_SFLOAT;
+		case BufferAttribute::ShaderDataType::half4:		return VK_FORMAT_R16G16B16A16_SFLOAT;
+		case BufferAttribute::ShaderDataType::snorm16x2:	return VK_FORMAT_R16G16_SNORM;
+		case BufferAttribute::ShaderDataType::snorm16x4:	return VK_FORMAT_R16G16B16A16_SNORM;
+		case BufferAttribute::ShaderDataType::unorm16x2:	return VK_FORMAT_R16G16_UNORM;
+		case BufferAttribute::ShaderDataType::unorm16x4:	return VK_FORMAT_R16G16B16A16_UNORM;
+		case BufferAttribute::ShaderDataType::unorm8x4:		return VK_FORMAT_R8G8B8A8_UNORM;
+		case BufferAttribute::ShaderDataType::unorm10x3a2:	return VK_FORMAT_A2B10G10R10_UNORM_PACK32;
+		default: break;
+		}
+		return VK_FORMAT_UNDEFINED;
+	}
+
+	struct BufferBinding {
+		uint32_t m_binding = 0;
+		uint32_t m_stride = 0;
+		VkVertexInputRate m_inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+	};
+
+	// Every binding is a separate vertex buffer, attribute locations run on across bindings
 	class CBufferLayout {
 	public:
-		CBufferLayout(std::initializer_list<BufferAttribute> bufferAttributes);
+		CBufferLayout(std::initializer_list<BufferAttribute> bufferAttributes, const VkVertexInputRate inputRate = VK_VERTEX_INPUT_RATE_VERTEX);
+		CBufferLayout& AddBinding(std::initializer_list<BufferAttribute> bufferAttributes, const VkVertexInputRate inputRate);
 		uint32_t GetAttributesCount() const { return m_attributes.size(); };
-		uint32_t GetByteSize() const { return m_byteSize; };
+		uint32_t GetBindingsCount() const { return m_bindings.size(); };
+		uint32_t GetByteSize(const uint32_t binding = 0) const { return binding < m_bindings.size() ? m_bindings[binding].m_stride : 0; };
 		BufferAttribute GetAttribute(uint32_t index) const { return m_attributes[index]; };
+		BufferBinding GetBinding(uint32_t index) const { return m_bindings[index]; };
 	private:
 		std::vector<BufferAttribute> m_attributes;
-		uint32_t m_byteSize = 0;
+		std::vector<BufferBinding> m_bindings;
+	};
+
+	enum class BufferMemory {
+		HostVisible,	// Written directly through a mapped pointer
+		DeviceLocal,	// Written through the staging uploader
+		HostStreaming	// Mapped, device local when the device offers it, may be non coherent so writes are flushed
+	};
+
+	struct BufferUsage {
+		VkBufferUsageFlags m_vkUsage = 0u;
+		BufferMemory m_memory = BufferMemory::HostVisible;
+
+		BufferUsage(const VkBufferUsageFlags vkUsage, const BufferMemory memory = BufferMemory::HostVisible)
+			: m_vkUsage(vkUsage), m_memory(memory) {}
 	};
 
 	class CVulkanBuffer {
 	public:
-		CVulkanBuffer(const CVulkanCore* const pCore, const void* data, const uint32_t byteSize, VkBufferUsageFlagBits usage);
+		CVulkanBuffer(const CVulkanCore* const pCore, const void* data, const uint32_t byteSize, const BufferUsage usage);
 		void SetData(const void* data);
+		void SetData(const void* data, const VkDeviceSize offset, const VkDeviceSize byteSize);
+		// Required after writing through GetMappedData(), only does work for non coherent memory
+		void Flush(const VkDeviceSize offset, const VkDeviceSize byteSize) const;
 		~CVulkanBuffer();
 		VkBuffer GetHandle() const { return m_vkBuffer; }
+		BufferMemory GetMemory() const { return m_memory; }
+		uint32_t GetByteSize() const { return m_byteSize; }
+		const void* GetMappedData() const { return m_pMappedData; } // Null for device local buffers
+		void* GetMappedData() { return m_pMappedData; }
 	private:
 		const CVulkanCore* const m_pCore = nullptr;
+		const BufferMemory m_memory = BufferMemory::HostVisible;
 		void* m_pMappedData = nullptr;
 		const uint32_t m_byteSize = 0;
 		VkBuffer m_vkBuffer = VK_NULL_HANDLE;
-		VkDeviceMemory m_vkBufferMemory = VK_NULL_HANDLE;
+		MemoryAllocation m_allocation;
 		static VkBuffer CreateBuffer(
 			const CVulkanCore *const pCore, const uint32_t byteSize, const uint32_t bufferUsageFlagBits,
-			const uint32_t memoryPropertyFlagBits,const VkSharingMode sharingMode, VkDeviceMemory *pBufferMemory);
+			const uint32_t memoryPropertyFlagBits, const uint32_t preferredPropertyFlagBits, const VkSharingMode sharingMode,
+			MemoryAllocation *pAllocationOut);
+	};
+
+	// Indices are stored as 16 bits whenever every vertex can be addressed with them
+	class CVulkanIndexBuffer : public CVulkanBuffer {
+	public:
+		CVulkanIndexBuffer(const CVulkanCore* const pCore, const uint32_t* indices, const uint32_t indexCount, const uint32_t vertexCount,
+			const BufferMemory memory = BufferMemory::DeviceLocal);
+		VkIndexType GetIndexType() const { return m_vkIndexType; }
+		uint32_t GetIndexCount() const { return m_indexCount; }
+		static VkIndexType SelectIndexType(const uint32_t vertexCount);
+		static uint32_t GetIndexSize(const VkIndexType indexType);
+	private:
+		const VkIndexType m_vkIndexType = VK_INDEX_TYPE_UINT32;
+		const uint32_t m_indexCount = 0;
 	};
 
 
 }
-#endif C_BUFFER_H_
\ No newline at end of file
+#endif // !C_BUFFER_H_
\ No newline at end of file
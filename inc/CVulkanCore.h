@@ -2,31 +2,73 @@
 #define C_VULKAN_CORE_H_
 
 #include <vulkan/vulkan_core.h>
+#include <DeviceCaps.h>
 
 #include <string>
 #include <vector>
 
 namespace VulkanApp {
+	class CVulkanMemoryAllocator;
+	class CVulkanUploader;
+	class CVulkanDescriptorCache;
+	class CVulkanShaderCache;
 	class CVulkanCore {
 	public:	
-		CVulkanCore(const std::string& applicationName);
+		// A headless core enables no surface or swapchain extensions and needs no presentation support
+		CVulkanCore(const std::string& applicationName, const bool headless = false);
 		~CVulkanCore();
-		const VkInstance GetVkInstance() const { return m_vkInstance; };
-		const VkDevice GetVkLogicalDevice() const { return m_vkLogicalDevice; };
-		const VkPhysicalDevice GetVkPhysicalDevice() const { return m_vkPhysicalDevices; };
+		VkInstance GetVkInstance() const { return m_vkInstance; };
+		VkDevice GetVkLogicalDevice() const { return m_vkLogicalDevice; };
+		VkPhysicalDevice GetVkPhysicalDevice() const { return m_vkPhysicalDevices; };
+		bool IsHeadless() const { return m_headless; };
+		// Queried once while the core is created, the selected device never changes
+		const DeviceCaps& GetDeviceCaps() const { return m_deviceCaps; };
+		// Optional features are enabled whenever the device supports them
+		const VkPhysicalDeviceFeatures& GetEnabledFeatures() const { return m_vkEnabledFeatures; };
+		uint32_t GetMaxDrawIndirectCount() const { return m_maxDrawIndirectCount; };
+		uint32_t GetQueueFamilyIndex() const { return m_queueFamilyIndex; };
+		uint32_t GetTransferQueueFamilyIndex() const { return m_transferQueueFamilyIndex; };
+		VkQueue GetTransferQueue() const { return m_vkTransferQueue; };
+		CVulkanMemoryAllocator* GetAllocator() const { return m_pAllocator; };
+		CVulkanUploader* GetUploader() const { return m_pUploader; };
+		CVulkanDescriptorCache* GetDescriptorCache() const { return m_pDescriptorCache; };
+		CVulkanShaderCache* GetShaderCache() const { return m_pShaderCache; };
+		VkPipelineCache GetVkPipelineCache() const { return m_vkPipelineCache; };
+		bool IsPipelineCacheWarm() const { return m_pipelineCacheWarm; };
+		double GetPipelineCacheLoadTime() const { return m_pipelineCacheLoadMs; };
+		bool SavePipelineCache();
 
 		VkQueue m_vkQueue = VK_NULL_HANDLE; // To be removed
 
 	private:
 		VkResult InitVkInstance() noexcept;
-		VkResult InitVkLogicalDevice(const VkDeviceQueueCreateInfo *const queueCI) noexcept;
+		VkResult InitVkLogicalDevice(const VkDeviceQueueCreateInfo *const queueCI, const uint32_t queueCICount) noexcept;
+		void InitVkPipelineCache();
+		std::vector<uint8_t> LoadPipelineCacheData() const;
 
 		std::string m_applicationName;
+		const bool m_headless = false;
 		VkInstance m_vkInstance = VK_NULL_HANDLE;
 		VkPhysicalDevice m_vkPhysicalDevices = VK_NULL_HANDLE;
 		uint32_t m_physicalDevicesCount = 0u;
+		DeviceCaps m_deviceCaps;
+		VkPhysicalDeviceFeatures m_vkEnabledFeatures = {};
+		uint32_t m_maxDrawIndirectCount = 1u;
 		VkDevice m_vkLogicalDevice = VK_NULL_HANDLE;
 		uint32_t m_queueFamilyIndex = 0u;
+		uint32_t m_transferQueueFamilyIndex = 0u;
+		VkQueue m_vkTransferQueue = VK_NULL_HANDLE;
+		CVulkanMemoryAllocator *m_pAllocator = nullptr;
+		CVulkanUploader *m_pUploader = nullptr;
+		CVulkanDescriptorCache *m_pDescriptorCache = nullptr;
+		CVulkanShaderCache *m_pShaderCache = nullptr;
+
+		// Pipeline cache persisted between runs
+		std::string m_pipelineCachePath;
+		VkPipelineCache m_vkPipelineCache = VK_NULL_HANDLE;
+		uint64_t m_pipelineCacheHash = 0u; // Hash of the data last loaded or stored
+		bool m_pipelineCacheWarm = false;
+		double m_pipelineCacheLoadMs = 0.0;
 	};
 
 }
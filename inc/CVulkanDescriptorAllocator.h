@@ -0,0 +1,54 @@
+#ifndef C_VULKAN_DESCRIPTOR_ALLOCATOR_H_
+#define C_VULKAN_DESCRIPTOR_ALLOCATOR_H_
+
+#include <vulkan/vulkan_core.h>
+
+#include <vector>
+
+/*
+Per frame descriptor sets:
+Sets are allocated from pools owned by a frame slot and are never
+freed one by one. Once the slot fence has been waited on, BeginFrame()
+resets all pools of the slot at once, which costs the same for one
+set or for thousands. A slot which runs out of space takes another
+pool, pools are kept for the following frames. Not thread safe,
+sets belong to the thread recording the frame.
+*/
+
+namespace VulkanApp {
+	class CVulkanCore;
+
+	class CVulkanDescriptorAllocator {
+	public:
+		static constexpr uint32_t cexp_defaultSetsPerPool = 256u;
+
+		CVulkanDescriptorAllocator(const CVulkanCore *const pCore, const uint32_t frameSlotCount, const uint32_t setsPerPool = cexp_defaultSetsPerPool);
+		~CVulkanDescriptorAllocator();
+		CVulkanDescriptorAllocator(const CVulkanDescriptorAllocator&) = delete;
+		CVulkanDescriptorAllocator& operator=(const CVulkanDescriptorAllocator&) = delete;
+
+		// The fence of the slot must have been waited on, sets allocated by its last frame become invalid
+		void BeginFrame(const uint32_t frameSlot);
+		VkDescriptorSet Allocate(const VkDescriptorSetLayout setLayout);
+
+		uint32_t GetPoolCount() const;
+		uint32_t GetAllocatedSetCount() const { return m_allocatedSets; };
+
+	private:
+		struct FrameSlot {
+			std::vector<VkDescriptorPool> m_pools;
+			uint32_t m_currentPool = 0u; // Pools before this one are full
+		};
+
+		VkDescriptorPool CreatePool() const;
+		void Release();
+
+		const CVulkanCore *const m_pCore = nullptr;
+		const uint32_t m_setsPerPool = 0u;
+		std::vector<FrameSlot> m_slots;
+		uint32_t m_currentSlot = 0u;
+		uint32_t m_allocatedSets = 0u; // Since the last BeginFrame()
+	};
+}
+
+#endif // !C_VULKAN_DESCRIPTOR_ALLOCATOR_H_
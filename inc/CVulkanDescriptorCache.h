@@ -0,0 +1,59 @@
+#ifndef C_VULKAN_DESCRIPTOR_CACHE_H_
+#define C_VULKAN_DESCRIPTOR_CACHE_H_
+
+#include <vulkan/vulkan_core.h>
+
+#include <initializer_list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+/*
+Descriptor layout cache:
+Descriptor set layouts and pipeline layouts are looked up by a hash
+of their description and created only once per device, so pipelines
+with the same interface share one layout object and descriptor sets
+made for one of them are compatible with all the others. The cache
+owns every layout it returns, they stay valid until the core is gone.
+*/
+
+namespace VulkanApp {
+	class CVulkanDescriptorCache {
+	public:
+		CVulkanDescriptorCache(const VkDevice device);
+		~CVulkanDescriptorCache();
+		CVulkanDescriptorCache(const CVulkanDescriptorCache&) = delete;
+		CVulkanDescriptorCache& operator=(const CVulkanDescriptorCache&) = delete;
+
+		// Bindings may be given in any order, immutable samplers are not supported
+		VkDescriptorSetLayout GetSetLayout(std::initializer_list<VkDescriptorSetLayoutBinding> bindings);
+		VkDescriptorSetLayout GetSetLayout(const VkDescriptorSetLayoutBinding *pBindings, const uint32_t bindingCount);
+		VkPipelineLayout GetPipelineLayout(std::initializer_list<VkDescriptorSetLayout> setLayouts,
+			std::initializer_list<VkPushConstantRange> pushConstantRanges = {});
+		VkPipelineLayout GetPipelineLayout(const VkDescriptorSetLayout *pSetLayouts, const uint32_t setLayoutCount,
+			const VkPushConstantRange *pPushConstantRanges, const uint32_t pushConstantRangeCount);
+
+		uint32_t GetSetLayoutCount() const;
+		uint32_t GetPipelineLayoutCount() const;
+
+	private:
+		struct SetLayoutEntry {
+			std::vector<VkDescriptorSetLayoutBinding> m_bindings;
+			VkDescriptorSetLayout m_vkSetLayout = VK_NULL_HANDLE;
+		};
+
+		struct PipelineLayoutEntry {
+			std::vector<VkDescriptorSetLayout> m_setLayouts;
+			std::vector<VkPushConstantRange> m_pushConstantRanges;
+			VkPipelineLayout m_vkPipelineLayout = VK_NULL_HANDLE;
+		};
+
+		const VkDevice m_vkDevice = VK_NULL_HANDLE;
+		// Colliding hashes share a bucket, entries are compared in full
+		std::unordered_multimap<uint64_t, SetLayoutEntry> m_setLayouts;
+		std::unordered_multimap<uint64_t, PipelineLayoutEntry> m_pipelineLayouts;
+		mutable std::mutex m_mutex;
+	};
+}
+
+#endif // !C_VULKAN_DESCRIPTOR_CACHE_H_
@@ -0,0 +1,102 @@
+#ifndef C_VULKAN_DRAW_LIST_H_
+#define C_VULKAN_DRAW_LIST_H_
+
+#include <vulkan/vulkan_core.h>
+
+#include <vector>
+
+/*
+Draw lists:
+Draw packets collected during a frame are sorted by pipeline and
+buffers, packets sharing all of them form a batch which needs a single
+set of binds. Build() writes one indirect command per packet into the
+host visible buffer of the frame slot, so with multiDrawIndirect every
+batch costs one vkCmdDraw(Indexed)Indirect call no matter how many
+objects it holds. Devices without it get plain draws in the same order.
+Small per draw parameters go through push constants, the data is kept
+in the list and pushed right before the draw, so batches using them
+are drawn directly and need no descriptor set per object.
+*/
+
+namespace VulkanApp {
+	class CVulkanCore;
+	class CVulkanBuffer;
+
+	struct DrawPacket {
+		static constexpr uint32_t cexp_maxVertexBuffers = 4u;
+		static constexpr uint32_t cexp_maxDynamicOffsets = 2u;
+
+		VkPipeline m_pipeline = VK_NULL_HANDLE;
+		VkPipelineLayout m_pipelineLayout = VK_NULL_HANDLE; // Required with a descriptor set or push constants
+		VkDescriptorSet m_descriptorSet = VK_NULL_HANDLE; // Bound to set 0, none when null
+		uint32_t m_dynamicOffsets[cexp_maxDynamicOffsets] = {}; // E.g. the offsets of ring buffer allocations
+		uint32_t m_dynamicOffsetCount = 0u;
+		VkBuffer m_vertexBuffers[cexp_maxVertexBuffers] = {}; // One per binding of the pipeline layout, instance rate streams included
+		VkDeviceSize m_vertexBufferOffsets[cexp_maxVertexBuffers] = {};
+		uint32_t m_vertexBufferCount = 0u;
+		VkBuffer m_indexBuffer = VK_NULL_HANDLE; // Non-indexed draw when null
+		VkDeviceSize m_indexBufferOffset = 0u;
+		VkIndexType m_indexType = VK_INDEX_TYPE_UINT32;
+		uint32_t m_count = 0u; // Indices, or vertices of a non-indexed draw
+		uint32_t m_first = 0u; // First index, or first vertex of a non-indexed draw
+		int32_t m_vertexOffset = 0; // Added to every index, unused without an index buffer
+		uint32_t m_instanceCount = 1u;
+		uint32_t m_firstInstance = 0u;
+		// Filled in by CVulkanDrawList::Add()
+		VkShaderStageFlags m_pushConstantStages = 0u;
+		uint32_t m_pushConstantSize = 0u;
+		uint32_t m_pushConstantOffset = 0u; // In the push constant data of the list
+
+		// Throws when the binding is not below cexp_maxVertexBuffers
+		void SetVertexBuffer(const uint32_t binding, const VkBuffer buffer, const VkDeviceSize offset = 0u);
+	};
+
+	class CVulkanDrawList {
+	public:
+		static constexpr uint32_t cexp_defaultCapacity = 4096u;
+		static constexpr uint32_t cexp_maxPushConstantSize = 128u; // Minimum of maxPushConstantsSize every device supports
+		// Both command types share one slot size, so command i always starts at i * stride
+		static constexpr uint32_t cexp_commandStride = static_cast<uint32_t>(sizeof(VkDrawIndexedIndirectCommand));
+
+		CVulkanDrawList(const CVulkanCore *const pCore, const uint32_t frameSlotCount, const uint32_t capacity = cexp_defaultCapacity, const bool useIndirect = true);
+		~CVulkanDrawList();
+		CVulkanDrawList(const CVulkanDrawList&) = delete;
+		CVulkanDrawList& operator=(const CVulkanDrawList&) = delete;
+
+		void Clear();
+		void Add(const DrawPacket &packet);
+		// The data is copied and pushed at offset 0 of the layout range before the draw
+		void Add(const DrawPacket &packet, const void *pushConstants, const uint32_t byteSize, const VkShaderStageFlags stages);
+		// The slot fence has to be signaled, the indirect buffer of the slot is rewritten and may grow
+		void Build(const uint32_t frameSlot);
+		// Records draws [firstDraw, firstDraw + drawCount) of the built list, safe to call from several threads
+		void Record(const VkCommandBuffer commandBuffer, const uint32_t firstDraw, const uint32_t drawCount) const;
+
+		uint32_t GetDrawCount() const { return static_cast<uint32_t>(m_packets.size()); };
+		uint32_t GetBatchCount() const { return static_cast<uint32_t>(m_batches.size()); };
+		bool UsesIndirect() const { return m_useIndirect; };
+
+	private:
+		struct Batch {
+			uint32_t m_firstDraw = 0u;
+			uint32_t m_drawCount = 0u;
+			bool m_indirect = false;
+		};
+
+		static bool SharesBinds(const DrawPacket &a, const DrawPacket &b);
+		void Release();
+
+		const CVulkanCore *const m_pCore = nullptr;
+		const bool m_useIndirect = false;
+		const bool m_firstInstanceSupported = false;
+		const uint32_t m_maxDrawIndirectCount = 1u;
+		std::vector<DrawPacket> m_packets;
+		std::vector<uint8_t> m_pushConstantData;
+		std::vector<Batch> m_batches;
+		std::vector<CVulkanBuffer*> m_indirectBuffers; // One per frame slot
+		std::vector<uint32_t> m_capacities;
+		uint32_t m_builtSlot = UINT32_MAX;
+	};
+}
+
+#endif // !C_VULKAN_DRAW_LIST_H_
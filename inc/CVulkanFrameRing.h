@@ -0,0 +1,59 @@
+#ifndef C_VULKAN_FRAME_RING_H_
+#define C_VULKAN_FRAME_RING_H_
+
+#include <vulkan/vulkan_core.h>
+
+#include <vector>
+
+/*
+Frames in flight:
+Every slot of the ring owns the resources required to record
+and submit a single frame. While the GPU consumes slot N the
+CPU is free to record slot N+1, the slot fence is the only
+point where the CPU waits for the GPU.
+*/
+
+namespace VulkanApp {
+	class CVulkanCore;
+
+	struct FrameContext {
+		VkCommandPool m_vkCommandPool = VK_NULL_HANDLE;
+		VkCommandBuffer m_vkCommandBuffer = VK_NULL_HANDLE;
+		VkSemaphore m_vkImageAcquiredSem = VK_NULL_HANDLE;
+		VkFence m_vkInFlightFence = VK_NULL_HANDLE;
+		uint32_t m_imageIndex = UINT32_MAX; // Swapchain image rendered by the slot last time
+		uint64_t m_frameNumber = 0u; // Number of the last frame submitted from the slot
+		double m_acquireToPresentMs = 0.0; // CPU time from image acquisition to presentation of that frame
+	};
+
+	class CVulkanFrameRing {
+	public:
+		static constexpr uint32_t cexp_minFramesInFlight = 1u;
+		static constexpr uint32_t cexp_maxFramesInFlight = 3u;
+
+		CVulkanFrameRing(const CVulkanCore *const pCore, const uint32_t framesInFlight, const uint32_t imageCount);
+		~CVulkanFrameRing();
+		FrameContext& BeginFrame();
+		void SetImageIndex(const uint32_t imageIndex);
+		void EndFrame();
+		void WaitIdle() const;
+		void SetImageCount(const uint32_t imageCount);
+		uint32_t GetFramesInFlight() const { return static_cast<uint32_t>(m_frames.size()); };
+		uint32_t GetCurrentSlot() const { return m_currentSlot; };
+		FrameContext& GetCurrentFrame() { return m_frames[m_currentSlot]; };
+		uint64_t GetLastSubmittedFrame() const { return m_submittedFrames; };
+		uint64_t GetCompletedFrame() const { return m_completedFrame; };
+
+	private:
+		void Release();
+
+		const CVulkanCore *const m_pCore = nullptr;
+		std::vector<FrameContext> m_frames;
+		std::vector<VkFence> m_imagesInFlight; // Fence of the slot which is rendering to the image
+		uint32_t m_currentSlot = 0u;
+		uint64_t m_submittedFrames = 0u;
+		uint64_t m_completedFrame = 0u; // Frames up to this number are finished on the GPU
+	};
+}
+
+#endif // !C_VULKAN_FRAME_RING_H_
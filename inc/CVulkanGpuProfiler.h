@@ -0,0 +1,68 @@
+#ifndef C_VULKAN_GPU_PROFILER_H_
+#define C_VULKAN_GPU_PROFILER_H_
+
+#include <CRollingStats.h>
+
+#include <vulkan/vulkan_core.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+/*
+GPU profiler:
+Named scopes are bracketed with timestamp queries written into
+the command buffer of a frame slot. Results of a slot are read
+back when the slot is recorded again, at that point the frame
+fence guarantees that they are available, so the readback never
+blocks. Devices whose queue reports no valid timestamp bits get
+a disabled profiler and every call becomes a no-op.
+*/
+
+namespace VulkanApp {
+	class CVulkanCore;
+
+	class CVulkanGpuProfiler {
+	public:
+		static constexpr uint32_t cexp_defaultMaxScopes = 16u;
+		static constexpr uint32_t cexp_invalidScope = UINT32_MAX;
+
+		// Statistics of each scope cover its latest statisticsWindow frames
+		CVulkanGpuProfiler(const CVulkanCore *const pCore, const uint32_t frameSlotCount, const uint32_t maxScopesPerFrame = cexp_defaultMaxScopes,
+			const uint32_t statisticsWindow = CRollingStats::cexp_defaultWindow);
+		~CVulkanGpuProfiler();
+		CVulkanGpuProfiler(const CVulkanGpuProfiler&) = delete;
+		CVulkanGpuProfiler& operator=(const CVulkanGpuProfiler&) = delete;
+
+		// Has to be recorded outside of a render pass, before any scope of the frame
+		void BeginFrame(const VkCommandBuffer commandBuffer, const uint32_t frameSlot);
+		// Reads back the slots that were not recorded again, oldest first. Only once the device is idle.
+		void ResolveAll();
+		uint32_t BeginScope(const VkCommandBuffer commandBuffer, const std::string &name);
+		void EndScope(const VkCommandBuffer commandBuffer, const uint32_t scope);
+
+		bool IsEnabled() const { return m_vkQueryPool != VK_NULL_HANDLE; };
+		const std::map<std::string, CRollingStats>& GetStatistics() const { return m_statistics; };
+
+	private:
+		struct FrameScopes {
+			std::vector<std::string> m_names; // Scope i owns queries 2i and 2i+1 of the slot
+			std::vector<bool> m_closed;
+		};
+
+		void Resolve(const uint32_t frameSlot);
+
+		const CVulkanCore *const m_pCore = nullptr;
+		const uint32_t m_maxScopes = cexp_defaultMaxScopes;
+		const uint32_t m_statisticsWindow = CRollingStats::cexp_defaultWindow;
+		VkQueryPool m_vkQueryPool = VK_NULL_HANDLE;
+		double m_nsPerTick = 1.0;
+		uint64_t m_validMask = 0u;
+		std::vector<FrameScopes> m_frames;
+		uint32_t m_currentSlot = 0u;
+		std::vector<uint64_t> m_results; // Timestamp and availability pairs
+		std::map<std::string, CRollingStats> m_statistics; // In milliseconds
+	};
+}
+
+#endif // !C_VULKAN_GPU_PROFILER_H_
@@ -0,0 +1,114 @@
+#ifndef C_VULKAN_MEMORY_ALLOCATOR_H_
+#define C_VULKAN_MEMORY_ALLOCATOR_H_
+
+#include <vulkan/vulkan_core.h>
+
+#include <vector>
+#include <map>
+#include <mutex>
+
+/*
+Device memory sub-allocator:
+Device memory is allocated in large blocks per memory type and
+handed out as aligned (offset, size) ranges of those blocks. It
+keeps the number of vkAllocateMemory calls far below
+maxMemoryAllocationCount. Host visible blocks are mapped once
+for their whole lifetime, suballocations receive a pointer into
+that mapping. Suballocations of non coherent types are aligned to
+nonCoherentAtomSize, so flushing one never has to touch a neighbour.
+*/
+
+namespace VulkanApp {
+
+	// Resources of different kind placed next to each other have to respect bufferImageGranularity
+	enum class AllocationKind : uint8_t {
+		Linear,		// Buffers and linearly tiled images
+		Optimal		// Optimally tiled images
+	};
+
+	struct MemoryAllocation {
+		VkDeviceMemory m_vkMemory = VK_NULL_HANDLE;
+		VkDeviceSize m_offset = 0u;
+		VkDeviceSize m_size = 0u;
+		void *m_pMappedData = nullptr;
+		uint32_t m_memoryTypeIndex = UINT32_MAX;
+		uint32_t m_blockIndex = UINT32_MAX;
+		bool IsValid() const { return m_vkMemory != VK_NULL_HANDLE; };
+	};
+
+	struct MemoryStatistics {
+		uint32_t m_blockCount = 0u;
+		uint32_t m_allocationCount = 0u;
+		uint32_t m_freeRangeCount = 0u;
+		VkDeviceSize m_blockBytes = 0u;		// Memory obtained from the driver
+		VkDeviceSize m_allocatedBytes = 0u;	// Memory handed out to resources
+		VkDeviceSize m_largestFreeRange = 0u;
+	};
+
+	class CVulkanMemoryAllocator {
+	public:
+		static constexpr VkDeviceSize cexp_defaultBlockSize = 64ull * 1024ull * 1024ull;
+
+		CVulkanMemoryAllocator(const VkPhysicalDevice physicalDevice, const VkDevice device, const VkDeviceSize blockSize = cexp_defaultBlockSize);
+		~CVulkanMemoryAllocator();
+		CVulkanMemoryAllocator(const CVulkanMemoryAllocator&) = delete;
+		CVulkanMemoryAllocator& operator=(const CVulkanMemoryAllocator&) = delete;
+
+		MemoryAllocation Allocate(const VkMemoryRequirements &requirements, const VkMemoryPropertyFlags requiredFlags,
+			const VkMemoryPropertyFlags preferredFlags, const AllocationKind kind);
+		MemoryAllocation AllocateForBuffer(const VkBuffer buffer, const VkMemoryPropertyFlags requiredFlags, const VkMemoryPropertyFlags preferredFlags);
+		MemoryAllocation AllocateForImage(const VkImage image, const VkImageTiling tiling, const VkMemoryPropertyFlags requiredFlags, const VkMemoryPropertyFlags preferredFlags);
+		void Free(MemoryAllocation &allocation);
+		// Makes host writes to a range of the allocation visible to the device, nothing to do for coherent memory
+		void Flush(const MemoryAllocation &allocation, const VkDeviceSize offset, const VkDeviceSize size) const;
+		bool IsCoherent(const MemoryAllocation &allocation) const;
+
+		uint32_t FindMemoryType(const uint32_t memoryTypeBits, const VkMemoryPropertyFlags requiredFlags, const VkMemoryPropertyFlags preferredFlags) const;
+		VkMemoryPropertyFlags GetMemoryTypeFlags(const uint32_t memoryTypeIndex) const { return m_memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags; };
+		MemoryStatistics GetStatistics() const;
+		MemoryStatistics GetStatistics(const uint32_t memoryTypeIndex) const;
+
+	private:
+		struct Suballocation {
+			VkDeviceSize m_size = 0u;
+			AllocationKind m_kind = AllocationKind::Linear;
+		};
+
+		struct FreeRange {
+			VkDeviceSize m_offset = 0u;
+			VkDeviceSize m_size = 0u;
+		};
+
+		struct MemoryBlock {
+			VkDeviceMemory m_vkMemory = VK_NULL_HANDLE;
+			VkDeviceSize m_size = 0u;
+			VkDeviceSize m_allocatedBytes = 0u;
+			void *m_pMappedData = nullptr;
+			uint32_t m_memoryTypeIndex = UINT32_MAX;
+			bool m_dedicated = false;
+			std::map<VkDeviceSize, Suballocation> m_suballocations; // Keyed by offset
+			std::vector<FreeRange> m_freeRanges; // Sorted by offset, never adjacent
+		};
+
+		bool AllocateFromBlock(MemoryBlock &block, const VkDeviceSize size, const VkDeviceSize alignment,
+			const AllocationKind kind, VkDeviceSize *pOffsetOut);
+		MemoryAllocation AllocateFromType(const uint32_t memoryTypeIndex, const VkDeviceSize size,
+			const VkDeviceSize alignment, const AllocationKind kind);
+		void FreeInBlock(MemoryBlock &block, const VkDeviceSize offset);
+		uint32_t CreateBlock(const uint32_t memoryTypeIndex, const VkDeviceSize minSize, const bool dedicated);
+		void DestroyBlock(const uint32_t blockIndex);
+		void AccumulateStatistics(const MemoryBlock &block, MemoryStatistics &stats) const;
+		uint32_t GetBlockCount() const;
+
+		const VkDevice m_vkDevice = VK_NULL_HANDLE;
+		const VkDeviceSize m_blockSize = cexp_defaultBlockSize;
+		VkDeviceSize m_bufferImageGranularity = 1u;
+		VkDeviceSize m_nonCoherentAtomSize = 1u;
+		uint32_t m_maxAllocationCount = UINT32_MAX;
+		VkPhysicalDeviceMemoryProperties m_memoryProperties = {};
+		std::vector<MemoryBlock*> m_blocks; // Released blocks leave a null entry so indices stay stable
+		mutable std::mutex m_mutex;
+	};
+}
+
+#endif // !C_VULKAN_MEMORY_ALLOCATOR_H_
@@ -0,0 +1,63 @@
+#ifndef C_VULKAN_OFFSCREEN_TARGET_H_
+#define C_VULKAN_OFFSCREEN_TARGET_H_
+
+#include <CVulkanMemoryAllocator.h>
+
+#include <vulkan/vulkan_core.h>
+
+#include <vector>
+
+/*
+Offscreen target:
+Color images rendered in place of swapchain images when there
+is no window. Each image has a framebuffer of the given render
+pass and, when readback is requested, a host visible buffer the
+image is copied into at the end of the frame.
+*/
+
+namespace VulkanApp {
+	class CVulkanCore;
+	class CVulkanBuffer;
+
+	class CVulkanOffscreenTarget {
+	public:
+		CVulkanOffscreenTarget(const CVulkanCore *const pCore, const VkRenderPass renderPass, const VkFormat format,
+			const uint32_t width, const uint32_t height, const uint32_t imageCount, const bool readback);
+		~CVulkanOffscreenTarget();
+		CVulkanOffscreenTarget(const CVulkanOffscreenTarget&) = delete;
+		CVulkanOffscreenTarget& operator=(const CVulkanOffscreenTarget&) = delete;
+
+		uint32_t GetImageCount() const { return static_cast<uint32_t>(m_images.size()); };
+		VkExtent2D GetExtent() const { return m_extent; };
+		VkFormat GetFormat() const { return m_format; };
+		VkFramebuffer GetFramebuffer(const uint32_t index) const;
+		VkImage GetImage(const uint32_t index) const;
+		bool HasReadback() const { return m_readback; };
+
+		// Records the copy of the image into its readback buffer, after the render pass
+		void RecordReadback(const VkCommandBuffer commandBuffer, const uint32_t index) const;
+		// Tightly packed pixels, valid once the frame which recorded the readback has finished
+		const void* GetReadbackData(const uint32_t index) const;
+		VkDeviceSize GetReadbackSize() const { return m_readbackSize; };
+
+	private:
+		struct OffscreenImage {
+			VkImage m_vkImage = VK_NULL_HANDLE;
+			MemoryAllocation m_allocation;
+			VkImageView m_vkImageView = VK_NULL_HANDLE;
+			VkFramebuffer m_vkFramebuffer = VK_NULL_HANDLE;
+			CVulkanBuffer *m_pReadbackBuffer = nullptr;
+		};
+
+		void Release();
+
+		const CVulkanCore *const m_pCore = nullptr;
+		const VkFormat m_format = VK_FORMAT_UNDEFINED;
+		const VkExtent2D m_extent = {};
+		const bool m_readback = false;
+		VkDeviceSize m_readbackSize = 0u;
+		std::vector<OffscreenImage> m_images;
+	};
+}
+
+#endif // !C_VULKAN_OFFSCREEN_TARGET_H_
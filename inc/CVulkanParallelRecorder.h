@@ -0,0 +1,90 @@
+#ifndef C_VULKAN_PARALLEL_RECORDER_H_
+#define C_VULKAN_PARALLEL_RECORDER_H_
+
+#include <vulkan/vulkan_core.h>
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+Parallel recording:
+A range of draws is split into contiguous chunks, every chunk is
+recorded into a secondary command buffer by its own thread and the
+buffers are returned in draw order, ready for vkCmdExecuteCommands.
+Command pools are owned by a single thread and a single frame slot,
+so recording never takes a lock and a whole slot is recycled with
+one vkResetCommandPool per thread once the slot fence has retired.
+The calling thread records the first chunk itself.
+*/
+
+namespace VulkanApp {
+	class CVulkanCore;
+
+	class CVulkanParallelRecorder {
+	public:
+		// Records draws [first, first + count) into a secondary command buffer which is already begun
+		using RecordFunction = std::function<void(VkCommandBuffer commandBuffer, uint32_t first, uint32_t count)>;
+
+		static constexpr uint32_t cexp_defaultMinDrawsPerThread = 256u;
+
+		// Thread count 0 uses every hardware thread, the calling thread included
+		CVulkanParallelRecorder(const CVulkanCore *const pCore, const uint32_t frameSlotCount, const uint32_t threadCount = 0u,
+			const uint32_t minDrawsPerThread = cexp_defaultMinDrawsPerThread);
+		~CVulkanParallelRecorder();
+		CVulkanParallelRecorder(const CVulkanParallelRecorder&) = delete;
+		CVulkanParallelRecorder& operator=(const CVulkanParallelRecorder&) = delete;
+
+		// The slot fence has to be signaled, every buffer recorded for the slot is recycled
+		void BeginFrame(const uint32_t frameSlot);
+		const std::vector<VkCommandBuffer>& Record(const uint32_t frameSlot, const VkCommandBufferInheritanceInfo &inheritanceInfo,
+			const uint32_t drawCount, const RecordFunction &recordFunction);
+
+		uint32_t GetThreadCount() const { return static_cast<uint32_t>(m_contexts.size()); };
+		// Below this many draws a single thread records and a secondary buffer is not worth it
+		uint32_t GetMinDrawsPerThread() const { return m_minDrawsPerThread; };
+
+	private:
+		struct SlotBuffers {
+			VkCommandPool m_vkCommandPool = VK_NULL_HANDLE;
+			std::vector<VkCommandBuffer> m_buffers;
+			uint32_t m_usedCount = 0u; // Buffers handed out since the last BeginFrame
+		};
+
+		struct ThreadContext {
+			std::vector<SlotBuffers> m_slots;
+			std::exception_ptr m_exception;
+		};
+
+		struct Job {
+			uint32_t m_frameSlot = 0u;
+			const VkCommandBufferInheritanceInfo *m_pInheritanceInfo = nullptr;
+			const RecordFunction *m_pRecordFunction = nullptr;
+			uint32_t m_drawCount = 0u;
+			uint32_t m_chunkCount = 0u;
+		};
+
+		void WorkerProcedure(const uint32_t threadIndex);
+		void RecordChunk(const uint32_t threadIndex);
+		void Release();
+
+		const CVulkanCore *const m_pCore = nullptr;
+		const uint32_t m_minDrawsPerThread = cexp_defaultMinDrawsPerThread;
+		std::vector<ThreadContext> m_contexts; // Index 0 belongs to the calling thread
+		std::vector<std::thread> m_workers;
+		std::vector<VkCommandBuffer> m_recorded;
+
+		std::mutex m_mutex;
+		std::condition_variable m_jobReady;
+		std::condition_variable m_jobDone;
+		Job m_job;
+		uint64_t m_jobGeneration = 0u;
+		uint32_t m_pendingChunks = 0u;
+		bool m_exit = false;
+	};
+}
+
+#endif // !C_VULKAN_PARALLEL_RECORDER_H_
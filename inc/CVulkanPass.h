@@ -10,33 +10,54 @@
 
 namespace VulkanApp {
 	class CVulkanCore;
+	class CVulkanGpuProfiler;
+	class CVulkanParallelRecorder;
+	class CVulkanDrawList;
 	class CVulkanPass {
 	public:
-		CVulkanPass(const CVulkanCore *const pCore, const VkFormat surfaceFormat);
+		// Offscreen targets which are read back end in VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL
+		CVulkanPass(const CVulkanCore *const pCore, const VkFormat surfaceFormat, const VkImageLayout finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
 		~CVulkanPass();
 		void Initialize();
 		void Release();
-		const VkRenderPass GetHandle() const { return m_vkRenderPass; };
-		void SubmitWorkload(VkQueue queue,
-			VkBuffer vertexBuffer,
-			VkPipeline pipeline,
+		VkRenderPass GetHandle() const { return m_vkRenderPass; };
+		void SubmitWorkload(VkCommandBuffer commandBuffer,
+			VkQueue queue,
+			const CVulkanDrawList &drawList,
 			VkSemaphore waitSemaphore,
+			VkSemaphore uploadSemaphore,
 			VkSemaphore signalSemaphore,
 			VkFence raiseFence,
 			VkFramebuffer renderTarget,
-			VkRect2D renderArea);
+			VkRect2D renderArea,
+			CVulkanGpuProfiler *pProfiler = nullptr,
+			uint32_t frameSlot = 0u,
+			CVulkanParallelRecorder *pRecorder = nullptr);
+		// The draw list has to be built for the frame slot. With a recorder, lists drawn without
+		// indirect commands are split over secondary command buffers once they are long enough
+		void RecordWorkload(VkCommandBuffer commandBuffer,
+			const CVulkanDrawList &drawList,
+			VkFramebuffer renderTarget,
+			VkRect2D renderArea,
+			CVulkanGpuProfiler *pProfiler = nullptr,
+			uint32_t frameSlot = 0u,
+			CVulkanParallelRecorder *pRecorder = nullptr);
+		// Dynamic state is not inherited by secondary command buffers, each of them sets it again
+		static void RecordDynamicState(VkCommandBuffer commandBuffer, VkRect2D renderArea);
+		static void SubmitCommandBuffer(VkQueue queue,
+			VkCommandBuffer commandBuffer,
+			VkSemaphore waitSemaphore,
+			VkSemaphore uploadSemaphore,
+			VkSemaphore signalSemaphore,
+			VkFence raiseFence);
 
 		VkAttachmentDescription m_attachmentDesc = {};
 		VkAttachmentReference m_colorAttachmentRef = {};
 		VkSubpassDescription m_subpassDesc = {};
-		VkSubpassDependency m_dependency{};
+		VkSubpassDependency m_dependencies[2] = {};
 		VkRenderPassCreateInfo m_renderPassCI = {};
-		VkCommandPoolCreateInfo m_vkCommandPoolCI = {};
-		VkCommandBufferAllocateInfo m_vkCommandBufferCI = {};
 
 	private:
-		VkCommandBuffer m_vkCommandBuffer = VK_NULL_HANDLE;
-
 		const CVulkanCore *const m_pCore = nullptr;
 		VkRenderPass m_vkRenderPass = VK_NULL_HANDLE;
 	};
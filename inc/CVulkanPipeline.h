@@ -2,6 +2,7 @@
 #define  C_VULKAN_PIPELINE_H_
 
 #include <CVulkanBuffer.h>
+#include <CSpecializationConstants.h>
 
 #ifndef VULKAN_H_
 #include <vulkan/vulkan.h>
@@ -15,18 +16,26 @@ namespace VulkanApp {
 	class CVulkanCore;
 	class CVulkanPipeline {
 	public:
-		CVulkanPipeline(const CVulkanCore * const pCore, const CVulkanPass *const pPass, const uint32_t vpWidth, const uint32_t vpHeight, const VkPipelineShaderStageCreateInfo *const shaderStages, const CBufferLayout vertexLayout);
+		// Without a layout, one matching m_pipelineLayoutCI is taken from the descriptor cache of the core.
+		// The two stages are copied with their pSpecializationInfo, the caller's structures may go away.
+		CVulkanPipeline(const CVulkanCore * const pCore, const CVulkanPass *const pPass, const VkPipelineShaderStageCreateInfo *const shaderStages, const CBufferLayout vertexLayout,
+			const VkPipelineLayout layout = VK_NULL_HANDLE);
+		// The descriptions have to outlive the pipeline, e.g. TVertexLayout<...>::cexp_inputState
+		CVulkanPipeline(const CVulkanCore * const pCore, const CVulkanPass *const pPass, const VkPipelineShaderStageCreateInfo *const shaderStages,
+			const VkPipelineVertexInputStateCreateInfo &vertexInputState, const VkPipelineLayout layout = VK_NULL_HANDLE);
 		~CVulkanPipeline();
 		VkPipeline GetHandle() const { return m_vkPipeline; };
+		// Owned by the descriptor cache, shared with every pipeline of the same interface
+		VkPipelineLayout GetLayout() const { return m_pipelineCI.layout; };
 		void Update();
+		double GetLastCreationTime() const { return m_lastCreationMs; };
 		void SetVertexBufferLayout(const CBufferLayout layout);
-		static VkShaderModule LoadCompiledShader(const VkDevice device, const std::string& filePath);
 		
 		VkPipelineVertexInputStateCreateInfo m_vertexInputStateCI = {};
 		VkPipelineInputAssemblyStateCreateInfo m_inputAssemblyCI = {};
-		VkViewport m_viewport = {};
-		VkRect2D m_scissorRect = {};
 		VkPipelineViewportStateCreateInfo m_viewportStateCI = {};
+		VkDynamicState m_dynamicStates[2] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+		VkPipelineDynamicStateCreateInfo m_dynamicStateCI = {};
 		VkPipelineRasterizationStateCreateInfo m_rasterizerStateCI = {};
 		VkPipelineMultisampleStateCreateInfo m_multisamplingStateCI = {};
 		VkPipelineColorBlendAttachmentState m_colorBlendAttachmentCI = {};
@@ -35,10 +44,19 @@ namespace VulkanApp {
 		VkGraphicsPipelineCreateInfo m_pipelineCI = {};
 
 	private:
+		void Setup(const CVulkanPass *const pPass, const VkPipelineShaderStageCreateInfo *const shaderStages);
 		void Release();
 
+		VkPipelineShaderStageCreateInfo m_shaderStages[2] = {};
+		CSpecializationConstants m_specializations[2]; // Storage of m_shaderStages[i].pSpecializationInfo
+
+		std::vector<VkVertexInputBindingDescription> m_vertexBindingDescs;
+		std::vector<VkVertexInputAttributeDescription> m_vertexAttributeDescs;
+
 		VkPipeline m_vkPipeline = VK_NULL_HANDLE;
+		VkPipelineLayout m_vkLayout = VK_NULL_HANDLE; // Given at construction, otherwise looked up on every update
 		const CVulkanCore *const m_pCore = nullptr;
+		double m_lastCreationMs = 0.0;
 	};
 }
 
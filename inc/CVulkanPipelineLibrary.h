@@ -0,0 +1,125 @@
+#ifndef C_VULKAN_PIPELINE_LIBRARY_H_
+#define C_VULKAN_PIPELINE_LIBRARY_H_
+
+#include <vulkan/vulkan_core.h>
+#include <CSpecializationConstants.h>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/*
+Pipeline library:
+Graphics pipelines are looked up by a hash of their whole state, equal
+states share one VkPipeline. A state which has not been seen before is
+queued for the worker threads and Get() returns the fallback given by
+the caller until it is ready, so a new material never stalls the frame,
+its draws use the fallback or are skipped for a few frames instead.
+Compilation goes through the pipeline cache of the core, which is
+internally synchronized. Pipelines live as long as the library. A state
+which failed to compile keeps its error, see GetStatus(), until
+Prepare() queues it again.
+*/
+
+namespace VulkanApp {
+	class CVulkanCore;
+
+	// Everything a graphics pipeline is built from, viewport and scissor are dynamic
+	struct GraphicsPipelineState {
+		VkShaderModule m_vertexShader = VK_NULL_HANDLE;
+		VkShaderModule m_fragmentShader = VK_NULL_HANDLE;
+		// Every set of values is a variant of its own
+		CSpecializationConstants m_vertexSpecialization;
+		CSpecializationConstants m_fragmentSpecialization;
+		std::vector<VkVertexInputBindingDescription> m_vertexBindings;
+		std::vector<VkVertexInputAttributeDescription> m_vertexAttributes;
+		VkPrimitiveTopology m_topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+		VkPolygonMode m_polygonMode = VK_POLYGON_MODE_FILL;
+		VkCullModeFlags m_cullMode = VK_CULL_MODE_BACK_BIT;
+		VkFrontFace m_frontFace = VK_FRONT_FACE_CLOCKWISE;
+		VkSampleCountFlagBits m_samples = VK_SAMPLE_COUNT_1_BIT;
+		VkBool32 m_blendEnable = VK_FALSE;
+		VkBlendFactor m_srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
+		VkBlendFactor m_dstColorBlendFactor = VK_BLEND_FACTOR_ZERO;
+		VkBlendOp m_colorBlendOp = VK_BLEND_OP_ADD;
+		VkBlendFactor m_srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+		VkBlendFactor m_dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+		VkBlendOp m_alphaBlendOp = VK_BLEND_OP_ADD;
+		VkColorComponentFlags m_colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+		VkPipelineLayout m_layout = VK_NULL_HANDLE; // E.g. from the descriptor cache of the core
+		VkRenderPass m_renderPass = VK_NULL_HANDLE;
+		uint32_t m_subpass = 0u;
+
+		// Copies the descriptions, e.g. from TVertexLayout<...>::cexp_inputState
+		void SetVertexInput(const VkPipelineVertexInputStateCreateInfo &vertexInputState);
+		// Same for equal states within a run, shader modules and other handles are part of it
+		uint64_t GetHash() const;
+		bool operator==(const GraphicsPipelineState &other) const;
+	};
+
+	enum class PipelineStatus {
+		Unknown, // Never requested
+		Pending, // Queued or compiling
+		Ready,
+		Failed
+	};
+
+	class CVulkanPipelineLibrary {
+	public:
+		// Worker count 0 leaves one hardware thread to the caller
+		CVulkanPipelineLibrary(const CVulkanCore *const pCore, const uint32_t workerCount = 0u);
+		~CVulkanPipelineLibrary();
+		CVulkanPipelineLibrary(const CVulkanPipelineLibrary&) = delete;
+		CVulkanPipelineLibrary& operator=(const CVulkanPipelineLibrary&) = delete;
+
+		// Never blocks, returns the fallback while the pipeline is compiling or when it failed to compile
+		VkPipeline Get(const GraphicsPipelineState &state, const VkPipeline fallback = VK_NULL_HANDLE);
+		// Waits for the pipeline, throws when it cannot be compiled
+		VkPipeline GetBlocking(const GraphicsPipelineState &state);
+		// Queues the state without waiting, e.g. for materials about to be used, failed states are compiled again
+		void Prepare(const GraphicsPipelineState &state);
+		void WaitIdle();
+		// Does not queue the state, the error is filled in when it failed
+		PipelineStatus GetStatus(const GraphicsPipelineState &state, std::string *pError = nullptr) const;
+
+		uint32_t GetPipelineCount() const; // Compiled successfully
+		uint32_t GetPendingCount() const;
+		uint32_t GetWorkerCount() const { return static_cast<uint32_t>(m_workers.size()); };
+		double GetTotalCompileTime() const;
+
+	private:
+		struct Entry {
+			GraphicsPipelineState m_state;
+			VkPipeline m_vkPipeline = VK_NULL_HANDLE;
+			PipelineStatus m_status = PipelineStatus::Pending;
+			std::string m_error;
+		};
+
+		// Caller holds m_mutex
+		Entry& FindOrQueue(const GraphicsPipelineState &state);
+		const Entry* Find(const GraphicsPipelineState &state) const;
+		void Queue(Entry &entry);
+		VkPipeline Compile(const GraphicsPipelineState &state) const;
+		void WorkerProcedure();
+		void Release();
+
+		const CVulkanCore *const m_pCore = nullptr;
+		std::vector<std::thread> m_workers;
+
+		mutable std::mutex m_mutex;
+		std::condition_variable m_jobReady;
+		std::condition_variable m_jobDone;
+		// Node based, entries keep their address while the map grows
+		std::unordered_multimap<uint64_t, Entry> m_entries;
+		std::deque<Entry*> m_queue;
+		uint32_t m_pendingCount = 0u; // Queued or compiling
+		double m_totalCompileMs = 0.0;
+		bool m_exit = false;
+	};
+}
+
+#endif // !C_VULKAN_PIPELINE_LIBRARY_H_
@@ -0,0 +1,68 @@
+#ifndef C_VULKAN_RING_BUFFER_H_
+#define C_VULKAN_RING_BUFFER_H_
+
+#include <vulkan/vulkan_core.h>
+
+#include <vector>
+
+/*
+Streaming ring buffer:
+Per frame data such as uniforms or streamed vertices is written into
+one persistently mapped buffer, allocations are handed out linearly
+and wrap around at its end. Every frame slot remembers how far the
+ring was filled when it was recorded. Once the slot fence has been
+waited on, BeginFrame() releases everything up to that point, so the
+CPU never overwrites data the GPU may still read. Not thread safe,
+allocations belong to the thread recording the frame.
+*/
+
+namespace VulkanApp {
+	class CVulkanCore;
+	class CVulkanBuffer;
+
+	struct RingAllocation {
+		VkBuffer m_vkBuffer = VK_NULL_HANDLE;
+		VkDeviceSize m_offset = 0u;
+		VkDeviceSize m_size = 0u;
+		void *m_pData = nullptr; // Mapped pointer to m_offset
+	};
+
+	class CVulkanRingBuffer {
+	public:
+		static constexpr VkDeviceSize cexp_maxAlignment = 256u; // Upper bound of minUniformBufferOffsetAlignment
+
+		CVulkanRingBuffer(const CVulkanCore *const pCore, const VkDeviceSize byteSize, const VkBufferUsageFlags usage, const uint32_t frameSlotCount);
+		~CVulkanRingBuffer();
+		CVulkanRingBuffer(const CVulkanRingBuffer&) = delete;
+		CVulkanRingBuffer& operator=(const CVulkanRingBuffer&) = delete;
+
+		// The fence of the slot must have been waited on
+		void BeginFrame(const uint32_t frameSlot);
+		// Alignment is a power of two up to cexp_maxAlignment, throws when frames in flight use the whole ring
+		RingAllocation Allocate(const VkDeviceSize byteSize, const VkDeviceSize alignment = 16u);
+		RingAllocation Push(const void *data, const VkDeviceSize byteSize, const VkDeviceSize alignment = 16u);
+		// Flushes everything allocated since the last call, before the frame is submitted
+		void Flush();
+
+		VkBuffer GetHandle() const;
+		VkDeviceSize GetSize() const { return m_size; };
+		VkDeviceSize GetUsedBytes() const { return m_head - m_tail; };
+
+	private:
+		void FlushRange(const VkDeviceSize begin, const VkDeviceSize end);
+
+		const CVulkanCore *const m_pCore = nullptr;
+		CVulkanBuffer *m_pBuffer = nullptr;
+		uint8_t *m_pMappedData = nullptr;
+		VkDeviceSize m_size = 0u;
+
+		// Positions grow monotonically, the offset in the buffer is the position modulo m_size
+		VkDeviceSize m_head = 0u;
+		VkDeviceSize m_tail = 0u;
+		VkDeviceSize m_flushed = 0u;
+		std::vector<VkDeviceSize> m_slotEnds; // Head after the last allocation of each slot
+		uint32_t m_currentSlot = 0u;
+	};
+}
+
+#endif // !C_VULKAN_RING_BUFFER_H_
@@ -0,0 +1,71 @@
+#ifndef C_VULKAN_SHADER_CACHE_H_
+#define C_VULKAN_SHADER_CACHE_H_
+
+#include <vulkan/vulkan_core.h>
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*
+Shader module cache:
+Compiled SPIR-V files are memory mapped and handed to the driver
+straight from the mapping, nothing is read into an intermediate
+buffer. The code is checked for size, alignment and the SPIR-V magic
+number first. Modules are deduplicated by path and by their code, so a
+file loaded twice or two files with the same code give one module.
+Equal hashes are confirmed by comparing the code itself, which is never
+copied: embedded code is static and a file stays mapped for as long as
+its module exists. LoadAll() maps and creates independent files on
+several threads. The cache owns every module it returns.
+*/
+
+namespace VulkanApp {
+	class CVulkanShaderCache {
+	public:
+		static constexpr uint32_t cexp_spirvMagic = 0x07230203u;
+
+		CVulkanShaderCache(const VkDevice device);
+		~CVulkanShaderCache();
+		CVulkanShaderCache(const CVulkanShaderCache&) = delete;
+		CVulkanShaderCache& operator=(const CVulkanShaderCache&) = delete;
+
+		VkShaderModule Load(const std::string &filePath);
+		// Modules in the order of the paths, thread count 0 uses one thread per file up to the hardware threads
+		std::vector<VkShaderModule> LoadAll(const std::vector<std::string> &filePaths, const uint32_t threadCount = 0u);
+		// Code which is already in memory and stays valid as long as the cache, e.g. embedded into the executable
+		VkShaderModule Create(const uint32_t *pCode, const size_t byteSize);
+
+		uint32_t GetModuleCount() const;
+		uint32_t GetDeduplicatedCount() const;
+
+		// Throws unless the code is a whole number of aligned words starting with the SPIR-V header
+		static void Validate(const void *pCode, const size_t byteSize, const std::string &name);
+
+	private:
+		class MappedFile;
+
+		// The code the module was created from, a file mapping is owned by the entry
+		struct CodeEntry {
+			const void *m_pCode = nullptr;
+			size_t m_byteSize = 0u;
+			std::unique_ptr<MappedFile> m_pMapping; // Null for code passed to Create()
+			VkShaderModule m_vkModule = VK_NULL_HANDLE;
+		};
+
+		VkShaderModule CreateDeduplicated(const void *pCode, const size_t byteSize, const std::string &name, std::unique_ptr<MappedFile> pMapping);
+		// Caller holds m_mutex
+		VkShaderModule FindModule(const uint64_t hash, const void *pCode, const size_t byteSize) const;
+
+		const VkDevice m_vkDevice = VK_NULL_HANDLE;
+		mutable std::mutex m_mutex;
+		std::unordered_map<std::string, VkShaderModule> m_pathModules;
+		// Colliding hashes share a bucket, the code is compared in full
+		std::unordered_multimap<uint64_t, CodeEntry> m_codeModules;
+		uint32_t m_deduplicatedCount = 0u; // Loads served by an existing module
+	};
+}
+
+#endif // !C_VULKAN_SHADER_CACHE_H_
@@ -2,37 +2,83 @@
 #define C_VULKAN_SWAPCHAIN_H_
 
 #include <vulkan/vulkan_core.h>
+#include <DeviceCaps.h>
+#include <array>
 #include <vector>
 
+/*
+Swapchain:
+Resizing creates the new swapchain from the old one and retires the
+old resources until the frames using them are done. The per-image
+arrays are reserved once for cexp_maxImageCount images and the retired
+list has a fixed number of slots, whose arrays are swapped back in on
+the next resize. So apart from the Vulkan objects themselves a resize
+allocates nothing and enumerates nothing but the images.
+*/
+
 namespace VulkanApp {
 
 	class CVulkanCore;
+
+	// Trade-off between input-to-display latency, frame rate and power
+	enum class PresentPolicy {
+		LowLatency,		// MAILBOX or IMMEDIATE, shortest image queue
+		MaxThroughput,	// IMMEDIATE, never blocks on vertical blank
+		PowerSaving		// FIFO, paced by the display and never tears, the present mode before policies existed
+	};
+
 	class CVulkanSwapchain {
 	public:
-		CVulkanSwapchain(const CVulkanCore* const pCore, const uint32_t width, const uint32_t height, const VkSurfaceKHR surface, const VkSurfaceFormatKHR surfaceFormat, const VkRenderPass renderPass);
+		static constexpr uint32_t cexp_maxImageCount = 8u; // Upper bound of the images a driver may return
+		static constexpr uint32_t cexp_maxRetiredCount = 8u; // Resizes pending release before the device is waited
+
+		CVulkanSwapchain(const CVulkanCore* const pCore, const uint32_t width, const uint32_t height, const VkSurfaceKHR surface, const VkSurfaceFormatKHR surfaceFormat, const VkRenderPass renderPass, const PresentPolicy policy = PresentPolicy::PowerSaving);
 		~CVulkanSwapchain();
-		const VkSwapchainKHR GetHandle() const { return m_vkSwapchain; }
+		VkSwapchainKHR GetHandle() const { return m_vkSwapchain; }
 		const CVulkanCore* GetCore() const { return m_pCore; }
-		const VkFramebuffer GetFramebuffer(const uint32_t index);
+		VkFramebuffer GetFramebuffer(const uint32_t index);
 		bool PresentModeAvailable(const VkPresentModeKHR mode) const;
 		bool SurfaceFormatAvailable(const VkSurfaceFormatKHR surfaceFormat) const;
-		void Update();
+		void Update(const uint64_t retireAfterFrame = 0u);
+		void ReleaseRetired(const uint64_t completedFrame);
 		bool SetPresentMode(const VkPresentModeKHR mode);
+		bool SetPresentPolicy(const PresentPolicy policy);
+		PresentPolicy GetPresentPolicy() const { return m_presentPolicy; };
+		VkPresentModeKHR GetPresentMode() const { return m_swapchainCI.presentMode; };
 		bool SetImageFormat(const VkSurfaceFormatKHR surfaceFormat);
 		bool SetImageSize(const uint32_t width, const uint32_t height);
-		uint32_t GetNextImageIndex(VkSemaphore signalImgReady) const;
-		void PresentFrame(uint32_t index, VkSemaphore waitFor) const;
+		VkResult GetNextImageIndex(VkSemaphore signalImgReady, uint32_t *pIndex) const;
+		VkResult PresentFrame(uint32_t index, VkSemaphore waitFor) const;
 		uint32_t GetFramebufferCount() const { return m_framebuffers.size(); };
+		VkSemaphore GetRenderDoneSemaphore(const uint32_t index) const;
+		VkExtent2D GetExtent() const { return m_swapchainCI.imageExtent; };
+		const SurfaceCaps& GetSurfaceCaps() const { return m_surfaceCaps; };
 
 	private:
+		// Resources of a replaced swapchain, kept alive until the GPU is done with them. A slot is free
+		// while it has no swapchain.
+		struct RetiredSwapchain {
+			VkSwapchainKHR m_vkSwapchain = VK_NULL_HANDLE;
+			std::vector<VkImageView> m_imageViews;
+			std::vector<VkFramebuffer> m_framebuffers;
+			std::vector<VkSemaphore> m_renderDoneSemaphores;
+			uint64_t m_lastFrame = 0u;
+		};
+
+
 		const CVulkanCore* const m_pCore; // Guaranteed to be non-null
 		VkRenderPass m_vkRenderPass = VK_NULL_HANDLE;
 		VkSwapchainCreateInfoKHR m_swapchainCI = {};
 		VkSwapchainKHR m_vkSwapchain = VK_NULL_HANDLE;
+		PresentPolicy m_presentPolicy = PresentPolicy::PowerSaving;
+		SurfaceCaps m_surfaceCaps; // Queried once for the surface
 		std::vector<VkImageView> m_swapchainImageViews;
 		std::vector<VkFramebuffer> m_framebuffers;
+		std::vector<VkSemaphore> m_renderDoneSemaphores; // Signaled by rendering, waited by presentation, one per image
+		std::array<RetiredSwapchain, cexp_maxRetiredCount> m_retired;
 		void InitializeFramebuffer();
 		void ReleaseFramebuffer();
+		void Release(RetiredSwapchain &retired);
 	};
 }
 
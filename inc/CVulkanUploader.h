@@ -0,0 +1,76 @@
+#ifndef C_VULKAN_UPLOADER_H_
+#define C_VULKAN_UPLOADER_H_
+
+#include <CVulkanMemoryAllocator.h>
+
+#include <vulkan/vulkan_core.h>
+
+#include <array>
+#include <deque>
+#include <mutex>
+
+/*
+Staging uploads:
+Data written into device local buffers is copied into a persistently
+mapped staging ring first. All copies requested during a frame are
+recorded into a single transfer command buffer which is submitted by
+Flush(), on the transfer queue when the device has a dedicated one.
+The semaphore returned by Flush() has to be waited by the next graphics
+submission of the same frame slot.
+*/
+
+namespace VulkanApp {
+	class CVulkanCore;
+
+	class CVulkanUploader {
+	public:
+		static constexpr VkDeviceSize cexp_defaultStagingSize = 32ull * 1024ull * 1024ull;
+		static constexpr uint32_t cexp_batchCount = 4u;
+		static constexpr uint32_t cexp_semaphoreCount = 3u; // One per frame slot, see CVulkanFrameRing::cexp_maxFramesInFlight
+		static constexpr VkPipelineStageFlags cexp_waitStageMask =
+			VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT |
+			VK_PIPELINE_STAGE_VERTEX_INPUT_BIT |
+			VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+			VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+
+		CVulkanUploader(const CVulkanCore *const pCore, const VkDeviceSize stagingSize = cexp_defaultStagingSize);
+		~CVulkanUploader();
+		CVulkanUploader(const CVulkanUploader&) = delete;
+		CVulkanUploader& operator=(const CVulkanUploader&) = delete;
+
+		void Upload(const VkBuffer dstBuffer, const VkDeviceSize dstOffset, const void *data, const VkDeviceSize byteSize);
+		VkSemaphore Flush(const uint32_t frameSlot);
+		void FlushAndWait();
+		bool UsesDedicatedQueue() const { return m_dedicatedQueue; };
+
+	private:
+		struct UploadBatch {
+			VkCommandPool m_vkCommandPool = VK_NULL_HANDLE;
+			VkCommandBuffer m_vkCommandBuffer = VK_NULL_HANDLE;
+			VkFence m_vkFence = VK_NULL_HANDLE;
+			VkDeviceSize m_ringBegin = 0u;
+			bool m_recording = false;
+		};
+
+		VkDeviceSize Reserve(const VkDeviceSize byteSize, VkDeviceSize *pRingBeginOut);
+		UploadBatch& GetRecordingBatch(const VkDeviceSize ringBegin);
+		void Submit(const VkSemaphore signalSemaphore);
+		void RetireBatches(const bool waitForOldest);
+		void Release();
+
+		const CVulkanCore *const m_pCore = nullptr;
+		const VkDeviceSize m_stagingSize = cexp_defaultStagingSize;
+		bool m_dedicatedQueue = false;
+		VkBuffer m_vkStagingBuffer = VK_NULL_HANDLE;
+		MemoryAllocation m_stagingAllocation;
+		VkDeviceSize m_head = 0u;
+
+		std::array<UploadBatch, cexp_batchCount> m_batches;
+		std::array<VkSemaphore, cexp_semaphoreCount> m_semaphores = {};
+		std::deque<uint32_t> m_pendingBatches; // Submitted or recording, oldest first
+		uint32_t m_recordingBatch = UINT32_MAX;
+		std::mutex m_mutex;
+	};
+}
+
+#endif // !C_VULKAN_UPLOADER_H_
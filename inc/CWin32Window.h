@@ -0,0 +1,27 @@
+#ifndef C_WIN32_WINDOW_H_
+#define C_WIN32_WINDOW_H_
+
+#include <CWindow.h>
+
+#include <Windows.h>
+
+class CWin32Window : public CWindow {
+public:
+	CWin32Window(const std::wstring title, const uint32_t width, const uint32_t height);
+	~CWin32Window();
+	HWND GetHandle() const { return m_windowHandle; };
+	WindowBackend GetBackend() const override { return WindowBackend::Win32; };
+	void Show(bool isVisible) override;
+	VkResult CreateSurface(const VkInstance instance, VkSurfaceKHR *pSurface) const override;
+
+private:
+	static LRESULT CALLBACK WindowProc(HWND hWnd, UINT Msg, WPARAM wParam, LPARAM lParam);
+	HWND CreateSystemWindow(const std::wstring name, const uint32_t windowWidth, const uint32_t windowHeight);
+	void DrainSystemEvents() override;
+	void WaitSystemEvents(const uint32_t timeoutMs) override;
+
+	HWND m_windowHandle = NULL;
+	bool m_inSizeMove = false;
+};
+
+#endif // !C_WIN32_WINDOW_H_
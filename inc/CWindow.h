@@ -1,11 +1,54 @@
 #ifndef C_WINDOW_H_
 #define C_WINDOW_H_
 
-#include <Windows.h>
+#include <vulkan/vulkan_core.h>
 
-#include <vector>
-#include <string>
+#include <cstdint>
 #include <functional>
+#include <string>
+#include <vector>
+
+/*
+Windows and events:
+A window is created for one of the backends, Win32 on Windows, xcb on
+Linux builds which define VULKANAPP_XCB=1 and link libxcb, or the null
+backend which has no system window and only delivers events pushed by
+the application. Every iteration of the main loop drains all pending
+system events first and hands them to the listeners as one batch, in
+the order they arrived. Consecutive resizes and mouse moves collapse
+into the last one, so a burst of input costs one handler call.
+*/
+
+enum class WindowBackend {
+	Native, // Win32 on Windows, xcb on Linux
+	Win32,
+	Xcb,
+	Null
+};
+
+enum class WindowEventType : uint32_t {
+	Create,
+	Close,
+	Destroy,
+	Resize, // Zero size while minimized
+	MoveEnter,
+	MoveExit,
+	Paint,
+	KeyDown,
+	KeyUp,
+	MouseMove,
+	MouseButtonDown,
+	MouseButtonUp
+};
+
+struct WindowEvent {
+	WindowEventType m_type = WindowEventType::Paint;
+	uint32_t m_width = 0u;
+	uint32_t m_height = 0u;
+	uint32_t m_code = 0u; // Key code of the backend, or mouse button counted from 0 for the left one
+	int32_t m_x = 0; // Mouse position in the client area
+	int32_t m_y = 0;
+};
 
 class CWindow {
 public:
@@ -13,30 +56,57 @@ public:
 
 	class IEventListener {
 		friend class CWindow;
+	protected:
+		// Called once per drained batch, the default forwards every event to the handlers below
+		virtual void OnEvents(const WindowEvent *pEvents, const uint32_t eventCount);
 	private:
 		virtual void OnClose() {};
 		virtual void OnCreate() {};
-		virtual void OnSizeChanged(const uint32_t width, const uint32_t height) {};
+		virtual void OnSizeChanged(const uint32_t /*width*/, const uint32_t /*height*/) {};
 		virtual void OnDestroy() {};
 		virtual void OnMoveEnter() {};
 		virtual void OnMoveExit() {};
 		virtual void OnPaint() {};
+		virtual void OnKey(const uint32_t /*code*/, const bool /*pressed*/) {};
+		virtual void OnMouseMove(const int32_t /*x*/, const int32_t /*y*/) {};
+		virtual void OnMouseButton(const uint32_t /*button*/, const bool /*pressed*/, const int32_t /*x*/, const int32_t /*y*/) {};
 	};
 
-	CWindow(const std::wstring title, const uint32_t width, const uint32_t height);
+	// Throws when the backend is not available in this build or the window cannot be created
+	static CWindow* Create(const std::wstring title, const uint32_t width, const uint32_t height, const WindowBackend backend = WindowBackend::Native);
+	virtual ~CWindow() = default;
+	CWindow(const CWindow&) = delete;
+	CWindow& operator=(const CWindow&) = delete;
+
 	bool AddEventListener(IEventListener* pListener);
 	bool RemoveEventListener(IEventListener* pListener);
-	HWND GetHandle() const { return m_windowHandle; };
-	void Show(bool isVisible) const;
-	bool RunMainLoop();
+	virtual WindowBackend GetBackend() const = 0;
+	virtual void Show(bool isVisible) = 0;
+	// The instance needs the surface extension of the backend, the null backend has no surface
+	virtual VkResult CreateSurface(const VkInstance instance, VkSurfaceKHR *pSurface) const = 0;
 
-private:
-	static LRESULT WindowProc(HWND hWnd, UINT Msg, WPARAM wParam, LPARAM lParam);
-	HWND CreateSystemWindow(const std::wstring name, const uint32_t windowWidth, const uint32_t windowHeight);
+	// Queued for the next batch, e.g. input replayed into a null window
+	void PushEvent(const WindowEvent &event);
+	// Drains every pending event and dispatches them as one batch, returns the number of events
+	uint32_t PollEvents();
+	// Blocks until an event is pending or the timeout has passed, the events are left for PollEvents()
+	void WaitForEvents(const uint32_t timeoutMs);
+	bool RunMainLoop();
 
-	HWND m_windowHandle = NULL;
-	static std::vector<std::pair<HWND, IEventListener*>> m_eventListeners;
+protected:
+	CWindow() = default;
+	// Moves all events waiting in the system queue into PushEvent(), without blocking
+	virtual void DrainSystemEvents() = 0;
+	// Returns early when the system queue has something, may drain it
+	virtual void WaitSystemEvents(const uint32_t timeoutMs) = 0;
+	bool HasPendingEvents() const { return !m_pendingEvents.empty(); };
+	// For backends which are kept inside a system loop, e.g. while a Win32 window is dragged
+	uint32_t DispatchPendingEvents();
 
+private:
+	std::vector<IEventListener*> m_eventListeners;
+	std::vector<WindowEvent> m_pendingEvents;
+	std::vector<WindowEvent> m_dispatchedEvents; // Swapped with the pending ones, listeners may push while a batch is dispatched
 };
 
 #endif // !C_WINDOW_H_
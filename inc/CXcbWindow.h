@@ -0,0 +1,34 @@
+#ifndef C_XCB_WINDOW_H_
+#define C_XCB_WINDOW_H_
+
+#include <CWindow.h>
+
+#include <xcb/xcb.h>
+
+class CXcbWindow : public CWindow {
+public:
+	// Connects to the display named by DISPLAY
+	CXcbWindow(const std::wstring title, const uint32_t width, const uint32_t height);
+	~CXcbWindow();
+	xcb_connection_t* GetConnection() const { return m_pConnection; };
+	xcb_window_t GetHandle() const { return m_window; };
+	WindowBackend GetBackend() const override { return WindowBackend::Xcb; };
+	void Show(bool isVisible) override;
+	VkResult CreateSurface(const VkInstance instance, VkSurfaceKHR *pSurface) const override;
+
+private:
+	xcb_atom_t InternAtom(const char *name) const;
+	void DrainSystemEvents() override;
+	void WaitSystemEvents(const uint32_t timeoutMs) override;
+	void Release();
+
+	xcb_connection_t *m_pConnection = nullptr;
+	xcb_window_t m_window = 0u;
+	xcb_atom_t m_protocolsAtom = 0u;
+	xcb_atom_t m_deleteWindowAtom = 0u;
+	uint32_t m_width = 0u;
+	uint32_t m_height = 0u;
+	bool m_connectionLost = false;
+};
+
+#endif // !C_XCB_WINDOW_H_
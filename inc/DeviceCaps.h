@@ -0,0 +1,70 @@
+#ifndef DEVICE_CAPS_H_
+#define DEVICE_CAPS_H_
+
+#include <vulkan/vulkan_core.h>
+
+#include <bitset>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+/*
+Capability snapshots:
+Everything the driver reports about the instance, the physical device
+and a surface is queried once and kept in flat arrays. Names of layers
+and extensions are kept as sorted hashes, present modes and common
+surface formats as bits, so checks made while running never enumerate
+or allocate. The device part is built by the core, the surface part
+by the swapchain of that surface. Surface capabilities also hold the
+extent limits, which follow the window, RefreshCapabilities() updates
+them with a single query.
+*/
+
+namespace VulkanApp {
+
+	struct DeviceCaps {
+		// Instance level, valid before a device is selected
+		std::vector<uint64_t> m_instanceLayers; // Hash64 of the names, sorted
+		std::vector<uint64_t> m_instanceExtensions;
+
+		VkPhysicalDevice m_vkPhysicalDevice = VK_NULL_HANDLE;
+		VkPhysicalDeviceProperties m_properties = {};
+		VkPhysicalDeviceFeatures m_features = {}; // Supported, see CVulkanCore::GetEnabledFeatures() for the enabled ones
+		VkPhysicalDeviceMemoryProperties m_memoryProperties = {};
+		std::vector<VkQueueFamilyProperties> m_queueFamilies;
+		std::vector<uint64_t> m_deviceExtensions;
+
+		void QueryInstance();
+		void QueryDevice(const VkPhysicalDevice physicalDevice);
+
+		bool HasInstanceLayer(const std::string_view name) const;
+		bool HasInstanceExtension(const std::string_view name) const;
+		bool HasDeviceExtension(const std::string_view name) const;
+		uint32_t GetQueueFamilyCount() const { return static_cast<uint32_t>(m_queueFamilies.size()); };
+		// First family with all of the flags and none of the excluded ones, UINT32_MAX when there is none
+		uint32_t FindQueueFamily(const VkQueueFlags queueFlags, const VkQueueFlags excludedFlags = 0u, const uint32_t firstFamily = 0u) const;
+	};
+
+	struct SurfaceCaps {
+		static constexpr uint32_t cexp_formatBits = 256u; // Core formats, anything above is looked up in m_formats
+
+		VkSurfaceKHR m_vkSurface = VK_NULL_HANDLE;
+		VkSurfaceCapabilitiesKHR m_capabilities = {};
+		uint32_t m_presentModes = 0u; // Bit per core present mode
+		std::bitset<cexp_formatBits> m_srgbFormats; // Formats with the sRGB nonlinear color space
+		std::vector<VkSurfaceFormatKHR> m_formats;
+
+		// Again whenever the surface is replaced
+		void Query(const VkPhysicalDevice physicalDevice, const VkSurfaceKHR surface);
+		// Capabilities only, e.g. after a resize, no allocation
+		VkResult RefreshCapabilities(const VkPhysicalDevice physicalDevice);
+
+		bool HasPresentMode(const VkPresentModeKHR mode) const {
+			return static_cast<uint32_t>(mode) < 32u && (m_presentModes & (1u << static_cast<uint32_t>(mode))) != 0u;
+		};
+		bool HasFormat(const VkSurfaceFormatKHR surfaceFormat) const;
+		bool IsExtentSupported(const uint32_t width, const uint32_t height) const;
+	};
+}
+
+#endif // !DEVICE_CAPS_H_
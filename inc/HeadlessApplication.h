@@ -0,0 +1,73 @@
+#pragma once
+#include <stdint.h>
+#include <string>
+
+#include <vulkan/vulkan_core.h>
+
+#include <CVulkanCore.h>
+#include <CRollingStats.h>
+#include <CSpecializationConstants.h>
+
+/*
+Headless application:
+Renders the same pass and pipeline as Application into offscreen
+images instead of a swapchain, so it runs without a window system,
+e.g. on a server with a software ICD such as lavapipe.
+*/
+
+namespace VulkanApp {
+	class CVulkanPass;
+	class CVulkanPipeline;
+	class CVulkanBuffer;
+	class CVulkanIndexBuffer;
+	class CVulkanFrameRing;
+	class CVulkanGpuProfiler;
+	class CVulkanOffscreenTarget;
+	class CVulkanDrawList;
+
+	struct HeadlessStatistics {
+		uint32_t m_frameCount = 0u;
+		double m_seconds = 0.0;
+		double m_framesPerSecond = 0.0;
+	};
+
+	class HeadlessApplication {
+	public:
+		static constexpr VkFormat cexp_targetFormat = VK_FORMAT_R8G8B8A8_UNORM;
+		static constexpr uint32_t cexp_traceFrameCount = 120u; // Frames written to the trace file on exit
+
+		// Instances of the triangle are drawn with a single instanced call
+		HeadlessApplication(const uint32_t width, const uint32_t height, const uint32_t framesInFlight = 2u, const bool readback = false,
+			const uint32_t instanceCount = 1u);
+		~HeadlessApplication();
+		bool RenderFrame();
+		// Renders frameCount frames as fast as possible and waits for the last one
+		HeadlessStatistics RunBatch(const uint32_t frameCount);
+		// Binary PPM of the last rendered frame, requires readback
+		bool WriteLastFrame(const std::string &filePath);
+		const CRollingStats& GetFrameTimes() const { return m_frameTimes; };
+		const CVulkanGpuProfiler* GetGpuProfiler() const { return m_pGpuProfiler; };
+
+	private:
+		// CPU trace written on exit, enabled by the VULKANAPP_TRACE environment variable.
+		// Declared before the core, so its creation is traced as well.
+		std::string m_tracePath;
+
+		CVulkanCore m_core;
+		CVulkanPass *m_pPass = nullptr;
+		CVulkanPipeline *m_pPipeline = nullptr;
+		CVulkanOffscreenTarget *m_pTarget = nullptr;
+		CVulkanBuffer *m_pVertexBuffer = nullptr;
+		CVulkanIndexBuffer *m_pIndexBuffer = nullptr;
+		CVulkanBuffer *m_pInstanceBuffer = nullptr;
+		uint32_t m_instanceCount = 1u;
+		CVulkanFrameRing *m_pFrameRing = nullptr;
+		CVulkanGpuProfiler *m_pGpuProfiler = nullptr;
+		CVulkanDrawList *m_pDrawList = nullptr;
+
+		VkPipelineShaderStageCreateInfo m_shaderStageCI[2] = {};
+		CSpecializationConstants m_fragmentConstants; // Behind m_shaderStageCI[1].pSpecializationInfo
+		uint32_t m_lastImageIndex = UINT32_MAX;
+		CRollingStats m_frameTimes; // CPU time per frame, in milliseconds
+	};
+}
@@ -0,0 +1,53 @@
+#ifndef SAMPLE_VERTEX_H_
+#define SAMPLE_VERTEX_H_
+
+#include <TVertexLayout.h>
+
+/*
+Sample geometry:
+Vertex and instance formats read by VertexShader.glsl, shared by the
+windowed and headless applications and the benchmarks.
+TransformVertexShader.glsl reads the vertices alone, its transform
+comes from push constants and its tint from a per frame uniform.
+FragmentShader.glsl is specialized for the format of its attachment.
+*/
+
+namespace VulkanApp {
+	struct SampleVertex {
+		float m_position[3];
+		float m_color[3];
+	};
+
+	struct SampleInstance {
+		float m_transform[4]; // xy offset, z scale
+	};
+
+	using SampleVertexLayout = TVertexLayout<
+		TVertexStructBinding<SampleVertex, VK_VERTEX_INPUT_RATE_VERTEX,
+			VERTEX_MEMBER(SampleVertex, m_position, float3),
+			VERTEX_MEMBER(SampleVertex, m_color, float3)>,
+		TVertexStructBinding<SampleInstance, VK_VERTEX_INPUT_RATE_INSTANCE,
+			VERTEX_MEMBER(SampleInstance, m_transform, float4)>>;
+
+	// Push constants of TransformVertexShader.glsl, same layout as SampleInstance
+	struct SampleDrawConstants {
+		float m_transform[4]; // xy offset, z scale
+	};
+
+	// Uniform block of TransformVertexShader.glsl at set 0, binding 0
+	struct SampleFrameData {
+		float m_tint[4];
+	};
+
+	// constant_id values of FragmentShader.glsl
+	struct SampleFragmentConstants {
+		static constexpr uint32_t cexp_encodeSrgb = 0u; // bool, set unless the color attachment is sRGB
+	};
+
+	using SampleMeshLayout = TVertexLayout<
+		TVertexStructBinding<SampleVertex, VK_VERTEX_INPUT_RATE_VERTEX,
+			VERTEX_MEMBER(SampleVertex, m_position, float3),
+			VERTEX_MEMBER(SampleVertex, m_color, float3)>>;
+}
+
+#endif // !SAMPLE_VERTEX_H_
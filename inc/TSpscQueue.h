@@ -0,0 +1,79 @@
+#ifndef T_SPSC_QUEUE_H_
+#define T_SPSC_QUEUE_H_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+/*
+Single producer, single consumer queue:
+A bounded ring without locks, one thread pushes and one other thread
+pops. Each side owns one index and only reads the other one, so an
+operation costs one acquire load and one release store. The indices
+sit on their own cache lines, the two threads do not invalidate each
+other's line on every operation. Capacity is a power of two.
+
+	TSpscQueue<Command, 64u> queue;
+	queue.TryPush(command); // Producer thread
+	while (queue.TryPop(command)) { ... } // Consumer thread
+*/
+
+namespace VulkanApp {
+
+	template <typename T, uint32_t Capacity>
+	class TSpscQueue {
+		static_assert(Capacity >= 2u && (Capacity & (Capacity - 1u)) == 0u, "Capacity has to be a power of two");
+		static_assert(std::is_trivially_copyable_v<T>, "Elements are copied in and out of the ring");
+
+	public:
+		TSpscQueue() = default;
+		TSpscQueue(const TSpscQueue&) = delete;
+		TSpscQueue& operator=(const TSpscQueue&) = delete;
+
+		// Producer only, false when the queue is full
+		bool TryPush(const T &value) {
+			const uint32_t tail = m_tail.load(std::memory_order_relaxed);
+			if (tail - m_cachedHead == Capacity) {
+				m_cachedHead = m_head.load(std::memory_order_acquire);
+				if (tail - m_cachedHead == Capacity) {
+					return false;
+				}
+			}
+			m_elements[tail & (Capacity - 1u)] = value;
+			m_tail.store(tail + 1u, std::memory_order_release);
+			return true;
+		}
+
+		// Consumer only, false when the queue is empty
+		bool TryPop(T &value) {
+			const uint32_t head = m_head.load(std::memory_order_relaxed);
+			if (head == m_cachedTail) {
+				m_cachedTail = m_tail.load(std::memory_order_acquire);
+				if (head == m_cachedTail) {
+					return false;
+				}
+			}
+			value = m_elements[head & (Capacity - 1u)];
+			m_head.store(head + 1u, std::memory_order_release);
+			return true;
+		}
+
+		// Exact on either side only while the other one is idle
+		uint32_t GetSize() const { return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire); };
+		static constexpr uint32_t GetCapacity() { return Capacity; };
+
+	private:
+		static constexpr size_t cexp_cacheLineSize = 64u;
+
+		// Indices run freely and wrap, only their difference is used
+		alignas(cexp_cacheLineSize) std::atomic<uint32_t> m_head = 0u; // Written by the consumer
+		uint32_t m_cachedTail = 0u; // Consumer's last view of the tail
+		alignas(cexp_cacheLineSize) std::atomic<uint32_t> m_tail = 0u; // Written by the producer
+		uint32_t m_cachedHead = 0u; // Producer's last view of the head
+		alignas(cexp_cacheLineSize) std::array<T, Capacity> m_elements = {};
+	};
+}
+
+#endif // !T_SPSC_QUEUE_H_
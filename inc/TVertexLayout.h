@@ -0,0 +1,128 @@
+#ifndef T_VERTEX_LAYOUT_H_
+#define T_VERTEX_LAYOUT_H_
+
+#include <CVulkanBuffer.h>
+
+#include <array>
+#include <cstddef>
+#include <type_traits>
+
+/*
+Compile time vertex layouts:
+Bindings are listed as formats packed in order, or as members of a
+vertex struct. Offsets, strides and the Vulkan input descriptions are
+computed by the compiler and live in static storage, so a pipeline
+built from them allocates nothing. A member whose size does not match
+its format, or which lies outside of the struct, does not compile.
+
+	struct Vertex { float m_position[3]; uint32_t m_color; };
+	using Layout = TVertexLayout<
+		TVertexStructBinding<Vertex, VK_VERTEX_INPUT_RATE_VERTEX,
+			VERTEX_MEMBER(Vertex, m_position, float3),
+			VERTEX_MEMBER(Vertex, m_color, unorm8x4)>,
+		TVertexBinding<VK_VERTEX_INPUT_RATE_INSTANCE, BufferAttribute::float4>>;
+	CVulkanPipeline pipeline(pCore, pPass, stages, Layout::cexp_inputState);
+*/
+
+// Offset and size of a struct member checked against an attribute type
+#define VERTEX_MEMBER(vertex, member, type) \
+	VulkanApp::TVertexMember<offsetof(vertex, member), sizeof(vertex::member), VulkanApp::BufferAttribute::ShaderDataType::type>
+
+namespace VulkanApp {
+
+	template <size_t Offset, size_t MemberSize, BufferAttribute::ShaderDataType Type>
+	struct TVertexMember {
+		static_assert(MemberSize == BufferAttribute::GetTypeSize(Type), "Member size does not match the attribute type");
+
+		static constexpr uint32_t cexp_offset = static_cast<uint32_t>(Offset);
+		static constexpr BufferAttribute::ShaderDataType cexp_type = Type;
+	};
+
+	// Attributes packed one after another, the stride is their total size
+	template <VkVertexInputRate InputRate, BufferAttribute::ShaderDataType... Types>
+	struct TVertexBinding {
+		static constexpr VkVertexInputRate cexp_inputRate = InputRate;
+		static constexpr uint32_t cexp_attributeCount = sizeof...(Types);
+		static constexpr std::array<BufferAttribute::ShaderDataType, sizeof...(Types)> cexp_types = { Types... };
+		static constexpr std::array<uint32_t, sizeof...(Types)> cexp_offsets = [] {
+			std::array<uint32_t, sizeof...(Types)> offsets = {};
+			uint32_t offset = 0u;
+			for (size_t i = 0u; i < offsets.size(); i++) {
+				offsets[i] = offset;
+				offset += BufferAttribute::GetTypeSize(cexp_types[i]);
+			}
+			return offsets;
+		}();
+		static constexpr uint32_t cexp_stride = (BufferAttribute::GetTypeSize(Types) + ... + 0u);
+	};
+
+	// Attributes taken from the members of TVertex, the stride is sizeof(TVertex)
+	template <typename TVertex, VkVertexInputRate InputRate, typename... Members>
+	struct TVertexStructBinding {
+		static_assert(std::is_standard_layout_v<TVertex> && std::is_trivially_copyable_v<TVertex>,
+			"Vertex structs are copied into buffers byte by byte");
+
+		static constexpr VkVertexInputRate cexp_inputRate = InputRate;
+		static constexpr uint32_t cexp_attributeCount = sizeof...(Members);
+		static constexpr std::array<BufferAttribute::ShaderDataType, sizeof...(Members)> cexp_types = { Members::cexp_type... };
+		static constexpr std::array<uint32_t, sizeof...(Members)> cexp_offsets = { Members::cexp_offset... };
+		static constexpr uint32_t cexp_stride = static_cast<uint32_t>(sizeof(TVertex));
+
+		static_assert(((Members::cexp_offset + BufferAttribute::GetTypeSize(Members::cexp_type) <= sizeof(TVertex)) && ...),
+			"Attribute lies outside of the vertex struct");
+	};
+
+	namespace VertexLayoutDetail {
+		template <typename... Bindings>
+		constexpr std::array<VkVertexInputBindingDescription, sizeof...(Bindings)> MakeBindingDescs() {
+			std::array<VkVertexInputBindingDescription, sizeof...(Bindings)> descs = {};
+			uint32_t binding = 0u;
+			((descs[binding] = { binding, Bindings::cexp_stride, Bindings::cexp_inputRate }, binding++), ...);
+			return descs;
+		}
+
+		// Locations run on across bindings, like in CBufferLayout
+		template <uint32_t AttributeCount, typename... Bindings>
+		constexpr std::array<VkVertexInputAttributeDescription, AttributeCount> MakeAttributeDescs() {
+			std::array<VkVertexInputAttributeDescription, AttributeCount> descs = {};
+			uint32_t binding = 0u;
+			uint32_t location = 0u;
+			[[maybe_unused]] auto addBinding = [&](const auto &types, const auto &offsets) {
+				for (size_t i = 0u; i < types.size(); i++) {
+					descs[location] = { location, binding, BufferAttribute::GetVkFormat(types[i]), offsets[i] };
+					location++;
+				}
+				binding++;
+			};
+			(addBinding(Bindings::cexp_types, Bindings::cexp_offsets), ...);
+			return descs;
+		}
+	}
+
+	template <typename... Bindings>
+	class TVertexLayout {
+	public:
+		static constexpr uint32_t cexp_bindingCount = sizeof...(Bindings);
+		static constexpr uint32_t cexp_attributeCount = (Bindings::cexp_attributeCount + ... + 0u);
+		static constexpr std::array<uint32_t, sizeof...(Bindings)> cexp_strides = { Bindings::cexp_stride... };
+
+		static constexpr std::array<VkVertexInputBindingDescription, cexp_bindingCount> cexp_bindingDescs =
+			VertexLayoutDetail::MakeBindingDescs<Bindings...>();
+		static constexpr std::array<VkVertexInputAttributeDescription, cexp_attributeCount> cexp_attributeDescs =
+			VertexLayoutDetail::MakeAttributeDescs<cexp_attributeCount, Bindings...>();
+
+		static constexpr VkPipelineVertexInputStateCreateInfo cexp_inputState = {
+			VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
+			nullptr,
+			0u,
+			cexp_bindingCount,
+			cexp_bindingCount > 0u ? cexp_bindingDescs.data() : nullptr,
+			cexp_attributeCount,
+			cexp_attributeCount > 0u ? cexp_attributeDescs.data() : nullptr
+		};
+
+		static constexpr uint32_t GetByteSize(const uint32_t binding = 0u) { return binding < cexp_bindingCount ? cexp_strides[binding] : 0u; };
+	};
+}
+
+#endif // !T_VERTEX_LAYOUT_H_
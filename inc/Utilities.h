@@ -13,6 +13,15 @@
 
 namespace VulkanApp {
 	std::string CreateExceptionMessage(const std::string msg, VkResult code, const std::string file, uint32_t line);
+
+	// FNV-1a, stable across runs and platforms
+	constexpr uint64_t cexp_hashSeed = 0xcbf29ce484222325ull;
+	uint64_t Hash64(const void* data, const size_t byteSize, const uint64_t seed = cexp_hashSeed);
+
+	// Formats which encode to sRGB on write and decode on read
+	bool IsSrgbFormat(const VkFormat format);
+
+	// Diagnostics, every call enumerates and allocates, see DeviceCaps for the cached queries
 	namespace CapsInfo {
 		std::vector<std::string> GetSupportedExtenstions();
 		std::vector<std::string> GetAvailableInstanceLayers();
@@ -0,0 +1,129 @@
+#!/usr/bin/env python3
+"""Compiles the GLSL sources in shaders/src into optimized SPIR-V and embeds
+it as constexpr arrays in shaders/generated/EmbeddedShaders.h.
+
+The stage is taken from the file name: *Vertex*, *Fragment* and *Compute*,
+or the usual .vert, .frag and .comp extensions. glslc is looked up in
+$VULKAN_SDK/bin (Bin on Windows) and then on the PATH. The header is only
+rewritten when its content changes, so unchanged shaders rebuild nothing.
+
+usage: EmbedShaders.py [--source DIR] [--output FILE] [--glslc PATH]
+"""
+
+import argparse
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+
+SCRIPTS_DIR = os.path.dirname(os.path.abspath(__file__))
+SHADERS_DIR = os.path.dirname(SCRIPTS_DIR)
+
+STAGES = (
+    ("vertex", ("Vertex", ".vert")),
+    ("fragment", ("Fragment", ".frag")),
+    ("compute", ("Compute", ".comp")),
+)
+
+SPIRV_MAGIC = 0x07230203
+
+
+def find_glslc(explicit):
+    if explicit:
+        return explicit
+    sdk = os.environ.get("VULKAN_SDK")
+    if sdk:
+        for bin_dir in ("Bin", "bin"):
+            for name in ("glslc.exe", "glslc"):
+                candidate = os.path.join(sdk, bin_dir, name)
+                if os.path.isfile(candidate):
+                    return candidate
+    found = shutil.which("glslc")
+    if not found:
+        sys.exit("EmbedShaders: glslc not found, install the Vulkan SDK or pass --glslc")
+    return found
+
+
+def shader_stage(file_name):
+    for stage, markers in STAGES:
+        if any(marker in file_name for marker in markers):
+            return stage
+    return None
+
+
+def array_name(file_name):
+    # VertexShader.glsl -> cexp_vertexShader
+    stem = os.path.splitext(file_name)[0].replace(".", "_")
+    return "cexp_" + stem[0].lower() + stem[1:]
+
+
+def compile_shader(glslc, source_path, stage):
+    with tempfile.TemporaryDirectory() as temp_dir:
+        output_path = os.path.join(temp_dir, "shader.spv")
+        # -O runs the performance passes of spirv-opt, debug info is left out
+        subprocess.run([glslc, "-O", "--target-env=vulkan1.0", "-fshader-stage=" + stage,
+                        source_path, "-o", output_path], check=True)
+        with open(output_path, "rb") as spv_file:
+            code = spv_file.read()
+
+    if len(code) % 4 != 0 or int.from_bytes(code[:4], "little") != SPIRV_MAGIC:
+        sys.exit("EmbedShaders: glslc wrote invalid SPIR-V for " + source_path)
+    return [int.from_bytes(code[i:i + 4], "little") for i in range(0, len(code), 4)]
+
+
+def format_array(name, file_name, words):
+    lines = ["\t\t// %s, %d bytes" % (file_name, len(words) * 4),
+             "\t\tinline constexpr uint32_t %s[] = {" % name]
+    for i in range(0, len(words), 8):
+        lines.append("\t\t\t" + ", ".join("0x%08xu" % word for word in words[i:i + 8]) + ",")
+    lines.append("\t\t};")
+    return "\n".join(lines)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Embed optimized SPIR-V into a C++ header")
+    parser.add_argument("--source", default=os.path.join(SHADERS_DIR, "src"))
+    parser.add_argument("--output", default=os.path.join(SHADERS_DIR, "generated", "EmbeddedShaders.h"))
+    parser.add_argument("--glslc")
+    args = parser.parse_args()
+
+    glslc = find_glslc(args.glslc)
+
+    arrays = []
+    for file_name in sorted(os.listdir(args.source)):
+        stage = shader_stage(file_name)
+        if stage is None:
+            continue
+        words = compile_shader(glslc, os.path.join(args.source, file_name), stage)
+        arrays.append(format_array(array_name(file_name), file_name, words))
+
+    header = "\n".join([
+        "// Generated by shaders/scripts/EmbedShaders.py from shaders/src, do not edit",
+        "#ifndef EMBEDDED_SHADERS_H_",
+        "#define EMBEDDED_SHADERS_H_",
+        "",
+        "#include <cstdint>",
+        "",
+        "namespace VulkanApp {",
+        "\tnamespace EmbeddedShaders {",
+        "\n\n".join(arrays),
+        "\t}",
+        "}",
+        "",
+        "#endif // !EMBEDDED_SHADERS_H_",
+        "",
+    ])
+
+    if os.path.isfile(args.output):
+        with open(args.output, "r", newline="\n") as current:
+            if current.read() == header:
+                return
+
+    os.makedirs(os.path.dirname(args.output), exist_ok=True)
+    with open(args.output, "w", newline="\n") as output:
+        output.write(header)
+
+
+if __name__ == "__main__":
+    main()
@@ -1,9 +1,17 @@
 #version 450
 
+// Set for attachments which store the value unchanged, e.g. UNORM, so the output is encoded by
+// hand. sRGB attachments encode on their own. Folded in when the pipeline is created.
+layout(constant_id = 0) const bool encodeSrgb = false;
+
 layout(location = 0) in vec3 fragColor;
 
 layout(location = 0) out vec4 outColor;
 
 void main() {
-    outColor = vec4(fragColor, 1.0);
+    vec3 color = fragColor;
+    if (encodeSrgb) {
+        color = mix(color * 12.92, 1.055 * pow(color, vec3(1.0 / 2.4)) - 0.055, step(vec3(0.0031308), color));
+    }
+    outColor = vec4(color, 1.0);
 }
\ No newline at end of file
@@ -0,0 +1,21 @@
+#version 450
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inColor;
+
+// Shared by every draw of the frame
+layout(set = 0, binding = 0) uniform FrameData {
+    vec4 tint; // rgb multiplies the vertex color
+} frame;
+
+// Per-draw transform: xy offset, z uniform scale
+layout(push_constant) uniform DrawData {
+    vec4 transform;
+} draw;
+
+layout(location = 0) out vec3 fragColor;
+
+void main() {
+    gl_Position = vec4(inPosition * draw.transform.z + vec3(draw.transform.xy, 0.0), 1.0);
+    fragColor = inColor * frame.tint.rgb;
+}
\ No newline at end of file
@@ -3,9 +3,12 @@
 layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec3 inColor;
 
+// Per-instance stream: xy offset, z uniform scale
+layout(location = 2) in vec4 inInstance;
+
 layout(location = 0) out vec3 fragColor;
 
 void main() {
-    gl_Position = vec4(inPosition, 1.0);
+    gl_Position = vec4(inPosition * inInstance.z + vec3(inInstance.xy, 0.0), 1.0);
     fragColor = inColor;
 }
\ No newline at end of file
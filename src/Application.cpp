@@ -2,24 +2,39 @@
 #include <CVulkanSwapchain.h>
 #include <CVulkanPass.h>
 #include <CVulkanPipeline.h>
+#include <CVulkanShaderCache.h>
+#include <EmbeddedShaders.h>
+#include <CVulkanFrameRing.h>
+#include <CVulkanUploader.h>
+#include <CVulkanGpuProfiler.h>
+#include <CVulkanParallelRecorder.h>
+#include <CVulkanDrawList.h>
+#include <SampleVertex.h>
 #include <Utilities.h>
-#include <Local.h>
+#include <CTracer.h>
 
-#include <Windows.h>
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <thread>
 
-VulkanApp::Application::Application(const HWND windowHandle) :
-		m_core("VulkanApp") {
+VulkanApp::Application::Application(const CWindow &window, const uint32_t framesInFlight,
+		const PresentPolicy presentPolicy, const double frameRateLimit) :
+		m_tracePath(CTracer::EnableFromEnvironment()), m_core("VulkanApp"), m_frameLimiter(frameRateLimit) {
 
-	VkWin32SurfaceCreateInfoKHR surfaceInfo = {};
-	{
-		surfaceInfo.sType = VK_STRUCTURE_TYPE_WIN32_SURFACE_CREATE_INFO_KHR;
-		surfaceInfo.pNext = nullptr;
-		surfaceInfo.hinstance = GetModuleHandle(NULL);
-		surfaceInfo.hwnd = windowHandle;
+	TRACE_SCOPE("Application::Create");
+
+	if (window.CreateSurface(m_core.GetVkInstance(), &m_vkSurface) != VK_SUCCESS) {
+		throw std::runtime_error("[Runtime error] Cannot create window surface");
 	}
 
-	if (vkCreateWin32SurfaceKHR(m_core.GetVkInstance(), &surfaceInfo, nullptr, &m_vkSurface) != VK_SUCCESS) {
-		throw std::runtime_error("[Runtime error] Cannot create Win32SurfaceKHR");
+	// The core only knows the platform, e.g. with xcb it cannot check a family without the window
+	VkBool32 presentSupported = VK_FALSE;
+	VkResult result = vkGetPhysicalDeviceSurfaceSupportKHR(m_core.GetVkPhysicalDevice(), m_core.GetQueueFamilyIndex(), m_vkSurface, &presentSupported);
+	if (result != VK_SUCCESS || presentSupported == VK_FALSE) {
+		vkDestroySurfaceKHR(m_core.GetVkInstance(), m_vkSurface, nullptr);
+		m_vkSurface = VK_NULL_HANDLE;
+		throw std::runtime_error(UTIL_EXC_MSG_EX("Graphics queue family of the device cannot present to the window surface", result));
 	}
 
 	VkSurfaceCapabilitiesKHR capabilities;
@@ -32,71 +47,109 @@ VulkanApp::Application::Application(const HWND windowHandle) :
 	
 	m_pPass = new CVulkanPass(&m_core, m_vkSurfaceFormat.format);
 	
-	// Initialize shaders
+	// Initialize shaders, the SPIR-V is embedded at build time and the core owns the modules
+	CVulkanShaderCache *pShaderCache = m_core.GetShaderCache();
 	m_shaderStageCI[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
 	m_shaderStageCI[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
-	m_shaderStageCI[0].module = CVulkanPipeline::LoadCompiledShader(m_core.GetVkLogicalDevice(), VERTEX_SHADER_PATH);
+	m_shaderStageCI[0].module = pShaderCache->Create(EmbeddedShaders::cexp_vertexShader, sizeof(EmbeddedShaders::cexp_vertexShader));
 	m_shaderStageCI[0].pName = "main";
 
 	m_shaderStageCI[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
 	m_shaderStageCI[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-	m_shaderStageCI[1].module = CVulkanPipeline::LoadCompiledShader(m_core.GetVkLogicalDevice(), FRAGMENT_SHADER_PATH);
+	m_shaderStageCI[1].module = pShaderCache->Create(EmbeddedShaders::cexp_fragmentShader, sizeof(EmbeddedShaders::cexp_fragmentShader));
 	m_shaderStageCI[1].pName = "main";
+
+	// The surface format is sRGB, the attachment encodes the output itself
+	m_fragmentConstants.Set(SampleFragmentConstants::cexp_encodeSrgb, !IsSrgbFormat(m_vkSurfaceFormat.format));
+	m_shaderStageCI[1].pSpecializationInfo = m_fragmentConstants.GetInfo();
 	
-	CBufferLayout vbLayout = {
-		{BufferAttribute::ShaderDataType::float3, "position"},
-		{BufferAttribute::ShaderDataType::float3, "color"} 
-	};
+	// Mesh vertices in binding 0, one offset and scale per instance in binding 1
+	m_pPipeline = new CVulkanPipeline(&m_core, m_pPass, m_shaderStageCI, SampleVertexLayout::cexp_inputState);
 
-	m_pPipeline = new CVulkanPipeline(&m_core, m_pPass, m_windowWidth, m_windowHeight, m_shaderStageCI, vbLayout);
-	m_pSwapchain = new CVulkanSwapchain(&m_core, m_windowWidth, m_windowHeight, m_vkSurface, m_vkSurfaceFormat, m_pPass->GetHandle());
+	std::cout << "[PIPELINE CACHE] " << (m_core.IsPipelineCacheWarm() ? "warm" : "cold") << " start, cache loaded in "
+		<< m_core.GetPipelineCacheLoadTime() << " ms, pipeline created in " << m_pPipeline->GetLastCreationTime() << " ms\n";
 
-	// Create synchronization objects
+	m_pSwapchain = new CVulkanSwapchain(&m_core, m_windowWidth, m_windowHeight, m_vkSurface, m_vkSurfaceFormat, m_pPass->GetHandle(), presentPolicy);
 
-	VkSemaphoreCreateInfo semaphoreCI = {};
-	semaphoreCI.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+	m_pFrameRing = new CVulkanFrameRing(&m_core, framesInFlight, m_pSwapchain->GetFramebufferCount());
+	m_pGpuProfiler = new CVulkanGpuProfiler(&m_core, m_pFrameRing->GetFramesInFlight());
+	if (!m_pGpuProfiler->IsEnabled()) {
+		std::cout << "[GPU PROFILER] Timestamps are not supported by the graphics queue, profiling disabled\n";
+	}
+	m_pRecorder = new CVulkanParallelRecorder(&m_core, m_pFrameRing->GetFramesInFlight());
+	m_pDrawList = new CVulkanDrawList(&m_core, m_pFrameRing->GetFramesInFlight());
+
+	// Create vertex buffer
+	const SampleVertex vertices[] = {
+		{ {  0.0f,-1.0f, 0.0f }, { 1.0f, 0.5f, 0.5f } },
+		{ {  1.0f, 1.0f, 0.0f }, { 0.1f, 1.0f, 0.4f } },
+		{ { -1.0f, 1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f } } };
 
-	VkFenceCreateInfo fenceCI = {};
-	fenceCI.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-	fenceCI.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+	m_pVertexBuffer = new CVulkanBuffer(&m_core, vertices, sizeof(vertices),
+		{ VkBufferUsageFlagBits::VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, BufferMemory::DeviceLocal });
 
-	m_vkRenderDoneSemVec.resize(m_pSwapchain->GetFramebufferCount());
+	const uint32_t indices[] = { 0, 1, 2 };
+	m_pIndexBuffer = new CVulkanIndexBuffer(&m_core, indices, 3u, 3u);
 
-	for (auto &fb : m_vkRenderDoneSemVec) {
-		VkSemaphore semaphore = VK_NULL_HANDLE;
-		if (vkCreateSemaphore(m_core.GetVkLogicalDevice(), &semaphoreCI, nullptr, &semaphore) != VK_SUCCESS) {
-			throw std::runtime_error("[Runtime error] failed to create semaphores");
+	const SampleInstance instance = { { 0.0f, 0.0f, 1.0f, 0.0f } };
+	m_pInstanceBuffer = new CVulkanBuffer(&m_core, &instance, sizeof(instance),
+		{ VkBufferUsageFlagBits::VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, BufferMemory::DeviceLocal });
+}
+
+VulkanApp::Application::~Application() {
+	Stop();
+
+	if (!m_tracePath.empty()) {
+		CTracer::SetEnabled(false);
+		if (CTracer::WriteChromeTrace(m_tracePath, cexp_traceFrameCount)) {
+			std::cout << "[TRACE] last " << cexp_traceFrameCount << " frames written to " << m_tracePath << "\n";
 		}
-		fb = semaphore;
 	}
 
-	if (vkCreateSemaphore(m_core.GetVkLogicalDevice(), &semaphoreCI, nullptr, &m_vkImgRdySem) != VK_SUCCESS ||
-		vkCreateFence(m_core.GetVkLogicalDevice(), &fenceCI, nullptr, &m_vkFence) != VK_SUCCESS) {
-		throw std::runtime_error("[Runtime error] failed to create semaphores");
+	if (m_presentLatency.GetCount() > 0u) {
+		std::cout << "[PRESENT] " << string_VkPresentModeKHR(m_pSwapchain->GetPresentMode())
+			<< ", acquire to present min " << m_presentLatency.GetMin() << " ms, avg " << m_presentLatency.GetAverage()
+			<< " ms, p99 " << m_presentLatency.GetPercentile(99.0) << " ms\n";
 	}
 
-	// Create vertex buffer
-	const float vertDataRaw[] = { 
-		 0.0,-1.0, 0.0,      1.0, 0.5, 0.5,
-		 1.0, 1.0, 0.0,      0.1, 1.0, 0.4,
-		-1.0, 1.0, 0.0,      0.0, 0.0, 1.0 };
-
-	m_pVertexBuffer = new CVulkanBuffer(&m_core, vertDataRaw, 3 * vbLayout.GetByteSize(), VkBufferUsageFlagBits::VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
-}
+	if (m_pGpuProfiler) {
+		for (const auto &scope : m_pGpuProfiler->GetStatistics()) {
+			std::cout << "[GPU PROFILER] " << scope.first << " min " << scope.second.GetMin() << " ms, avg "
+				<< scope.second.GetAverage() << " ms, p99 " << scope.second.GetPercentile(99.0) << " ms\n";
+		}
+	}
 
-VulkanApp::Application::~Application() {
 	// Cleanup created Vulkan resources
 	vkDeviceWaitIdle(m_core.GetVkLogicalDevice());
-	vkDestroySemaphore(m_core.GetVkLogicalDevice(), m_vkImgRdySem, nullptr);
-	for (auto &fb : m_vkRenderDoneSemVec) {
-		vkDestroySemaphore(m_core.GetVkLogicalDevice(), fb, nullptr);
+
+	if (m_pGpuProfiler) {
+		delete m_pGpuProfiler;
+	}
+
+	if (m_pRecorder) {
+		delete m_pRecorder;
+	}
+
+	if (m_pDrawList) {
+		delete m_pDrawList;
+	}
+
+	if (m_pFrameRing) {
+		delete m_pFrameRing;
 	}
-	vkDestroyFence(m_core.GetVkLogicalDevice(), m_vkFence, nullptr);
 	
 	if (m_pVertexBuffer) {
 		delete m_pVertexBuffer;
 	}
 
+	if (m_pIndexBuffer) {
+		delete m_pIndexBuffer;
+	}
+
+	if (m_pInstanceBuffer) {
+		delete m_pInstanceBuffer;
+	}
+
 	if (m_pSwapchain) {
 		delete m_pSwapchain;
 	}
@@ -109,33 +162,188 @@ VulkanApp::Application::~Application() {
 		delete m_pPass;
 	}
 
-	vkDestroyShaderModule(m_core.GetVkLogicalDevice(), m_shaderStageCI[0].module, nullptr);
-	vkDestroyShaderModule(m_core.GetVkLogicalDevice(), m_shaderStageCI[1].module, nullptr);
 	vkDestroySurfaceKHR(m_core.GetVkInstance(), m_vkSurface, nullptr);
 }
 
-bool VulkanApp::Application::RenderFrame() {
-	if (m_windowClosed) {
-		return false;
+void VulkanApp::Application::Start() {
+	if (m_renderThread.joinable()) {
+		return;
 	}
-	if (m_windowMinimized) {
-		return true;
+
+	// Everything created so far is handed over, the thread start orders it before the first frame
+	m_stopRequested.store(false, std::memory_order_relaxed);
+	m_running.store(true, std::memory_order_release);
+	m_renderThread = std::thread(&Application::RenderThreadProcedure, this);
+}
+
+void VulkanApp::Application::Stop() {
+	if (!m_renderThread.joinable()) {
+		return;
 	}
-	vkWaitForFences(m_core.GetVkLogicalDevice(), 1u, &m_vkFence, VK_TRUE, UINT64_MAX);
-	vkResetFences(m_core.GetVkLogicalDevice(), 1u, &m_vkFence);
+
+	m_stopRequested.store(true, std::memory_order_relaxed);
+	m_renderThread.join();
+}
+
+void VulkanApp::Application::SetPresentPolicy(const PresentPolicy policy) {
+	RenderCommand command;
+	command.m_type = RenderCommandType::PresentPolicy;
+	command.m_presentPolicy = policy;
+	PushCommand(command);
+}
+
+void VulkanApp::Application::SetFrameRateLimit(const double frameRate) {
+	RenderCommand command;
+	command.m_type = RenderCommandType::FrameRateLimit;
+	command.m_frameRate = frameRate;
+	PushCommand(command);
+}
+
+void VulkanApp::Application::PushCommand(const RenderCommand &command) {
+	// Full only while the render thread is busy with a long frame, events are not dropped for that
+	while (!m_commands.TryPush(command)) {
+		if (!IsRunning()) {
+			return;
+		}
+		std::this_thread::yield();
+	}
+}
+
+void VulkanApp::Application::RenderThreadProcedure() {
+	while (!m_stopRequested.load(std::memory_order_relaxed)) {
+		ProcessCommands();
+		if (m_windowClosed) {
+			break;
+		}
+
+		// Nothing is presented while minimized and the queue cannot wake the thread
+		if (m_windowMinimized) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(cexp_idleSleepMs));
+			continue;
+		}
+
+		if (!RenderFrame()) {
+			break;
+		}
+	}
+
+	m_running.store(false, std::memory_order_release);
+}
+
+void VulkanApp::Application::ProcessCommands() {
+	TRACE_SCOPE("ProcessCommands");
+	RenderCommand command;
+	while (m_commands.TryPop(command)) {
+		switch (command.m_type)
+		{
+		case RenderCommandType::Resize:
+			// Only the size is taken here, the swapchain is recreated once before the next frame
+			if (command.m_width == 0u || command.m_height == 0u) {
+				m_windowMinimized = true;
+			}
+			else {
+				m_windowWidth = command.m_width;
+				m_windowHeight = command.m_height;
+				m_swapchainDirty = true;
+				m_windowMinimized = false;
+			}
+			break;
+
+		case RenderCommandType::Close:
+			m_windowClosed = true;
+			break;
+
+		case RenderCommandType::PresentPolicy:
+			if (m_pSwapchain->SetPresentPolicy(command.m_presentPolicy)) {
+				// Samples of the previous policy would skew the comparison
+				m_presentLatency.Reset();
+				m_swapchainDirty = true;
+			}
+			break;
+
+		case RenderCommandType::FrameRateLimit:
+			m_frameLimiter.SetTargetFrameRate(command.m_frameRate);
+			break;
+		}
+	}
+}
+
+bool VulkanApp::Application::RenderFrame() {
+	TRACE_NEXT_FRAME();
+	TRACE_SCOPE("RenderFrame");
 	try
 	{
-		uint32_t imgIndex = m_pSwapchain->GetNextImageIndex(m_vkImgRdySem);
+		if (m_swapchainDirty && !RecreateSwapchain()) {
+			// The surface has not settled on the window size yet, retry at the idle interval
+			std::this_thread::sleep_for(std::chrono::milliseconds(cexp_idleSleepMs));
+			return true;
+		}
+
+		// Pacing happens before the acquire, so the wait does not add to the latency of the frame
+		if (m_frameLimiter.IsEnabled()) {
+			TRACE_SCOPE("FrameLimiter");
+			m_frameLimiter.Wait();
+		}
+
+		FrameContext &frame = m_pFrameRing->BeginFrame();
+
+		// Retired swapchains go once the frame after their last present has finished
+		m_pSwapchain->ReleaseRetired(m_pFrameRing->GetCompletedFrame());
+		m_pRecorder->BeginFrame(m_pFrameRing->GetCurrentSlot());
+
+		DrawPacket triangle;
+		triangle.m_pipeline = m_pPipeline->GetHandle();
+		triangle.SetVertexBuffer(0u, m_pVertexBuffer->GetHandle());
+		triangle.SetVertexBuffer(1u, m_pInstanceBuffer->GetHandle());
+		triangle.m_indexBuffer = m_pIndexBuffer->GetHandle();
+		triangle.m_indexType = m_pIndexBuffer->GetIndexType();
+		triangle.m_count = m_pIndexBuffer->GetIndexCount();
+
+		m_pDrawList->Clear();
+		m_pDrawList->Add(triangle);
+		m_pDrawList->Build(m_pFrameRing->GetCurrentSlot());
+
+		const auto acquireStart = std::chrono::steady_clock::now();
+		uint32_t imgIndex = 0u;
+		VkResult result = m_pSwapchain->GetNextImageIndex(frame.m_vkImageAcquiredSem, &imgIndex);
+		if (result == VK_ERROR_OUT_OF_DATE_KHR) {
+			// Nothing was acquired, the slot stays unused until the next frame
+			m_swapchainDirty = true;
+			return true;
+		}
+		if (result == VK_SUBOPTIMAL_KHR) {
+			m_swapchainDirty = true;
+		}
+
+		m_pFrameRing->SetImageIndex(imgIndex);
+
+		// All uploads requested since the previous frame go out in one transfer submission
+		VkSemaphore uploadSem = m_core.GetUploader()->Flush(m_pFrameRing->GetCurrentSlot());
+		VkSemaphore renderDoneSem = m_pSwapchain->GetRenderDoneSemaphore(imgIndex);
+
 		m_pPass->SubmitWorkload(
+			frame.m_vkCommandBuffer,
 			m_core.m_vkQueue,
-			m_pVertexBuffer->GetHandle(),
-			m_pPipeline->GetHandle(),
-			m_vkImgRdySem,
-			m_vkRenderDoneSemVec[imgIndex],
-			m_vkFence,
+			*m_pDrawList,
+			frame.m_vkImageAcquiredSem,
+			uploadSem,
+			renderDoneSem,
+			frame.m_vkInFlightFence,
 			m_pSwapchain->GetFramebuffer(imgIndex),
-			{ {0,0}, {m_windowWidth, m_windowHeight} });
-		m_pSwapchain->PresentFrame(imgIndex, m_vkRenderDoneSemVec[imgIndex]);
+			{ {0,0}, m_pSwapchain->GetExtent() },
+			m_pGpuProfiler,
+			m_pFrameRing->GetCurrentSlot(),
+			m_pRecorder);
+
+		result = m_pSwapchain->PresentFrame(imgIndex, renderDoneSem);
+		if (result != VK_SUCCESS) {
+			m_swapchainDirty = true;
+		}
+
+		frame.m_acquireToPresentMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - acquireStart).count();
+		m_presentLatency.Add(frame.m_acquireToPresentMs);
+
+		m_pFrameRing->EndFrame();
 		return true;
 	}
 	catch (const std::exception &)
@@ -144,25 +352,33 @@ bool VulkanApp::Application::RenderFrame() {
 	}
 }
 
-void VulkanApp::Application::OnSizeChanged(const uint32_t width, const uint32_t height) {
-	if (width == 0) {
-		m_windowMinimized = true;
-	}
-	else {
-		vkWaitForFences(m_core.GetVkLogicalDevice(), 1u, &m_vkFence, VK_TRUE, UINT64_MAX);
-		m_windowWidth = width;
-		m_windowHeight = height;
-		m_pSwapchain->SetImageSize(width, height);
-		m_pSwapchain->Update();
-		m_pPipeline->m_viewport.width = static_cast<float>(width);
-		m_pPipeline->m_viewport.height = static_cast<float>(height);
-		m_pPipeline->m_scissorRect.extent.width = width;
-		m_pPipeline->m_scissorRect.extent.height = height;
-		m_pPipeline->Update();
-		m_windowMinimized = false;
+bool VulkanApp::Application::RecreateSwapchain() {
+	if (m_windowWidth == 0u || m_windowHeight == 0u) {
+		return false;
+	}
+
+	// The surface may briefly report an extent that differs from the last size event
+	if (!m_pSwapchain->SetImageSize(m_windowWidth, m_windowHeight)) {
+		return false;
 	}
+
+	// Frames already submitted keep using the old images, no device wait is needed
+	m_pSwapchain->Update(m_pFrameRing->GetLastSubmittedFrame());
+	m_pFrameRing->SetImageCount(m_pSwapchain->GetFramebufferCount());
+	m_swapchainDirty = false;
+	return true;
+}
+
+void VulkanApp::Application::OnSizeChanged(const uint32_t width, const uint32_t height) {
+	RenderCommand command;
+	command.m_type = RenderCommandType::Resize;
+	command.m_width = width;
+	command.m_height = height;
+	PushCommand(command);
 }
 
 void VulkanApp::Application::OnClose() {
-	m_windowClosed = true;
+	RenderCommand command;
+	command.m_type = RenderCommandType::Close;
+	PushCommand(command);
 }
\ No newline at end of file
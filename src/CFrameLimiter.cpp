@@ -0,0 +1,40 @@
+#include <CFrameLimiter.h>
+
+#include <thread>
+
+VulkanApp::CFrameLimiter::CFrameLimiter(const double targetFrameRate) {
+	SetTargetFrameRate(targetFrameRate);
+}
+
+void VulkanApp::CFrameLimiter::SetTargetFrameRate(const double targetFrameRate) {
+	m_targetFrameRate = targetFrameRate > 0.0 ? targetFrameRate : 0.0;
+	m_period = m_targetFrameRate > 0.0 ?
+		std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / m_targetFrameRate)) :
+		Clock::duration::zero();
+	m_deadline = Clock::now();
+}
+
+void VulkanApp::CFrameLimiter::Wait() {
+	if (!IsEnabled()) {
+		return;
+	}
+
+	m_deadline += m_period;
+
+	Clock::time_point now = Clock::now();
+	if (now >= m_deadline) {
+		// Too late to catch up, restart pacing from the current frame
+		if (now - m_deadline > m_period) {
+			m_deadline = now;
+		}
+		return;
+	}
+
+	if (m_deadline - now > cexp_spinThreshold) {
+		std::this_thread::sleep_until(m_deadline - cexp_spinThreshold);
+	}
+
+	while (Clock::now() < m_deadline) {
+		std::this_thread::yield();
+	}
+}
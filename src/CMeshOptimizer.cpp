@@ -0,0 +1,266 @@
+#include <CMeshOptimizer.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+
+#include <Utilities.h>
+#include <CTracer.h>
+
+namespace {
+	constexpr uint32_t cexp_unusedVertex = UINT32_MAX;
+	constexpr uint32_t cexp_fetchCacheLines = 256u; // 16 KiB with 64 byte lines
+
+	// Triangles using each vertex, as offsets into one shared list
+	struct VertexAdjacency {
+		std::vector<uint32_t> m_offsets;
+		std::vector<uint32_t> m_counts;
+		std::vector<uint32_t> m_triangles;
+	};
+
+	VertexAdjacency BuildAdjacency(const uint32_t *pIndices, const size_t indexCount, const uint32_t vertexCount) {
+		VertexAdjacency adjacency;
+		adjacency.m_offsets.resize(vertexCount, 0u);
+		adjacency.m_counts.resize(vertexCount, 0u);
+		adjacency.m_triangles.resize(indexCount);
+
+		for (size_t i = 0u; i < indexCount; i++) {
+			adjacency.m_counts[pIndices[i]]++;
+		}
+
+		uint32_t offset = 0u;
+		for (uint32_t v = 0u; v < vertexCount; v++) {
+			adjacency.m_offsets[v] = offset;
+			offset += adjacency.m_counts[v];
+		}
+
+		// Counts are rebuilt while filling the list
+		std::fill(adjacency.m_counts.begin(), adjacency.m_counts.end(), 0u);
+		for (size_t i = 0u; i < indexCount; i++) {
+			const uint32_t v = pIndices[i];
+			adjacency.m_triangles[adjacency.m_offsets[v] + adjacency.m_counts[v]++] = static_cast<uint32_t>(i / 3u);
+		}
+
+		return adjacency;
+	}
+
+	void ValidateIndices(const uint32_t *pIndices, const size_t indexCount, const uint32_t vertexCount) {
+		if (indexCount % 3u != 0u) {
+			throw std::runtime_error(UTIL_EXC_MSG("Index count is not a multiple of three"));
+		}
+
+		for (size_t i = 0u; i < indexCount; i++) {
+			if (pIndices[i] >= vertexCount) {
+				throw std::runtime_error(UTIL_EXC_MSG("Index is out of the vertex range"));
+			}
+		}
+	}
+}
+
+VulkanApp::MeshStatistics VulkanApp::CMeshOptimizer::Analyze(const uint32_t *pIndices, const size_t indexCount, const uint32_t vertexCount,
+	const uint32_t vertexStride, const uint32_t cacheSize) {
+
+	MeshStatistics statistics;
+	if (indexCount < 3u || vertexCount == 0u) {
+		return statistics;
+	}
+
+	ValidateIndices(pIndices, indexCount, vertexCount);
+
+	// A vertex is cached while fewer than cacheSize vertices were inserted after it
+	std::vector<uint32_t> insertedAt(vertexCount, 0u);
+	std::vector<bool> referenced(vertexCount, false);
+	uint32_t timestamp = cacheSize + 1u;
+	uint32_t transformed = 0u;
+	uint32_t referencedCount = 0u;
+
+	std::vector<uint64_t> fetchLines(cexp_fetchCacheLines, UINT64_MAX);
+	uint64_t fetchedBytes = 0u;
+
+	for (size_t i = 0u; i < indexCount; i++) {
+		const uint32_t v = pIndices[i];
+		if (!referenced[v]) {
+			referenced[v] = true;
+			referencedCount++;
+		}
+
+		if (timestamp - insertedAt[v] <= cacheSize) {
+			continue;
+		}
+		insertedAt[v] = timestamp++;
+		transformed++;
+
+		// Only transformed vertices are fetched, every line they touch goes through the cache
+		const uint64_t firstLine = static_cast<uint64_t>(v) * vertexStride / cexp_cacheLineSize;
+		const uint64_t lastLine = (static_cast<uint64_t>(v) * vertexStride + std::max(vertexStride, 1u) - 1u) / cexp_cacheLineSize;
+		for (uint64_t line = firstLine; line <= lastLine; line++) {
+			uint64_t &cachedLine = fetchLines[line % cexp_fetchCacheLines];
+			if (cachedLine != line) {
+				cachedLine = line;
+				fetchedBytes += cexp_cacheLineSize;
+			}
+		}
+	}
+
+	const uint32_t triangleCount = static_cast<uint32_t>(indexCount / 3u);
+	statistics.m_acmr = static_cast<float>(transformed) / static_cast<float>(triangleCount);
+	statistics.m_atvr = static_cast<float>(transformed) / static_cast<float>(referencedCount);
+	statistics.m_overfetch = vertexStride > 0u ?
+		static_cast<float>(fetchedBytes) / static_cast<float>(static_cast<uint64_t>(referencedCount) * vertexStride) : 0.0f;
+	return statistics;
+}
+
+void VulkanApp::CMeshOptimizer::OptimizeVertexCache(uint32_t *pDstIndices, const uint32_t *pIndices, const size_t indexCount,
+	const uint32_t vertexCount, const uint32_t cacheSize) {
+
+	TRACE_SCOPE("CMeshOptimizer::OptimizeVertexCache");
+
+	// Empty vectors may hand out null for both pointers, which is not aliasing
+	if (indexCount == 0u) {
+		return;
+	}
+	if (pDstIndices == pIndices) {
+		throw std::runtime_error(UTIL_EXC_MSG("Destination indices alias the source"));
+	}
+	ValidateIndices(pIndices, indexCount, vertexCount);
+
+	const VertexAdjacency adjacency = BuildAdjacency(pIndices, indexCount, vertexCount);
+	std::vector<uint32_t> liveTriangles = adjacency.m_counts;
+	std::vector<uint32_t> cacheTime(vertexCount, 0u);
+	std::vector<bool> emitted(indexCount / 3u, false);
+	std::vector<uint32_t> deadEnds;
+	std::vector<uint32_t> candidates;
+	deadEnds.reserve(indexCount);
+
+	uint32_t timestamp = cacheSize + 1u;
+	uint32_t cursor = 0u; // Next vertex checked in input order once the dead-end stack runs dry
+	size_t written = 0u;
+
+	uint32_t fanning = vertexCount > 0u ? 0u : cexp_unusedVertex;
+	while (fanning != cexp_unusedVertex) {
+		// Emit every remaining triangle around the fanning vertex
+		candidates.clear();
+		const uint32_t begin = adjacency.m_offsets[fanning];
+		const uint32_t end = begin + adjacency.m_counts[fanning];
+		for (uint32_t a = begin; a < end; a++) {
+			const uint32_t triangle = adjacency.m_triangles[a];
+			if (emitted[triangle]) {
+				continue;
+			}
+			emitted[triangle] = true;
+
+			for (uint32_t corner = 0u; corner < 3u; corner++) {
+				const uint32_t v = pIndices[triangle * 3u + corner];
+				pDstIndices[written++] = v;
+				deadEnds.push_back(v);
+				candidates.push_back(v);
+				liveTriangles[v]--;
+
+				if (timestamp - cacheTime[v] > cacheSize) {
+					cacheTime[v] = timestamp++;
+				}
+			}
+		}
+
+		// Prefer the candidate which is oldest in the cache but will not drop out while its fan is emitted
+		uint32_t next = cexp_unusedVertex;
+		int64_t bestPriority = -1;
+		for (const uint32_t v : candidates) {
+			if (liveTriangles[v] == 0u) {
+				continue;
+			}
+
+			int64_t priority = 0;
+			const int64_t age = static_cast<int64_t>(timestamp) - static_cast<int64_t>(cacheTime[v]);
+			if (age + 2 * static_cast<int64_t>(liveTriangles[v]) <= static_cast<int64_t>(cacheSize)) {
+				priority = age;
+			}
+
+			if (priority > bestPriority) {
+				bestPriority = priority;
+				next = v;
+			}
+		}
+
+		// Dead end, recently emitted vertices first, then the input order
+		while (next == cexp_unusedVertex && !deadEnds.empty()) {
+			const uint32_t v = deadEnds.back();
+			deadEnds.pop_back();
+			if (liveTriangles[v] > 0u) {
+				next = v;
+			}
+		}
+		while (next == cexp_unusedVertex && cursor < vertexCount) {
+			if (liveTriangles[cursor] > 0u) {
+				next = cursor;
+			}
+			cursor++;
+		}
+
+		fanning = next;
+	}
+}
+
+uint32_t VulkanApp::CMeshOptimizer::OptimizeVertexFetch(void *pDstVertices, uint32_t *pIndices, const size_t indexCount, const void *pVertices,
+	const uint32_t vertexCount, const uint32_t vertexStride) {
+
+	TRACE_SCOPE("CMeshOptimizer::OptimizeVertexFetch");
+
+	// Without indices no vertex is referenced, so none is kept
+	if (indexCount == 0u) {
+		return 0u;
+	}
+	if (pDstVertices == pVertices) {
+		throw std::runtime_error(UTIL_EXC_MSG("Destination vertices alias the source"));
+	}
+	ValidateIndices(pIndices, indexCount, vertexCount);
+
+	std::vector<uint32_t> remap(vertexCount, cexp_unusedVertex);
+	uint32_t nextVertex = 0u;
+
+	uint8_t *pDst = static_cast<uint8_t*>(pDstVertices);
+	const uint8_t *pSrc = static_cast<const uint8_t*>(pVertices);
+	for (size_t i = 0u; i < indexCount; i++) {
+		const uint32_t v = pIndices[i];
+		if (remap[v] == cexp_unusedVertex) {
+			remap[v] = nextVertex;
+			memcpy(pDst + static_cast<size_t>(nextVertex) * vertexStride, pSrc + static_cast<size_t>(v) * vertexStride, vertexStride);
+			nextVertex++;
+		}
+		pIndices[i] = remap[v];
+	}
+
+	return nextVertex;
+}
+
+VulkanApp::MeshOptimizationReport VulkanApp::CMeshOptimizer::Optimize(std::vector<uint8_t> &vertices, const uint32_t vertexStride,
+	std::vector<uint32_t> &indices, const uint32_t cacheSize) {
+
+	if (vertexStride == 0u || vertices.size() % vertexStride != 0u) {
+		throw std::runtime_error(UTIL_EXC_MSG("Vertex data is not a whole number of vertices"));
+	}
+
+	MeshOptimizationReport report;
+	const uint32_t vertexCount = static_cast<uint32_t>(vertices.size() / vertexStride);
+	report.m_before = Analyze(indices.data(), indices.size(), vertexCount, vertexStride, cacheSize);
+
+	const auto optimizationStart = std::chrono::steady_clock::now();
+
+	// The fetch order follows the triangle order, so the cache pass has to run first
+	std::vector<uint32_t> cacheOptimized(indices.size());
+	OptimizeVertexCache(cacheOptimized.data(), indices.data(), indices.size(), vertexCount, cacheSize);
+
+	std::vector<uint8_t> fetchOptimized(vertices.size());
+	report.m_vertexCount = OptimizeVertexFetch(fetchOptimized.data(), cacheOptimized.data(), cacheOptimized.size(),
+		vertices.data(), vertexCount, vertexStride);
+	fetchOptimized.resize(static_cast<size_t>(report.m_vertexCount) * vertexStride);
+
+	report.m_optimizationMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - optimizationStart).count();
+
+	indices.swap(cacheOptimized);
+	vertices.swap(fetchOptimized);
+
+	report.m_after = Analyze(indices.data(), indices.size(), report.m_vertexCount, vertexStride, cacheSize);
+	return report;
+}
@@ -0,0 +1,26 @@
+#include <CNullWindow.h>
+
+#include <chrono>
+#include <thread>
+
+CNullWindow::CNullWindow(const uint32_t width, const uint32_t height) {
+	// Listeners learn the size the same way as from a system window
+	WindowEvent createEvent;
+	createEvent.m_type = WindowEventType::Create;
+	PushEvent(createEvent);
+
+	WindowEvent resizeEvent;
+	resizeEvent.m_type = WindowEventType::Resize;
+	resizeEvent.m_width = width;
+	resizeEvent.m_height = height;
+	PushEvent(resizeEvent);
+}
+
+VkResult CNullWindow::CreateSurface(const VkInstance /*instance*/, VkSurfaceKHR *pSurface) const {
+	*pSurface = VK_NULL_HANDLE;
+	return VK_ERROR_EXTENSION_NOT_PRESENT;
+}
+
+void CNullWindow::WaitSystemEvents(const uint32_t timeoutMs) {
+	std::this_thread::sleep_for(std::chrono::milliseconds(timeoutMs));
+}
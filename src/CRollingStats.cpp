@@ -0,0 +1,69 @@
+#include <CRollingStats.h>
+
+#include <algorithm>
+#include <cmath>
+
+VulkanApp::CRollingStats::CRollingStats(const uint32_t window)
+	: m_samples(std::max(window, 1u), 0.0) {
+}
+
+void VulkanApp::CRollingStats::Add(const double value) {
+	if (m_count == m_samples.size()) {
+		m_sum -= m_samples[m_next];
+	}
+	else {
+		m_count++;
+	}
+
+	m_samples[m_next] = value;
+	m_sum += value;
+	m_next = (m_next + 1u) % static_cast<uint32_t>(m_samples.size());
+}
+
+void VulkanApp::CRollingStats::Reset() {
+	m_next = 0u;
+	m_count = 0u;
+	m_sum = 0.0;
+}
+
+double VulkanApp::CRollingStats::GetLast() const {
+	if (m_count == 0u) {
+		return 0.0;
+	}
+	const uint32_t size = static_cast<uint32_t>(m_samples.size());
+	return m_samples[(m_next + size - 1u) % size];
+}
+
+double VulkanApp::CRollingStats::GetMin() const {
+	if (m_count == 0u) {
+		return 0.0;
+	}
+	return *std::min_element(m_samples.cbegin(), m_samples.cbegin() + m_count);
+}
+
+double VulkanApp::CRollingStats::GetMax() const {
+	if (m_count == 0u) {
+		return 0.0;
+	}
+	return *std::max_element(m_samples.cbegin(), m_samples.cbegin() + m_count);
+}
+
+double VulkanApp::CRollingStats::GetAverage() const {
+	if (m_count == 0u) {
+		return 0.0;
+	}
+	return m_sum / m_count;
+}
+
+double VulkanApp::CRollingStats::GetPercentile(const double percentile) const {
+	if (m_count == 0u) {
+		return 0.0;
+	}
+
+	// Nearest rank on a copy, the window is small enough
+	std::vector<double> sorted(m_samples.cbegin(), m_samples.cbegin() + m_count);
+	const double rank = std::ceil(std::clamp(percentile, 0.0, 100.0) / 100.0 * m_count);
+	const size_t index = static_cast<size_t>(std::max(rank, 1.0)) - 1u;
+	std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+	return sorted[index];
+}
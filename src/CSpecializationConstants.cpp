@@ -0,0 +1,80 @@
+#include <CSpecializationConstants.h>
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include <Utilities.h>
+
+void VulkanApp::CSpecializationConstants::SetRaw(const uint32_t constantId, const void *data, const uint32_t byteSize) {
+	auto itr = std::find_if(m_entries.begin(), m_entries.end(), [constantId](const VkSpecializationMapEntry &entry) {
+		return entry.constantID == constantId;
+	});
+
+	if (itr != m_entries.end()) {
+		if (itr->size != byteSize) {
+			throw std::runtime_error(UTIL_EXC_MSG("Specialization constant was set before with another size"));
+		}
+		memcpy(m_data.data() + itr->offset, data, byteSize);
+		return;
+	}
+
+	VkSpecializationMapEntry entry = {};
+	entry.constantID = constantId;
+	entry.offset = static_cast<uint32_t>(m_data.size());
+	entry.size = byteSize;
+	m_entries.push_back(entry);
+
+	m_data.resize(m_data.size() + byteSize);
+	memcpy(m_data.data() + entry.offset, data, byteSize);
+}
+
+void VulkanApp::CSpecializationConstants::Assign(const VkSpecializationInfo *pInfo) {
+	Clear();
+	if (pInfo == nullptr) {
+		return;
+	}
+
+	for (uint32_t i = 0u; i < pInfo->mapEntryCount; i++) {
+		const VkSpecializationMapEntry &entry = pInfo->pMapEntries[i];
+		if (entry.offset + entry.size > pInfo->dataSize) {
+			throw std::runtime_error(UTIL_EXC_MSG("Specialization map entry lies outside of the data"));
+		}
+		SetRaw(entry.constantID, static_cast<const uint8_t*>(pInfo->pData) + entry.offset, static_cast<uint32_t>(entry.size));
+	}
+}
+
+void VulkanApp::CSpecializationConstants::Clear() {
+	m_entries.clear();
+	m_data.clear();
+}
+
+const VkSpecializationInfo* VulkanApp::CSpecializationConstants::GetInfo() {
+	if (m_entries.empty()) {
+		return nullptr;
+	}
+
+	// Refreshed on every call, copies of the object must not point into the original
+	m_info.mapEntryCount = static_cast<uint32_t>(m_entries.size());
+	m_info.pMapEntries = m_entries.data();
+	m_info.dataSize = m_data.size();
+	m_info.pData = m_data.data();
+	return &m_info;
+}
+
+uint64_t VulkanApp::CSpecializationConstants::GetHash(const uint64_t seed) const {
+	uint64_t hash = seed;
+	for (const auto &entry : m_entries) {
+		const uint32_t fields[] = { entry.constantID, entry.offset, static_cast<uint32_t>(entry.size) };
+		hash = Hash64(fields, sizeof(fields), hash);
+	}
+	return m_data.empty() ? hash : Hash64(m_data.data(), m_data.size(), hash);
+}
+
+bool VulkanApp::CSpecializationConstants::operator==(const CSpecializationConstants &other) const {
+	const bool sameEntries = std::equal(m_entries.begin(), m_entries.end(), other.m_entries.begin(), other.m_entries.end(),
+		[](const VkSpecializationMapEntry &a, const VkSpecializationMapEntry &b) {
+			return a.constantID == b.constantID && a.offset == b.offset && a.size == b.size;
+		});
+	return sameEntries && m_data == other.m_data;
+}
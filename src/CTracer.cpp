@@ -0,0 +1,136 @@
+#include <CTracer.h>
+
+#include <array>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+	struct ThreadEvents {
+		uint32_t m_threadId = 0u;
+		std::array<VulkanApp::TraceEvent, VulkanApp::CTracer::cexp_eventsPerThread> m_events;
+		std::atomic<uint64_t> m_head = 0u; // Total number of events written
+	};
+
+	// Rings stay registered after their thread exits, so its events can still be written out
+	std::mutex g_registryMutex;
+	std::vector<std::unique_ptr<ThreadEvents>> g_registry;
+
+	const std::chrono::steady_clock::time_point g_epoch = std::chrono::steady_clock::now();
+
+	ThreadEvents& GetThreadEvents() {
+		thread_local ThreadEvents *pEvents = nullptr;
+		if (pEvents == nullptr) {
+			std::lock_guard<std::mutex> lock(g_registryMutex);
+			g_registry.push_back(std::make_unique<ThreadEvents>());
+			pEvents = g_registry.back().get();
+			pEvents->m_threadId = static_cast<uint32_t>(g_registry.size());
+		}
+		return *pEvents;
+	}
+
+	void WriteEscaped(std::ofstream &file, const char *text) {
+		for (const char *c = text; *c != '\0'; c++) {
+			if (*c == '"' || *c == '\\') {
+				file << '\\';
+			}
+			file << *c;
+		}
+	}
+}
+
+std::atomic<bool> VulkanApp::CTracer::s_enabled = false;
+std::atomic<uint64_t> VulkanApp::CTracer::s_frame = 0u;
+
+int64_t VulkanApp::CTracer::Now() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - g_epoch).count();
+}
+
+void VulkanApp::CTracer::Record(const char *name, const int64_t beginNs, const int64_t endNs) {
+	ThreadEvents &thread = GetThreadEvents();
+	const uint64_t head = thread.m_head.load(std::memory_order_relaxed);
+
+	TraceEvent &event = thread.m_events[head % cexp_eventsPerThread];
+	event.m_name = name;
+	event.m_beginNs = beginNs;
+	event.m_durationNs = endNs - beginNs;
+	event.m_frame = GetFrame();
+
+	thread.m_head.store(head + 1u, std::memory_order_release);
+}
+
+bool VulkanApp::CTracer::WriteChromeTrace(const std::string &filePath, const uint32_t frameCount) {
+	std::ofstream file(filePath, std::ios::out | std::ios::trunc);
+	if (!file.is_open()) {
+		return false;
+	}
+
+	const uint64_t currentFrame = GetFrame();
+	const uint64_t firstFrame = (frameCount == 0u || currentFrame < frameCount) ? 0u : currentFrame - frameCount + 1u;
+
+	file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+	bool first = true;
+
+	std::lock_guard<std::mutex> lock(g_registryMutex);
+	for (const auto &pThread : g_registry) {
+		const uint64_t head = pThread->m_head.load(std::memory_order_acquire);
+		const uint64_t begin = head > cexp_eventsPerThread ? head - cexp_eventsPerThread : 0u;
+
+		for (uint64_t i = begin; i < head; i++) {
+			const TraceEvent &event = pThread->m_events[i % cexp_eventsPerThread];
+			if (event.m_name == nullptr || event.m_frame < firstFrame) {
+				continue;
+			}
+
+			// Complete events, timestamps in microseconds
+			file << (first ? "\n" : ",\n") << "{\"name\":\"";
+			WriteEscaped(file, event.m_name);
+			file << "\",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":1,\"tid\":" << pThread->m_threadId
+				<< ",\"ts\":" << event.m_beginNs / 1000.0
+				<< ",\"dur\":" << event.m_durationNs / 1000.0
+				<< ",\"args\":{\"frame\":" << event.m_frame << "}}";
+			first = false;
+		}
+	}
+
+	file << "\n]}\n";
+	return file.good();
+}
+
+double VulkanApp::CTracer::MeasureScopeOverhead(const uint32_t iterations) {
+	if (iterations == 0u) {
+		return 0.0;
+	}
+
+	// The measurement must not evict real events from the ring
+	ThreadEvents &thread = GetThreadEvents();
+	const uint64_t head = thread.m_head.load(std::memory_order_relaxed);
+	std::vector<TraceEvent> saved(thread.m_events.cbegin(), thread.m_events.cend());
+
+	const int64_t begin = Now();
+	for (uint32_t i = 0u; i < iterations; i++) {
+		CTraceScope scope("TraceOverhead");
+	}
+	const int64_t end = Now();
+
+	std::copy(saved.cbegin(), saved.cend(), thread.m_events.begin());
+	thread.m_head.store(head, std::memory_order_release);
+
+	return static_cast<double>(end - begin) / iterations;
+}
+
+std::string VulkanApp::CTracer::EnableFromEnvironment(const char *variable) {
+#if VULKANAPP_TRACING
+	const char *tracePath = std::getenv(variable);
+	if (tracePath && *tracePath) {
+		std::cout << "[TRACE] scope overhead " << MeasureScopeOverhead() << " ns disabled, ";
+		SetEnabled(true);
+		std::cout << MeasureScopeOverhead() << " ns enabled\n";
+		return tracePath;
+	}
+#endif
+	return std::string();
+}
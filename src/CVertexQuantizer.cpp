@@ -0,0 +1,523 @@
+#include <CVertexQuantizer.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+#include <Utilities.h>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define QUANTIZER_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define QUANTIZER_TARGET_SSE2
+#define QUANTIZER_TARGET_AVX2
+#else
+#define QUANTIZER_TARGET_SSE2 __attribute__((target("sse2")))
+#define QUANTIZER_TARGET_AVX2 __attribute__((target("avx2,f16c")))
+#endif
+#endif
+
+namespace {
+	using VulkanApp::BufferAttribute;
+	using VulkanApp::QuantizerIsa;
+
+	constexpr size_t cexp_stridedBatch = 256u; // Vertices gathered into a packed batch at a time
+
+	// Same operand order as minps/maxps, so NaN ends up at the lower bound on every path
+	inline float Saturate(const float value, const float low, const float high) {
+		const float clampedLow = value > low ? value : low;
+		return clampedLow < high ? clampedLow : high;
+	}
+
+	// Round to nearest even, like cvtps2dq with the default MXCSR
+	inline int32_t RoundToInt(const float value) {
+		return static_cast<int32_t>(std::nearbyint(value));
+	}
+
+	// Scalar kernels, also used for the tails of the vectorized ones
+
+	void HalfScalar(uint16_t *pDst, const float *pSrc, const size_t count) {
+		for (size_t i = 0u; i < count; i++) {
+			pDst[i] = VulkanApp::CVertexQuantizer::FloatToHalf(pSrc[i]);
+		}
+	}
+
+	void Snorm16Scalar(int16_t *pDst, const float *pSrc, const size_t count) {
+		for (size_t i = 0u; i < count; i++) {
+			pDst[i] = static_cast<int16_t>(RoundToInt(Saturate(pSrc[i], -1.0f, 1.0f) * 32767.0f));
+		}
+	}
+
+	void Unorm16Scalar(uint16_t *pDst, const float *pSrc, const size_t count) {
+		for (size_t i = 0u; i < count; i++) {
+			pDst[i] = static_cast<uint16_t>(RoundToInt(Saturate(pSrc[i], 0.0f, 1.0f) * 65535.0f));
+		}
+	}
+
+	void Unorm8Scalar(uint8_t *pDst, const float *pSrc, const size_t count) {
+		for (size_t i = 0u; i < count; i++) {
+			pDst[i] = static_cast<uint8_t>(RoundToInt(Saturate(pSrc[i], 0.0f, 1.0f) * 255.0f));
+		}
+	}
+
+	void Unorm10x3a2Scalar(uint32_t *pDst, const float *pSrc, const size_t vertexCount) {
+		for (size_t i = 0u; i < vertexCount; i++) {
+			const float *pVertex = pSrc + i * 4u;
+			const uint32_t r = static_cast<uint32_t>(RoundToInt(Saturate(pVertex[0], 0.0f, 1.0f) * 1023.0f));
+			const uint32_t g = static_cast<uint32_t>(RoundToInt(Saturate(pVertex[1], 0.0f, 1.0f) * 1023.0f));
+			const uint32_t b = static_cast<uint32_t>(RoundToInt(Saturate(pVertex[2], 0.0f, 1.0f) * 1023.0f));
+			const uint32_t a = static_cast<uint32_t>(RoundToInt(Saturate(pVertex[3], 0.0f, 1.0f) * 3.0f));
+			pDst[i] = r | (g << 10) | (b << 20) | (a << 30);
+		}
+	}
+
+#ifdef QUANTIZER_X86
+
+	// SSE2 kernels
+
+	QUANTIZER_TARGET_SSE2 inline __m128i ScaleToInt(const __m128 value, const __m128 low, const __m128 high, const __m128 scale) {
+		return _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(value, low), high), scale));
+	}
+
+	// Rounding half conversion without F16C, same bit tricks as FloatToHalf()
+	QUANTIZER_TARGET_SSE2 inline __m128i FloatToHalfSSE2(const __m128 value) {
+		const __m128i signMask = _mm_set1_epi32(static_cast<int32_t>(0x80000000u));
+		const __m128i bits = _mm_castps_si128(value);
+		const __m128i sign = _mm_and_si128(bits, signMask);
+		const __m128i absBits = _mm_xor_si128(bits, sign);
+
+		const __m128i isNan = _mm_cmpgt_epi32(absBits, _mm_set1_epi32(255 << 23));
+		const __m128i isFinite = _mm_cmpgt_epi32(_mm_set1_epi32((127 + 16) << 23), absBits);
+		const __m128i isSubnormal = _mm_cmpgt_epi32(_mm_set1_epi32(113 << 23), absBits);
+		const __m128i infOrNan = _mm_or_si128(_mm_set1_epi32(0x7c00), _mm_and_si128(isNan, _mm_set1_epi32(0x0200)));
+
+		// Subnormals are rounded by the FPU when the magic number is added
+		const __m128i subnormalMagic = _mm_set1_epi32(((127 - 15) + (23 - 10) + 1) << 23);
+		const __m128i subnormal = _mm_sub_epi32(
+			_mm_castps_si128(_mm_add_ps(_mm_castsi128_ps(absBits), _mm_castsi128_ps(subnormalMagic))), subnormalMagic);
+
+		// Normals rebias the exponent and round the mantissa to nearest even
+		const __m128i mantissaOdd = _mm_srai_epi32(_mm_slli_epi32(absBits, 31 - 13), 31);
+		const __m128i rounded = _mm_sub_epi32(_mm_add_epi32(absBits, _mm_set1_epi32(0xfff - ((127 - 15) << 23))), mantissaOdd);
+		const __m128i normal = _mm_srli_epi32(rounded, 13);
+
+		const __m128i finite = _mm_or_si128(_mm_and_si128(isSubnormal, subnormal), _mm_andnot_si128(isSubnormal, normal));
+		const __m128i joined = _mm_or_si128(_mm_and_si128(isFinite, finite), _mm_andnot_si128(isFinite, infOrNan));
+		return _mm_or_si128(joined, _mm_srli_epi32(sign, 16));
+	}
+
+	// Sign extension first, so the saturating pack keeps all 16 bits
+	QUANTIZER_TARGET_SSE2 inline __m128i PackLow16(const __m128i a, const __m128i b) {
+		return _mm_packs_epi32(_mm_srai_epi32(_mm_slli_epi32(a, 16), 16), _mm_srai_epi32(_mm_slli_epi32(b, 16), 16));
+	}
+
+	QUANTIZER_TARGET_SSE2 void HalfSSE2(uint16_t *pDst, const float *pSrc, const size_t count) {
+		size_t i = 0u;
+		for (; i + 8u <= count; i += 8u) {
+			const __m128i a = FloatToHalfSSE2(_mm_loadu_ps(pSrc + i));
+			const __m128i b = FloatToHalfSSE2(_mm_loadu_ps(pSrc + i + 4u));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + i), PackLow16(a, b));
+		}
+		HalfScalar(pDst + i, pSrc + i, count - i);
+	}
+
+	QUANTIZER_TARGET_SSE2 void Snorm16SSE2(int16_t *pDst, const float *pSrc, const size_t count) {
+		const __m128 low = _mm_set1_ps(-1.0f);
+		const __m128 high = _mm_set1_ps(1.0f);
+		const __m128 scale = _mm_set1_ps(32767.0f);
+
+		size_t i = 0u;
+		for (; i + 8u <= count; i += 8u) {
+			const __m128i a = ScaleToInt(_mm_loadu_ps(pSrc + i), low, high, scale);
+			const __m128i b = ScaleToInt(_mm_loadu_ps(pSrc + i + 4u), low, high, scale);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + i), _mm_packs_epi32(a, b));
+		}
+		Snorm16Scalar(pDst + i, pSrc + i, count - i);
+	}
+
+	QUANTIZER_TARGET_SSE2 void Unorm16SSE2(uint16_t *pDst, const float *pSrc, const size_t count) {
+		const __m128 low = _mm_setzero_ps();
+		const __m128 high = _mm_set1_ps(1.0f);
+		const __m128 scale = _mm_set1_ps(65535.0f);
+		const __m128i bias = _mm_set1_epi32(32768);
+		const __m128i bias16 = _mm_set1_epi16(static_cast<int16_t>(0x8000));
+
+		// No unsigned 32 to 16 bit pack before SSE4.1, the range is shifted into the signed one and back
+		size_t i = 0u;
+		for (; i + 8u <= count; i += 8u) {
+			const __m128i a = _mm_sub_epi32(ScaleToInt(_mm_loadu_ps(pSrc + i), low, high, scale), bias);
+			const __m128i b = _mm_sub_epi32(ScaleToInt(_mm_loadu_ps(pSrc + i + 4u), low, high, scale), bias);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + i), _mm_xor_si128(_mm_packs_epi32(a, b), bias16));
+		}
+		Unorm16Scalar(pDst + i, pSrc + i, count - i);
+	}
+
+	QUANTIZER_TARGET_SSE2 void Unorm8SSE2(uint8_t *pDst, const float *pSrc, const size_t count) {
+		const __m128 low = _mm_setzero_ps();
+		const __m128 high = _mm_set1_ps(1.0f);
+		const __m128 scale = _mm_set1_ps(255.0f);
+
+		size_t i = 0u;
+		for (; i + 16u <= count; i += 16u) {
+			const __m128i a = ScaleToInt(_mm_loadu_ps(pSrc + i), low, high, scale);
+			const __m128i b = ScaleToInt(_mm_loadu_ps(pSrc + i + 4u), low, high, scale);
+			const __m128i c = ScaleToInt(_mm_loadu_ps(pSrc + i + 8u), low, high, scale);
+			const __m128i d = ScaleToInt(_mm_loadu_ps(pSrc + i + 12u), low, high, scale);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + i), _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d)));
+		}
+		Unorm8Scalar(pDst + i, pSrc + i, count - i);
+	}
+
+	QUANTIZER_TARGET_SSE2 void Unorm10x3a2SSE2(uint32_t *pDst, const float *pSrc, const size_t vertexCount) {
+		const __m128 low = _mm_setzero_ps();
+		const __m128 high = _mm_set1_ps(1.0f);
+		const __m128 scale10 = _mm_set1_ps(1023.0f);
+		const __m128 scale2 = _mm_set1_ps(3.0f);
+
+		// Four vertices are transposed so every component gets its own register and a constant shift
+		size_t i = 0u;
+		for (; i + 4u <= vertexCount; i += 4u) {
+			__m128 r = _mm_loadu_ps(pSrc + i * 4u);
+			__m128 g = _mm_loadu_ps(pSrc + i * 4u + 4u);
+			__m128 b = _mm_loadu_ps(pSrc + i * 4u + 8u);
+			__m128 a = _mm_loadu_ps(pSrc + i * 4u + 12u);
+			_MM_TRANSPOSE4_PS(r, g, b, a);
+
+			__m128i packed = ScaleToInt(r, low, high, scale10);
+			packed = _mm_or_si128(packed, _mm_slli_epi32(ScaleToInt(g, low, high, scale10), 10));
+			packed = _mm_or_si128(packed, _mm_slli_epi32(ScaleToInt(b, low, high, scale10), 20));
+			packed = _mm_or_si128(packed, _mm_slli_epi32(ScaleToInt(a, low, high, scale2), 30));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + i), packed);
+		}
+		Unorm10x3a2Scalar(pDst + i, pSrc + i * 4u, vertexCount - i);
+	}
+
+	// AVX2 kernels, 256 bit packs work per 128 bit lane and are followed by a cross lane permute
+
+	QUANTIZER_TARGET_AVX2 inline __m256i ScaleToInt256(const __m256 value, const __m256 low, const __m256 high, const __m256 scale) {
+		return _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_min_ps(_mm256_max_ps(value, low), high), scale));
+	}
+
+	QUANTIZER_TARGET_AVX2 void HalfAVX2(uint16_t *pDst, const float *pSrc, const size_t count) {
+		size_t i = 0u;
+		for (; i + 8u <= count; i += 8u) {
+			const __m128i half = _mm256_cvtps_ph(_mm256_loadu_ps(pSrc + i), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + i), half);
+		}
+		HalfScalar(pDst + i, pSrc + i, count - i);
+	}
+
+	QUANTIZER_TARGET_AVX2 void Snorm16AVX2(int16_t *pDst, const float *pSrc, const size_t count) {
+		const __m256 low = _mm256_set1_ps(-1.0f);
+		const __m256 high = _mm256_set1_ps(1.0f);
+		const __m256 scale = _mm256_set1_ps(32767.0f);
+
+		size_t i = 0u;
+		for (; i + 16u <= count; i += 16u) {
+			const __m256i a = ScaleToInt256(_mm256_loadu_ps(pSrc + i), low, high, scale);
+			const __m256i b = ScaleToInt256(_mm256_loadu_ps(pSrc + i + 8u), low, high, scale);
+			const __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(a, b), 0xD8);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(pDst + i), packed);
+		}
+		Snorm16Scalar(pDst + i, pSrc + i, count - i);
+	}
+
+	QUANTIZER_TARGET_AVX2 void Unorm16AVX2(uint16_t *pDst, const float *pSrc, const size_t count) {
+		const __m256 low = _mm256_setzero_ps();
+		const __m256 high = _mm256_set1_ps(1.0f);
+		const __m256 scale = _mm256_set1_ps(65535.0f);
+
+		size_t i = 0u;
+		for (; i + 16u <= count; i += 16u) {
+			const __m256i a = ScaleToInt256(_mm256_loadu_ps(pSrc + i), low, high, scale);
+			const __m256i b = ScaleToInt256(_mm256_loadu_ps(pSrc + i + 8u), low, high, scale);
+			const __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(a, b), 0xD8);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(pDst + i), packed);
+		}
+		Unorm16Scalar(pDst + i, pSrc + i, count - i);
+	}
+
+	QUANTIZER_TARGET_AVX2 void Unorm8AVX2(uint8_t *pDst, const float *pSrc, const size_t count) {
+		const __m256 low = _mm256_setzero_ps();
+		const __m256 high = _mm256_set1_ps(1.0f);
+		const __m256 scale = _mm256_set1_ps(255.0f);
+		const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+
+		size_t i = 0u;
+		for (; i + 32u <= count; i += 32u) {
+			const __m256i a = ScaleToInt256(_mm256_loadu_ps(pSrc + i), low, high, scale);
+			const __m256i b = ScaleToInt256(_mm256_loadu_ps(pSrc + i + 8u), low, high, scale);
+			const __m256i c = ScaleToInt256(_mm256_loadu_ps(pSrc + i + 16u), low, high, scale);
+			const __m256i d = ScaleToInt256(_mm256_loadu_ps(pSrc + i + 24u), low, high, scale);
+			const __m256i packed = _mm256_packus_epi16(_mm256_packs_epi32(a, b), _mm256_packs_epi32(c, d));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(pDst + i), _mm256_permutevar8x32_epi32(packed, order));
+		}
+		Unorm8Scalar(pDst + i, pSrc + i, count - i);
+	}
+
+	QUANTIZER_TARGET_AVX2 inline __m256 LoadVertexPair(const float *pLow, const float *pHigh) {
+		return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(pLow)), _mm_loadu_ps(pHigh), 1);
+	}
+
+	QUANTIZER_TARGET_AVX2 void Unorm10x3a2AVX2(uint32_t *pDst, const float *pSrc, const size_t vertexCount) {
+		const __m256 low = _mm256_setzero_ps();
+		const __m256 high = _mm256_set1_ps(1.0f);
+		const __m256 scale10 = _mm256_set1_ps(1023.0f);
+		const __m256 scale2 = _mm256_set1_ps(3.0f);
+
+		// Vertex n and n + 4 share a register, the per lane transpose then yields components in vertex order
+		size_t i = 0u;
+		for (; i + 8u <= vertexCount; i += 8u) {
+			const float *pVertices = pSrc + i * 4u;
+			const __m256 v04 = LoadVertexPair(pVertices, pVertices + 16u);
+			const __m256 v15 = LoadVertexPair(pVertices + 4u, pVertices + 20u);
+			const __m256 v26 = LoadVertexPair(pVertices + 8u, pVertices + 24u);
+			const __m256 v37 = LoadVertexPair(pVertices + 12u, pVertices + 28u);
+
+			const __m256 rg01 = _mm256_unpacklo_ps(v04, v15);
+			const __m256 ba01 = _mm256_unpackhi_ps(v04, v15);
+			const __m256 rg23 = _mm256_unpacklo_ps(v26, v37);
+			const __m256 ba23 = _mm256_unpackhi_ps(v26, v37);
+			const __m256 r = _mm256_castpd_ps(_mm256_unpacklo_pd(_mm256_castps_pd(rg01), _mm256_castps_pd(rg23)));
+			const __m256 g = _mm256_castpd_ps(_mm256_unpackhi_pd(_mm256_castps_pd(rg01), _mm256_castps_pd(rg23)));
+			const __m256 b = _mm256_castpd_ps(_mm256_unpacklo_pd(_mm256_castps_pd(ba01), _mm256_castps_pd(ba23)));
+			const __m256 a = _mm256_castpd_ps(_mm256_unpackhi_pd(_mm256_castps_pd(ba01), _mm256_castps_pd(ba23)));
+
+			__m256i packed = ScaleToInt256(r, low, high, scale10);
+			packed = _mm256_or_si256(packed, _mm256_slli_epi32(ScaleToInt256(g, low, high, scale10), 10));
+			packed = _mm256_or_si256(packed, _mm256_slli_epi32(ScaleToInt256(b, low, high, scale10), 20));
+			packed = _mm256_or_si256(packed, _mm256_slli_epi32(ScaleToInt256(a, low, high, scale2), 30));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(pDst + i), packed);
+		}
+		Unorm10x3a2Scalar(pDst + i, pSrc + i * 4u, vertexCount - i);
+	}
+
+	QuantizerIsa DetectIsa() {
+#if defined(_MSC_VER)
+		int info[4] = {};
+		__cpuid(info, 0);
+		const int maxLeaf = info[0];
+
+		__cpuid(info, 1);
+		const bool sse2 = (info[3] & (1 << 26)) != 0;
+		const bool osxsave = (info[2] & (1 << 27)) != 0;
+		const bool avx = (info[2] & (1 << 28)) != 0;
+		const bool f16c = (info[2] & (1 << 29)) != 0;
+
+		bool avx2 = false;
+		if (maxLeaf >= 7) {
+			__cpuidex(info, 7, 0);
+			avx2 = (info[1] & (1 << 5)) != 0;
+		}
+
+		// The OS has to save the upper halves of the ymm registers
+		const bool ymmState = osxsave && avx && (_xgetbv(0) & 0x6) == 0x6;
+		if (ymmState && avx2 && f16c) {
+			return QuantizerIsa::AVX2;
+		}
+		return sse2 ? QuantizerIsa::SSE2 : QuantizerIsa::Scalar;
+#else
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("f16c")) {
+			return QuantizerIsa::AVX2;
+		}
+		return __builtin_cpu_supports("sse2") ? QuantizerIsa::SSE2 : QuantizerIsa::Scalar;
+#endif
+	}
+
+#else
+
+	QuantizerIsa DetectIsa() {
+		return QuantizerIsa::Scalar;
+	}
+
+#endif // QUANTIZER_X86
+}
+
+VulkanApp::QuantizerIsa VulkanApp::CVertexQuantizer::GetSupportedIsa() {
+	static const QuantizerIsa isa = DetectIsa();
+	return isa;
+}
+
+const char* VulkanApp::CVertexQuantizer::GetIsaName(const QuantizerIsa isa) {
+	switch (isa)
+	{
+	case QuantizerIsa::SSE2:	return "SSE2";
+	case QuantizerIsa::AVX2:	return "AVX2";
+	default: break;
+	}
+	return "scalar";
+}
+
+uint32_t VulkanApp::CVertexQuantizer::GetComponentCount(const BufferAttribute::ShaderDataType dstType) {
+	switch (dstType)
+	{
+	case BufferAttribute::ShaderDataType::half2:		return 2u;
+	case BufferAttribute::ShaderDataType::half4:		return 4u;
+	case BufferAttribute::ShaderDataType::snorm16x2:	return 2u;
+	case BufferAttribute::ShaderDataType::snorm16x4:	return 4u;
+	case BufferAttribute::ShaderDataType::unorm16x2:	return 2u;
+	case BufferAttribute::ShaderDataType::unorm16x4:	return 4u;
+	case BufferAttribute::ShaderDataType::unorm8x4:		return 4u;
+	case BufferAttribute::ShaderDataType::unorm10x3a2:	return 4u;
+	default: break;
+	}
+	return 0u;
+}
+
+void VulkanApp::CVertexQuantizer::Quantize(const BufferAttribute::ShaderDataType dstType, void *pDst, const float *pSrc, const size_t vertexCount) {
+	Quantize(dstType, pDst, pSrc, vertexCount, GetSupportedIsa());
+}
+
+void VulkanApp::CVertexQuantizer::Quantize(const BufferAttribute::ShaderDataType dstType, void *pDst, const float *pSrc, const size_t vertexCount,
+	const QuantizerIsa isa) {
+
+	const uint32_t componentCount = GetComponentCount(dstType);
+	if (componentCount == 0u) {
+		throw std::runtime_error(UTIL_EXC_MSG("Attribute type is not a quantized type"));
+	}
+
+	if (isa > GetSupportedIsa()) {
+		throw std::runtime_error(UTIL_EXC_MSG("Instruction set is not supported by the CPU"));
+	}
+
+	const size_t count = vertexCount * componentCount;
+	switch (dstType)
+	{
+	case BufferAttribute::ShaderDataType::half2:
+	case BufferAttribute::ShaderDataType::half4:
+#ifdef QUANTIZER_X86
+		if (isa == QuantizerIsa::AVX2) { HalfAVX2(static_cast<uint16_t*>(pDst), pSrc, count); return; }
+		if (isa == QuantizerIsa::SSE2) { HalfSSE2(static_cast<uint16_t*>(pDst), pSrc, count); return; }
+#endif
+		HalfScalar(static_cast<uint16_t*>(pDst), pSrc, count);
+		return;
+	case BufferAttribute::ShaderDataType::snorm16x2:
+	case BufferAttribute::ShaderDataType::snorm16x4:
+#ifdef QUANTIZER_X86
+		if (isa == QuantizerIsa::AVX2) { Snorm16AVX2(static_cast<int16_t*>(pDst), pSrc, count); return; }
+		if (isa == QuantizerIsa::SSE2) { Snorm16SSE2(static_cast<int16_t*>(pDst), pSrc, count); return; }
+#endif
+		Snorm16Scalar(static_cast<int16_t*>(pDst), pSrc, count);
+		return;
+	case BufferAttribute::ShaderDataType::unorm16x2:
+	case BufferAttribute::ShaderDataType::unorm16x4:
+#ifdef QUANTIZER_X86
+		if (isa == QuantizerIsa::AVX2) { Unorm16AVX2(static_cast<uint16_t*>(pDst), pSrc, count); return; }
+		if (isa == QuantizerIsa::SSE2) { Unorm16SSE2(static_cast<uint16_t*>(pDst), pSrc, count); return; }
+#endif
+		Unorm16Scalar(static_cast<uint16_t*>(pDst), pSrc, count);
+		return;
+	case BufferAttribute::ShaderDataType::unorm8x4:
+#ifdef QUANTIZER_X86
+		if (isa == QuantizerIsa::AVX2) { Unorm8AVX2(static_cast<uint8_t*>(pDst), pSrc, count); return; }
+		if (isa == QuantizerIsa::SSE2) { Unorm8SSE2(static_cast<uint8_t*>(pDst), pSrc, count); return; }
+#endif
+		Unorm8Scalar(static_cast<uint8_t*>(pDst), pSrc, count);
+		return;
+	case BufferAttribute::ShaderDataType::unorm10x3a2:
+#ifdef QUANTIZER_X86
+		if (isa == QuantizerIsa::AVX2) { Unorm10x3a2AVX2(static_cast<uint32_t*>(pDst), pSrc, vertexCount); return; }
+		if (isa == QuantizerIsa::SSE2) { Unorm10x3a2SSE2(static_cast<uint32_t*>(pDst), pSrc, vertexCount); return; }
+#endif
+		Unorm10x3a2Scalar(static_cast<uint32_t*>(pDst), pSrc, vertexCount);
+		return;
+	default:
+		break;
+	}
+}
+
+void VulkanApp::CVertexQuantizer::QuantizeStrided(const BufferAttribute::ShaderDataType dstType, void *pDst, const size_t dstStride,
+	const float *pSrc, const size_t srcStride, const size_t vertexCount) {
+
+	const uint32_t componentCount = GetComponentCount(dstType);
+	if (componentCount == 0u) {
+		throw std::runtime_error(UTIL_EXC_MSG("Attribute type is not a quantized type"));
+	}
+
+	const size_t srcSize = componentCount * sizeof(float);
+	const size_t dstSize = BufferAttribute::GetTypeSize(dstType);
+	if (srcStride == srcSize && dstStride == dstSize) {
+		Quantize(dstType, pDst, pSrc, vertexCount);
+		return;
+	}
+
+	// Interleaved data is gathered into small packed batches which stay in L1
+	float srcBatch[cexp_stridedBatch * 4u];
+	uint8_t dstBatch[cexp_stridedBatch * 8u];
+	const uint8_t *pSrcBytes = reinterpret_cast<const uint8_t*>(pSrc);
+	uint8_t *pDstBytes = static_cast<uint8_t*>(pDst);
+
+	for (size_t first = 0u; first < vertexCount; first += cexp_stridedBatch) {
+		const size_t batchCount = std::min(cexp_stridedBatch, vertexCount - first);
+		for (size_t i = 0u; i < batchCount; i++) {
+			memcpy(srcBatch + i * componentCount, pSrcBytes + (first + i) * srcStride, srcSize);
+		}
+
+		Quantize(dstType, dstBatch, srcBatch, batchCount);
+
+		for (size_t i = 0u; i < batchCount; i++) {
+			memcpy(pDstBytes + (first + i) * dstStride, dstBatch + i * dstSize, dstSize);
+		}
+	}
+}
+
+uint16_t VulkanApp::CVertexQuantizer::FloatToHalf(const float value) {
+	uint32_t bits = 0u;
+	memcpy(&bits, &value, sizeof(bits));
+
+	const uint32_t sign = bits & 0x80000000u;
+	uint32_t absBits = bits ^ sign;
+	uint32_t half = 0u;
+
+	if (absBits >= ((127u + 16u) << 23)) {
+		// Overflow saturates to infinity, NaN payloads are not preserved
+		half = absBits > (255u << 23) ? 0x7e00u : 0x7c00u;
+	}
+	else if (absBits < (113u << 23)) {
+		// Subnormal or zero, the FPU rounds when the magic number is added
+		const uint32_t magicBits = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+		float magic = 0.0f;
+		float absValue = 0.0f;
+		memcpy(&magic, &magicBits, sizeof(magic));
+		memcpy(&absValue, &absBits, sizeof(absValue));
+		absValue += magic;
+		memcpy(&absBits, &absValue, sizeof(absBits));
+		half = absBits - magicBits;
+	}
+	else {
+		// Rebias the exponent and round the mantissa to nearest even
+		const uint32_t mantissaOdd = (absBits >> 13) & 1u;
+		absBits += (static_cast<uint32_t>(15 - 127) << 23) + 0xfffu;
+		absBits += mantissaOdd;
+		half = absBits >> 13;
+	}
+
+	return static_cast<uint16_t>(half | (sign >> 16));
+}
+
+float VulkanApp::CVertexQuantizer::HalfToFloat(const uint16_t value) {
+	const uint32_t sign = static_cast<uint32_t>(value & 0x8000u) << 16;
+	const uint32_t exponent = (value >> 10) & 0x1fu;
+	const uint32_t mantissa = value & 0x3ffu;
+
+	uint32_t bits = 0u;
+	if (exponent == 0u) {
+		const float subnormal = static_cast<float>(mantissa) * (1.0f / 16777216.0f);
+		memcpy(&bits, &subnormal, sizeof(bits));
+		bits |= sign;
+	}
+	else if (exponent == 31u) {
+		bits = sign | 0x7f800000u | (mantissa << 13);
+	}
+	else {
+		bits = sign | ((exponent + 112u) << 23) | (mantissa << 13);
+	}
+
+	float result = 0.0f;
+	memcpy(&result, &bits, sizeof(result));
+	return result;
+}
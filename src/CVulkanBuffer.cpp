@@ -1,8 +1,11 @@
 #include <CVulkanBuffer.h>
 #include <CVulkanCore.h>
+#include <CVulkanUploader.h>
 
 #include <Utilities.h>
 
+#include <cstring>
+
 /*
 CBuffer:
 -> Vertex buffer
@@ -16,77 +19,162 @@ CBuffer:
 
 
 namespace VulkanApp {
-	static uint32_t GetShaderDataTypeSize(BufferAttribute::ShaderDataType shaderDataType) {
-		switch (shaderDataType)
-		{
-		case BufferAttribute::ShaderDataType::int3:		return 4 * 3;
-		case BufferAttribute::ShaderDataType::int4:		return 4 * 4;
-		case BufferAttribute::ShaderDataType::uint3:	return 4 * 3;
-		case BufferAttribute::ShaderDataType::uint4:	return 4 * 4;
-		case BufferAttribute::ShaderDataType::float3:	return 4 * 3;
-		case BufferAttribute::ShaderDataType::float4:	return 4 * 4;
-		default: break;
-		}
-		return 0;
-	}
-
 	BufferAttribute::BufferAttribute(ShaderDataType shaderDataType, const std::string name)
 		: m_name(name),
 		m_shaderDataType(shaderDataType),
-		m_size(GetShaderDataTypeSize(shaderDataType)),
-		m_offset(0) {
+		m_size(GetTypeSize(shaderDataType)),
+		m_offset(0),
+		m_binding(0),
+		m_location(0) {
 	}
 
 
-	CBufferLayout::CBufferLayout(std::initializer_list<BufferAttribute> bufferAttributes)
-		: m_attributes(bufferAttributes.begin(), bufferAttributes.end()) {
+	CBufferLayout::CBufferLayout(std::initializer_list<BufferAttribute> bufferAttributes, const VkVertexInputRate inputRate) {
+		AddBinding(bufferAttributes, inputRate);
+	};
+
+	CBufferLayout& CBufferLayout::AddBinding(std::initializer_list<BufferAttribute> bufferAttributes, const VkVertexInputRate inputRate) {
+		BufferBinding binding;
+		binding.m_binding = static_cast<uint32_t>(m_bindings.size());
+		binding.m_inputRate = inputRate;
+
 		uint32_t offset = 0;
-		for (auto& attribute : m_attributes) {
+		for (auto attribute : bufferAttributes) {
 			attribute.m_offset = offset;
+			attribute.m_binding = binding.m_binding;
+			attribute.m_location = static_cast<uint32_t>(m_attributes.size());
 			offset += attribute.m_size;
+			m_attributes.push_back(attribute);
 		}
-		m_byteSize = offset;
-	};
+		binding.m_stride = offset;
 
+		m_bindings.push_back(binding);
+		return *this;
+	}
 
-	CVulkanBuffer::CVulkanBuffer(const CVulkanCore* const pCore, const void* data, const uint32_t byteSize, VkBufferUsageFlagBits usage)
-		: m_pCore(pCore), m_byteSize(byteSize){
 
-		m_vkBuffer = CreateBuffer(
-			m_pCore,
-			byteSize,
-			usage,
-			(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT),
-			VkSharingMode::VK_SHARING_MODE_EXCLUSIVE,
-			&m_vkBufferMemory);
+	CVulkanBuffer::CVulkanBuffer(const CVulkanCore* const pCore, const void* data, const uint32_t byteSize, const BufferUsage usage)
+		: m_pCore(pCore), m_memory(usage.m_memory), m_byteSize(byteSize){
 
-		VkResult result = vkMapMemory(m_pCore->GetVkLogicalDevice(), m_vkBufferMemory, 0, m_byteSize, 0, &m_pMappedData);
-		if (result != VK_SUCCESS) {
-			throw std::runtime_error(UTIL_EXC_MSG_EX("Buffer memory mapping failed.", result));
+		if (m_memory == BufferMemory::DeviceLocal) {
+			// Copies may run on a transfer queue family, the buffer is shared with it instead of transferring ownership
+			const bool separateTransferFamily = m_pCore->GetTransferQueueFamilyIndex() != m_pCore->GetQueueFamilyIndex();
+
+			m_vkBuffer = CreateBuffer(
+				m_pCore,
+				byteSize,
+				usage.m_vkUsage | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+				0u,
+				separateTransferFamily ? VkSharingMode::VK_SHARING_MODE_CONCURRENT : VkSharingMode::VK_SHARING_MODE_EXCLUSIVE,
+				&m_allocation);
+		}
+		else if (m_memory == BufferMemory::HostStreaming) {
+			// Host visible device memory lets the GPU read streamed data without crossing the bus
+			m_vkBuffer = CreateBuffer(
+				m_pCore,
+				byteSize,
+				usage.m_vkUsage,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
+				(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT),
+				VkSharingMode::VK_SHARING_MODE_EXCLUSIVE,
+				&m_allocation);
+
+			m_pMappedData = m_allocation.m_pMappedData;
+		}
+		else {
+			m_vkBuffer = CreateBuffer(
+				m_pCore,
+				byteSize,
+				usage.m_vkUsage,
+				(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT),
+				0u,
+				VkSharingMode::VK_SHARING_MODE_EXCLUSIVE,
+				&m_allocation);
+
+			// Host visible blocks are persistently mapped by the allocator
+			m_pMappedData = m_allocation.m_pMappedData;
 		}
 
-		SetData(data);
+		if (data) {
+			SetData(data);
+		}
 	}
 
 	void CVulkanBuffer::SetData(const void* data) {
-		memcpy(m_pMappedData, data, m_byteSize);
+		SetData(data, 0u, m_byteSize);
 	}
 
-	CVulkanBuffer::~CVulkanBuffer() {
+	void CVulkanBuffer::SetData(const void* data, const VkDeviceSize offset, const VkDeviceSize byteSize) {
+		if (offset > m_byteSize || byteSize > m_byteSize - offset) {
+			throw std::runtime_error(UTIL_EXC_MSG("Range is outside of the buffer"));
+		}
 
-		vkUnmapMemory(m_pCore->GetVkLogicalDevice(), m_vkBufferMemory);
+		if (m_memory == BufferMemory::DeviceLocal) {
+			m_pCore->GetUploader()->Upload(m_vkBuffer, offset, data, byteSize);
+		}
+		else {
+			memcpy(static_cast<uint8_t*>(m_pMappedData) + offset, data, byteSize);
+			Flush(offset, byteSize);
+		}
+	}
 
-		if (m_vkBufferMemory != VK_NULL_HANDLE) {
-			vkFreeMemory(m_pCore->GetVkLogicalDevice(), m_vkBufferMemory, nullptr);
+	void CVulkanBuffer::Flush(const VkDeviceSize offset, const VkDeviceSize byteSize) const {
+		if (m_pMappedData) {
+			m_pCore->GetAllocator()->Flush(m_allocation, offset, byteSize);
 		}
+	}
+
+	CVulkanBuffer::~CVulkanBuffer() {
 
 		if (m_vkBuffer != VK_NULL_HANDLE) {
 			vkDestroyBuffer(m_pCore->GetVkLogicalDevice(), m_vkBuffer, nullptr);
 		}
+
+		m_pCore->GetAllocator()->Free(m_allocation);
+	}
+
+	CVulkanIndexBuffer::CVulkanIndexBuffer(const CVulkanCore* const pCore, const uint32_t* indices, const uint32_t indexCount, const uint32_t vertexCount,
+		const BufferMemory memory)
+		: CVulkanBuffer(pCore, nullptr, indexCount * GetIndexSize(SelectIndexType(vertexCount)), { VK_BUFFER_USAGE_INDEX_BUFFER_BIT, memory }),
+		m_vkIndexType(SelectIndexType(vertexCount)),
+		m_indexCount(indexCount) {
+
+		if (indices == nullptr) {
+			return;
+		}
+
+		// Both widths, an index past the vertices reads outside the vertex buffers of the draw
+		for (uint32_t i = 0; i < indexCount; i++) {
+			if (indices[i] >= vertexCount) {
+				throw std::runtime_error(UTIL_EXC_MSG("Index is out of the vertex range"));
+			}
+		}
+
+		if (m_vkIndexType == VK_INDEX_TYPE_UINT32) {
+			SetData(indices);
+			return;
+		}
+
+		std::vector<uint16_t> shortIndices(indexCount);
+		for (uint32_t i = 0; i < indexCount; i++) {
+			shortIndices[i] = static_cast<uint16_t>(indices[i]);
+		}
+		SetData(shortIndices.data());
+	}
+
+	VkIndexType CVulkanIndexBuffer::SelectIndexType(const uint32_t vertexCount) {
+		// 0xFFFF is left out, it restarts primitives when primitive restart is enabled
+		return vertexCount <= UINT16_MAX ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+	}
+
+	uint32_t CVulkanIndexBuffer::GetIndexSize(const VkIndexType indexType) {
+		return indexType == VK_INDEX_TYPE_UINT16 ? 2u : 4u;
 	}
 
 	VkBuffer CVulkanBuffer::CreateBuffer(const CVulkanCore *const pCore, const uint32_t byteSize, const uint32_t bufferUsageFlagBits,
-		const uint32_t memoryPropertyFlagBits, const VkSharingMode sharingMode, VkDeviceMemory *pBufferMemoryOut)
+		const uint32_t memoryPropertyFlagBits, const uint32_t preferredPropertyFlagBits, const VkSharingMode sharingMode,
+		MemoryAllocation *pAllocationOut)
 	{
 		VkBuffer buffer = VK_NULL_HANDLE;
 		VkBufferCreateInfo bufferCI = {};
@@ -95,47 +183,25 @@ namespace VulkanApp {
 		bufferCI.usage = bufferUsageFlagBits;
 		bufferCI.sharingMode = sharingMode;
 
+		const uint32_t queueFamilyIndices[] = { pCore->GetQueueFamilyIndex(), pCore->GetTransferQueueFamilyIndex() };
+		if (sharingMode == VkSharingMode::VK_SHARING_MODE_CONCURRENT) {
+			bufferCI.queueFamilyIndexCount = 2u;
+			bufferCI.pQueueFamilyIndices = queueFamilyIndices;
+		}
+
 		VkResult result = vkCreateBuffer(pCore->GetVkLogicalDevice(), &bufferCI, nullptr, &buffer);
 
 		if (result != VK_SUCCESS) {
 			throw std::runtime_error(UTIL_EXC_MSG_EX("Buffer creation failed.", result));
 		}
 
-		VkMemoryRequirements memoryRequirements = {};
-		vkGetBufferMemoryRequirements(pCore->GetVkLogicalDevice(), buffer, &memoryRequirements);
-
-		VkPhysicalDeviceMemoryProperties bufferMemoryProps = {};
-		vkGetPhysicalDeviceMemoryProperties(pCore->GetVkPhysicalDevice(), &bufferMemoryProps);
-
-		int memoryTypeIndex = -1;
-		for (int i = 0; i < bufferMemoryProps.memoryTypeCount; i++) {
-			if ((memoryRequirements.memoryTypeBits & (1 << i)) &&
-				(bufferMemoryProps.memoryTypes[i].propertyFlags & memoryPropertyFlagBits)) {
-				memoryTypeIndex = i;
-				break;
-			}
-		}
-
-		if (memoryTypeIndex == -1) {
-			throw std::runtime_error(UTIL_EXC_MSG("Unable to find required memory type."));
+		try {
+			*pAllocationOut = pCore->GetAllocator()->AllocateForBuffer(buffer, memoryPropertyFlagBits, preferredPropertyFlagBits);
 		}
-
-		VkMemoryAllocateInfo memoryAllocateInfo = {};
-		memoryAllocateInfo.allocationSize = memoryRequirements.size;
-		memoryAllocateInfo.memoryTypeIndex = memoryTypeIndex;
-		memoryAllocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-
-		VkDeviceMemory bufferMemory = VK_NULL_HANDLE;
-		result = vkAllocateMemory(pCore->GetVkLogicalDevice(), &memoryAllocateInfo, nullptr, &bufferMemory);
-		if (result != VK_SUCCESS) {
-			throw std::runtime_error(UTIL_EXC_MSG_EX("Memory allocation failed.", result));
-		}
-
-		result = vkBindBufferMemory(pCore->GetVkLogicalDevice(), buffer, bufferMemory, 0);
-		if (result != VK_SUCCESS) {
-			throw std::runtime_error(UTIL_EXC_MSG_EX("Buffer memory binding failed.", result));
+		catch (...) {
+			vkDestroyBuffer(pCore->GetVkLogicalDevice(), buffer, nullptr);
+			throw;
 		}
-		*pBufferMemoryOut = bufferMemory;
 
 		return buffer;
 	}
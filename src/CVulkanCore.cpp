@@ -1,9 +1,16 @@
 #include <CVulkanCore.h>
 #include <CVulkanSwapchain.h>
+#include <CVulkanMemoryAllocator.h>
+#include <CVulkanUploader.h>
+#include <CVulkanDescriptorCache.h>
+#include <CVulkanShaderCache.h>
 
 #include <vector>
 #include <stdexcept>
-#include <optional>
+#include <fstream>
+#include <filesystem>
+#include <chrono>
+#include <cstring>
 
 #ifdef _WIN32
 
@@ -11,51 +18,55 @@
 #include <vulkan/vulkan.h>
 constexpr std::string_view cexp_platform_extension = VK_KHR_WIN32_SURFACE_EXTENSION_NAME;
 
+#elif defined(__linux__) && VULKANAPP_XCB
+
+#define VK_USE_PLATFORM_XCB_KHR
+#include <vulkan/vulkan.h>
+constexpr std::string_view cexp_platform_extension = VK_KHR_XCB_SURFACE_EXTENSION_NAME;
+
 #elif MAC_OS
 
 #define VK_USE_PLATFORM_MACOS_MVK
 #include <vulkan/vulkan.h>
 constexpr std::string_view cexp_platform_extension = VK_KHR_MACOS_SURFACE_EXTENSION_NAME;
 
-#endif
-
-#include <Utilities.h>
-
-static std::vector<uint32_t> GetQueueFamilyIndexList(const VkPhysicalDevice device, const VkQueueFlags queueFlags) {
+#else
 
-	std::vector<uint32_t> result;
+// No window system integration, only headless cores can be created
+#include <vulkan/vulkan_core.h>
+constexpr std::string_view cexp_platform_extension = {};
 
-	uint32_t familiesCount = 0;
-	vkGetPhysicalDeviceQueueFamilyProperties(device, &familiesCount, nullptr);
-
-	if (familiesCount == 0)
-		return result;
-
-	std::vector<VkQueueFamilyProperties> queueFamilyProperties(familiesCount);
-	vkGetPhysicalDeviceQueueFamilyProperties(device, &familiesCount, queueFamilyProperties.data());
-
-	uint32_t i = 0;
-	for (auto& properties : queueFamilyProperties) {
-		if (properties.queueFlags & queueFlags) {
-			result.push_back(i);
-		}
-		i++;
-	}
+#endif
 
-	return result;
+#include <Utilities.h>
+#include <CTracer.h>
+
+namespace VulkanApp {
+	// On-disk wrapper around the driver blob, guards against truncated or corrupted files
+	struct PipelineCacheFileHeader {
+		uint32_t m_magic;
+		uint32_t m_version;
+		uint64_t m_dataSize;
+		uint64_t m_dataHash;
+	};
+
+	static constexpr uint32_t cexp_pipelineCacheMagic = 0x43504b56u; // "VKPC"
+	static constexpr uint32_t cexp_pipelineCacheVersion = 1u;
 }
 
-VulkanApp::CVulkanCore::CVulkanCore(const std::string& applicationName) : m_applicationName(applicationName) {
+VulkanApp::CVulkanCore::CVulkanCore(const std::string& applicationName, const bool headless)
+	: m_applicationName(applicationName), m_headless(headless) {
 	
+	TRACE_SCOPE("CVulkanCore::Create");
 	VkResult code;
 	
 	// Create the instance
-	if (code = InitVkInstance()) {
+	if ((code = InitVkInstance()) != VK_SUCCESS) {
 		throw std::runtime_error(UTIL_EXC_MSG_EX("Failed to create a Vulkan instance", code));
 	}
 
 	// Create physical device
-	if (code = vkEnumeratePhysicalDevices(m_vkInstance, &m_physicalDevicesCount, nullptr)) {
+	if ((code = vkEnumeratePhysicalDevices(m_vkInstance, &m_physicalDevicesCount, nullptr)) != VK_SUCCESS) {
 		throw std::runtime_error(UTIL_EXC_MSG_EX("Failed to enumerate physical devices", code));
 	}
 
@@ -69,70 +80,121 @@ VulkanApp::CVulkanCore::CVulkanCore(const std::string& applicationName) : m_appl
 		throw std::runtime_error(UTIL_EXC_MSG_EX("No physical devices found", code));
 	}
 	
-	// Find desired queue family (index)
-	auto queueFamilies = GetQueueFamilyIndexList(m_vkPhysicalDevices, VK_QUEUE_GRAPHICS_BIT);
+	// Properties, features, queue families and extensions of the device, read from here on
+	m_deviceCaps.QueryDevice(m_vkPhysicalDevices);
 
-	// Check if the physical device supports presentation
-	auto indexItr = std::find_if(queueFamilies.cbegin(), queueFamilies.cend(), [this](uint32_t index)->bool{
+	// Check if the physical device supports presentation, any graphics family does without a window
+	auto supportsPresentation = [this]([[maybe_unused]] uint32_t index)->bool{
+		if (m_headless) {
+			return true;
+		}
 #ifdef _WIN32
 		// Simplified by checking the first device only
 		return vkGetPhysicalDeviceWin32PresentationSupportKHR(m_vkPhysicalDevices, index);
-#elif MAC_OS
+#elif defined(__linux__) && VULKANAPP_XCB
+		// The xcb query needs the connection and visual of the window, which the core does not know.
+		// Application checks the family against its surface once it has been created.
+		return true;
+#else
 		return false;
 #endif
-	});
+	};
+
+	// Find desired queue family (index)
+	uint32_t graphicsFamily = m_deviceCaps.FindQueueFamily(VK_QUEUE_GRAPHICS_BIT);
+	while (graphicsFamily != UINT32_MAX && !supportsPresentation(graphicsFamily)) {
+		graphicsFamily = m_deviceCaps.FindQueueFamily(VK_QUEUE_GRAPHICS_BIT, 0u, graphicsFamily + 1u);
+	}
 
-	if (indexItr == queueFamilies.cend()) {
-		throw std::runtime_error(UTIL_EXC_MSG_EX("Selected physical device does not support presentation", code));
+	if (graphicsFamily == UINT32_MAX) {
+		throw std::runtime_error(UTIL_EXC_MSG_EX(m_headless ?
+			"Selected physical device has no graphics queue" :
+			"Selected physical device does not support presentation", code));
 	}
 
-	uint32_t m_queueFamilyIndex = *indexItr;
+	m_queueFamilyIndex = graphicsFamily;
+
+	// Copies run on a transfer-only family when the device exposes one (usually DMA engines)
+	uint32_t transferFamily = m_deviceCaps.FindQueueFamily(VK_QUEUE_TRANSFER_BIT, VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT);
+	if (transferFamily == UINT32_MAX) {
+		transferFamily = m_deviceCaps.FindQueueFamily(VK_QUEUE_TRANSFER_BIT, VK_QUEUE_GRAPHICS_BIT);
+	}
+	m_transferQueueFamilyIndex = (transferFamily != UINT32_MAX) ? transferFamily : m_queueFamilyIndex;
 
-	// Declare the queue to be created
-	VkDeviceQueueCreateInfo queueCI = {};
-	queueCI.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
-	queueCI.queueFamilyIndex = m_queueFamilyIndex;
-	queueCI.queueCount = 1u;
+	// Declare the queues to be created
 	float priority = 1.f;
-	queueCI.pQueuePriorities = &priority;
+	VkDeviceQueueCreateInfo queueCI[2] = {};
+	queueCI[0].sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+	queueCI[0].queueFamilyIndex = m_queueFamilyIndex;
+	queueCI[0].queueCount = 1u;
+	queueCI[0].pQueuePriorities = &priority;
+
+	queueCI[1] = queueCI[0];
+	queueCI[1].queueFamilyIndex = m_transferQueueFamilyIndex;
+
+	const uint32_t queueCICount = (m_transferQueueFamilyIndex != m_queueFamilyIndex) ? 2u : 1u;
 
 	// Create logical device
-	if (code = InitVkLogicalDevice(&queueCI)) {
+	if ((code = InitVkLogicalDevice(queueCI, queueCICount)) != VK_SUCCESS) {
 		throw std::runtime_error(UTIL_EXC_MSG_EX("Failed to create a Vulkan logical device", code));
 	}
 
+	// Without multiDrawIndirect every indirect draw call reads a single command
+	const VkPhysicalDeviceLimits &limits = m_deviceCaps.m_properties.limits;
+	m_maxDrawIndirectCount = m_vkEnabledFeatures.multiDrawIndirect ? std::max(limits.maxDrawIndirectCount, 1u) : 1u;
+
 	// Get command queue
 	vkGetDeviceQueue(m_vkLogicalDevice, m_queueFamilyIndex, 0, &m_vkQueue);
 	if (m_vkQueue == VK_NULL_HANDLE) {
 		throw std::runtime_error(UTIL_EXC_MSG_EX("Cannot retrieve the command queue", code));
 	}
 
+	vkGetDeviceQueue(m_vkLogicalDevice, m_transferQueueFamilyIndex, 0, &m_vkTransferQueue);
+	if (m_vkTransferQueue == VK_NULL_HANDLE) {
+		throw std::runtime_error(UTIL_EXC_MSG_EX("Cannot retrieve the transfer queue", code));
+	}
+
+	// Device memory is suballocated from blocks owned by the allocator
+	m_pAllocator = new CVulkanMemoryAllocator(m_vkPhysicalDevices, m_vkLogicalDevice);
+
+	// Staging uploads into device local memory
+	m_pUploader = new CVulkanUploader(this);
+
+	// Descriptor set and pipeline layouts shared by every pipeline
+	m_pDescriptorCache = new CVulkanDescriptorCache(m_vkLogicalDevice);
+
+	// Shader modules shared by everything loading the same code
+	m_pShaderCache = new CVulkanShaderCache(m_vkLogicalDevice);
+
+	// Pipelines compiled by previous runs
+	m_pipelineCachePath = m_applicationName + ".pipelinecache";
+	InitVkPipelineCache();
 }
 
 VulkanApp::CVulkanCore::~CVulkanCore() {
 
-	if (m_vkLogicalDevice)
-		vkDestroyDevice(m_vkLogicalDevice, nullptr);
-		
-	if (m_vkInstance)
-		vkDestroyInstance(m_vkInstance, NULL);
-}
+	if (m_vkPipelineCache) {
+		SavePipelineCache();
+		vkDestroyPipelineCache(m_vkLogicalDevice, m_vkPipelineCache, nullptr);
+	}
 
-static bool IsLayerAvailable(const std::string_view layerName) {
+	if (m_pShaderCache)
+		delete m_pShaderCache;
 
-	uint32_t layerCount = 0;
-	vkEnumerateInstanceLayerProperties(&layerCount, nullptr);
+	if (m_pDescriptorCache)
+		delete m_pDescriptorCache;
 
-	std::vector<VkLayerProperties> layerProperties(layerCount);
-	vkEnumerateInstanceLayerProperties(&layerCount, layerProperties.data());
+	if (m_pUploader)
+		delete m_pUploader;
 
-	std::vector<std::string> layers;
-	for (auto& properties : layerProperties)
-		layers.push_back(std::string(properties.layerName));
+	if (m_pAllocator)
+		delete m_pAllocator;
 
-	auto itr = std::find(layers.cbegin(), layers.cend(), layerName);
-	
-	return itr != layers.cend();
+	if (m_vkLogicalDevice)
+		vkDestroyDevice(m_vkLogicalDevice, nullptr);
+		
+	if (m_vkInstance)
+		vkDestroyInstance(m_vkInstance, NULL);
 }
 
 VkResult VulkanApp::CVulkanCore::InitVkInstance() noexcept {
@@ -152,13 +214,19 @@ VkResult VulkanApp::CVulkanCore::InitVkInstance() noexcept {
 	instanceInfo.pApplicationInfo = &vkAppInfo;
 
 	// Select required Vulkan extensions (check available ones using getSupportedExtenstions())
-	const std::vector<const char*> vulkanExtensions = { VK_KHR_SURFACE_EXTENSION_NAME, cexp_platform_extension.data() };
-	instanceInfo.ppEnabledExtensionNames = vulkanExtensions.data();
+	std::vector<const char*> vulkanExtensions;
+	if (!m_headless) {
+		vulkanExtensions = { VK_KHR_SURFACE_EXTENSION_NAME, cexp_platform_extension.data() };
+	}
+	instanceInfo.ppEnabledExtensionNames = vulkanExtensions.empty() ? nullptr : vulkanExtensions.data();
 	instanceInfo.enabledExtensionCount = static_cast<uint32_t>(vulkanExtensions.size());
 	
+	// Layers and extensions the loader offers, enumerated once
+	m_deviceCaps.QueryInstance();
+
 	// Enable validation layer
 	const char* cp_validationLayer = "VK_LAYER_KHRONOS_validation";
-	if (IsLayerAvailable(cp_validationLayer)) {
+	if (m_deviceCaps.HasInstanceLayer(cp_validationLayer)) {
 		instanceInfo.enabledLayerCount = 1u;
 		instanceInfo.ppEnabledLayerNames = &cp_validationLayer;
 	}
@@ -173,21 +241,168 @@ VkResult VulkanApp::CVulkanCore::InitVkInstance() noexcept {
 	return vkCreateInstance(&instanceInfo, nullptr, &m_vkInstance);		
 }
 
-VkResult VulkanApp::CVulkanCore::InitVkLogicalDevice(const VkDeviceQueueCreateInfo *const queueCI) noexcept
+VkResult VulkanApp::CVulkanCore::InitVkLogicalDevice(const VkDeviceQueueCreateInfo *const queueCI, const uint32_t queueCICount) noexcept
 {
-	// Select required device features
+	// Select required device features, indirect drawing ones are used when available
+	const VkPhysicalDeviceFeatures &supportedFeatures = m_deviceCaps.m_features;
+
 	VkPhysicalDeviceFeatures features = {};
+	features.multiDrawIndirect = supportedFeatures.multiDrawIndirect;
+	features.drawIndirectFirstInstance = supportedFeatures.drawIndirectFirstInstance;
 
 	// Prepare logical device info
 	VkDeviceCreateInfo deviceInfo = {};
 	deviceInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
 	deviceInfo.pQueueCreateInfos = queueCI;
-	deviceInfo.queueCreateInfoCount = 1;
+	deviceInfo.queueCreateInfoCount = queueCICount;
 	deviceInfo.pEnabledFeatures = &features;
 	const char* extensions = VK_KHR_SWAPCHAIN_EXTENSION_NAME;
-	deviceInfo.ppEnabledExtensionNames = &extensions;
-	deviceInfo.enabledExtensionCount = 1;
+	deviceInfo.ppEnabledExtensionNames = m_headless ? nullptr : &extensions;
+	deviceInfo.enabledExtensionCount = m_headless ? 0u : 1u;
 
 	// Create logical device itself
-	return vkCreateDevice(m_vkPhysicalDevices, &deviceInfo, nullptr, &m_vkLogicalDevice);
+	VkResult result = vkCreateDevice(m_vkPhysicalDevices, &deviceInfo, nullptr, &m_vkLogicalDevice);
+	if (result == VK_SUCCESS) {
+		m_vkEnabledFeatures = features;
+	}
+	return result;
+}
+
+void VulkanApp::CVulkanCore::InitVkPipelineCache() {
+	TRACE_SCOPE("CVulkanCore::InitVkPipelineCache");
+
+	const auto loadStart = std::chrono::steady_clock::now();
+	std::vector<uint8_t> initialData = LoadPipelineCacheData();
+
+	VkPipelineCacheCreateInfo pipelineCacheCI = {};
+	pipelineCacheCI.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+	pipelineCacheCI.initialDataSize = initialData.size();
+	pipelineCacheCI.pInitialData = initialData.empty() ? nullptr : initialData.data();
+
+	VkResult result = vkCreatePipelineCache(m_vkLogicalDevice, &pipelineCacheCI, nullptr, &m_vkPipelineCache);
+	if (result != VK_SUCCESS && !initialData.empty()) {
+		// The driver refused the blob, start from an empty cache rather than failing
+		pipelineCacheCI.initialDataSize = 0u;
+		pipelineCacheCI.pInitialData = nullptr;
+		initialData.clear();
+		result = vkCreatePipelineCache(m_vkLogicalDevice, &pipelineCacheCI, nullptr, &m_vkPipelineCache);
+	}
+
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error(UTIL_EXC_MSG_EX("Cannot create pipeline cache", result));
+	}
+
+	m_pipelineCacheWarm = !initialData.empty();
+	m_pipelineCacheHash = m_pipelineCacheWarm ? Hash64(initialData.data(), initialData.size()) : 0u;
+	m_pipelineCacheLoadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loadStart).count();
+}
+
+std::vector<uint8_t> VulkanApp::CVulkanCore::LoadPipelineCacheData() const {
+
+	std::vector<uint8_t> data;
+
+	std::ifstream file(m_pipelineCachePath, std::ios::binary | std::ios::ate);
+	if (!file.is_open()) {
+		return data;
+	}
+
+	const std::streamoff fileSize = file.tellg();
+	if (fileSize < static_cast<std::streamoff>(sizeof(PipelineCacheFileHeader))) {
+		return data;
+	}
+
+	PipelineCacheFileHeader fileHeader = {};
+	file.seekg(0);
+	file.read(reinterpret_cast<char*>(&fileHeader), sizeof(fileHeader));
+
+	if (!file || fileHeader.m_magic != cexp_pipelineCacheMagic ||
+		fileHeader.m_version != cexp_pipelineCacheVersion ||
+		fileHeader.m_dataSize != static_cast<uint64_t>(fileSize) - sizeof(fileHeader)) {
+		return data;
+	}
+
+	data.resize(static_cast<size_t>(fileHeader.m_dataSize));
+	file.read(reinterpret_cast<char*>(data.data()), data.size());
+
+	// Truncated or corrupted payload
+	if (!file || Hash64(data.data(), data.size()) != fileHeader.m_dataHash) {
+		data.clear();
+		return data;
+	}
+
+	// The blob has to be produced by the very same device and driver
+	VkPipelineCacheHeaderVersionOne cacheHeader = {};
+	if (data.size() < sizeof(cacheHeader)) {
+		data.clear();
+		return data;
+	}
+	memcpy(&cacheHeader, data.data(), sizeof(cacheHeader));
+
+	const VkPhysicalDeviceProperties &properties = m_deviceCaps.m_properties;
+
+	if (cacheHeader.headerSize < sizeof(cacheHeader) ||
+		cacheHeader.headerSize > data.size() ||
+		cacheHeader.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE ||
+		cacheHeader.vendorID != properties.vendorID ||
+		cacheHeader.deviceID != properties.deviceID ||
+		memcmp(cacheHeader.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) != 0) {
+		data.clear();
+	}
+
+	return data;
+}
+
+bool VulkanApp::CVulkanCore::SavePipelineCache() {
+
+	if (m_vkPipelineCache == VK_NULL_HANDLE) {
+		return false;
+	}
+
+	size_t dataSize = 0u;
+	VkResult result = vkGetPipelineCacheData(m_vkLogicalDevice, m_vkPipelineCache, &dataSize, nullptr);
+	if (result != VK_SUCCESS || dataSize == 0u) {
+		return false;
+	}
+
+	std::vector<uint8_t> data(dataSize);
+	result = vkGetPipelineCacheData(m_vkLogicalDevice, m_vkPipelineCache, &dataSize, data.data());
+	if (result != VK_SUCCESS) {
+		return false;
+	}
+	data.resize(dataSize);
+
+	// Nothing new was compiled since the last load or store
+	const uint64_t dataHash = Hash64(data.data(), data.size());
+	if (dataHash == m_pipelineCacheHash) {
+		return true;
+	}
+
+	PipelineCacheFileHeader fileHeader = {};
+	fileHeader.m_magic = cexp_pipelineCacheMagic;
+	fileHeader.m_version = cexp_pipelineCacheVersion;
+	fileHeader.m_dataSize = data.size();
+	fileHeader.m_dataHash = dataHash;
+
+	// Written aside and renamed, so a crash mid-write never leaves a half-written cache behind
+	const std::string tempPath = m_pipelineCachePath + ".tmp";
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		if (!file.is_open()) {
+			return false;
+		}
+		file.write(reinterpret_cast<const char*>(&fileHeader), sizeof(fileHeader));
+		file.write(reinterpret_cast<const char*>(data.data()), data.size());
+		if (!file) {
+			return false;
+		}
+	}
+
+	std::error_code error;
+	std::filesystem::rename(tempPath, m_pipelineCachePath, error);
+	if (error) {
+		return false;
+	}
+
+	m_pipelineCacheHash = dataHash;
+	return true;
 }
@@ -0,0 +1,134 @@
+#include <CVulkanDescriptorAllocator.h>
+#include <CVulkanCore.h>
+
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+
+#include <Utilities.h>
+
+namespace {
+	// Descriptors of each type per set, pools are shared by sets of any layout
+	struct PoolRatio {
+		VkDescriptorType m_type;
+		float m_perSet;
+	};
+
+	constexpr PoolRatio cexp_poolRatios[] = {
+		{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2.0f },
+		{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 2.0f },
+		{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1.0f },
+		{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 1.0f },
+		{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4.0f },
+		{ VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 1.0f },
+		{ VK_DESCRIPTOR_TYPE_SAMPLER, 1.0f },
+		{ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1.0f },
+	};
+}
+
+VulkanApp::CVulkanDescriptorAllocator::CVulkanDescriptorAllocator(const CVulkanCore *const pCore, const uint32_t frameSlotCount, const uint32_t setsPerPool)
+	: m_pCore(pCore), m_setsPerPool(std::max(setsPerPool, 1u)) {
+
+	if (m_pCore == nullptr) {
+		throw std::runtime_error(UTIL_EXC_MSG("Pointer to parent object was null"));
+	}
+
+	m_slots.resize(std::max(frameSlotCount, 1u));
+
+	try {
+		for (auto &slot : m_slots) {
+			slot.m_pools.push_back(CreatePool());
+		}
+	}
+	catch (...) {
+		Release();
+		throw;
+	}
+}
+
+VulkanApp::CVulkanDescriptorAllocator::~CVulkanDescriptorAllocator() {
+	Release();
+}
+
+void VulkanApp::CVulkanDescriptorAllocator::BeginFrame(const uint32_t frameSlot) {
+	m_currentSlot = frameSlot % static_cast<uint32_t>(m_slots.size());
+	m_allocatedSets = 0u;
+
+	FrameSlot &slot = m_slots[m_currentSlot];
+	for (uint32_t i = 0u; i <= slot.m_currentPool && i < slot.m_pools.size(); i++) {
+		vkResetDescriptorPool(m_pCore->GetVkLogicalDevice(), slot.m_pools[i], 0);
+	}
+	slot.m_currentPool = 0u;
+}
+
+VkDescriptorSet VulkanApp::CVulkanDescriptorAllocator::Allocate(const VkDescriptorSetLayout setLayout) {
+	FrameSlot &slot = m_slots[m_currentSlot];
+
+	VkDescriptorSetAllocateInfo setAI = {};
+	setAI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	setAI.descriptorSetCount = 1;
+	setAI.pSetLayouts = &setLayout;
+
+	// A full pool is only retried once, with the next pool of the slot or a new one
+	for (uint32_t attempt = 0u; attempt < 2u; attempt++) {
+		setAI.descriptorPool = slot.m_pools[slot.m_currentPool];
+
+		VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+		VkResult result = vkAllocateDescriptorSets(m_pCore->GetVkLogicalDevice(), &setAI, &descriptorSet);
+		if (result == VK_SUCCESS) {
+			m_allocatedSets++;
+			return descriptorSet;
+		}
+
+		if (result != VK_ERROR_OUT_OF_POOL_MEMORY && result != VK_ERROR_FRAGMENTED_POOL) {
+			throw std::runtime_error(UTIL_EXC_MSG_EX("Cannot allocate a descriptor set", result));
+		}
+
+		slot.m_currentPool++;
+		if (slot.m_currentPool == slot.m_pools.size()) {
+			slot.m_pools.push_back(CreatePool());
+		}
+	}
+
+	throw std::runtime_error(UTIL_EXC_MSG("Descriptor set layout does not fit into an empty pool"));
+}
+
+uint32_t VulkanApp::CVulkanDescriptorAllocator::GetPoolCount() const {
+	size_t count = 0u;
+	for (const auto &slot : m_slots) {
+		count += slot.m_pools.size();
+	}
+	return static_cast<uint32_t>(count);
+}
+
+VkDescriptorPool VulkanApp::CVulkanDescriptorAllocator::CreatePool() const {
+	VkDescriptorPoolSize poolSizes[std::size(cexp_poolRatios)] = {};
+	for (size_t i = 0u; i < std::size(cexp_poolRatios); i++) {
+		poolSizes[i].type = cexp_poolRatios[i].m_type;
+		poolSizes[i].descriptorCount = static_cast<uint32_t>(cexp_poolRatios[i].m_perSet * m_setsPerPool);
+	}
+
+	// No FREE_DESCRIPTOR_SET_BIT, sets are only released by resetting the whole pool
+	VkDescriptorPoolCreateInfo poolCI = {};
+	poolCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolCI.maxSets = m_setsPerPool;
+	poolCI.poolSizeCount = static_cast<uint32_t>(std::size(poolSizes));
+	poolCI.pPoolSizes = poolSizes;
+
+	VkDescriptorPool pool = VK_NULL_HANDLE;
+	VkResult result = vkCreateDescriptorPool(m_pCore->GetVkLogicalDevice(), &poolCI, nullptr, &pool);
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error(UTIL_EXC_MSG_EX("Cannot create a descriptor pool", result));
+	}
+	return pool;
+}
+
+void VulkanApp::CVulkanDescriptorAllocator::Release() {
+	for (auto &slot : m_slots) {
+		for (auto &pool : slot.m_pools) {
+			vkDestroyDescriptorPool(m_pCore->GetVkLogicalDevice(), pool, nullptr);
+		}
+		slot.m_pools.clear();
+		slot.m_currentPool = 0u;
+	}
+}
@@ -0,0 +1,152 @@
+#include <CVulkanDescriptorCache.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <Utilities.h>
+
+namespace {
+	bool SameBindings(const std::vector<VkDescriptorSetLayoutBinding> &a, const std::vector<VkDescriptorSetLayoutBinding> &b) {
+		return std::equal(a.begin(), a.end(), b.begin(), b.end(), [](const VkDescriptorSetLayoutBinding &x, const VkDescriptorSetLayoutBinding &y) {
+			return x.binding == y.binding && x.descriptorType == y.descriptorType &&
+				x.descriptorCount == y.descriptorCount && x.stageFlags == y.stageFlags;
+		});
+	}
+
+	bool SameRanges(const std::vector<VkPushConstantRange> &a, const std::vector<VkPushConstantRange> &b) {
+		return std::equal(a.begin(), a.end(), b.begin(), b.end(), [](const VkPushConstantRange &x, const VkPushConstantRange &y) {
+			return x.stageFlags == y.stageFlags && x.offset == y.offset && x.size == y.size;
+		});
+	}
+
+	// Field by field, the structures contain pointers and may contain padding
+	uint64_t HashBindings(const std::vector<VkDescriptorSetLayoutBinding> &bindings) {
+		uint64_t hash = VulkanApp::cexp_hashSeed;
+		for (const auto &binding : bindings) {
+			const uint32_t fields[] = { binding.binding, static_cast<uint32_t>(binding.descriptorType), binding.descriptorCount, binding.stageFlags };
+			hash = VulkanApp::Hash64(fields, sizeof(fields), hash);
+		}
+		return hash;
+	}
+
+	uint64_t HashPipelineLayout(const std::vector<VkDescriptorSetLayout> &setLayouts, const std::vector<VkPushConstantRange> &pushConstantRanges) {
+		uint64_t hash = VulkanApp::cexp_hashSeed;
+		for (const auto &setLayout : setLayouts) {
+			const uint64_t handle = (uint64_t)(setLayout);
+			hash = VulkanApp::Hash64(&handle, sizeof(handle), hash);
+		}
+		for (const auto &range : pushConstantRanges) {
+			const uint32_t fields[] = { range.stageFlags, range.offset, range.size };
+			hash = VulkanApp::Hash64(fields, sizeof(fields), hash);
+		}
+		return hash;
+	}
+}
+
+VulkanApp::CVulkanDescriptorCache::CVulkanDescriptorCache(const VkDevice device)
+	: m_vkDevice(device) {
+}
+
+VulkanApp::CVulkanDescriptorCache::~CVulkanDescriptorCache() {
+	for (auto &entry : m_pipelineLayouts) {
+		vkDestroyPipelineLayout(m_vkDevice, entry.second.m_vkPipelineLayout, nullptr);
+	}
+
+	for (auto &entry : m_setLayouts) {
+		vkDestroyDescriptorSetLayout(m_vkDevice, entry.second.m_vkSetLayout, nullptr);
+	}
+}
+
+VkDescriptorSetLayout VulkanApp::CVulkanDescriptorCache::GetSetLayout(std::initializer_list<VkDescriptorSetLayoutBinding> bindings) {
+	return GetSetLayout(bindings.begin(), static_cast<uint32_t>(bindings.size()));
+}
+
+VkDescriptorSetLayout VulkanApp::CVulkanDescriptorCache::GetSetLayout(const VkDescriptorSetLayoutBinding *pBindings, const uint32_t bindingCount) {
+	// Sorted, so the order the bindings were listed in does not create another layout
+	std::vector<VkDescriptorSetLayoutBinding> bindings(pBindings, pBindings + bindingCount);
+	for (auto &binding : bindings) {
+		if (binding.pImmutableSamplers != nullptr) {
+			throw std::runtime_error(UTIL_EXC_MSG("Immutable samplers are not supported by the layout cache"));
+		}
+	}
+	std::sort(bindings.begin(), bindings.end(), [](const VkDescriptorSetLayoutBinding &a, const VkDescriptorSetLayoutBinding &b) {
+		return a.binding < b.binding;
+	});
+
+	const uint64_t hash = HashBindings(bindings);
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	auto range = m_setLayouts.equal_range(hash);
+	for (auto itr = range.first; itr != range.second; ++itr) {
+		if (SameBindings(itr->second.m_bindings, bindings)) {
+			return itr->second.m_vkSetLayout;
+		}
+	}
+
+	VkDescriptorSetLayoutCreateInfo setLayoutCI = {};
+	setLayoutCI.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	setLayoutCI.bindingCount = static_cast<uint32_t>(bindings.size());
+	setLayoutCI.pBindings = bindings.data();
+
+	SetLayoutEntry entry;
+	VkResult result = vkCreateDescriptorSetLayout(m_vkDevice, &setLayoutCI, nullptr, &entry.m_vkSetLayout);
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error(UTIL_EXC_MSG_EX("Cannot create a descriptor set layout", result));
+	}
+
+	entry.m_bindings = std::move(bindings);
+	const VkDescriptorSetLayout setLayout = entry.m_vkSetLayout;
+	m_setLayouts.emplace(hash, std::move(entry));
+	return setLayout;
+}
+
+VkPipelineLayout VulkanApp::CVulkanDescriptorCache::GetPipelineLayout(std::initializer_list<VkDescriptorSetLayout> setLayouts,
+	std::initializer_list<VkPushConstantRange> pushConstantRanges) {
+	return GetPipelineLayout(setLayouts.begin(), static_cast<uint32_t>(setLayouts.size()),
+		pushConstantRanges.begin(), static_cast<uint32_t>(pushConstantRanges.size()));
+}
+
+VkPipelineLayout VulkanApp::CVulkanDescriptorCache::GetPipelineLayout(const VkDescriptorSetLayout *pSetLayouts, const uint32_t setLayoutCount,
+	const VkPushConstantRange *pPushConstantRanges, const uint32_t pushConstantRangeCount) {
+
+	std::vector<VkDescriptorSetLayout> setLayouts(pSetLayouts, pSetLayouts + setLayoutCount);
+	std::vector<VkPushConstantRange> pushConstantRanges(pPushConstantRanges, pPushConstantRanges + pushConstantRangeCount);
+	const uint64_t hash = HashPipelineLayout(setLayouts, pushConstantRanges);
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	auto range = m_pipelineLayouts.equal_range(hash);
+	for (auto itr = range.first; itr != range.second; ++itr) {
+		if (itr->second.m_setLayouts == setLayouts && SameRanges(itr->second.m_pushConstantRanges, pushConstantRanges)) {
+			return itr->second.m_vkPipelineLayout;
+		}
+	}
+
+	VkPipelineLayoutCreateInfo pipelineLayoutCI = {};
+	pipelineLayoutCI.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutCI.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
+	pipelineLayoutCI.pSetLayouts = setLayouts.data();
+	pipelineLayoutCI.pushConstantRangeCount = static_cast<uint32_t>(pushConstantRanges.size());
+	pipelineLayoutCI.pPushConstantRanges = pushConstantRanges.data();
+
+	PipelineLayoutEntry entry;
+	VkResult result = vkCreatePipelineLayout(m_vkDevice, &pipelineLayoutCI, nullptr, &entry.m_vkPipelineLayout);
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error(UTIL_EXC_MSG_EX("Cannot create a pipeline layout", result));
+	}
+
+	entry.m_setLayouts = std::move(setLayouts);
+	entry.m_pushConstantRanges = std::move(pushConstantRanges);
+	const VkPipelineLayout pipelineLayout = entry.m_vkPipelineLayout;
+	m_pipelineLayouts.emplace(hash, std::move(entry));
+	return pipelineLayout;
+}
+
+uint32_t VulkanApp::CVulkanDescriptorCache::GetSetLayoutCount() const {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return static_cast<uint32_t>(m_setLayouts.size());
+}
+
+uint32_t VulkanApp::CVulkanDescriptorCache::GetPipelineLayoutCount() const {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return static_cast<uint32_t>(m_pipelineLayouts.size());
+}
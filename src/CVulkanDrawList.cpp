@@ -0,0 +1,303 @@
+#include <CVulkanDrawList.h>
+#include <CVulkanCore.h>
+#include <CVulkanBuffer.h>
+
+#include <stdexcept>
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <tuple>
+
+#include <Utilities.h>
+#include <CTracer.h>
+
+namespace {
+	// Non-dispatchable handles are pointers or 64-bit integers depending on the platform
+	template <typename T>
+	uint64_t HandleKey(const T handle) {
+		return (uint64_t)(handle);
+	}
+
+	auto SortKey(const VulkanApp::DrawPacket &packet) {
+		std::array<uint64_t, VulkanApp::DrawPacket::cexp_maxVertexBuffers * 2u> vertexBuffers = {};
+		for (uint32_t i = 0u; i < packet.m_vertexBufferCount; i++) {
+			vertexBuffers[i * 2u] = HandleKey(packet.m_vertexBuffers[i]);
+			vertexBuffers[i * 2u + 1u] = packet.m_vertexBufferOffsets[i];
+		}
+
+		std::array<uint32_t, VulkanApp::DrawPacket::cexp_maxDynamicOffsets> dynamicOffsets = {};
+		for (uint32_t i = 0u; i < packet.m_dynamicOffsetCount; i++) {
+			dynamicOffsets[i] = packet.m_dynamicOffsets[i];
+		}
+
+		// Push constants only split batches from packets without them, their values may differ within one
+		return std::make_tuple(HandleKey(packet.m_pipeline), HandleKey(packet.m_pipelineLayout),
+			HandleKey(packet.m_descriptorSet), packet.m_dynamicOffsetCount, dynamicOffsets,
+			packet.m_vertexBufferCount, vertexBuffers,
+			HandleKey(packet.m_indexBuffer), packet.m_indexBufferOffset, static_cast<uint32_t>(packet.m_indexType),
+			packet.m_pushConstantSize != 0u);
+	}
+
+	bool SharesDescriptorSet(const VulkanApp::DrawPacket &a, const VulkanApp::DrawPacket &b) {
+		if (a.m_pipelineLayout != b.m_pipelineLayout || a.m_descriptorSet != b.m_descriptorSet || a.m_dynamicOffsetCount != b.m_dynamicOffsetCount) {
+			return false;
+		}
+
+		for (uint32_t i = 0u; i < a.m_dynamicOffsetCount; i++) {
+			if (a.m_dynamicOffsets[i] != b.m_dynamicOffsets[i]) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool SharesVertexBuffers(const VulkanApp::DrawPacket &a, const VulkanApp::DrawPacket &b) {
+		if (a.m_vertexBufferCount != b.m_vertexBufferCount) {
+			return false;
+		}
+
+		for (uint32_t i = 0u; i < a.m_vertexBufferCount; i++) {
+			if (a.m_vertexBuffers[i] != b.m_vertexBuffers[i] || a.m_vertexBufferOffsets[i] != b.m_vertexBufferOffsets[i]) {
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+void VulkanApp::DrawPacket::SetVertexBuffer(const uint32_t binding, const VkBuffer buffer, const VkDeviceSize offset) {
+	if (binding >= cexp_maxVertexBuffers) {
+		throw std::runtime_error(UTIL_EXC_MSG("Vertex buffer binding is out of range"));
+	}
+
+	m_vertexBuffers[binding] = buffer;
+	m_vertexBufferOffsets[binding] = offset;
+	m_vertexBufferCount = std::max(m_vertexBufferCount, binding + 1u);
+}
+
+VulkanApp::CVulkanDrawList::CVulkanDrawList(const CVulkanCore *const pCore, const uint32_t frameSlotCount, const uint32_t capacity, const bool useIndirect)
+	: m_pCore(pCore),
+	m_useIndirect(useIndirect && pCore != nullptr && pCore->GetEnabledFeatures().multiDrawIndirect),
+	m_firstInstanceSupported(pCore != nullptr && pCore->GetEnabledFeatures().drawIndirectFirstInstance),
+	m_maxDrawIndirectCount(pCore != nullptr ? pCore->GetMaxDrawIndirectCount() : 1u) {
+
+	if (m_pCore == nullptr) {
+		throw std::runtime_error(UTIL_EXC_MSG("Pointer to parent object was null"));
+	}
+
+	m_packets.reserve(capacity);
+	m_indirectBuffers.resize(std::max(frameSlotCount, 1u), nullptr);
+	m_capacities.resize(m_indirectBuffers.size(), 0u);
+
+	if (!m_useIndirect) {
+		return;
+	}
+
+	try {
+		for (size_t i = 0u; i < m_indirectBuffers.size(); i++) {
+			m_indirectBuffers[i] = new CVulkanBuffer(m_pCore, nullptr, std::max(capacity, 1u) * cexp_commandStride,
+				{ VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, BufferMemory::HostVisible });
+			m_capacities[i] = std::max(capacity, 1u);
+		}
+	}
+	catch (...) {
+		Release();
+		throw;
+	}
+}
+
+VulkanApp::CVulkanDrawList::~CVulkanDrawList() {
+	Release();
+}
+
+void VulkanApp::CVulkanDrawList::Clear() {
+	m_packets.clear();
+	m_pushConstantData.clear();
+	m_batches.clear();
+	m_builtSlot = UINT32_MAX;
+}
+
+void VulkanApp::CVulkanDrawList::Add(const DrawPacket &packet) {
+	// Pipelines still compiling in a library come back as null, their draws are skipped
+	if (packet.m_pipeline == VK_NULL_HANDLE || packet.m_count == 0u || packet.m_instanceCount == 0u) {
+		return;
+	}
+	m_packets.push_back(packet);
+	m_packets.back().m_pushConstantSize = 0u;
+}
+
+void VulkanApp::CVulkanDrawList::Add(const DrawPacket &packet, const void *pushConstants, const uint32_t byteSize, const VkShaderStageFlags stages) {
+	// Pipelines still compiling in a library come back as null, their draws are skipped
+	if (packet.m_pipeline == VK_NULL_HANDLE || packet.m_count == 0u || packet.m_instanceCount == 0u) {
+		return;
+	}
+
+	if (byteSize == 0u || byteSize > cexp_maxPushConstantSize || byteSize % 4u != 0u || packet.m_pipelineLayout == VK_NULL_HANDLE) {
+		throw std::runtime_error(UTIL_EXC_MSG("Push constants need a pipeline layout and a multiple of 4 bytes up to 128"));
+	}
+
+	// One arena for the frame, packets refer to it by offset since it may grow
+	const size_t offset = m_pushConstantData.size();
+	m_pushConstantData.resize(offset + byteSize);
+	memcpy(m_pushConstantData.data() + offset, pushConstants, byteSize);
+
+	m_packets.push_back(packet);
+	DrawPacket &added = m_packets.back();
+	added.m_pushConstantStages = stages;
+	added.m_pushConstantSize = byteSize;
+	added.m_pushConstantOffset = static_cast<uint32_t>(offset);
+}
+
+bool VulkanApp::CVulkanDrawList::SharesBinds(const DrawPacket &a, const DrawPacket &b) {
+	return SortKey(a) == SortKey(b);
+}
+
+void VulkanApp::CVulkanDrawList::Build(const uint32_t frameSlot) {
+	TRACE_SCOPE("DrawList::Build");
+
+	const uint32_t slot = frameSlot % static_cast<uint32_t>(m_indirectBuffers.size());
+	m_builtSlot = UINT32_MAX;
+
+	// Stable, so packets with equal binds keep their submission order
+	std::stable_sort(m_packets.begin(), m_packets.end(), [](const DrawPacket &a, const DrawPacket &b) {
+		return SortKey(a) < SortKey(b);
+	});
+
+	m_batches.clear();
+	for (uint32_t i = 0u; i < m_packets.size(); i++) {
+		if (m_batches.empty() || !SharesBinds(m_packets[m_batches.back().m_firstDraw], m_packets[i])) {
+			Batch batch;
+			batch.m_firstDraw = i;
+			batch.m_indirect = m_useIndirect;
+			m_batches.push_back(batch);
+		}
+
+		// A non-zero first instance can only be read from an indirect command with drawIndirectFirstInstance,
+		// push constants have to be recorded between the draws
+		Batch &batch = m_batches.back();
+		batch.m_drawCount++;
+		if ((m_packets[i].m_firstInstance != 0u && !m_firstInstanceSupported) || m_packets[i].m_pushConstantSize != 0u) {
+			batch.m_indirect = false;
+		}
+	}
+
+	if (!m_useIndirect || m_packets.empty()) {
+		m_builtSlot = slot;
+		return;
+	}
+
+	// The previous frame of the slot has retired, its buffer can be replaced
+	const uint32_t drawCount = static_cast<uint32_t>(m_packets.size());
+	if (drawCount > m_capacities[slot]) {
+		uint32_t capacity = std::max(m_capacities[slot], 1u);
+		while (capacity < drawCount) {
+			capacity *= 2u;
+		}
+
+		delete m_indirectBuffers[slot];
+		m_indirectBuffers[slot] = nullptr;
+		m_capacities[slot] = 0u;
+
+		m_indirectBuffers[slot] = new CVulkanBuffer(m_pCore, nullptr, capacity * cexp_commandStride,
+			{ VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, BufferMemory::HostVisible });
+		m_capacities[slot] = capacity;
+	}
+
+	uint8_t *pCommands = static_cast<uint8_t*>(m_indirectBuffers[slot]->GetMappedData());
+	for (uint32_t i = 0u; i < drawCount; i++) {
+		const DrawPacket &packet = m_packets[i];
+		if (packet.m_indexBuffer != VK_NULL_HANDLE) {
+			VkDrawIndexedIndirectCommand command = {};
+			command.indexCount = packet.m_count;
+			command.instanceCount = packet.m_instanceCount;
+			command.firstIndex = packet.m_first;
+			command.vertexOffset = packet.m_vertexOffset;
+			command.firstInstance = packet.m_firstInstance;
+			memcpy(pCommands + i * cexp_commandStride, &command, sizeof(command));
+		}
+		else {
+			VkDrawIndirectCommand command = {};
+			command.vertexCount = packet.m_count;
+			command.instanceCount = packet.m_instanceCount;
+			command.firstVertex = packet.m_first;
+			command.firstInstance = packet.m_firstInstance;
+			memcpy(pCommands + i * cexp_commandStride, &command, sizeof(command));
+		}
+	}
+
+	m_builtSlot = slot;
+}
+
+void VulkanApp::CVulkanDrawList::Record(const VkCommandBuffer commandBuffer, const uint32_t firstDraw, const uint32_t drawCount) const {
+	if (m_builtSlot == UINT32_MAX) {
+		throw std::runtime_error(UTIL_EXC_MSG("Draw list was not built for this frame"));
+	}
+
+	const uint32_t endDraw = std::min(firstDraw + drawCount, GetDrawCount());
+	const VkBuffer indirectBuffer = m_useIndirect ? m_indirectBuffers[m_builtSlot]->GetHandle() : VK_NULL_HANDLE;
+
+	// Binds are skipped while consecutive batches keep using the same objects
+	const DrawPacket *pBound = nullptr;
+	for (const Batch &batch : m_batches) {
+		const uint32_t begin = std::max(batch.m_firstDraw, firstDraw);
+		const uint32_t end = std::min(batch.m_firstDraw + batch.m_drawCount, endDraw);
+		if (begin >= end) {
+			continue;
+		}
+
+		const DrawPacket &packet = m_packets[batch.m_firstDraw];
+		if (pBound == nullptr || pBound->m_pipeline != packet.m_pipeline) {
+			vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, packet.m_pipeline);
+		}
+		if (packet.m_descriptorSet != VK_NULL_HANDLE && (pBound == nullptr || !SharesDescriptorSet(*pBound, packet))) {
+			vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, packet.m_pipelineLayout, 0, 1, &packet.m_descriptorSet,
+				packet.m_dynamicOffsetCount, packet.m_dynamicOffsets);
+		}
+		if (packet.m_vertexBufferCount > 0u && (pBound == nullptr || !SharesVertexBuffers(*pBound, packet))) {
+			vkCmdBindVertexBuffers(commandBuffer, 0, packet.m_vertexBufferCount, packet.m_vertexBuffers, packet.m_vertexBufferOffsets);
+		}
+		const bool indexed = packet.m_indexBuffer != VK_NULL_HANDLE;
+		if (indexed && (pBound == nullptr || pBound->m_indexBuffer != packet.m_indexBuffer ||
+			pBound->m_indexBufferOffset != packet.m_indexBufferOffset || pBound->m_indexType != packet.m_indexType)) {
+			vkCmdBindIndexBuffer(commandBuffer, packet.m_indexBuffer, packet.m_indexBufferOffset, packet.m_indexType);
+		}
+		pBound = &packet;
+
+		if (batch.m_indirect) {
+			for (uint32_t first = begin; first < end; first += m_maxDrawIndirectCount) {
+				const uint32_t count = std::min(end - first, m_maxDrawIndirectCount);
+				const VkDeviceSize offset = static_cast<VkDeviceSize>(first) * cexp_commandStride;
+				if (indexed) {
+					vkCmdDrawIndexedIndirect(commandBuffer, indirectBuffer, offset, count, cexp_commandStride);
+				}
+				else {
+					vkCmdDrawIndirect(commandBuffer, indirectBuffer, offset, count, cexp_commandStride);
+				}
+			}
+			continue;
+		}
+
+		for (uint32_t i = begin; i < end; i++) {
+			const DrawPacket &draw = m_packets[i];
+			if (draw.m_pushConstantSize != 0u) {
+				vkCmdPushConstants(commandBuffer, draw.m_pipelineLayout, draw.m_pushConstantStages, 0, draw.m_pushConstantSize,
+					m_pushConstantData.data() + draw.m_pushConstantOffset);
+			}
+			if (indexed) {
+				vkCmdDrawIndexed(commandBuffer, draw.m_count, draw.m_instanceCount, draw.m_first, draw.m_vertexOffset, draw.m_firstInstance);
+			}
+			else {
+				vkCmdDraw(commandBuffer, draw.m_count, draw.m_instanceCount, draw.m_first, draw.m_firstInstance);
+			}
+		}
+	}
+}
+
+void VulkanApp::CVulkanDrawList::Release() {
+	for (auto &pBuffer : m_indirectBuffers) {
+		if (pBuffer) {
+			delete pBuffer;
+			pBuffer = nullptr;
+		}
+	}
+}
@@ -0,0 +1,162 @@
+#include <CVulkanFrameRing.h>
+#include <CVulkanCore.h>
+
+#include <stdexcept>
+#include <algorithm>
+
+#include <Utilities.h>
+#include <CTracer.h>
+
+VulkanApp::CVulkanFrameRing::CVulkanFrameRing(const CVulkanCore *const pCore, const uint32_t framesInFlight, const uint32_t imageCount)
+	: m_pCore(pCore) {
+
+	if (m_pCore == nullptr) {
+		throw std::runtime_error(UTIL_EXC_MSG("Pointer to parent object was null"));
+	}
+
+	m_frames.resize(std::clamp(framesInFlight, cexp_minFramesInFlight, cexp_maxFramesInFlight));
+	m_imagesInFlight.resize(imageCount, VK_NULL_HANDLE);
+
+	VkCommandPoolCreateInfo commandPoolCI = {};
+	commandPoolCI.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	commandPoolCI.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+	commandPoolCI.queueFamilyIndex = m_pCore->GetQueueFamilyIndex();
+
+	VkCommandBufferAllocateInfo commandBufferAI = {};
+	commandBufferAI.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	commandBufferAI.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	commandBufferAI.commandBufferCount = 1u;
+
+	VkSemaphoreCreateInfo semaphoreCI = {};
+	semaphoreCI.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+	// Fences start signaled, so the first wait on every slot returns immediately
+	VkFenceCreateInfo fenceCI = {};
+	fenceCI.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+	fenceCI.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+	const VkDevice device = m_pCore->GetVkLogicalDevice();
+	try {
+		for (auto &frame : m_frames) {
+			VkResult result = vkCreateCommandPool(device, &commandPoolCI, nullptr, &frame.m_vkCommandPool);
+			if (result != VK_SUCCESS) {
+				throw std::runtime_error(UTIL_EXC_MSG_EX("Cannot create a command pool", result));
+			}
+
+			commandBufferAI.commandPool = frame.m_vkCommandPool;
+			result = vkAllocateCommandBuffers(device, &commandBufferAI, &frame.m_vkCommandBuffer);
+			if (result != VK_SUCCESS) {
+				throw std::runtime_error(UTIL_EXC_MSG_EX("Cannot allocate a command buffer", result));
+			}
+
+			result = vkCreateSemaphore(device, &semaphoreCI, nullptr, &frame.m_vkImageAcquiredSem);
+			if (result != VK_SUCCESS) {
+				throw std::runtime_error(UTIL_EXC_MSG_EX("Cannot create a semaphore", result));
+			}
+
+			result = vkCreateFence(device, &fenceCI, nullptr, &frame.m_vkInFlightFence);
+			if (result != VK_SUCCESS) {
+				throw std::runtime_error(UTIL_EXC_MSG_EX("Cannot create a fence", result));
+			}
+		}
+	}
+	catch (...) {
+		Release();
+		throw;
+	}
+}
+
+VulkanApp::CVulkanFrameRing::~CVulkanFrameRing() {
+	WaitIdle();
+	Release();
+}
+
+VulkanApp::FrameContext& VulkanApp::CVulkanFrameRing::BeginFrame() {
+	FrameContext &frame = m_frames[m_currentSlot];
+
+	// Wait until the GPU finished the frame previously recorded into this slot
+	TRACE_SCOPE("FenceWait");
+	VkResult result = vkWaitForFences(m_pCore->GetVkLogicalDevice(), 1u, &frame.m_vkInFlightFence, VK_TRUE, UINT64_MAX);
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error(UTIL_EXC_MSG_EX("Waiting for the frame fence failed", result));
+	}
+
+	// A single queue retires submissions in order
+	m_completedFrame = std::max(m_completedFrame, frame.m_frameNumber);
+
+	// All command buffers of the slot are retired, recycle them at once
+	result = vkResetCommandPool(m_pCore->GetVkLogicalDevice(), frame.m_vkCommandPool, 0);
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error(UTIL_EXC_MSG_EX("Cannot reset the command pool", result));
+	}
+
+	return frame;
+}
+
+void VulkanApp::CVulkanFrameRing::SetImageIndex(const uint32_t imageIndex) {
+	FrameContext &frame = m_frames[m_currentSlot];
+	const VkDevice device = m_pCore->GetVkLogicalDevice();
+
+	if (imageIndex >= m_imagesInFlight.size()) {
+		m_imagesInFlight.resize(imageIndex + 1u, VK_NULL_HANDLE);
+	}
+
+	// Another slot may still be rendering to the acquired image
+	VkFence imageFence = m_imagesInFlight[imageIndex];
+	if (imageFence != VK_NULL_HANDLE && imageFence != frame.m_vkInFlightFence) {
+		vkWaitForFences(device, 1u, &imageFence, VK_TRUE, UINT64_MAX);
+	}
+
+	m_imagesInFlight[imageIndex] = frame.m_vkInFlightFence;
+	frame.m_imageIndex = imageIndex;
+	frame.m_frameNumber = ++m_submittedFrames;
+
+	// The fence is reset only once it is certain that a submission will signal it
+	vkResetFences(device, 1u, &frame.m_vkInFlightFence);
+}
+
+void VulkanApp::CVulkanFrameRing::EndFrame() {
+	m_currentSlot = (m_currentSlot + 1u) % static_cast<uint32_t>(m_frames.size());
+}
+
+void VulkanApp::CVulkanFrameRing::WaitIdle() const {
+	std::vector<VkFence> fences;
+	for (auto &frame : m_frames) {
+		if (frame.m_vkInFlightFence != VK_NULL_HANDLE) {
+			fences.push_back(frame.m_vkInFlightFence);
+		}
+	}
+
+	if (!fences.empty()) {
+		vkWaitForFences(m_pCore->GetVkLogicalDevice(), static_cast<uint32_t>(fences.size()), fences.data(), VK_TRUE, UINT64_MAX);
+	}
+}
+
+void VulkanApp::CVulkanFrameRing::SetImageCount(const uint32_t imageCount) {
+	m_imagesInFlight.assign(imageCount, VK_NULL_HANDLE);
+	for (auto &frame : m_frames) {
+		frame.m_imageIndex = UINT32_MAX;
+	}
+}
+
+void VulkanApp::CVulkanFrameRing::Release() {
+	const VkDevice device = m_pCore->GetVkLogicalDevice();
+	for (auto &frame : m_frames) {
+		if (frame.m_vkInFlightFence != VK_NULL_HANDLE) {
+			vkDestroyFence(device, frame.m_vkInFlightFence, nullptr);
+			frame.m_vkInFlightFence = VK_NULL_HANDLE;
+		}
+
+		if (frame.m_vkImageAcquiredSem != VK_NULL_HANDLE) {
+			vkDestroySemaphore(device, frame.m_vkImageAcquiredSem, nullptr);
+			frame.m_vkImageAcquiredSem = VK_NULL_HANDLE;
+		}
+
+		// Destroying the pool frees its command buffers
+		if (frame.m_vkCommandPool != VK_NULL_HANDLE) {
+			vkDestroyCommandPool(device, frame.m_vkCommandPool, nullptr);
+			frame.m_vkCommandPool = VK_NULL_HANDLE;
+			frame.m_vkCommandBuffer = VK_NULL_HANDLE;
+		}
+	}
+}
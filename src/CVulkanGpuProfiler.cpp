@@ -0,0 +1,133 @@
+#include <CVulkanGpuProfiler.h>
+#include <CVulkanCore.h>
+
+#include <stdexcept>
+
+#include <Utilities.h>
+
+VulkanApp::CVulkanGpuProfiler::CVulkanGpuProfiler(const CVulkanCore *const pCore, const uint32_t frameSlotCount, const uint32_t maxScopesPerFrame,
+	const uint32_t statisticsWindow)
+	: m_pCore(pCore), m_maxScopes(maxScopesPerFrame), m_statisticsWindow(statisticsWindow) {
+
+	if (m_pCore == nullptr) {
+		throw std::runtime_error(UTIL_EXC_MSG("Pointer to parent object was null"));
+	}
+
+	m_frames.resize(frameSlotCount);
+
+	// Timestamps are only meaningful when the queue writes at least some bits of them
+	const DeviceCaps &caps = m_pCore->GetDeviceCaps();
+	const uint32_t familyIndex = m_pCore->GetQueueFamilyIndex();
+	const uint32_t validBits = familyIndex < caps.GetQueueFamilyCount() ? caps.m_queueFamilies[familyIndex].timestampValidBits : 0u;
+	if (validBits == 0u || m_maxScopes == 0u || frameSlotCount == 0u) {
+		return;
+	}
+
+	m_nsPerTick = static_cast<double>(caps.m_properties.limits.timestampPeriod);
+	m_validMask = validBits >= 64u ? UINT64_MAX : ((1ull << validBits) - 1ull);
+
+	VkQueryPoolCreateInfo queryPoolCI = {};
+	queryPoolCI.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	queryPoolCI.queryType = VK_QUERY_TYPE_TIMESTAMP;
+	queryPoolCI.queryCount = frameSlotCount * m_maxScopes * 2u;
+
+	VkResult result = vkCreateQueryPool(m_pCore->GetVkLogicalDevice(), &queryPoolCI, nullptr, &m_vkQueryPool);
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error(UTIL_EXC_MSG_EX("Cannot create a timestamp query pool", result));
+	}
+
+	m_results.resize(m_maxScopes * 2u * 2u);
+}
+
+VulkanApp::CVulkanGpuProfiler::~CVulkanGpuProfiler() {
+	if (m_vkQueryPool != VK_NULL_HANDLE) {
+		vkDestroyQueryPool(m_pCore->GetVkLogicalDevice(), m_vkQueryPool, nullptr);
+	}
+}
+
+void VulkanApp::CVulkanGpuProfiler::BeginFrame(const VkCommandBuffer commandBuffer, const uint32_t frameSlot) {
+	if (!IsEnabled() || frameSlot >= m_frames.size()) {
+		return;
+	}
+
+	// The queries of the slot were written by the frame its fence has just retired
+	Resolve(frameSlot);
+
+	m_currentSlot = frameSlot;
+	vkCmdResetQueryPool(commandBuffer, m_vkQueryPool, frameSlot * m_maxScopes * 2u, m_maxScopes * 2u);
+}
+
+void VulkanApp::CVulkanGpuProfiler::ResolveAll() {
+	if (!IsEnabled()) {
+		return;
+	}
+
+	// The current slot holds the newest frame, the one after it the oldest
+	const uint32_t slotCount = static_cast<uint32_t>(m_frames.size());
+	for (uint32_t i = 1u; i <= slotCount; i++) {
+		Resolve((m_currentSlot + i) % slotCount);
+	}
+}
+
+uint32_t VulkanApp::CVulkanGpuProfiler::BeginScope(const VkCommandBuffer commandBuffer, const std::string &name) {
+	if (!IsEnabled()) {
+		return cexp_invalidScope;
+	}
+
+	FrameScopes &frame = m_frames[m_currentSlot];
+	if (frame.m_names.size() >= m_maxScopes) {
+		return cexp_invalidScope;
+	}
+
+	const uint32_t scope = static_cast<uint32_t>(frame.m_names.size());
+	frame.m_names.push_back(name);
+	frame.m_closed.push_back(false);
+
+	vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_vkQueryPool, (m_currentSlot * m_maxScopes + scope) * 2u);
+	return scope;
+}
+
+void VulkanApp::CVulkanGpuProfiler::EndScope(const VkCommandBuffer commandBuffer, const uint32_t scope) {
+	if (!IsEnabled() || scope >= m_frames[m_currentSlot].m_names.size()) {
+		return;
+	}
+
+	m_frames[m_currentSlot].m_closed[scope] = true;
+	vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_vkQueryPool, (m_currentSlot * m_maxScopes + scope) * 2u + 1u);
+}
+
+void VulkanApp::CVulkanGpuProfiler::Resolve(const uint32_t frameSlot) {
+	FrameScopes &frame = m_frames[frameSlot];
+	const uint32_t scopeCount = static_cast<uint32_t>(frame.m_names.size());
+	if (scopeCount == 0u) {
+		return;
+	}
+
+	// No wait flag, queries which are not available yet are skipped
+	const VkResult result = vkGetQueryPoolResults(
+		m_pCore->GetVkLogicalDevice(),
+		m_vkQueryPool,
+		frameSlot * m_maxScopes * 2u,
+		scopeCount * 2u,
+		scopeCount * 2u * 2u * sizeof(uint64_t),
+		m_results.data(),
+		2u * sizeof(uint64_t),
+		VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+
+	if (result == VK_SUCCESS || result == VK_NOT_READY) {
+		for (uint32_t i = 0u; i < scopeCount; i++) {
+			const uint64_t *begin = &m_results[i * 4u];
+			const uint64_t *end = begin + 2u;
+			if (!frame.m_closed[i] || begin[1] == 0u || end[1] == 0u) {
+				continue;
+			}
+
+			// Masking keeps the difference correct when the counter wraps around
+			const uint64_t ticks = (end[0] - begin[0]) & m_validMask;
+			m_statistics.try_emplace(frame.m_names[i], m_statisticsWindow).first->second.Add(static_cast<double>(ticks) * m_nsPerTick / 1000000.0);
+		}
+	}
+
+	frame.m_names.clear();
+	frame.m_closed.clear();
+}
@@ -0,0 +1,400 @@
+#include <CVulkanMemoryAllocator.h>
+
+#include <stdexcept>
+#include <algorithm>
+#include <iterator>
+
+#include <Utilities.h>
+
+namespace VulkanApp {
+	static VkDeviceSize AlignUp(const VkDeviceSize value, const VkDeviceSize alignment) {
+		return (value + alignment - 1u) / alignment * alignment;
+	}
+
+	// Granularity is a power of two, see VkPhysicalDeviceLimits::bufferImageGranularity
+	static bool OnSamePage(const VkDeviceSize lastByteA, const VkDeviceSize firstByteB, const VkDeviceSize pageSize) {
+		return (lastByteA & ~(pageSize - 1u)) == (firstByteB & ~(pageSize - 1u));
+	}
+}
+
+VulkanApp::CVulkanMemoryAllocator::CVulkanMemoryAllocator(const VkPhysicalDevice physicalDevice, const VkDevice device, const VkDeviceSize blockSize)
+	: m_vkDevice(device), m_blockSize(blockSize) {
+
+	vkGetPhysicalDeviceMemoryProperties(physicalDevice, &m_memoryProperties);
+
+	VkPhysicalDeviceProperties properties = {};
+	vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+	m_bufferImageGranularity = std::max<VkDeviceSize>(properties.limits.bufferImageGranularity, 1u);
+	m_nonCoherentAtomSize = std::max<VkDeviceSize>(properties.limits.nonCoherentAtomSize, 1u);
+	m_maxAllocationCount = properties.limits.maxMemoryAllocationCount;
+}
+
+VulkanApp::CVulkanMemoryAllocator::~CVulkanMemoryAllocator() {
+	for (uint32_t i = 0; i < m_blocks.size(); i++) {
+		DestroyBlock(i);
+	}
+}
+
+uint32_t VulkanApp::CVulkanMemoryAllocator::FindMemoryType(const uint32_t memoryTypeBits, const VkMemoryPropertyFlags requiredFlags, const VkMemoryPropertyFlags preferredFlags) const {
+
+	// Every requested property has to be present, not just one of them
+	auto findType = [this, memoryTypeBits](const VkMemoryPropertyFlags flags)->uint32_t {
+		for (uint32_t i = 0; i < m_memoryProperties.memoryTypeCount; i++) {
+			if ((memoryTypeBits & (1u << i)) &&
+				(m_memoryProperties.memoryTypes[i].propertyFlags & flags) == flags) {
+				return i;
+			}
+		}
+		return UINT32_MAX;
+	};
+
+	uint32_t index = findType(requiredFlags | preferredFlags);
+	if (index == UINT32_MAX && preferredFlags != 0u) {
+		index = findType(requiredFlags);
+	}
+	return index;
+}
+
+VulkanApp::MemoryAllocation VulkanApp::CVulkanMemoryAllocator::Allocate(const VkMemoryRequirements &requirements, const VkMemoryPropertyFlags requiredFlags,
+	const VkMemoryPropertyFlags preferredFlags, const AllocationKind kind) {
+
+	const uint32_t preferredType = FindMemoryType(requirements.memoryTypeBits, requiredFlags, preferredFlags);
+	if (preferredType == UINT32_MAX) {
+		throw std::runtime_error(UTIL_EXC_MSG("Unable to find required memory type."));
+	}
+
+	// Flushed ranges are rounded to whole atoms, those must not reach into another suballocation
+	auto allocateFromType = [this, &requirements, kind](const uint32_t memoryTypeIndex) {
+		VkDeviceSize alignment = std::max<VkDeviceSize>(requirements.alignment, 1u);
+		VkDeviceSize size = requirements.size;
+
+		const VkMemoryPropertyFlags flags = m_memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags;
+		if ((flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) && !(flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)) {
+			alignment = std::max(alignment, m_nonCoherentAtomSize);
+			size = AlignUp(size, m_nonCoherentAtomSize);
+		}
+		return AllocateFromType(memoryTypeIndex, size, alignment, kind);
+	};
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	try {
+		return allocateFromType(preferredType);
+	}
+	catch (const std::runtime_error &) {
+		// The heap of the preferred type may be exhausted, fall back to any type with the required properties
+		const uint32_t requiredType = FindMemoryType(requirements.memoryTypeBits, requiredFlags, 0u);
+		if (requiredType == preferredType) {
+			throw;
+		}
+		return allocateFromType(requiredType);
+	}
+}
+
+VulkanApp::MemoryAllocation VulkanApp::CVulkanMemoryAllocator::AllocateForBuffer(const VkBuffer buffer, const VkMemoryPropertyFlags requiredFlags, const VkMemoryPropertyFlags preferredFlags) {
+	VkMemoryRequirements memoryRequirements = {};
+	vkGetBufferMemoryRequirements(m_vkDevice, buffer, &memoryRequirements);
+
+	MemoryAllocation allocation = Allocate(memoryRequirements, requiredFlags, preferredFlags, AllocationKind::Linear);
+
+	VkResult result = vkBindBufferMemory(m_vkDevice, buffer, allocation.m_vkMemory, allocation.m_offset);
+	if (result != VK_SUCCESS) {
+		Free(allocation);
+		throw std::runtime_error(UTIL_EXC_MSG_EX("Buffer memory binding failed.", result));
+	}
+	return allocation;
+}
+
+VulkanApp::MemoryAllocation VulkanApp::CVulkanMemoryAllocator::AllocateForImage(const VkImage image, const VkImageTiling tiling, const VkMemoryPropertyFlags requiredFlags, const VkMemoryPropertyFlags preferredFlags) {
+	VkMemoryRequirements memoryRequirements = {};
+	vkGetImageMemoryRequirements(m_vkDevice, image, &memoryRequirements);
+
+	const AllocationKind kind = (tiling == VK_IMAGE_TILING_OPTIMAL) ? AllocationKind::Optimal : AllocationKind::Linear;
+	MemoryAllocation allocation = Allocate(memoryRequirements, requiredFlags, preferredFlags, kind);
+
+	VkResult result = vkBindImageMemory(m_vkDevice, image, allocation.m_vkMemory, allocation.m_offset);
+	if (result != VK_SUCCESS) {
+		Free(allocation);
+		throw std::runtime_error(UTIL_EXC_MSG_EX("Image memory binding failed.", result));
+	}
+	return allocation;
+}
+
+void VulkanApp::CVulkanMemoryAllocator::Free(MemoryAllocation &allocation) {
+	if (!allocation.IsValid()) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	const uint32_t blockIndex = allocation.m_blockIndex;
+	MemoryBlock *pBlock = m_blocks[blockIndex];
+	FreeInBlock(*pBlock, allocation.m_offset);
+
+	if (pBlock->m_suballocations.empty()) {
+		// Keep one empty block per memory type around to avoid allocate/free thrashing
+		bool hasSibling = false;
+		for (uint32_t i = 0; i < m_blocks.size() && !hasSibling; i++) {
+			hasSibling = i != blockIndex && m_blocks[i] && !m_blocks[i]->m_dedicated &&
+				m_blocks[i]->m_memoryTypeIndex == pBlock->m_memoryTypeIndex;
+		}
+
+		if (pBlock->m_dedicated || hasSibling) {
+			DestroyBlock(blockIndex);
+		}
+	}
+
+	allocation = MemoryAllocation();
+}
+
+void VulkanApp::CVulkanMemoryAllocator::Flush(const MemoryAllocation &allocation, const VkDeviceSize offset, const VkDeviceSize size) const {
+	if (!allocation.IsValid() || allocation.m_pMappedData == nullptr || size == 0u || IsCoherent(allocation)) {
+		return;
+	}
+
+	// Allocation offset and size are whole atoms, so the rounded range stays inside of it
+	const VkDeviceSize begin = (allocation.m_offset + offset) / m_nonCoherentAtomSize * m_nonCoherentAtomSize;
+	const VkDeviceSize end = std::min(AlignUp(allocation.m_offset + offset + size, m_nonCoherentAtomSize), allocation.m_offset + allocation.m_size);
+
+	VkMappedMemoryRange range = {};
+	range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+	range.memory = allocation.m_vkMemory;
+	range.offset = begin;
+	range.size = end - begin;
+
+	VkResult result = vkFlushMappedMemoryRanges(m_vkDevice, 1u, &range);
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error(UTIL_EXC_MSG_EX("Cannot flush mapped memory", result));
+	}
+}
+
+bool VulkanApp::CVulkanMemoryAllocator::IsCoherent(const MemoryAllocation &allocation) const {
+	return allocation.m_memoryTypeIndex < m_memoryProperties.memoryTypeCount &&
+		(GetMemoryTypeFlags(allocation.m_memoryTypeIndex) & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0u;
+}
+
+VulkanApp::MemoryAllocation VulkanApp::CVulkanMemoryAllocator::AllocateFromType(const uint32_t memoryTypeIndex, const VkDeviceSize size,
+	const VkDeviceSize alignment, const AllocationKind kind) {
+
+	// Large resources get a block of their own, so they do not fragment the shared ones
+	const bool dedicated = size > m_blockSize / 2u;
+
+	VkDeviceSize offset = 0u;
+	uint32_t blockIndex = UINT32_MAX;
+
+	if (!dedicated) {
+		for (uint32_t i = 0; i < m_blocks.size(); i++) {
+			MemoryBlock *pBlock = m_blocks[i];
+			if (pBlock && !pBlock->m_dedicated && pBlock->m_memoryTypeIndex == memoryTypeIndex &&
+				pBlock->m_size - pBlock->m_allocatedBytes >= size &&
+				AllocateFromBlock(*pBlock, size, alignment, kind, &offset)) {
+				blockIndex = i;
+				break;
+			}
+		}
+	}
+
+	if (blockIndex == UINT32_MAX) {
+		blockIndex = CreateBlock(memoryTypeIndex, size, dedicated);
+		if (!AllocateFromBlock(*m_blocks[blockIndex], size, alignment, kind, &offset)) {
+			throw std::runtime_error(UTIL_EXC_MSG("Fresh memory block cannot hold the allocation."));
+		}
+	}
+
+	const MemoryBlock &block = *m_blocks[blockIndex];
+
+	MemoryAllocation allocation;
+	allocation.m_vkMemory = block.m_vkMemory;
+	allocation.m_offset = offset;
+	allocation.m_size = size;
+	allocation.m_memoryTypeIndex = memoryTypeIndex;
+	allocation.m_blockIndex = blockIndex;
+	if (block.m_pMappedData) {
+		allocation.m_pMappedData = static_cast<uint8_t*>(block.m_pMappedData) + offset;
+	}
+	return allocation;
+}
+
+bool VulkanApp::CVulkanMemoryAllocator::AllocateFromBlock(MemoryBlock &block, const VkDeviceSize size, const VkDeviceSize alignment,
+	const AllocationKind kind, VkDeviceSize *pOffsetOut) {
+
+	const VkDeviceSize granularity = m_bufferImageGranularity;
+
+	for (auto rangeItr = block.m_freeRanges.begin(); rangeItr != block.m_freeRanges.end(); ++rangeItr) {
+		const VkDeviceSize rangeEnd = rangeItr->m_offset + rangeItr->m_size;
+		VkDeviceSize offset = AlignUp(rangeItr->m_offset, alignment);
+
+		// The preceding resource of the other kind must not share a granularity page
+		auto nextItr = block.m_suballocations.lower_bound(offset);
+		if (granularity > 1u && nextItr != block.m_suballocations.begin()) {
+			auto prevItr = std::prev(nextItr);
+			if (prevItr->second.m_kind != kind &&
+				OnSamePage(prevItr->first + prevItr->second.m_size - 1u, offset, granularity)) {
+				offset = AlignUp(offset, granularity);
+			}
+		}
+
+		if (offset >= rangeEnd || rangeEnd - offset < size) {
+			continue;
+		}
+
+		// Same rule for the following resource, it cannot be moved so the range is rejected instead
+		nextItr = block.m_suballocations.lower_bound(offset + size);
+		if (granularity > 1u && nextItr != block.m_suballocations.end() &&
+			nextItr->second.m_kind != kind &&
+			OnSamePage(offset + size - 1u, nextItr->first, granularity)) {
+			continue;
+		}
+
+		// Split the free range around the new suballocation
+		const FreeRange head = { rangeItr->m_offset, offset - rangeItr->m_offset };
+		const FreeRange tail = { offset + size, rangeEnd - (offset + size) };
+
+		rangeItr = block.m_freeRanges.erase(rangeItr);
+		if (tail.m_size > 0u) {
+			rangeItr = block.m_freeRanges.insert(rangeItr, tail);
+		}
+		if (head.m_size > 0u) {
+			block.m_freeRanges.insert(rangeItr, head);
+		}
+
+		block.m_suballocations[offset] = { size, kind };
+		block.m_allocatedBytes += size;
+		*pOffsetOut = offset;
+		return true;
+	}
+
+	return false;
+}
+
+void VulkanApp::CVulkanMemoryAllocator::FreeInBlock(MemoryBlock &block, const VkDeviceSize offset) {
+	auto suballocationItr = block.m_suballocations.find(offset);
+	if (suballocationItr == block.m_suballocations.end()) {
+		throw std::runtime_error(UTIL_EXC_MSG("Freed memory range does not belong to the block."));
+	}
+
+	FreeRange range = { offset, suballocationItr->second.m_size };
+	block.m_allocatedBytes -= range.m_size;
+	block.m_suballocations.erase(suballocationItr);
+
+	// Insert keeping the list sorted and merge with touching neighbours
+	auto nextItr = std::lower_bound(block.m_freeRanges.begin(), block.m_freeRanges.end(), range.m_offset,
+		[](const FreeRange &lhs, const VkDeviceSize value) { return lhs.m_offset < value; });
+
+	if (nextItr != block.m_freeRanges.end() && range.m_offset + range.m_size == nextItr->m_offset) {
+		range.m_size += nextItr->m_size;
+		nextItr = block.m_freeRanges.erase(nextItr);
+	}
+
+	if (nextItr != block.m_freeRanges.begin()) {
+		auto prevItr = std::prev(nextItr);
+		if (prevItr->m_offset + prevItr->m_size == range.m_offset) {
+			prevItr->m_size += range.m_size;
+			return;
+		}
+	}
+
+	block.m_freeRanges.insert(nextItr, range);
+}
+
+uint32_t VulkanApp::CVulkanMemoryAllocator::CreateBlock(const uint32_t memoryTypeIndex, const VkDeviceSize minSize, const bool dedicated) {
+
+	if (GetBlockCount() >= m_maxAllocationCount) {
+		throw std::runtime_error(UTIL_EXC_MSG("maxMemoryAllocationCount reached."));
+	}
+
+	VkMemoryAllocateInfo memoryAllocateInfo = {};
+	memoryAllocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	memoryAllocateInfo.allocationSize = dedicated ? minSize : std::max(m_blockSize, minSize);
+	memoryAllocateInfo.memoryTypeIndex = memoryTypeIndex;
+
+	VkDeviceMemory memory = VK_NULL_HANDLE;
+	VkResult result = vkAllocateMemory(m_vkDevice, &memoryAllocateInfo, nullptr, &memory);
+
+	// Retry with smaller blocks when the heap is almost full
+	while (result != VK_SUCCESS && memoryAllocateInfo.allocationSize / 2u >= minSize) {
+		memoryAllocateInfo.allocationSize /= 2u;
+		result = vkAllocateMemory(m_vkDevice, &memoryAllocateInfo, nullptr, &memory);
+	}
+
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error(UTIL_EXC_MSG_EX("Memory allocation failed.", result));
+	}
+
+	MemoryBlock *pBlock = new MemoryBlock();
+	pBlock->m_vkMemory = memory;
+	pBlock->m_size = memoryAllocateInfo.allocationSize;
+	pBlock->m_memoryTypeIndex = memoryTypeIndex;
+	pBlock->m_dedicated = dedicated;
+	pBlock->m_freeRanges.push_back({ 0u, pBlock->m_size });
+
+	// Host visible memory can only be mapped once, so the whole block is mapped persistently
+	if (GetMemoryTypeFlags(memoryTypeIndex) & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+		result = vkMapMemory(m_vkDevice, memory, 0u, VK_WHOLE_SIZE, 0u, &pBlock->m_pMappedData);
+		if (result != VK_SUCCESS) {
+			vkFreeMemory(m_vkDevice, memory, nullptr);
+			delete pBlock;
+			throw std::runtime_error(UTIL_EXC_MSG_EX("Buffer memory mapping failed.", result));
+		}
+	}
+
+	auto freeSlot = std::find(m_blocks.begin(), m_blocks.end(), nullptr);
+	if (freeSlot != m_blocks.end()) {
+		*freeSlot = pBlock;
+		return static_cast<uint32_t>(std::distance(m_blocks.begin(), freeSlot));
+	}
+
+	m_blocks.push_back(pBlock);
+	return static_cast<uint32_t>(m_blocks.size() - 1u);
+}
+
+void VulkanApp::CVulkanMemoryAllocator::DestroyBlock(const uint32_t blockIndex) {
+	MemoryBlock *pBlock = m_blocks[blockIndex];
+	if (pBlock == nullptr) {
+		return;
+	}
+
+	if (pBlock->m_pMappedData) {
+		vkUnmapMemory(m_vkDevice, pBlock->m_vkMemory);
+	}
+	vkFreeMemory(m_vkDevice, pBlock->m_vkMemory, nullptr);
+
+	delete pBlock;
+	m_blocks[blockIndex] = nullptr;
+}
+
+uint32_t VulkanApp::CVulkanMemoryAllocator::GetBlockCount() const {
+	return static_cast<uint32_t>(std::count_if(m_blocks.cbegin(), m_blocks.cend(), [](const MemoryBlock *pBlock) { return pBlock != nullptr; }));
+}
+
+void VulkanApp::CVulkanMemoryAllocator::AccumulateStatistics(const MemoryBlock &block, MemoryStatistics &stats) const {
+	stats.m_blockCount++;
+	stats.m_allocationCount += static_cast<uint32_t>(block.m_suballocations.size());
+	stats.m_freeRangeCount += static_cast<uint32_t>(block.m_freeRanges.size());
+	stats.m_blockBytes += block.m_size;
+	stats.m_allocatedBytes += block.m_allocatedBytes;
+	for (auto &range : block.m_freeRanges) {
+		stats.m_largestFreeRange = std::max(stats.m_largestFreeRange, range.m_size);
+	}
+}
+
+VulkanApp::MemoryStatistics VulkanApp::CVulkanMemoryAllocator::GetStatistics() const {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	MemoryStatistics stats;
+	for (auto pBlock : m_blocks) {
+		if (pBlock) {
+			AccumulateStatistics(*pBlock, stats);
+		}
+	}
+	return stats;
+}
+
+VulkanApp::MemoryStatistics VulkanApp::CVulkanMemoryAllocator::GetStatistics(const uint32_t memoryTypeIndex) const {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	MemoryStatistics stats;
+	for (auto pBlock : m_blocks) {
+		if (pBlock && pBlock->m_memoryTypeIndex == memoryTypeIndex) {
+			AccumulateStatistics(*pBlock, stats);
+		}
+	}
+	return stats;
+}
@@ -0,0 +1,204 @@
+#include <CVulkanOffscreenTarget.h>
+#include <CVulkanCore.h>
+#include <CVulkanBuffer.h>
+
+#include <stdexcept>
+
+#include <Utilities.h>
+
+namespace VulkanApp {
+	static uint32_t GetFormatByteSize(const VkFormat format) {
+		switch (format)
+		{
+		case VK_FORMAT_R8G8B8A8_UNORM:
+		case VK_FORMAT_R8G8B8A8_SRGB:
+		case VK_FORMAT_B8G8R8A8_UNORM:
+		case VK_FORMAT_B8G8R8A8_SRGB:			return 4u;
+		case VK_FORMAT_R16G16B16A16_SFLOAT:		return 8u;
+		case VK_FORMAT_R32G32B32A32_SFLOAT:		return 16u;
+		default: break;
+		}
+		return 0u;
+	}
+}
+
+VulkanApp::CVulkanOffscreenTarget::CVulkanOffscreenTarget(
+	const CVulkanCore *const pCore,
+	const VkRenderPass renderPass,
+	const VkFormat format,
+	const uint32_t width,
+	const uint32_t height,
+	const uint32_t imageCount,
+	const bool readback) : m_pCore(pCore), m_format(format), m_extent({ width, height }), m_readback(readback) {
+
+	if (m_pCore == nullptr) {
+		throw std::runtime_error(UTIL_EXC_MSG("Pointer to parent object was null"));
+	}
+
+	if (width == 0u || height == 0u || imageCount == 0u) {
+		throw std::runtime_error(UTIL_EXC_MSG("Invalid offscreen target extent or image count"));
+	}
+
+	if (m_readback) {
+		const uint32_t texelSize = GetFormatByteSize(m_format);
+		if (texelSize == 0u) {
+			throw std::runtime_error(UTIL_EXC_MSG("Readback is not supported for the offscreen target format"));
+		}
+		m_readbackSize = static_cast<VkDeviceSize>(width) * height * texelSize;
+	}
+
+	const VkDevice device = m_pCore->GetVkLogicalDevice();
+
+	VkImageCreateInfo imageCI = {};
+	imageCI.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	imageCI.imageType = VK_IMAGE_TYPE_2D;
+	imageCI.format = m_format;
+	imageCI.extent = { width, height, 1u };
+	imageCI.mipLevels = 1u;
+	imageCI.arrayLayers = 1u;
+	imageCI.samples = VK_SAMPLE_COUNT_1_BIT;
+	imageCI.tiling = VK_IMAGE_TILING_OPTIMAL;
+	imageCI.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | (m_readback ? static_cast<VkImageUsageFlags>(VK_IMAGE_USAGE_TRANSFER_SRC_BIT) : 0u);
+	imageCI.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	imageCI.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+	VkImageViewCreateInfo imageViewCI = {};
+	imageViewCI.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+	imageViewCI.viewType = VK_IMAGE_VIEW_TYPE_2D;
+	imageViewCI.format = m_format;
+	imageViewCI.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+	imageViewCI.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+	imageViewCI.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+	imageViewCI.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+	imageViewCI.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	imageViewCI.subresourceRange.baseMipLevel = 0;
+	imageViewCI.subresourceRange.levelCount = 1;
+	imageViewCI.subresourceRange.baseArrayLayer = 0;
+	imageViewCI.subresourceRange.layerCount = 1;
+
+	VkFramebufferCreateInfo framebufferCI = {};
+	framebufferCI.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+	framebufferCI.attachmentCount = 1;
+	framebufferCI.renderPass = renderPass;
+	framebufferCI.width = width;
+	framebufferCI.height = height;
+	framebufferCI.layers = 1;
+
+	m_images.resize(imageCount);
+	try {
+		for (auto &image : m_images) {
+			VkResult result = vkCreateImage(device, &imageCI, nullptr, &image.m_vkImage);
+			if (result != VK_SUCCESS) {
+				throw std::runtime_error(UTIL_EXC_MSG_EX("Cannot create an offscreen image", result));
+			}
+
+			image.m_allocation = m_pCore->GetAllocator()->AllocateForImage(image.m_vkImage, imageCI.tiling, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0u);
+
+			imageViewCI.image = image.m_vkImage;
+			result = vkCreateImageView(device, &imageViewCI, nullptr, &image.m_vkImageView);
+			if (result != VK_SUCCESS) {
+				throw std::runtime_error(UTIL_EXC_MSG_EX("Cannot create an image view", result));
+			}
+
+			framebufferCI.pAttachments = &image.m_vkImageView;
+			result = vkCreateFramebuffer(device, &framebufferCI, nullptr, &image.m_vkFramebuffer);
+			if (result != VK_SUCCESS) {
+				throw std::runtime_error(UTIL_EXC_MSG_EX("Cannot create a framebuffer", result));
+			}
+
+			if (m_readback) {
+				image.m_pReadbackBuffer = new CVulkanBuffer(m_pCore, nullptr, static_cast<uint32_t>(m_readbackSize),
+					{ VK_BUFFER_USAGE_TRANSFER_DST_BIT, BufferMemory::HostVisible });
+			}
+		}
+	}
+	catch (...) {
+		Release();
+		throw;
+	}
+}
+
+VulkanApp::CVulkanOffscreenTarget::~CVulkanOffscreenTarget() {
+	Release();
+}
+
+VkFramebuffer VulkanApp::CVulkanOffscreenTarget::GetFramebuffer(const uint32_t index) const {
+	if (index < m_images.size()) {
+		return m_images[index].m_vkFramebuffer;
+	}
+	return VK_NULL_HANDLE;
+}
+
+VkImage VulkanApp::CVulkanOffscreenTarget::GetImage(const uint32_t index) const {
+	if (index < m_images.size()) {
+		return m_images[index].m_vkImage;
+	}
+	return VK_NULL_HANDLE;
+}
+
+void VulkanApp::CVulkanOffscreenTarget::RecordReadback(const VkCommandBuffer commandBuffer, const uint32_t index) const {
+	if (!m_readback || index >= m_images.size()) {
+		return;
+	}
+
+	// The render pass leaves the image in the transfer source layout, its external dependency orders the copy
+	VkBufferImageCopy region = {};
+	region.bufferOffset = 0u;
+	region.bufferRowLength = 0u;
+	region.bufferImageHeight = 0u;
+	region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	region.imageSubresource.mipLevel = 0u;
+	region.imageSubresource.baseArrayLayer = 0u;
+	region.imageSubresource.layerCount = 1u;
+	region.imageOffset = { 0, 0, 0 };
+	region.imageExtent = { m_extent.width, m_extent.height, 1u };
+
+	vkCmdCopyImageToBuffer(commandBuffer, m_images[index].m_vkImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+		m_images[index].m_pReadbackBuffer->GetHandle(), 1u, &region);
+
+	// Make the copy visible to the host once the frame fence is signaled
+	VkBufferMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.buffer = m_images[index].m_pReadbackBuffer->GetHandle();
+	barrier.offset = 0u;
+	barrier.size = VK_WHOLE_SIZE;
+
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0u,
+		0u, nullptr, 1u, &barrier, 0u, nullptr);
+}
+
+const void* VulkanApp::CVulkanOffscreenTarget::GetReadbackData(const uint32_t index) const {
+	if (!m_readback || index >= m_images.size()) {
+		return nullptr;
+	}
+	return m_images[index].m_pReadbackBuffer->GetMappedData();
+}
+
+void VulkanApp::CVulkanOffscreenTarget::Release() {
+	const VkDevice device = m_pCore->GetVkLogicalDevice();
+	for (auto &image : m_images) {
+		if (image.m_pReadbackBuffer) {
+			delete image.m_pReadbackBuffer;
+			image.m_pReadbackBuffer = nullptr;
+		}
+
+		if (image.m_vkFramebuffer != VK_NULL_HANDLE) {
+			vkDestroyFramebuffer(device, image.m_vkFramebuffer, nullptr);
+		}
+
+		if (image.m_vkImageView != VK_NULL_HANDLE) {
+			vkDestroyImageView(device, image.m_vkImageView, nullptr);
+		}
+
+		if (image.m_vkImage != VK_NULL_HANDLE) {
+			vkDestroyImage(device, image.m_vkImage, nullptr);
+		}
+
+		m_pCore->GetAllocator()->Free(image.m_allocation);
+	}
+	m_images.clear();
+}
@@ -0,0 +1,226 @@
+#include <CVulkanParallelRecorder.h>
+#include <CVulkanCore.h>
+
+#include <stdexcept>
+#include <algorithm>
+
+#include <Utilities.h>
+#include <CTracer.h>
+
+VulkanApp::CVulkanParallelRecorder::CVulkanParallelRecorder(const CVulkanCore *const pCore, const uint32_t frameSlotCount, const uint32_t threadCount,
+	const uint32_t minDrawsPerThread)
+	: m_pCore(pCore), m_minDrawsPerThread(std::max(minDrawsPerThread, 1u)) {
+
+	if (m_pCore == nullptr) {
+		throw std::runtime_error(UTIL_EXC_MSG("Pointer to parent object was null"));
+	}
+
+	uint32_t contextCount = threadCount;
+	if (contextCount == 0u) {
+		contextCount = std::max(std::thread::hardware_concurrency(), 1u);
+	}
+
+	m_contexts.resize(contextCount);
+	for (auto &context : m_contexts) {
+		context.m_slots.resize(std::max(frameSlotCount, 1u));
+	}
+
+	VkCommandPoolCreateInfo commandPoolCI = {};
+	commandPoolCI.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	commandPoolCI.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+	commandPoolCI.queueFamilyIndex = m_pCore->GetQueueFamilyIndex();
+
+	try {
+		for (auto &context : m_contexts) {
+			for (auto &slot : context.m_slots) {
+				VkResult result = vkCreateCommandPool(m_pCore->GetVkLogicalDevice(), &commandPoolCI, nullptr, &slot.m_vkCommandPool);
+				if (result != VK_SUCCESS) {
+					throw std::runtime_error(UTIL_EXC_MSG_EX("Cannot create a command pool", result));
+				}
+			}
+		}
+
+		for (uint32_t i = 1u; i < contextCount; i++) {
+			m_workers.emplace_back(&CVulkanParallelRecorder::WorkerProcedure, this, i);
+		}
+	}
+	catch (...) {
+		Release();
+		throw;
+	}
+}
+
+VulkanApp::CVulkanParallelRecorder::~CVulkanParallelRecorder() {
+	Release();
+}
+
+void VulkanApp::CVulkanParallelRecorder::BeginFrame(const uint32_t frameSlot) {
+	// Workers are idle between Record calls, their pools can be reset from here
+	for (auto &context : m_contexts) {
+		SlotBuffers &slot = context.m_slots[frameSlot % context.m_slots.size()];
+		if (slot.m_usedCount == 0u) {
+			continue;
+		}
+
+		VkResult result = vkResetCommandPool(m_pCore->GetVkLogicalDevice(), slot.m_vkCommandPool, 0);
+		if (result != VK_SUCCESS) {
+			throw std::runtime_error(UTIL_EXC_MSG_EX("Cannot reset the command pool", result));
+		}
+		slot.m_usedCount = 0u;
+	}
+}
+
+const std::vector<VkCommandBuffer>& VulkanApp::CVulkanParallelRecorder::Record(const uint32_t frameSlot, const VkCommandBufferInheritanceInfo &inheritanceInfo,
+	const uint32_t drawCount, const RecordFunction &recordFunction) {
+
+	TRACE_SCOPE("ParallelRecord");
+
+	// Every thread gets at least m_minDrawsPerThread draws, the rest stays idle
+	const uint32_t wantedChunks = (drawCount + m_minDrawsPerThread - 1u) / m_minDrawsPerThread;
+	const uint32_t chunkCount = std::clamp(wantedChunks, 1u, GetThreadCount());
+
+	m_recorded.assign(chunkCount, VK_NULL_HANDLE);
+	{
+		// Idle workers may still be looking at the previous job
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_job.m_frameSlot = frameSlot % static_cast<uint32_t>(m_contexts[0].m_slots.size());
+		m_job.m_pInheritanceInfo = &inheritanceInfo;
+		m_job.m_pRecordFunction = &recordFunction;
+		m_job.m_drawCount = drawCount;
+		m_job.m_chunkCount = chunkCount;
+		if (chunkCount > 1u) {
+			m_pendingChunks = chunkCount - 1u;
+			m_jobGeneration++;
+		}
+	}
+	if (chunkCount > 1u) {
+		m_jobReady.notify_all();
+	}
+
+	RecordChunk(0u);
+
+	if (chunkCount > 1u) {
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_jobDone.wait(lock, [this] { return m_pendingChunks == 0u; });
+	}
+
+	// Report the first failure, the others would otherwise resurface on the next frame
+	std::exception_ptr exception;
+	for (uint32_t i = 0u; i < chunkCount; i++) {
+		if (m_contexts[i].m_exception && !exception) {
+			exception = m_contexts[i].m_exception;
+		}
+		m_contexts[i].m_exception = nullptr;
+	}
+
+	if (exception) {
+		std::rethrow_exception(exception);
+	}
+
+	return m_recorded;
+}
+
+void VulkanApp::CVulkanParallelRecorder::WorkerProcedure(const uint32_t threadIndex) {
+	uint64_t seenGeneration = 0u;
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_jobReady.wait(lock, [&] { return m_exit || m_jobGeneration != seenGeneration; });
+			if (m_exit) {
+				return;
+			}
+			seenGeneration = m_jobGeneration;
+
+			// Threads past the chunk count sit this job out
+			if (threadIndex >= m_job.m_chunkCount) {
+				continue;
+			}
+		}
+
+		RecordChunk(threadIndex);
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (--m_pendingChunks == 0u) {
+			m_jobDone.notify_one();
+		}
+	}
+}
+
+void VulkanApp::CVulkanParallelRecorder::RecordChunk(const uint32_t threadIndex) {
+	ThreadContext &context = m_contexts[threadIndex];
+	try {
+		TRACE_SCOPE("RecordChunk");
+
+		SlotBuffers &slot = context.m_slots[m_job.m_frameSlot];
+		if (slot.m_usedCount == slot.m_buffers.size()) {
+			VkCommandBufferAllocateInfo commandBufferAI = {};
+			commandBufferAI.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			commandBufferAI.commandPool = slot.m_vkCommandPool;
+			commandBufferAI.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+			commandBufferAI.commandBufferCount = 1u;
+
+			VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+			VkResult result = vkAllocateCommandBuffers(m_pCore->GetVkLogicalDevice(), &commandBufferAI, &commandBuffer);
+			if (result != VK_SUCCESS) {
+				throw std::runtime_error(UTIL_EXC_MSG_EX("Cannot allocate a secondary command buffer", result));
+			}
+			slot.m_buffers.push_back(commandBuffer);
+		}
+		VkCommandBuffer commandBuffer = slot.m_buffers[slot.m_usedCount++];
+
+		// Draws are spread evenly, the first chunks take the remainder
+		const uint32_t baseCount = m_job.m_drawCount / m_job.m_chunkCount;
+		const uint32_t remainder = m_job.m_drawCount % m_job.m_chunkCount;
+		const uint32_t first = threadIndex * baseCount + std::min(threadIndex, remainder);
+		const uint32_t count = baseCount + (threadIndex < remainder ? 1u : 0u);
+
+		VkCommandBufferBeginInfo beginInfoCI = {};
+		beginInfoCI.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfoCI.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+		beginInfoCI.pInheritanceInfo = m_job.m_pInheritanceInfo;
+
+		VkResult result = vkBeginCommandBuffer(commandBuffer, &beginInfoCI);
+		if (result != VK_SUCCESS) {
+			throw std::runtime_error(UTIL_EXC_MSG_EX("Failed to begin a secondary command buffer", result));
+		}
+
+		(*m_job.m_pRecordFunction)(commandBuffer, first, count);
+
+		result = vkEndCommandBuffer(commandBuffer);
+		if (result != VK_SUCCESS) {
+			throw std::runtime_error(UTIL_EXC_MSG_EX("Failed to end a secondary command buffer", result));
+		}
+
+		m_recorded[threadIndex] = commandBuffer;
+	}
+	catch (...) {
+		context.m_exception = std::current_exception();
+	}
+}
+
+void VulkanApp::CVulkanParallelRecorder::Release() {
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_exit = true;
+	}
+	m_jobReady.notify_all();
+
+	for (auto &worker : m_workers) {
+		if (worker.joinable()) {
+			worker.join();
+		}
+	}
+	m_workers.clear();
+
+	// Destroying the pools frees their command buffers
+	for (auto &context : m_contexts) {
+		for (auto &slot : context.m_slots) {
+			if (slot.m_vkCommandPool != VK_NULL_HANDLE) {
+				vkDestroyCommandPool(m_pCore->GetVkLogicalDevice(), slot.m_vkCommandPool, nullptr);
+				slot.m_vkCommandPool = VK_NULL_HANDLE;
+			}
+			slot.m_buffers.clear();
+			slot.m_usedCount = 0u;
+		}
+	}
+}
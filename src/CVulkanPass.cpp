@@ -1,9 +1,14 @@
 #include <CVulkanPass.h>
 #include <CVulkanCore.h>
+#include <CVulkanUploader.h>
+#include <CVulkanGpuProfiler.h>
+#include <CVulkanParallelRecorder.h>
+#include <CVulkanDrawList.h>
 #include <Utilities.h>
+#include <CTracer.h>
 #include <fstream>
 
-VulkanApp::CVulkanPass::CVulkanPass(const CVulkanCore *const pCore, const VkFormat surfaceFormat)
+VulkanApp::CVulkanPass::CVulkanPass(const CVulkanCore *const pCore, const VkFormat surfaceFormat, const VkImageLayout finalLayout)
 	: m_pCore(pCore)
 {
 	m_attachmentDesc.format = surfaceFormat;
@@ -13,7 +18,7 @@ VulkanApp::CVulkanPass::CVulkanPass(const CVulkanCore *const pCore, const VkForm
 	m_attachmentDesc.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 	m_attachmentDesc.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
 	m_attachmentDesc.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-	m_attachmentDesc.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+	m_attachmentDesc.finalLayout = finalLayout;
 
 	m_colorAttachmentRef.attachment = 0;
 	m_colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
@@ -22,30 +27,28 @@ VulkanApp::CVulkanPass::CVulkanPass(const CVulkanCore *const pCore, const VkForm
 	m_subpassDesc.colorAttachmentCount = 1;
 	m_subpassDesc.pColorAttachments = &m_colorAttachmentRef;
 
-	m_dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
-	m_dependency.dstSubpass = 0;
-	m_dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-	m_dependency.srcAccessMask = 0;
-	m_dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-	m_dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	m_dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+	m_dependencies[0].dstSubpass = 0;
+	m_dependencies[0].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+	m_dependencies[0].srcAccessMask = 0;
+	m_dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+	m_dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+
+	// Copies out of the attachment recorded after the pass have to see the rendered pixels
+	m_dependencies[1].srcSubpass = 0;
+	m_dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+	m_dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+	m_dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	m_dependencies[1].dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+	m_dependencies[1].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
 
 	m_renderPassCI.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
 	m_renderPassCI.attachmentCount = 1;
 	m_renderPassCI.pAttachments = &m_attachmentDesc;
 	m_renderPassCI.subpassCount = 1;
 	m_renderPassCI.pSubpasses = &m_subpassDesc;
-	m_renderPassCI.dependencyCount = 1;
-	m_renderPassCI.pDependencies = &m_dependency;
-
-	std::optional<uint32_t> qfIndex = VulkanApp::CapsInfo::GetQueueFamilies(m_pCore->GetVkPhysicalDevice(), VK_QUEUE_GRAPHICS_BIT);
-	m_vkCommandPoolCI.queueFamilyIndex = qfIndex.value();
-	m_vkCommandPoolCI.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-	m_vkCommandPoolCI.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
-
-	m_vkCommandBufferCI.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-	m_vkCommandBufferCI.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-	m_vkCommandBufferCI.commandBufferCount = 1;
-	m_vkCommandBufferCI.commandPool = VK_NULL_HANDLE;
+	m_renderPassCI.dependencyCount = (finalLayout == VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL) ? 2u : 1u;
+	m_renderPassCI.pDependencies = m_dependencies;
 
 	Initialize();
 }
@@ -60,55 +63,36 @@ void VulkanApp::CVulkanPass::Initialize() {
 	if (result != VK_SUCCESS) {
 		throw std::runtime_error(UTIL_EXC_MSG_EX("Cannot create render pass", result));
 	}
-
-	result = vkCreateCommandPool(m_pCore->GetVkLogicalDevice(), &m_vkCommandPoolCI, nullptr, &m_vkCommandBufferCI.commandPool);
-	if (result != VK_SUCCESS) {
-		throw std::runtime_error(UTIL_EXC_MSG_EX("Cannot create a command pool", result));
-	}
-
-	result = vkAllocateCommandBuffers(m_pCore->GetVkLogicalDevice(), &m_vkCommandBufferCI, &m_vkCommandBuffer);
-	if (result != VK_SUCCESS) {
-		throw std::runtime_error(UTIL_EXC_MSG_EX("Cannot allocate a command buffer", result));
-	}
 }
 
 void VulkanApp::CVulkanPass::Release() {
 	vkDeviceWaitIdle(m_pCore->GetVkLogicalDevice());
 
-	if (m_vkCommandBufferCI.commandPool != VK_NULL_HANDLE) {
-		vkDestroyCommandPool(m_pCore->GetVkLogicalDevice(), m_vkCommandBufferCI.commandPool, nullptr);
-		m_vkCommandBufferCI.commandPool = VK_NULL_HANDLE;
-		m_vkCommandBuffer = VK_NULL_HANDLE;
-	}
-
 	if (m_vkRenderPass != VK_NULL_HANDLE) {
 		vkDestroyRenderPass(m_pCore->GetVkLogicalDevice(), m_vkRenderPass, nullptr);
 		m_vkRenderPass = VK_NULL_HANDLE;
 	}
 }
 
-void VulkanApp::CVulkanPass::SubmitWorkload(
-	VkQueue queue,
-	VkBuffer vertexBuffer,
-	VkPipeline pipeline,
-	VkSemaphore waitSemaphore,
-	VkSemaphore signalSemaphore,
-	VkFence raiseFence,
+void VulkanApp::CVulkanPass::RecordWorkload(
+	VkCommandBuffer commandBuffer,
+	const CVulkanDrawList &drawList,
 	VkFramebuffer renderTarget,
-	VkRect2D renderArea) {
-
-	vkResetCommandBuffer(m_vkCommandBuffer, 0);
-
-	VkCommandBufferBeginInfo beginInfoCI = {};
-	beginInfoCI.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-	beginInfoCI.flags = 0;
-	beginInfoCI.pInheritanceInfo = nullptr;
-
-	VkResult result = vkBeginCommandBuffer(m_vkCommandBuffer, &beginInfoCI);
-	if (result != VK_SUCCESS) {
-		throw std::runtime_error(UTIL_EXC_MSG_EX("Failed to begin a command buffer", result));
+	VkRect2D renderArea,
+	CVulkanGpuProfiler *pProfiler,
+	uint32_t frameSlot,
+	CVulkanParallelRecorder *pRecorder) {
+
+	uint32_t passScope = CVulkanGpuProfiler::cexp_invalidScope;
+	if (pProfiler) {
+		pProfiler->BeginFrame(commandBuffer, frameSlot);
+		passScope = pProfiler->BeginScope(commandBuffer, "RenderPass");
 	}
 
+	// Indirect lists are a handful of calls, splitting them would only add overhead
+	const uint32_t drawCount = drawList.GetDrawCount();
+	const bool parallel = pRecorder != nullptr && !drawList.UsesIndirect() && drawCount >= 2u * pRecorder->GetMinDrawsPerThread();
+
 	VkRenderPassBeginInfo renderPassCI = {};
 	renderPassCI.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
 	renderPassCI.renderPass = m_vkRenderPass;
@@ -119,36 +103,134 @@ void VulkanApp::CVulkanPass::SubmitWorkload(
 	renderPassCI.clearValueCount = 1;
 	renderPassCI.pClearValues = &clearColor;
 
-	vkCmdBeginRenderPass(m_vkCommandBuffer, &renderPassCI, VK_SUBPASS_CONTENTS_INLINE);
-	vkCmdBindPipeline(m_vkCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
-	VkDeviceSize offsets[] = { 0 };
-	vkCmdBindVertexBuffers(m_vkCommandBuffer, 0, 1, &vertexBuffer, offsets);
-	vkCmdDraw(m_vkCommandBuffer, 3, 1, 0, 0);
-	vkCmdEndRenderPass(m_vkCommandBuffer);
+	vkCmdBeginRenderPass(commandBuffer, &renderPassCI, parallel ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE);
 
-	result = vkEndCommandBuffer(m_vkCommandBuffer);
-	if (result != VK_SUCCESS) {
-		throw std::runtime_error(UTIL_EXC_MSG_EX("Failed to end a command buffer", result));
+	if (parallel) {
+		// Only vkCmdExecuteCommands is allowed in this subpass, so the Draw scope is not available here
+		VkCommandBufferInheritanceInfo inheritanceInfo = {};
+		inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+		inheritanceInfo.renderPass = m_vkRenderPass;
+		inheritanceInfo.subpass = 0;
+		inheritanceInfo.framebuffer = renderTarget;
+
+		const std::vector<VkCommandBuffer> &secondaryBuffers = pRecorder->Record(frameSlot, inheritanceInfo, drawCount,
+			[&](VkCommandBuffer secondaryBuffer, uint32_t first, uint32_t count) {
+				RecordDynamicState(secondaryBuffer, renderArea);
+				drawList.Record(secondaryBuffer, first, count);
+			});
+
+		vkCmdExecuteCommands(commandBuffer, static_cast<uint32_t>(secondaryBuffers.size()), secondaryBuffers.data());
+	}
+	else {
+		RecordDynamicState(commandBuffer, renderArea);
+
+		uint32_t drawScope = CVulkanGpuProfiler::cexp_invalidScope;
+		if (pProfiler) {
+			drawScope = pProfiler->BeginScope(commandBuffer, "Draw");
+		}
+
+		drawList.Record(commandBuffer, 0u, drawCount);
+
+		if (pProfiler) {
+			pProfiler->EndScope(commandBuffer, drawScope);
+		}
+	}
+
+	vkCmdEndRenderPass(commandBuffer);
+
+	if (pProfiler) {
+		pProfiler->EndScope(commandBuffer, passScope);
+	}
+}
+
+void VulkanApp::CVulkanPass::RecordDynamicState(VkCommandBuffer commandBuffer, VkRect2D renderArea) {
+	// Dynamic state of the pipelines, follows the render area and outlives pipeline binds
+	VkViewport viewport = {};
+	viewport.x = static_cast<float>(renderArea.offset.x);
+	viewport.y = static_cast<float>(renderArea.offset.y);
+	viewport.width = static_cast<float>(renderArea.extent.width);
+	viewport.height = static_cast<float>(renderArea.extent.height);
+	viewport.minDepth = 0.0f;
+	viewport.maxDepth = 1.0f;
+	vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+	vkCmdSetScissor(commandBuffer, 0, 1, &renderArea);
+}
+
+void VulkanApp::CVulkanPass::SubmitWorkload(
+	VkCommandBuffer commandBuffer,
+	VkQueue queue,
+	const CVulkanDrawList &drawList,
+	VkSemaphore waitSemaphore,
+	VkSemaphore uploadSemaphore,
+	VkSemaphore signalSemaphore,
+	VkFence raiseFence,
+	VkFramebuffer renderTarget,
+	VkRect2D renderArea,
+	CVulkanGpuProfiler *pProfiler,
+	uint32_t frameSlot,
+	CVulkanParallelRecorder *pRecorder) {
+
+	VkResult result = VK_SUCCESS;
+	{
+		TRACE_SCOPE("Record");
+
+		VkCommandBufferBeginInfo beginInfoCI = {};
+		beginInfoCI.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfoCI.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		beginInfoCI.pInheritanceInfo = nullptr;
+
+		result = vkBeginCommandBuffer(commandBuffer, &beginInfoCI);
+		if (result != VK_SUCCESS) {
+			throw std::runtime_error(UTIL_EXC_MSG_EX("Failed to begin a command buffer", result));
+		}
+
+		RecordWorkload(commandBuffer, drawList, renderTarget, renderArea, pProfiler, frameSlot, pRecorder);
+
+		result = vkEndCommandBuffer(commandBuffer);
+		if (result != VK_SUCCESS) {
+			throw std::runtime_error(UTIL_EXC_MSG_EX("Failed to end a command buffer", result));
+		}
+	}
+
+	{
+		TRACE_SCOPE("Submit");
+		SubmitCommandBuffer(queue, commandBuffer, waitSemaphore, uploadSemaphore, signalSemaphore, raiseFence);
+	}
+}
+
+void VulkanApp::CVulkanPass::SubmitCommandBuffer(
+	VkQueue queue,
+	VkCommandBuffer commandBuffer,
+	VkSemaphore waitSemaphore,
+	VkSemaphore uploadSemaphore,
+	VkSemaphore signalSemaphore,
+	VkFence raiseFence) {
+
+	// Image acquisition and staging uploads are both optional, offscreen targets need no acquire
+	VkSemaphore waitSemaphores[2] = {};
+	VkPipelineStageFlags waitStages[2] = {};
+	uint32_t waitCount = 0u;
+	if (waitSemaphore != VK_NULL_HANDLE) {
+		waitSemaphores[waitCount] = waitSemaphore;
+		waitStages[waitCount++] = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+	}
+	if (uploadSemaphore != VK_NULL_HANDLE) {
+		waitSemaphores[waitCount] = uploadSemaphore;
+		waitStages[waitCount++] = CVulkanUploader::cexp_waitStageMask;
 	}
 
 	VkSubmitInfo submitInfo{};
 	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-
-	VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-	submitInfo.waitSemaphoreCount = 1;
-	submitInfo.pWaitSemaphores = &waitSemaphore; // Semaphore will be signaled by vkAcquireNextImage 
+	submitInfo.waitSemaphoreCount = waitCount;
+	submitInfo.pWaitSemaphores = waitSemaphores;
 	submitInfo.pWaitDstStageMask = waitStages;
 	submitInfo.commandBufferCount = 1;
-	submitInfo.pCommandBuffers = &m_vkCommandBuffer;
-
-	submitInfo.signalSemaphoreCount = 1;
+	submitInfo.pCommandBuffers = &commandBuffer;
+	submitInfo.signalSemaphoreCount = (signalSemaphore != VK_NULL_HANDLE) ? 1u : 0u;
 	submitInfo.pSignalSemaphores = &signalSemaphore;
 
-	result = vkQueueSubmit(queue, 1, &submitInfo, raiseFence);
+	VkResult result = vkQueueSubmit(queue, 1, &submitInfo, raiseFence);
 	if (result != VK_SUCCESS) {
 		throw std::runtime_error(UTIL_EXC_MSG_EX("Command buffers submission failed", result));
 	}
-
 }
-
-
@@ -1,35 +1,20 @@
 #include <CVulkanPipeline.h>
 #include <CVulkanCore.h>
 #include <CVulkanPass.h>
+#include <CVulkanDescriptorCache.h>
 #include <Utilities.h>
+#include <CTracer.h>
 
 #include <stdexcept>
-#include <fstream>
-
-namespace VulkanApp {
-	static VkFormat GetVkFormat(BufferAttribute::ShaderDataType shaderDataType) {
-		switch (shaderDataType)
-		{
-		case BufferAttribute::ShaderDataType::int3:		return VK_FORMAT_R32G32B32_SINT;
-		case BufferAttribute::ShaderDataType::int4:		return VK_FORMAT_R32G32B32A32_SINT;
-		case BufferAttribute::ShaderDataType::uint3:	return VK_FORMAT_R32G32B32_UINT;
-		case BufferAttribute::ShaderDataType::uint4:	return VK_FORMAT_R32G32B32A32_UINT;
-		case BufferAttribute::ShaderDataType::float3:	return VK_FORMAT_R32G32B32_SFLOAT;
-		case BufferAttribute::ShaderDataType::float4:	return VK_FORMAT_R32G32B32A32_SFLOAT;
-		default: break;
-		}
-		return VK_FORMAT_UNDEFINED;
-	}
-}
+#include <chrono>
 
 VulkanApp::CVulkanPipeline::CVulkanPipeline(
 	const CVulkanCore *const pCore,
 	const CVulkanPass *const pPass,
-	const uint32_t vpWidth,
-	const uint32_t vpHeight,
 	const VkPipelineShaderStageCreateInfo *const shaderStages,
-	const CBufferLayout vertexLayout)
-	: m_pCore(pCore)
+	const CBufferLayout vertexLayout,
+	const VkPipelineLayout layout)
+	: m_vkLayout(layout), m_pCore(pCore)
 {
 	if (vertexLayout.GetAttributesCount() == 0) {
 		m_vertexInputStateCI.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
@@ -42,26 +27,42 @@ VulkanApp::CVulkanPipeline::CVulkanPipeline(
 		SetVertexBufferLayout(vertexLayout);
 	}
 
+	Setup(pPass, shaderStages);
+}
+
+VulkanApp::CVulkanPipeline::CVulkanPipeline(
+	const CVulkanCore *const pCore,
+	const CVulkanPass *const pPass,
+	const VkPipelineShaderStageCreateInfo *const shaderStages,
+	const VkPipelineVertexInputStateCreateInfo &vertexInputState,
+	const VkPipelineLayout layout)
+	: m_vertexInputStateCI(vertexInputState), m_vkLayout(layout), m_pCore(pCore)
+{
+	Setup(pPass, shaderStages);
+}
+
+void VulkanApp::CVulkanPipeline::Setup(const CVulkanPass *const pPass, const VkPipelineShaderStageCreateInfo *const shaderStages) {
+	// Update() creates the pipeline again later, from copies that stay valid until then
+	for (uint32_t i = 0u; i < 2u; i++) {
+		m_shaderStages[i] = shaderStages[i];
+		m_specializations[i].Assign(shaderStages[i].pSpecializationInfo);
+		m_shaderStages[i].pSpecializationInfo = m_specializations[i].GetInfo();
+	}
+
 	m_inputAssemblyCI.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
 	m_inputAssemblyCI.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
 	m_inputAssemblyCI.primitiveRestartEnable = VK_FALSE;
 
-	m_viewport.x = 0.0f;
-	m_viewport.y = 0.0f;
-	m_viewport.width = static_cast<float>(vpWidth);
-	m_viewport.height = static_cast<float>(vpHeight);
-	m_viewport.minDepth = 0.0f;
-	m_viewport.maxDepth = 1.0f;
-
-	m_scissorRect.offset = { 0,0 };
-	m_scissorRect.extent.width = vpWidth;
-	m_scissorRect.extent.height = vpHeight;
-
+	// Viewport and scissor are set while recording, resizing the target does not touch the pipeline
 	m_viewportStateCI.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
 	m_viewportStateCI.viewportCount = 1;
-	m_viewportStateCI.pViewports = &m_viewport;
+	m_viewportStateCI.pViewports = nullptr;
 	m_viewportStateCI.scissorCount = 1;
-	m_viewportStateCI.pScissors = &m_scissorRect;
+	m_viewportStateCI.pScissors = nullptr;
+
+	m_dynamicStateCI.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+	m_dynamicStateCI.dynamicStateCount = 2;
+	m_dynamicStateCI.pDynamicStates = m_dynamicStates;
 
 	m_rasterizerStateCI.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
 	m_rasterizerStateCI.depthClampEnable = VK_FALSE;
@@ -104,7 +105,7 @@ VulkanApp::CVulkanPipeline::CVulkanPipeline(
 
 	m_pipelineCI.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
 	m_pipelineCI.stageCount = 2;
-	m_pipelineCI.pStages = shaderStages;
+	m_pipelineCI.pStages = m_shaderStages;
 	m_pipelineCI.pVertexInputState = &m_vertexInputStateCI;
 	m_pipelineCI.pInputAssemblyState = &m_inputAssemblyCI;
 	m_pipelineCI.pViewportState = &m_viewportStateCI;
@@ -112,39 +113,33 @@ VulkanApp::CVulkanPipeline::CVulkanPipeline(
 	m_pipelineCI.pMultisampleState = &m_multisamplingStateCI;
 	m_pipelineCI.pDepthStencilState = nullptr;
 	m_pipelineCI.pColorBlendState = &m_colorBlendingCI;
+	m_pipelineCI.pDynamicState = &m_dynamicStateCI;
 	m_pipelineCI.renderPass = pPass->GetHandle();
 	m_pipelineCI.subpass = 0;
 	m_pipelineCI.basePipelineHandle = VK_NULL_HANDLE;
 	m_pipelineCI.basePipelineIndex = -1;
 
 	Update();
-
 }
 
 VulkanApp::CVulkanPipeline::~CVulkanPipeline() 
 {
 	Release();
-
-	if (m_vertexInputStateCI.pVertexBindingDescriptions) {
-		delete m_vertexInputStateCI.pVertexBindingDescriptions;
-	}
-
-	if (m_vertexInputStateCI.pVertexAttributeDescriptions) {
-		delete m_vertexInputStateCI.pVertexAttributeDescriptions;
-	}
 }
 
 void VulkanApp::CVulkanPipeline::Update() {
-	
-	Release();
+	TRACE_SCOPE("CVulkanPipeline::Update");
 
-	VkResult result = vkCreatePipelineLayout(m_pCore->GetVkLogicalDevice(), &m_pipelineLayoutCI, nullptr, &m_pipelineCI.layout);
+	Release();
 
-	if (result != VK_SUCCESS) {
-		throw std::runtime_error(UTIL_EXC_MSG_EX("Cannot create pipeline layout", result));
-	}
+	// Pipelines with equal set layouts and push constant ranges get the same layout object
+	m_pipelineCI.layout = m_vkLayout != VK_NULL_HANDLE ? m_vkLayout : m_pCore->GetDescriptorCache()->GetPipelineLayout(
+		m_pipelineLayoutCI.pSetLayouts, m_pipelineLayoutCI.setLayoutCount,
+		m_pipelineLayoutCI.pPushConstantRanges, m_pipelineLayoutCI.pushConstantRangeCount);
 
-	result = vkCreateGraphicsPipelines(m_pCore->GetVkLogicalDevice(), VK_NULL_HANDLE, 1, &m_pipelineCI, nullptr, &m_vkPipeline);
+	const auto creationStart = std::chrono::steady_clock::now();
+	VkResult result = vkCreateGraphicsPipelines(m_pCore->GetVkLogicalDevice(), m_pCore->GetVkPipelineCache(), 1, &m_pipelineCI, nullptr, &m_vkPipeline);
+	m_lastCreationMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - creationStart).count();
 
 	if (result != VK_SUCCESS) {
 		throw std::runtime_error(UTIL_EXC_MSG_EX("Cannot create pipeline", result));
@@ -154,57 +149,28 @@ void VulkanApp::CVulkanPipeline::Update() {
 
 void VulkanApp::CVulkanPipeline::SetVertexBufferLayout(const CBufferLayout layout)
 {
-	if (m_vertexInputStateCI.pVertexBindingDescriptions) {
-		delete m_vertexInputStateCI.pVertexBindingDescriptions;
+	m_vertexBindingDescs.resize(layout.GetBindingsCount());
+	for (uint32_t i = 0; i < layout.GetBindingsCount(); i++) {
+		const BufferBinding binding = layout.GetBinding(i);
+		m_vertexBindingDescs[i].binding = binding.m_binding;
+		m_vertexBindingDescs[i].stride = binding.m_stride;
+		m_vertexBindingDescs[i].inputRate = binding.m_inputRate;
 	}
 
-	if (m_vertexInputStateCI.pVertexAttributeDescriptions) {
-		delete m_vertexInputStateCI.pVertexAttributeDescriptions;
-	}
-
-	m_vertexInputStateCI.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-	m_vertexInputStateCI.vertexBindingDescriptionCount = 1;
-	m_vertexInputStateCI.pVertexBindingDescriptions = new VkVertexInputBindingDescription(0, layout.GetByteSize(), VK_VERTEX_INPUT_RATE_VERTEX);
-
-	m_vertexInputStateCI.vertexAttributeDescriptionCount = layout.GetAttributesCount();
-
-	VkVertexInputAttributeDescription* viaDesc = new VkVertexInputAttributeDescription[layout.GetAttributesCount()];
-
+	m_vertexAttributeDescs.resize(layout.GetAttributesCount());
 	for (uint32_t i = 0; i < layout.GetAttributesCount(); i++) {
-		BufferAttribute attribute = layout.GetAttribute(i);
-		viaDesc[i].binding = 0;
-		viaDesc[i].location = i;
-		viaDesc[i].offset = attribute.m_offset;
-		viaDesc[i].format = GetVkFormat(attribute.m_shaderDataType);
+		const BufferAttribute attribute = layout.GetAttribute(i);
+		m_vertexAttributeDescs[i].binding = attribute.m_binding;
+		m_vertexAttributeDescs[i].location = attribute.m_location;
+		m_vertexAttributeDescs[i].offset = attribute.m_offset;
+		m_vertexAttributeDescs[i].format = BufferAttribute::GetVkFormat(attribute.m_shaderDataType);
 	}
 
-	m_vertexInputStateCI.pVertexAttributeDescriptions = viaDesc;
-}
-
-VkShaderModule VulkanApp::CVulkanPipeline::LoadCompiledShader(const VkDevice device, const std::string& filePath) {
-	
-	std::ifstream file(filePath, std::ios::ate | std::ios::binary);
-
-	if (!file.is_open()) {
-		throw std::runtime_error("[Runtime error] Failed to open compiled shader file");
-	}
-
-	size_t fileSize = static_cast<size_t>(file.tellg());
-	std::vector<char> buffer(fileSize);
-
-	file.seekg(0);
-	file.read(buffer.data(), fileSize);
-	file.close();
-
-	VkShaderModuleCreateInfo shaderModuleCI = {};
-	shaderModuleCI.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-	shaderModuleCI.codeSize = buffer.size();
-	shaderModuleCI.pCode = reinterpret_cast<const uint32_t*>(buffer.data());
-
-	VkShaderModule shaderModule = VK_NULL_HANDLE;
-	vkCreateShaderModule(device, &shaderModuleCI, nullptr, &shaderModule);
-
-	return shaderModule;
+	m_vertexInputStateCI.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+	m_vertexInputStateCI.vertexBindingDescriptionCount = static_cast<uint32_t>(m_vertexBindingDescs.size());
+	m_vertexInputStateCI.pVertexBindingDescriptions = m_vertexBindingDescs.data();
+	m_vertexInputStateCI.vertexAttributeDescriptionCount = static_cast<uint32_t>(m_vertexAttributeDescs.size());
+	m_vertexInputStateCI.pVertexAttributeDescriptions = m_vertexAttributeDescs.data();
 }
 
 void VulkanApp::CVulkanPipeline::Release() {
@@ -215,9 +181,4 @@ void VulkanApp::CVulkanPipeline::Release() {
 		vkDestroyPipeline(m_pCore->GetVkLogicalDevice(), m_vkPipeline, nullptr);
 		m_vkPipeline = VK_NULL_HANDLE;
 	}
-
-	if (m_pipelineCI.layout != VK_NULL_HANDLE) {
-		vkDestroyPipelineLayout(m_pCore->GetVkLogicalDevice(), m_pipelineCI.layout, nullptr);
-		m_pipelineCI.layout = VK_NULL_HANDLE;
-	}
 }
\ No newline at end of file
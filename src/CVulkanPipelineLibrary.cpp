@@ -0,0 +1,346 @@
+#include <CVulkanPipelineLibrary.h>
+#include <CVulkanCore.h>
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+#include <Utilities.h>
+#include <CTracer.h>
+
+namespace {
+	template <typename T>
+	uint64_t HandleKey(const T handle) {
+		return (uint64_t)(handle);
+	}
+}
+
+void VulkanApp::GraphicsPipelineState::SetVertexInput(const VkPipelineVertexInputStateCreateInfo &vertexInputState) {
+	m_vertexBindings.assign(vertexInputState.pVertexBindingDescriptions,
+		vertexInputState.pVertexBindingDescriptions + vertexInputState.vertexBindingDescriptionCount);
+	m_vertexAttributes.assign(vertexInputState.pVertexAttributeDescriptions,
+		vertexInputState.pVertexAttributeDescriptions + vertexInputState.vertexAttributeDescriptionCount);
+}
+
+uint64_t VulkanApp::GraphicsPipelineState::GetHash() const {
+	// Field by field, so padding never reaches the hash
+	const uint64_t fields[] = {
+		HandleKey(m_vertexShader), HandleKey(m_fragmentShader),
+		static_cast<uint64_t>(m_topology), static_cast<uint64_t>(m_polygonMode), m_cullMode, static_cast<uint64_t>(m_frontFace),
+		static_cast<uint64_t>(m_samples), m_blendEnable,
+		static_cast<uint64_t>(m_srcColorBlendFactor), static_cast<uint64_t>(m_dstColorBlendFactor), static_cast<uint64_t>(m_colorBlendOp),
+		static_cast<uint64_t>(m_srcAlphaBlendFactor), static_cast<uint64_t>(m_dstAlphaBlendFactor), static_cast<uint64_t>(m_alphaBlendOp),
+		m_colorWriteMask, HandleKey(m_layout), HandleKey(m_renderPass), m_subpass
+	};
+	uint64_t hash = Hash64(fields, sizeof(fields), cexp_hashSeed);
+	hash = m_vertexSpecialization.GetHash(hash);
+	hash = m_fragmentSpecialization.GetHash(hash);
+
+	for (const auto &binding : m_vertexBindings) {
+		const uint32_t bindingFields[] = { binding.binding, binding.stride, static_cast<uint32_t>(binding.inputRate) };
+		hash = Hash64(bindingFields, sizeof(bindingFields), hash);
+	}
+	for (const auto &attribute : m_vertexAttributes) {
+		const uint32_t attributeFields[] = { attribute.location, attribute.binding, static_cast<uint32_t>(attribute.format), attribute.offset };
+		hash = Hash64(attributeFields, sizeof(attributeFields), hash);
+	}
+	return hash;
+}
+
+bool VulkanApp::GraphicsPipelineState::operator==(const GraphicsPipelineState &other) const {
+	const bool sameBindings = std::equal(m_vertexBindings.begin(), m_vertexBindings.end(), other.m_vertexBindings.begin(), other.m_vertexBindings.end(),
+		[](const VkVertexInputBindingDescription &a, const VkVertexInputBindingDescription &b) {
+			return a.binding == b.binding && a.stride == b.stride && a.inputRate == b.inputRate;
+		});
+	const bool sameAttributes = std::equal(m_vertexAttributes.begin(), m_vertexAttributes.end(), other.m_vertexAttributes.begin(), other.m_vertexAttributes.end(),
+		[](const VkVertexInputAttributeDescription &a, const VkVertexInputAttributeDescription &b) {
+			return a.location == b.location && a.binding == b.binding && a.format == b.format && a.offset == b.offset;
+		});
+
+	return sameBindings && sameAttributes &&
+		m_vertexShader == other.m_vertexShader && m_fragmentShader == other.m_fragmentShader &&
+		m_vertexSpecialization == other.m_vertexSpecialization && m_fragmentSpecialization == other.m_fragmentSpecialization &&
+		m_topology == other.m_topology && m_polygonMode == other.m_polygonMode && m_cullMode == other.m_cullMode && m_frontFace == other.m_frontFace &&
+		m_samples == other.m_samples && m_blendEnable == other.m_blendEnable &&
+		m_srcColorBlendFactor == other.m_srcColorBlendFactor && m_dstColorBlendFactor == other.m_dstColorBlendFactor && m_colorBlendOp == other.m_colorBlendOp &&
+		m_srcAlphaBlendFactor == other.m_srcAlphaBlendFactor && m_dstAlphaBlendFactor == other.m_dstAlphaBlendFactor && m_alphaBlendOp == other.m_alphaBlendOp &&
+		m_colorWriteMask == other.m_colorWriteMask && m_layout == other.m_layout && m_renderPass == other.m_renderPass && m_subpass == other.m_subpass;
+}
+
+VulkanApp::CVulkanPipelineLibrary::CVulkanPipelineLibrary(const CVulkanCore *const pCore, const uint32_t workerCount)
+	: m_pCore(pCore) {
+
+	if (m_pCore == nullptr) {
+		throw std::runtime_error(UTIL_EXC_MSG("Pointer to parent object was null"));
+	}
+
+	uint32_t threadCount = workerCount;
+	if (threadCount == 0u) {
+		threadCount = std::max(std::thread::hardware_concurrency(), 2u) - 1u;
+	}
+
+	try {
+		for (uint32_t i = 0u; i < threadCount; i++) {
+			m_workers.emplace_back(&CVulkanPipelineLibrary::WorkerProcedure, this);
+		}
+	}
+	catch (...) {
+		Release();
+		throw;
+	}
+}
+
+VulkanApp::CVulkanPipelineLibrary::~CVulkanPipelineLibrary() {
+	Release();
+}
+
+VkPipeline VulkanApp::CVulkanPipelineLibrary::Get(const GraphicsPipelineState &state, const VkPipeline fallback) {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	const Entry &entry = FindOrQueue(state);
+	return entry.m_status == PipelineStatus::Ready ? entry.m_vkPipeline : fallback;
+}
+
+VkPipeline VulkanApp::CVulkanPipelineLibrary::GetBlocking(const GraphicsPipelineState &state) {
+	TRACE_SCOPE("PipelineLibrary::GetBlocking");
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	const Entry &entry = FindOrQueue(state);
+	m_jobDone.wait(lock, [&] { return entry.m_status != PipelineStatus::Pending; });
+
+	if (entry.m_status == PipelineStatus::Failed) {
+		// Formatted by the worker where it was thrown
+		throw std::runtime_error(entry.m_error);
+	}
+	return entry.m_vkPipeline;
+}
+
+void VulkanApp::CVulkanPipelineLibrary::Prepare(const GraphicsPipelineState &state) {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	Entry &entry = FindOrQueue(state);
+	if (entry.m_status == PipelineStatus::Failed) {
+		entry.m_status = PipelineStatus::Pending;
+		entry.m_error.clear();
+		Queue(entry);
+	}
+}
+
+void VulkanApp::CVulkanPipelineLibrary::WaitIdle() {
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_jobDone.wait(lock, [this] { return m_pendingCount == 0u; });
+}
+
+VulkanApp::PipelineStatus VulkanApp::CVulkanPipelineLibrary::GetStatus(const GraphicsPipelineState &state, std::string *pError) const {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	const Entry *pEntry = Find(state);
+	if (pEntry == nullptr) {
+		return PipelineStatus::Unknown;
+	}
+	if (pError && pEntry->m_status == PipelineStatus::Failed) {
+		*pError = pEntry->m_error;
+	}
+	return pEntry->m_status;
+}
+
+uint32_t VulkanApp::CVulkanPipelineLibrary::GetPipelineCount() const {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return static_cast<uint32_t>(std::count_if(m_entries.cbegin(), m_entries.cend(), [](const auto &entry) {
+		return entry.second.m_status == PipelineStatus::Ready;
+	}));
+}
+
+uint32_t VulkanApp::CVulkanPipelineLibrary::GetPendingCount() const {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_pendingCount;
+}
+
+double VulkanApp::CVulkanPipelineLibrary::GetTotalCompileTime() const {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_totalCompileMs;
+}
+
+VulkanApp::CVulkanPipelineLibrary::Entry& VulkanApp::CVulkanPipelineLibrary::FindOrQueue(const GraphicsPipelineState &state) {
+	const uint64_t hash = state.GetHash();
+
+	// Colliding hashes share a bucket, states are compared in full
+	auto range = m_entries.equal_range(hash);
+	for (auto itr = range.first; itr != range.second; ++itr) {
+		if (itr->second.m_state == state) {
+			return itr->second;
+		}
+	}
+
+	auto itr = m_entries.emplace(hash, Entry());
+	Entry &entry = itr->second;
+	entry.m_state = state;
+	Queue(entry);
+	return entry;
+}
+
+const VulkanApp::CVulkanPipelineLibrary::Entry* VulkanApp::CVulkanPipelineLibrary::Find(const GraphicsPipelineState &state) const {
+	auto range = m_entries.equal_range(state.GetHash());
+	for (auto itr = range.first; itr != range.second; ++itr) {
+		if (itr->second.m_state == state) {
+			return &itr->second;
+		}
+	}
+	return nullptr;
+}
+
+void VulkanApp::CVulkanPipelineLibrary::Queue(Entry &entry) {
+	m_queue.push_back(&entry);
+	m_pendingCount++;
+	m_jobReady.notify_one();
+}
+
+VkPipeline VulkanApp::CVulkanPipelineLibrary::Compile(const GraphicsPipelineState &state) const {
+	// Copies, the create info points into them
+	CSpecializationConstants vertexSpecialization = state.m_vertexSpecialization;
+	CSpecializationConstants fragmentSpecialization = state.m_fragmentSpecialization;
+
+	VkPipelineShaderStageCreateInfo shaderStageCI[2] = {};
+	shaderStageCI[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	shaderStageCI[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+	shaderStageCI[0].module = state.m_vertexShader;
+	shaderStageCI[0].pName = "main";
+	shaderStageCI[0].pSpecializationInfo = vertexSpecialization.GetInfo();
+	shaderStageCI[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	shaderStageCI[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+	shaderStageCI[1].module = state.m_fragmentShader;
+	shaderStageCI[1].pName = "main";
+	shaderStageCI[1].pSpecializationInfo = fragmentSpecialization.GetInfo();
+
+	VkPipelineVertexInputStateCreateInfo vertexInputStateCI = {};
+	vertexInputStateCI.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+	vertexInputStateCI.vertexBindingDescriptionCount = static_cast<uint32_t>(state.m_vertexBindings.size());
+	vertexInputStateCI.pVertexBindingDescriptions = state.m_vertexBindings.data();
+	vertexInputStateCI.vertexAttributeDescriptionCount = static_cast<uint32_t>(state.m_vertexAttributes.size());
+	vertexInputStateCI.pVertexAttributeDescriptions = state.m_vertexAttributes.data();
+
+	VkPipelineInputAssemblyStateCreateInfo inputAssemblyCI = {};
+	inputAssemblyCI.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+	inputAssemblyCI.topology = state.m_topology;
+
+	VkPipelineViewportStateCreateInfo viewportStateCI = {};
+	viewportStateCI.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+	viewportStateCI.viewportCount = 1;
+	viewportStateCI.scissorCount = 1;
+
+	const VkDynamicState dynamicStates[] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+	VkPipelineDynamicStateCreateInfo dynamicStateCI = {};
+	dynamicStateCI.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+	dynamicStateCI.dynamicStateCount = 2;
+	dynamicStateCI.pDynamicStates = dynamicStates;
+
+	VkPipelineRasterizationStateCreateInfo rasterizerStateCI = {};
+	rasterizerStateCI.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+	rasterizerStateCI.polygonMode = state.m_polygonMode;
+	rasterizerStateCI.cullMode = state.m_cullMode;
+	rasterizerStateCI.frontFace = state.m_frontFace;
+	rasterizerStateCI.lineWidth = 1.0f;
+
+	VkPipelineMultisampleStateCreateInfo multisamplingStateCI = {};
+	multisamplingStateCI.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+	multisamplingStateCI.rasterizationSamples = state.m_samples;
+	multisamplingStateCI.minSampleShading = 1.0f;
+
+	VkPipelineColorBlendAttachmentState colorBlendAttachmentCI = {};
+	colorBlendAttachmentCI.blendEnable = state.m_blendEnable;
+	colorBlendAttachmentCI.srcColorBlendFactor = state.m_srcColorBlendFactor;
+	colorBlendAttachmentCI.dstColorBlendFactor = state.m_dstColorBlendFactor;
+	colorBlendAttachmentCI.colorBlendOp = state.m_colorBlendOp;
+	colorBlendAttachmentCI.srcAlphaBlendFactor = state.m_srcAlphaBlendFactor;
+	colorBlendAttachmentCI.dstAlphaBlendFactor = state.m_dstAlphaBlendFactor;
+	colorBlendAttachmentCI.alphaBlendOp = state.m_alphaBlendOp;
+	colorBlendAttachmentCI.colorWriteMask = state.m_colorWriteMask;
+
+	VkPipelineColorBlendStateCreateInfo colorBlendingCI = {};
+	colorBlendingCI.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+	colorBlendingCI.attachmentCount = 1;
+	colorBlendingCI.pAttachments = &colorBlendAttachmentCI;
+
+	VkGraphicsPipelineCreateInfo pipelineCI = {};
+	pipelineCI.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+	pipelineCI.stageCount = 2;
+	pipelineCI.pStages = shaderStageCI;
+	pipelineCI.pVertexInputState = &vertexInputStateCI;
+	pipelineCI.pInputAssemblyState = &inputAssemblyCI;
+	pipelineCI.pViewportState = &viewportStateCI;
+	pipelineCI.pRasterizationState = &rasterizerStateCI;
+	pipelineCI.pMultisampleState = &multisamplingStateCI;
+	pipelineCI.pColorBlendState = &colorBlendingCI;
+	pipelineCI.pDynamicState = &dynamicStateCI;
+	pipelineCI.layout = state.m_layout;
+	pipelineCI.renderPass = state.m_renderPass;
+	pipelineCI.subpass = state.m_subpass;
+	pipelineCI.basePipelineIndex = -1;
+
+	VkPipeline pipeline = VK_NULL_HANDLE;
+	VkResult result = vkCreateGraphicsPipelines(m_pCore->GetVkLogicalDevice(), m_pCore->GetVkPipelineCache(), 1, &pipelineCI, nullptr, &pipeline);
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error(UTIL_EXC_MSG_EX("Cannot create pipeline", result));
+	}
+	return pipeline;
+}
+
+void VulkanApp::CVulkanPipelineLibrary::WorkerProcedure() {
+	while (true) {
+		Entry *pEntry = nullptr;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_jobReady.wait(lock, [this] { return m_exit || !m_queue.empty(); });
+			if (m_exit) {
+				return;
+			}
+			pEntry = m_queue.front();
+			m_queue.pop_front();
+		}
+
+		// The state is not modified while the entry is pending, it can be read without the lock
+		VkPipeline pipeline = VK_NULL_HANDLE;
+		std::string error;
+		const auto compileStart = std::chrono::steady_clock::now();
+		try {
+			TRACE_SCOPE("PipelineLibrary::Compile");
+			pipeline = Compile(pEntry->m_state);
+		}
+		catch (const std::exception &exception) {
+			error = exception.what();
+		}
+		const double compileMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - compileStart).count();
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			pEntry->m_vkPipeline = pipeline;
+			pEntry->m_status = pipeline != VK_NULL_HANDLE ? PipelineStatus::Ready : PipelineStatus::Failed;
+			pEntry->m_error = std::move(error);
+			m_pendingCount--;
+			m_totalCompileMs += compileMs;
+		}
+		m_jobDone.notify_all();
+	}
+}
+
+void VulkanApp::CVulkanPipelineLibrary::Release() {
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_exit = true;
+	}
+	m_jobReady.notify_all();
+
+	// Pipelines being compiled are finished by their workers, queued ones are dropped
+	for (auto &worker : m_workers) {
+		if (worker.joinable()) {
+			worker.join();
+		}
+	}
+	m_workers.clear();
+	m_queue.clear();
+
+	for (auto &entry : m_entries) {
+		if (entry.second.m_vkPipeline != VK_NULL_HANDLE) {
+			vkDestroyPipeline(m_pCore->GetVkLogicalDevice(), entry.second.m_vkPipeline, nullptr);
+		}
+	}
+	m_entries.clear();
+	m_pendingCount = 0u;
+}
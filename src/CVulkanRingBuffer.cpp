@@ -0,0 +1,108 @@
+#include <CVulkanRingBuffer.h>
+#include <CVulkanBuffer.h>
+#include <CVulkanCore.h>
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include <Utilities.h>
+
+namespace {
+	VkDeviceSize AlignUp(const VkDeviceSize value, const VkDeviceSize alignment) {
+		return (value + alignment - 1u) / alignment * alignment;
+	}
+}
+
+VulkanApp::CVulkanRingBuffer::CVulkanRingBuffer(const CVulkanCore *const pCore, const VkDeviceSize byteSize, const VkBufferUsageFlags usage,
+	const uint32_t frameSlotCount)
+	: m_pCore(pCore) {
+
+	if (m_pCore == nullptr) {
+		throw std::runtime_error(UTIL_EXC_MSG("Pointer to parent object was null"));
+	}
+
+	// A whole number of the largest alignment keeps aligned positions aligned after wrapping
+	m_size = AlignUp(std::max<VkDeviceSize>(byteSize, cexp_maxAlignment), cexp_maxAlignment);
+	m_slotEnds.resize(std::max(frameSlotCount, 1u), 0u);
+
+	m_pBuffer = new CVulkanBuffer(m_pCore, nullptr, static_cast<uint32_t>(m_size), { usage, BufferMemory::HostStreaming });
+	m_pMappedData = static_cast<uint8_t*>(m_pBuffer->GetMappedData());
+}
+
+VulkanApp::CVulkanRingBuffer::~CVulkanRingBuffer() {
+	if (m_pBuffer) {
+		delete m_pBuffer;
+	}
+}
+
+void VulkanApp::CVulkanRingBuffer::BeginFrame(const uint32_t frameSlot) {
+	m_currentSlot = frameSlot % static_cast<uint32_t>(m_slotEnds.size());
+
+	// Slots retire in submission order, everything before the end of this slot's last frame is free
+	m_tail = std::max(m_tail, m_slotEnds[m_currentSlot]);
+	m_slotEnds[m_currentSlot] = m_head;
+}
+
+VulkanApp::RingAllocation VulkanApp::CVulkanRingBuffer::Allocate(const VkDeviceSize byteSize, const VkDeviceSize alignment) {
+	if (alignment == 0u || alignment > cexp_maxAlignment || (alignment & (alignment - 1u)) != 0u) {
+		throw std::runtime_error(UTIL_EXC_MSG("Ring buffer alignment has to be a power of two up to 256"));
+	}
+
+	VkDeviceSize begin = AlignUp(m_head, alignment);
+
+	// Allocations are contiguous, one which does not fit before the end starts over at the beginning
+	if (begin % m_size + byteSize > m_size) {
+		begin = AlignUp(begin, m_size);
+	}
+
+	if (begin + byteSize - m_tail > m_size) {
+		throw std::runtime_error(UTIL_EXC_MSG("Ring buffer is full, the frames in flight need a larger one"));
+	}
+
+	m_head = begin + byteSize;
+	m_slotEnds[m_currentSlot] = m_head;
+
+	RingAllocation allocation;
+	allocation.m_vkBuffer = m_pBuffer->GetHandle();
+	allocation.m_offset = begin % m_size;
+	allocation.m_size = byteSize;
+	allocation.m_pData = m_pMappedData + allocation.m_offset;
+	return allocation;
+}
+
+VulkanApp::RingAllocation VulkanApp::CVulkanRingBuffer::Push(const void *data, const VkDeviceSize byteSize, const VkDeviceSize alignment) {
+	RingAllocation allocation = Allocate(byteSize, alignment);
+	memcpy(allocation.m_pData, data, byteSize);
+	return allocation;
+}
+
+void VulkanApp::CVulkanRingBuffer::Flush() {
+	// Older positions have been overwritten already, they cannot be pending anymore
+	const VkDeviceSize begin = std::max(m_flushed, m_head > m_size ? m_head - m_size : 0u);
+	const VkDeviceSize end = m_head;
+	m_flushed = m_head;
+
+	if (begin >= end) {
+		return;
+	}
+
+	// A wrapped range is flushed as two
+	const VkDeviceSize wrap = AlignUp(begin + 1u, m_size);
+	if (end > wrap) {
+		FlushRange(begin, wrap);
+		FlushRange(wrap, end);
+	}
+	else {
+		FlushRange(begin, end);
+	}
+}
+
+VkBuffer VulkanApp::CVulkanRingBuffer::GetHandle() const {
+	return m_pBuffer->GetHandle();
+}
+
+void VulkanApp::CVulkanRingBuffer::FlushRange(const VkDeviceSize begin, const VkDeviceSize end) {
+	const VkDeviceSize offset = begin % m_size;
+	m_pBuffer->Flush(offset, end - begin);
+}
@@ -0,0 +1,268 @@
+#include <CVulkanShaderCache.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+#include <thread>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <Utilities.h>
+#include <CTracer.h>
+
+// Read only view of a whole file, unmapped when it goes out of scope
+class VulkanApp::CVulkanShaderCache::MappedFile {
+public:
+	MappedFile(const std::string &filePath) {
+#ifdef _WIN32
+		m_file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (m_file == INVALID_HANDLE_VALUE) {
+			throw std::runtime_error(UTIL_EXC_MSG("Failed to open compiled shader file " + filePath));
+		}
+
+		LARGE_INTEGER fileSize = {};
+		GetFileSizeEx(m_file, &fileSize);
+		m_byteSize = static_cast<size_t>(fileSize.QuadPart);
+		if (m_byteSize == 0u) {
+			return;
+		}
+
+		m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		m_pData = m_mapping != nullptr ? MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+#else
+		m_file = open(filePath.c_str(), O_RDONLY);
+		if (m_file < 0) {
+			throw std::runtime_error(UTIL_EXC_MSG("Failed to open compiled shader file " + filePath));
+		}
+
+		struct stat fileStat = {};
+		fstat(m_file, &fileStat);
+		m_byteSize = static_cast<size_t>(fileStat.st_size);
+		if (m_byteSize == 0u) {
+			return;
+		}
+
+		void *pData = mmap(nullptr, m_byteSize, PROT_READ, MAP_PRIVATE, m_file, 0);
+		m_pData = pData != MAP_FAILED ? pData : nullptr;
+#endif
+		if (m_pData == nullptr) {
+			Release();
+			throw std::runtime_error(UTIL_EXC_MSG("Failed to map compiled shader file " + filePath));
+		}
+	}
+
+	~MappedFile() {
+		Release();
+	}
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	const void* GetData() const { return m_pData; };
+	size_t GetByteSize() const { return m_byteSize; };
+
+private:
+	void Release() {
+#ifdef _WIN32
+		if (m_pData) {
+			UnmapViewOfFile(m_pData);
+		}
+		if (m_mapping) {
+			CloseHandle(m_mapping);
+		}
+		if (m_file != INVALID_HANDLE_VALUE) {
+			CloseHandle(m_file);
+		}
+		m_mapping = nullptr;
+		m_file = INVALID_HANDLE_VALUE;
+#else
+		if (m_pData) {
+			munmap(const_cast<void*>(m_pData), m_byteSize);
+		}
+		if (m_file >= 0) {
+			close(m_file);
+		}
+		m_file = -1;
+#endif
+		m_pData = nullptr;
+	}
+
+#ifdef _WIN32
+	HANDLE m_file = INVALID_HANDLE_VALUE;
+	HANDLE m_mapping = nullptr;
+#else
+	int m_file = -1;
+#endif
+	const void *m_pData = nullptr;
+	size_t m_byteSize = 0u;
+};
+
+VulkanApp::CVulkanShaderCache::CVulkanShaderCache(const VkDevice device)
+	: m_vkDevice(device) {
+}
+
+VulkanApp::CVulkanShaderCache::~CVulkanShaderCache() {
+	for (auto &entry : m_codeModules) {
+		vkDestroyShaderModule(m_vkDevice, entry.second.m_vkModule, nullptr);
+	}
+}
+
+VkShaderModule VulkanApp::CVulkanShaderCache::Load(const std::string &filePath) {
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto itr = m_pathModules.find(filePath);
+		if (itr != m_pathModules.end()) {
+			m_deduplicatedCount++;
+			return itr->second;
+		}
+	}
+
+	TRACE_SCOPE("ShaderCache::Load");
+
+	// The mapping stays open with the module, a later load compares against it. It is released right
+	// away when the code turns out to be a duplicate.
+	auto pFile = std::make_unique<MappedFile>(filePath);
+	const void *pCode = pFile->GetData();
+	const size_t byteSize = pFile->GetByteSize();
+	const VkShaderModule module = CreateDeduplicated(pCode, byteSize, filePath, std::move(pFile));
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_pathModules.emplace(filePath, module);
+	return module;
+}
+
+std::vector<VkShaderModule> VulkanApp::CVulkanShaderCache::LoadAll(const std::vector<std::string> &filePaths, const uint32_t threadCount) {
+	TRACE_SCOPE("ShaderCache::LoadAll");
+
+	std::vector<VkShaderModule> modules(filePaths.size(), VK_NULL_HANDLE);
+	std::vector<std::exception_ptr> exceptions(filePaths.size());
+
+	// Files are handed out one at a time, a large module does not hold up a whole range
+	std::atomic<size_t> nextFile = 0u;
+	auto loadProcedure = [&] {
+		for (size_t i = nextFile++; i < filePaths.size(); i = nextFile++) {
+			try {
+				modules[i] = Load(filePaths[i]);
+			}
+			catch (...) {
+				exceptions[i] = std::current_exception();
+			}
+		}
+	};
+
+	uint32_t workerCount = threadCount != 0u ? threadCount : std::max(std::thread::hardware_concurrency(), 1u);
+	workerCount = std::min(workerCount, static_cast<uint32_t>(filePaths.size()));
+
+	// The calling thread loads too
+	std::vector<std::thread> workers;
+	for (uint32_t i = 1u; i < workerCount; i++) {
+		workers.emplace_back(loadProcedure);
+	}
+	loadProcedure();
+	for (auto &worker : workers) {
+		worker.join();
+	}
+
+	for (auto &exception : exceptions) {
+		if (exception) {
+			std::rethrow_exception(exception);
+		}
+	}
+	return modules;
+}
+
+VkShaderModule VulkanApp::CVulkanShaderCache::Create(const uint32_t *pCode, const size_t byteSize) {
+	return CreateDeduplicated(pCode, byteSize, "embedded shader", nullptr);
+}
+
+uint32_t VulkanApp::CVulkanShaderCache::GetModuleCount() const {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return static_cast<uint32_t>(m_codeModules.size());
+}
+
+uint32_t VulkanApp::CVulkanShaderCache::GetDeduplicatedCount() const {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_deduplicatedCount;
+}
+
+void VulkanApp::CVulkanShaderCache::Validate(const void *pCode, const size_t byteSize, const std::string &name) {
+	// Header of five words: magic, version, generator, bound and schema
+	if (pCode == nullptr || byteSize < 5u * sizeof(uint32_t) || byteSize % sizeof(uint32_t) != 0u) {
+		throw std::runtime_error(UTIL_EXC_MSG("SPIR-V code has to be a whole number of words with a header: " + name));
+	}
+
+	if (reinterpret_cast<uintptr_t>(pCode) % alignof(uint32_t) != 0u) {
+		throw std::runtime_error(UTIL_EXC_MSG("SPIR-V code is not aligned to 4 bytes: " + name));
+	}
+
+	if (*static_cast<const uint32_t*>(pCode) != cexp_spirvMagic) {
+		throw std::runtime_error(UTIL_EXC_MSG("SPIR-V magic number does not match, wrong file or byte order: " + name));
+	}
+}
+
+VkShaderModule VulkanApp::CVulkanShaderCache::CreateDeduplicated(const void *pCode, const size_t byteSize, const std::string &name,
+	std::unique_ptr<MappedFile> pMapping) {
+	Validate(pCode, byteSize, name);
+
+	const uint64_t hash = Hash64(pCode, byteSize);
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		const VkShaderModule existing = FindModule(hash, pCode, byteSize);
+		if (existing != VK_NULL_HANDLE) {
+			m_deduplicatedCount++;
+			return existing;
+		}
+	}
+
+	// Created without the lock, so threads of LoadAll() create their modules in parallel
+	VkShaderModuleCreateInfo shaderModuleCI = {};
+	shaderModuleCI.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+	shaderModuleCI.codeSize = byteSize;
+	shaderModuleCI.pCode = static_cast<const uint32_t*>(pCode);
+
+	VkShaderModule module = VK_NULL_HANDLE;
+	VkResult result = vkCreateShaderModule(m_vkDevice, &shaderModuleCI, nullptr, &module);
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error(UTIL_EXC_MSG_EX("Cannot create a shader module from " + name, result));
+	}
+
+	// Another thread may have created the same code meanwhile, its module wins
+	std::lock_guard<std::mutex> lock(m_mutex);
+	const VkShaderModule existing = FindModule(hash, pCode, byteSize);
+	if (existing != VK_NULL_HANDLE) {
+		vkDestroyShaderModule(m_vkDevice, module, nullptr);
+		m_deduplicatedCount++;
+		return existing;
+	}
+
+	CodeEntry entry;
+	entry.m_pCode = pCode;
+	entry.m_byteSize = byteSize;
+	entry.m_pMapping = std::move(pMapping);
+	entry.m_vkModule = module;
+	m_codeModules.emplace(hash, std::move(entry));
+	return module;
+}
+
+VkShaderModule VulkanApp::CVulkanShaderCache::FindModule(const uint64_t hash, const void *pCode, const size_t byteSize) const {
+	auto range = m_codeModules.equal_range(hash);
+	for (auto itr = range.first; itr != range.second; ++itr) {
+		const CodeEntry &entry = itr->second;
+		if (entry.m_byteSize == byteSize && memcmp(entry.m_pCode, pCode, byteSize) == 0) {
+			return itr->second.m_vkModule;
+		}
+	}
+	return VK_NULL_HANDLE;
+}
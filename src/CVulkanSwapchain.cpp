@@ -2,8 +2,10 @@
 #include <CVulkanCore.h>
 
 #include <stdexcept>
+#include <algorithm>
 
 #include <Utilities.h>
+#include <CTracer.h>
 
 VulkanApp::CVulkanSwapchain::CVulkanSwapchain(
 	const CVulkanCore *const pCore,
@@ -11,7 +13,10 @@ VulkanApp::CVulkanSwapchain::CVulkanSwapchain(
 	const uint32_t height,
 	const VkSurfaceKHR surface,
 	const VkSurfaceFormatKHR surfaceFormat,
-	const VkRenderPass renderPass) : m_pCore(pCore) , m_vkRenderPass(renderPass) {
+	const VkRenderPass renderPass,
+	const PresentPolicy policy) : m_pCore(pCore) , m_vkRenderPass(renderPass) {
+
+	TRACE_SCOPE("CVulkanSwapchain::Create");
 
 	if (m_pCore == nullptr) {
 		throw std::runtime_error(UTIL_EXC_MSG( "Pointer to parent object was null"));
@@ -19,14 +24,13 @@ VulkanApp::CVulkanSwapchain::CVulkanSwapchain(
 
 	m_swapchainCI.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
 	m_swapchainCI.pNext = nullptr;
-	m_swapchainCI.flags = NULL;
+	m_swapchainCI.flags = 0u;
 	m_swapchainCI.surface = surface;
 
-	// Retrieve the detalis about swapchains
-	VkSurfaceCapabilitiesKHR capabilities;
-	vkGetPhysicalDeviceSurfaceCapabilitiesKHR(m_pCore->GetVkPhysicalDevice(), surface, &capabilities);
+	// Present modes, formats and limits of the surface, later checks only read the snapshot
+	m_surfaceCaps.Query(m_pCore->GetVkPhysicalDevice(), surface);
+	const VkSurfaceCapabilitiesKHR &capabilities = m_surfaceCaps.m_capabilities;
 
-	m_swapchainCI.minImageCount = capabilities.minImageCount + 1;
 	m_swapchainCI.imageArrayLayers = capabilities.maxImageArrayLayers;
 	
 	if (!SetImageSize(width, height)) {
@@ -44,13 +48,23 @@ VulkanApp::CVulkanSwapchain::CVulkanSwapchain(
 	m_swapchainCI.preTransform = capabilities.currentTransform;
 	m_swapchainCI.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
 
-	if (!SetPresentMode(VK_PRESENT_MODE_FIFO_KHR)) {
-		throw std::runtime_error(UTIL_EXC_MSG("Specified present mode is not supported"));
+	if (!SetPresentPolicy(policy)) {
+		throw std::runtime_error(UTIL_EXC_MSG("No present mode of the policy is supported"));
 	}
 
 	m_swapchainCI.clipped = VK_TRUE;
 	m_swapchainCI.oldSwapchain = VK_NULL_HANDLE;
 
+	// Reserved once, resizes swap the arrays between the current and the retired resources
+	m_swapchainImageViews.reserve(cexp_maxImageCount);
+	m_framebuffers.reserve(cexp_maxImageCount);
+	m_renderDoneSemaphores.reserve(cexp_maxImageCount);
+	for (auto &retired : m_retired) {
+		retired.m_imageViews.reserve(cexp_maxImageCount);
+		retired.m_framebuffers.reserve(cexp_maxImageCount);
+		retired.m_renderDoneSemaphores.reserve(cexp_maxImageCount);
+	}
+
 	VkResult result = vkCreateSwapchainKHR(m_pCore->GetVkLogicalDevice(), &m_swapchainCI, nullptr, &m_vkSwapchain);
 	if(result != VK_SUCCESS) {
 		throw std::runtime_error(UTIL_EXC_MSG_EX("Swapchain creation failed", result));
@@ -60,6 +74,11 @@ VulkanApp::CVulkanSwapchain::CVulkanSwapchain(
 }
 
 VulkanApp::CVulkanSwapchain::~CVulkanSwapchain() {
+	// The owner waits for the device before destroying the swapchain
+	for (auto &retired : m_retired) {
+		Release(retired);
+	}
+
 	ReleaseFramebuffer();
 	if (m_vkSwapchain) {
 		vkDestroySwapchainKHR(m_pCore->GetVkLogicalDevice(), m_vkSwapchain, nullptr);
@@ -67,32 +86,36 @@ VulkanApp::CVulkanSwapchain::~CVulkanSwapchain() {
 	}
 }
 
-const VkFramebuffer VulkanApp::CVulkanSwapchain::GetFramebuffer(const uint32_t index) {
-	if (index >= 0 && index < m_framebuffers.size()) {
+VkFramebuffer VulkanApp::CVulkanSwapchain::GetFramebuffer(const uint32_t index) {
+	if (index < m_framebuffers.size()) {
 		return m_framebuffers[index];
 	}
 	return VK_NULL_HANDLE;
 }
 
-void VulkanApp::CVulkanSwapchain::InitializeFramebuffer() {
-
-	// Retrieve the swap chain images
-	uint32_t imageCount = 0;
-	VkResult result = vkGetSwapchainImagesKHR(m_pCore->GetVkLogicalDevice(), m_vkSwapchain, &imageCount, nullptr);
-	if (result != VK_SUCCESS) {
-		throw std::runtime_error(UTIL_EXC_MSG_EX("Failed to obtain swapchain images count", result));
+VkSemaphore VulkanApp::CVulkanSwapchain::GetRenderDoneSemaphore(const uint32_t index) const {
+	if (index < m_renderDoneSemaphores.size()) {
+		return m_renderDoneSemaphores[index];
 	}
+	return VK_NULL_HANDLE;
+}
 
-	std::vector<VkImage> swapchainImages(imageCount);
+void VulkanApp::CVulkanSwapchain::InitializeFramebuffer() {
 
-	result = vkGetSwapchainImagesKHR(m_pCore->GetVkLogicalDevice(), m_vkSwapchain, &imageCount, swapchainImages.data());
+	// Retrieve the swap chain images in one call, VK_INCOMPLETE means there are more than the bound
+	std::array<VkImage, cexp_maxImageCount> swapchainImages = {};
+	uint32_t imageCount = cexp_maxImageCount;
+	VkResult result = vkGetSwapchainImagesKHR(m_pCore->GetVkLogicalDevice(), m_vkSwapchain, &imageCount, swapchainImages.data());
+	if (result == VK_INCOMPLETE) {
+		throw std::runtime_error(UTIL_EXC_MSG("Swapchain has more images than cexp_maxImageCount"));
+	}
 	if (result != VK_SUCCESS) {
 		throw std::runtime_error(UTIL_EXC_MSG_EX("Cannot retrieve swapchain images", result));
 	}
 
-	// Create the views to the swapchain images
+	// Create the views to the swapchain images, within the reserved capacity
 
-	m_swapchainImageViews.resize(swapchainImages.size());
+	m_swapchainImageViews.resize(imageCount);
 
 	VkImageViewCreateInfo imageViewCI = {};
 	imageViewCI.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
@@ -135,72 +158,120 @@ void VulkanApp::CVulkanSwapchain::InitializeFramebuffer() {
 			throw std::runtime_error("[Runtime error] Failed to create framebuffer");
 		}
 	}
+
+	// Create semaphores signaled when rendering to an image is done
+
+	m_renderDoneSemaphores.resize(m_framebuffers.size());
+
+	VkSemaphoreCreateInfo semaphoreCI = {};
+	semaphoreCI.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+	for (auto &semaphore : m_renderDoneSemaphores) {
+		result = vkCreateSemaphore(m_pCore->GetVkLogicalDevice(), &semaphoreCI, nullptr, &semaphore);
+		if (result != VK_SUCCESS) {
+			throw std::runtime_error(UTIL_EXC_MSG_EX("Cannot create a semaphore", result));
+		}
+	}
 }
 
 void VulkanApp::CVulkanSwapchain::ReleaseFramebuffer() {
+	RetiredSwapchain current;
+	current.m_imageViews.swap(m_swapchainImageViews);
+	current.m_framebuffers.swap(m_framebuffers);
+	current.m_renderDoneSemaphores.swap(m_renderDoneSemaphores);
+	Release(current);
+}
 
-	for (auto framebuffer : m_framebuffers) {
+void VulkanApp::CVulkanSwapchain::Release(RetiredSwapchain &retired) {
+	const VkDevice device = m_pCore->GetVkLogicalDevice();
+
+	for (auto framebuffer : retired.m_framebuffers) {
 		if (framebuffer) {
-			vkDestroyFramebuffer(m_pCore->GetVkLogicalDevice(), framebuffer, nullptr);
+			vkDestroyFramebuffer(device, framebuffer, nullptr);
 		}
 	}
 
-	m_framebuffers.clear();
+	retired.m_framebuffers.clear();
 
-	for (auto imageView : m_swapchainImageViews) {
+	for (auto imageView : retired.m_imageViews) {
 		if (imageView) {
-			vkDestroyImageView(m_pCore->GetVkLogicalDevice(), imageView, nullptr);
+			vkDestroyImageView(device, imageView, nullptr);
 		}
 	}
 
-	m_swapchainImageViews.clear();
-}
+	retired.m_imageViews.clear();
 
-bool VulkanApp::CVulkanSwapchain::PresentModeAvailable(const VkPresentModeKHR mode) const {
-	uint32_t count = 0;
-	vkGetPhysicalDeviceSurfacePresentModesKHR(m_pCore->GetVkPhysicalDevice(), m_swapchainCI.surface, &count, nullptr);
+	for (auto semaphore : retired.m_renderDoneSemaphores) {
+		if (semaphore) {
+			vkDestroySemaphore(device, semaphore, nullptr);
+		}
+	}
 
-	std::vector<VkPresentModeKHR> presentModes(count);
-	vkGetPhysicalDeviceSurfacePresentModesKHR(m_pCore->GetVkPhysicalDevice(), m_swapchainCI.surface, &count, presentModes.data());
+	retired.m_renderDoneSemaphores.clear();
 
-	return std::find(presentModes.cbegin(), presentModes.cend(), mode) != presentModes.cend();
+	if (retired.m_vkSwapchain) {
+		vkDestroySwapchainKHR(device, retired.m_vkSwapchain, nullptr);
+		retired.m_vkSwapchain = VK_NULL_HANDLE;
+	}
 }
 
-bool VulkanApp::CVulkanSwapchain::SurfaceFormatAvailable(const VkSurfaceFormatKHR surfaceFormat) const {
-	// Surface formats for the physical device
-	uint32_t count = 0;
-	vkGetPhysicalDeviceSurfaceFormatsKHR(m_pCore->GetVkPhysicalDevice(), m_swapchainCI.surface, &count, nullptr);
-
-	std::vector<VkSurfaceFormatKHR> formats(count);
-	vkGetPhysicalDeviceSurfaceFormatsKHR(m_pCore->GetVkPhysicalDevice(), m_swapchainCI.surface, &count, formats.data());
-
-	// Selecting required format and color space
-	bool formatFound = false;
-	for (auto& format : formats) {
-		if (format.format == surfaceFormat.format &&
-			format.colorSpace == surfaceFormat.colorSpace) {
-			return true;
-		}
-	}
-	return false;
+bool VulkanApp::CVulkanSwapchain::PresentModeAvailable(const VkPresentModeKHR mode) const {
+	return m_surfaceCaps.HasPresentMode(mode);
 }
 
-void VulkanApp::CVulkanSwapchain::Update() {
+bool VulkanApp::CVulkanSwapchain::SurfaceFormatAvailable(const VkSurfaceFormatKHR surfaceFormat) const {
+	return m_surfaceCaps.HasFormat(surfaceFormat);
+}
 
-	ReleaseFramebuffer();
+void VulkanApp::CVulkanSwapchain::Update(const uint64_t retireAfterFrame) {
+	TRACE_SCOPE("CVulkanSwapchain::Update");
 
 	m_swapchainCI.oldSwapchain = m_vkSwapchain;
 
-	VkResult result = vkCreateSwapchainKHR(m_pCore->GetVkLogicalDevice(), &m_swapchainCI, nullptr, &m_vkSwapchain);
+	VkSwapchainKHR newSwapchain = VK_NULL_HANDLE;
+	VkResult result = vkCreateSwapchainKHR(m_pCore->GetVkLogicalDevice(), &m_swapchainCI, nullptr, &newSwapchain);
+	m_swapchainCI.oldSwapchain = VK_NULL_HANDLE;
 	if (result != VK_SUCCESS) {
 		throw std::runtime_error(UTIL_EXC_MSG_EX("Swapchain creation failed", result));
 	}
 
-	vkDestroySwapchainKHR(m_pCore->GetVkLogicalDevice(), m_swapchainCI.oldSwapchain, nullptr);
+	// Frames up to retireAfterFrame may still render to and present the old images,
+	// the old resources are destroyed by ReleaseRetired() once the frame after them is done
+	auto freeSlot = std::find_if(m_retired.begin(), m_retired.end(), [](const RetiredSwapchain &retired) {
+		return retired.m_vkSwapchain == VK_NULL_HANDLE;
+	});
+	if (freeSlot == m_retired.end()) {
+		// Only when resizes come faster than frames complete, waiting once frees every slot
+		vkDeviceWaitIdle(m_pCore->GetVkLogicalDevice());
+		for (auto &retired : m_retired) {
+			Release(retired);
+		}
+		freeSlot = m_retired.begin();
+	}
 
+	// The slot hands its emptied arrays to the new swapchain
+	RetiredSwapchain &retired = *freeSlot;
+	retired.m_vkSwapchain = m_vkSwapchain;
+	retired.m_imageViews.swap(m_swapchainImageViews);
+	retired.m_framebuffers.swap(m_framebuffers);
+	retired.m_renderDoneSemaphores.swap(m_renderDoneSemaphores);
+	retired.m_lastFrame = retireAfterFrame;
+
+	m_vkSwapchain = newSwapchain;
 	InitializeFramebuffer();
 }
 
+void VulkanApp::CVulkanSwapchain::ReleaseRetired(const uint64_t completedFrame) {
+	// The fence of the last frame does not cover its present, which still waits on the render done
+	// semaphore and holds the old image. The fence of the next frame, submitted after that present,
+	// is taken as the point where the present has been consumed.
+	for (auto &retired : m_retired) {
+		if (retired.m_vkSwapchain != VK_NULL_HANDLE && retired.m_lastFrame < completedFrame) {
+			Release(retired);
+		}
+	}
+}
+
 bool VulkanApp::CVulkanSwapchain::SetPresentMode(const VkPresentModeKHR mode) {
 	if (!PresentModeAvailable(mode)) {
 		return false;
@@ -209,6 +280,58 @@ bool VulkanApp::CVulkanSwapchain::SetPresentMode(const VkPresentModeKHR mode) {
 	return true;
 }
 
+bool VulkanApp::CVulkanSwapchain::SetPresentPolicy(const PresentPolicy policy) {
+	// Present modes in the order of preference, FIFO_KHR ends every list since it is always supported
+	static constexpr VkPresentModeKHR cexp_lowLatencyModes[] = { VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_FIFO_KHR };
+	static constexpr VkPresentModeKHR cexp_maxThroughputModes[] = { VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_FIFO_KHR };
+	// Not FIFO_RELAXED, a late frame would tear and this is the default policy
+	static constexpr VkPresentModeKHR cexp_powerSavingModes[] = { VK_PRESENT_MODE_FIFO_KHR };
+
+	const VkPresentModeKHR *candidatesBegin = cexp_powerSavingModes;
+	const VkPresentModeKHR *candidatesEnd = std::end(cexp_powerSavingModes);
+	switch (policy) {
+	case PresentPolicy::LowLatency:
+		candidatesBegin = cexp_lowLatencyModes;
+		candidatesEnd = std::end(cexp_lowLatencyModes);
+		break;
+	case PresentPolicy::MaxThroughput:
+		candidatesBegin = cexp_maxThroughputModes;
+		candidatesEnd = std::end(cexp_maxThroughputModes);
+		break;
+	case PresentPolicy::PowerSaving:
+		break;
+	}
+
+	const VkPresentModeKHR *it = std::find_if(candidatesBegin, candidatesEnd, [this](const VkPresentModeKHR mode) {
+		return m_surfaceCaps.HasPresentMode(mode);
+	});
+	if (it == candidatesEnd) {
+		return false;
+	}
+
+	// Every queued image adds a frame of latency, low latency keeps the queue at the minimum.
+	// Mailbox needs a third image to render while one is shown and one is queued.
+	const uint32_t surfaceMinImageCount = m_surfaceCaps.m_capabilities.minImageCount;
+	const uint32_t surfaceMaxImageCount = m_surfaceCaps.m_capabilities.maxImageCount; // Zero means no limit
+	uint32_t imageCount = surfaceMinImageCount + 1u;
+	if (*it == VK_PRESENT_MODE_MAILBOX_KHR) {
+		imageCount = std::max(imageCount, 3u);
+	}
+	else if (policy == PresentPolicy::LowLatency) {
+		imageCount = surfaceMinImageCount;
+	}
+
+	if (surfaceMaxImageCount != 0u) {
+		imageCount = std::min(imageCount, surfaceMaxImageCount);
+	}
+	imageCount = std::min(imageCount, cexp_maxImageCount);
+
+	m_swapchainCI.presentMode = *it;
+	m_swapchainCI.minImageCount = imageCount;
+	m_presentPolicy = policy;
+	return true;
+}
+
 bool VulkanApp::CVulkanSwapchain::SetImageFormat(const VkSurfaceFormatKHR surfaceFormat)
 {
 	if (!SurfaceFormatAvailable(surfaceFormat)) {
@@ -221,14 +344,14 @@ bool VulkanApp::CVulkanSwapchain::SetImageFormat(const VkSurfaceFormatKHR surfac
 
 bool VulkanApp::CVulkanSwapchain::SetImageSize(const uint32_t width, const uint32_t height)
 {
-	VkSurfaceCapabilitiesKHR capabilities;
-	vkGetPhysicalDeviceSurfaceCapabilitiesKHR(m_pCore->GetVkPhysicalDevice(), m_swapchainCI.surface, &capabilities);
-
-	if (width > capabilities.maxImageExtent.width ||
-		height > capabilities.maxImageExtent.height ||
-		width < capabilities.minImageExtent.width ||
-		height < capabilities.minImageExtent.height) {
-
+	// The extent limits follow the window, e.g. on Win32 they equal its current size, so they are
+	// queried again. Present modes and formats stay as they were, nothing is allocated.
+	// A failed query, e.g. a lost surface, would fail every retry as well
+	const VkResult result = m_surfaceCaps.RefreshCapabilities(m_pCore->GetVkPhysicalDevice());
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error(UTIL_EXC_MSG_EX("Cannot query surface capabilities", result));
+	}
+	if (!m_surfaceCaps.IsExtentSupported(width, height)) {
 		return false;
 	}
 
@@ -237,24 +360,26 @@ bool VulkanApp::CVulkanSwapchain::SetImageSize(const uint32_t width, const uint3
 	return true;
 }
 
-uint32_t VulkanApp::CVulkanSwapchain::GetNextImageIndex(VkSemaphore signalImgReady) const {
-	uint32_t index = 0u;
+VkResult VulkanApp::CVulkanSwapchain::GetNextImageIndex(VkSemaphore signalImgReady, uint32_t *pIndex) const {
+	TRACE_SCOPE("Acquire");
 	VkResult result = vkAcquireNextImageKHR(
 		m_pCore->GetVkLogicalDevice(),
 		m_vkSwapchain,
 		UINT64_MAX,
 		signalImgReady,
 		NULL,
-		&index);
+		pIndex);
 
-	if (result != VK_SUCCESS) {
+	// Suboptimal still acquires an image, out of date requires recreation before the next acquire
+	if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR && result != VK_ERROR_OUT_OF_DATE_KHR) {
 		throw std::runtime_error(UTIL_EXC_MSG_EX("Cannot acquire a swapchain image", result));
 	}
 
-	return index;
+	return result;
 }
 
-void VulkanApp::CVulkanSwapchain::PresentFrame(uint32_t index, VkSemaphore waitFor) const {
+VkResult VulkanApp::CVulkanSwapchain::PresentFrame(uint32_t index, VkSemaphore waitFor) const {
+	TRACE_SCOPE("Present");
 	VkPresentInfoKHR presentInfo{};
 	presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
 	presentInfo.waitSemaphoreCount = 1;
@@ -265,7 +390,9 @@ void VulkanApp::CVulkanSwapchain::PresentFrame(uint32_t index, VkSemaphore waitF
 	presentInfo.pResults = nullptr; // Optional
 
 	VkResult result = vkQueuePresentKHR(m_pCore->m_vkQueue, &presentInfo);
-	if (result != VK_SUCCESS) {
-		throw std::runtime_error(UTIL_EXC_MSG_EX("Swapchain recreation failure", result));
+	if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR && result != VK_ERROR_OUT_OF_DATE_KHR) {
+		throw std::runtime_error(UTIL_EXC_MSG_EX("Cannot present a swapchain image", result));
 	}
-}
\ No newline at end of file
+
+	return result;
+}
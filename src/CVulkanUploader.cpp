@@ -0,0 +1,320 @@
+#include <CVulkanUploader.h>
+#include <CVulkanCore.h>
+
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+
+#include <Utilities.h>
+#include <CTracer.h>
+
+namespace VulkanApp {
+	static constexpr VkDeviceSize cexp_stagingAlignment = 16u;
+}
+
+VulkanApp::CVulkanUploader::CVulkanUploader(const CVulkanCore *const pCore, const VkDeviceSize stagingSize)
+	: m_pCore(pCore), m_stagingSize(stagingSize) {
+
+	if (m_pCore == nullptr) {
+		throw std::runtime_error(UTIL_EXC_MSG("Pointer to parent object was null"));
+	}
+
+	const VkDevice device = m_pCore->GetVkLogicalDevice();
+	m_dedicatedQueue = m_pCore->GetTransferQueueFamilyIndex() != m_pCore->GetQueueFamilyIndex();
+
+	try {
+		// Staging ring
+		VkBufferCreateInfo bufferCI = {};
+		bufferCI.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		bufferCI.size = m_stagingSize;
+		bufferCI.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+		bufferCI.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+		VkResult result = vkCreateBuffer(device, &bufferCI, nullptr, &m_vkStagingBuffer);
+		if (result != VK_SUCCESS) {
+			throw std::runtime_error(UTIL_EXC_MSG_EX("Staging buffer creation failed.", result));
+		}
+
+		m_stagingAllocation = m_pCore->GetAllocator()->AllocateForBuffer(m_vkStagingBuffer,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 0u);
+
+		// Transfer command buffers, each batch has its own pool so it can be recycled at once
+		VkCommandPoolCreateInfo commandPoolCI = {};
+		commandPoolCI.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		commandPoolCI.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+		commandPoolCI.queueFamilyIndex = m_pCore->GetTransferQueueFamilyIndex();
+
+		VkCommandBufferAllocateInfo commandBufferAI = {};
+		commandBufferAI.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		commandBufferAI.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		commandBufferAI.commandBufferCount = 1u;
+
+		VkFenceCreateInfo fenceCI = {};
+		fenceCI.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+		for (auto &batch : m_batches) {
+			result = vkCreateCommandPool(device, &commandPoolCI, nullptr, &batch.m_vkCommandPool);
+			if (result != VK_SUCCESS) {
+				throw std::runtime_error(UTIL_EXC_MSG_EX("Cannot create a command pool", result));
+			}
+
+			commandBufferAI.commandPool = batch.m_vkCommandPool;
+			result = vkAllocateCommandBuffers(device, &commandBufferAI, &batch.m_vkCommandBuffer);
+			if (result != VK_SUCCESS) {
+				throw std::runtime_error(UTIL_EXC_MSG_EX("Cannot allocate a command buffer", result));
+			}
+
+			result = vkCreateFence(device, &fenceCI, nullptr, &batch.m_vkFence);
+			if (result != VK_SUCCESS) {
+				throw std::runtime_error(UTIL_EXC_MSG_EX("Cannot create a fence", result));
+			}
+		}
+
+		VkSemaphoreCreateInfo semaphoreCI = {};
+		semaphoreCI.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+		for (auto &semaphore : m_semaphores) {
+			result = vkCreateSemaphore(device, &semaphoreCI, nullptr, &semaphore);
+			if (result != VK_SUCCESS) {
+				throw std::runtime_error(UTIL_EXC_MSG_EX("Cannot create a semaphore", result));
+			}
+		}
+	}
+	catch (...) {
+		Release();
+		throw;
+	}
+}
+
+VulkanApp::CVulkanUploader::~CVulkanUploader() {
+	FlushAndWait();
+	Release();
+}
+
+void VulkanApp::CVulkanUploader::Upload(const VkBuffer dstBuffer, const VkDeviceSize dstOffset, const void *data, const VkDeviceSize byteSize) {
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	// Large uploads are split, so a single copy never needs the whole ring
+	const VkDeviceSize chunkLimit = m_stagingSize / 2u;
+	const uint8_t *pSource = static_cast<const uint8_t*>(data);
+
+	for (VkDeviceSize copied = 0u; copied < byteSize;) {
+		const VkDeviceSize chunkSize = std::min(byteSize - copied, chunkLimit);
+
+		VkDeviceSize ringBegin = 0u;
+		const VkDeviceSize stagingOffset = Reserve(chunkSize, &ringBegin);
+		memcpy(static_cast<uint8_t*>(m_stagingAllocation.m_pMappedData) + stagingOffset, pSource + copied, chunkSize);
+
+		UploadBatch &batch = GetRecordingBatch(ringBegin);
+
+		VkBufferCopy region = {};
+		region.srcOffset = stagingOffset;
+		region.dstOffset = dstOffset + copied;
+		region.size = chunkSize;
+		vkCmdCopyBuffer(batch.m_vkCommandBuffer, m_vkStagingBuffer, dstBuffer, 1u, &region);
+
+		copied += chunkSize;
+	}
+}
+
+VkSemaphore VulkanApp::CVulkanUploader::Flush(const uint32_t frameSlot) {
+	TRACE_SCOPE("UploadFlush");
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	RetireBatches(false);
+
+	if (m_recordingBatch == UINT32_MAX) {
+		return VK_NULL_HANDLE;
+	}
+
+	// The semaphore of a slot is free again, the graphics submission waiting on it
+	// last time has already passed the frame fence of that slot
+	VkSemaphore semaphore = m_semaphores[frameSlot % cexp_semaphoreCount];
+	Submit(semaphore);
+	return semaphore;
+}
+
+void VulkanApp::CVulkanUploader::FlushAndWait() {
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if (m_recordingBatch != UINT32_MAX) {
+		Submit(VK_NULL_HANDLE);
+	}
+
+	while (!m_pendingBatches.empty()) {
+		RetireBatches(true);
+	}
+}
+
+VkDeviceSize VulkanApp::CVulkanUploader::Reserve(const VkDeviceSize byteSize, VkDeviceSize *pRingBeginOut) {
+	const VkDeviceSize alignedSize = (byteSize + cexp_stagingAlignment - 1u) / cexp_stagingAlignment * cexp_stagingAlignment;
+	if (alignedSize > m_stagingSize) {
+		throw std::runtime_error(UTIL_EXC_MSG("Upload does not fit into the staging ring."));
+	}
+
+	for (;;) {
+		// Nothing in flight, the whole ring is free
+		if (m_pendingBatches.empty()) {
+			m_head = 0u;
+		}
+
+		*pRingBeginOut = m_head;
+
+		if (m_pendingBatches.empty()) {
+			m_head = alignedSize;
+			return 0u;
+		}
+
+		// Bytes from the oldest pending batch up to the head are in use
+		const VkDeviceSize tail = m_batches[m_pendingBatches.front()].m_ringBegin;
+
+		if (m_head > tail) {
+			if (m_stagingSize - m_head >= alignedSize) {
+				const VkDeviceSize offset = m_head;
+				m_head += alignedSize;
+				return offset;
+			}
+			// Wrap around, the skipped end of the ring is reclaimed together with the batch
+			if (tail >= alignedSize) {
+				m_head = alignedSize;
+				return 0u;
+			}
+		}
+		else if (m_head < tail && tail - m_head >= alignedSize) {
+			const VkDeviceSize offset = m_head;
+			m_head += alignedSize;
+			return offset;
+		}
+
+		// Head caught up with the tail, the oldest batch has to finish first
+		RetireBatches(true);
+	}
+}
+
+VulkanApp::CVulkanUploader::UploadBatch& VulkanApp::CVulkanUploader::GetRecordingBatch(const VkDeviceSize ringBegin) {
+	if (m_recordingBatch != UINT32_MAX) {
+		return m_batches[m_recordingBatch];
+	}
+
+	uint32_t batchIndex = UINT32_MAX;
+	while (batchIndex == UINT32_MAX) {
+		for (uint32_t i = 0; i < cexp_batchCount && batchIndex == UINT32_MAX; i++) {
+			if (std::find(m_pendingBatches.cbegin(), m_pendingBatches.cend(), i) == m_pendingBatches.cend()) {
+				batchIndex = i;
+			}
+		}
+
+		if (batchIndex == UINT32_MAX) {
+			RetireBatches(true);
+		}
+	}
+
+	UploadBatch &batch = m_batches[batchIndex];
+
+	VkResult result = vkResetCommandPool(m_pCore->GetVkLogicalDevice(), batch.m_vkCommandPool, 0);
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error(UTIL_EXC_MSG_EX("Cannot reset the command pool", result));
+	}
+
+	VkCommandBufferBeginInfo beginInfoCI = {};
+	beginInfoCI.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfoCI.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+	result = vkBeginCommandBuffer(batch.m_vkCommandBuffer, &beginInfoCI);
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error(UTIL_EXC_MSG_EX("Failed to begin a command buffer", result));
+	}
+
+	batch.m_ringBegin = ringBegin;
+	batch.m_recording = true;
+	m_recordingBatch = batchIndex;
+	m_pendingBatches.push_back(batchIndex);
+	return batch;
+}
+
+void VulkanApp::CVulkanUploader::Submit(const VkSemaphore signalSemaphore) {
+	UploadBatch &batch = m_batches[m_recordingBatch];
+
+	VkResult result = vkEndCommandBuffer(batch.m_vkCommandBuffer);
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error(UTIL_EXC_MSG_EX("Failed to end a command buffer", result));
+	}
+
+	VkSubmitInfo submitInfo = {};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.commandBufferCount = 1u;
+	submitInfo.pCommandBuffers = &batch.m_vkCommandBuffer;
+	submitInfo.signalSemaphoreCount = (signalSemaphore != VK_NULL_HANDLE) ? 1u : 0u;
+	submitInfo.pSignalSemaphores = &signalSemaphore;
+
+	vkResetFences(m_pCore->GetVkLogicalDevice(), 1u, &batch.m_vkFence);
+
+	result = vkQueueSubmit(m_pCore->GetTransferQueue(), 1u, &submitInfo, batch.m_vkFence);
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error(UTIL_EXC_MSG_EX("Upload submission failed", result));
+	}
+
+	batch.m_recording = false;
+	m_recordingBatch = UINT32_MAX;
+}
+
+void VulkanApp::CVulkanUploader::RetireBatches(const bool waitForOldest) {
+	bool wait = waitForOldest;
+
+	while (!m_pendingBatches.empty()) {
+		UploadBatch &batch = m_batches[m_pendingBatches.front()];
+
+		if (batch.m_recording) {
+			if (!wait) {
+				break;
+			}
+			// Staging memory is short, push the copies recorded so far and wait for them on the CPU
+			Submit(VK_NULL_HANDLE);
+		}
+
+		VkResult result = wait ?
+			vkWaitForFences(m_pCore->GetVkLogicalDevice(), 1u, &batch.m_vkFence, VK_TRUE, UINT64_MAX) :
+			vkGetFenceStatus(m_pCore->GetVkLogicalDevice(), batch.m_vkFence);
+
+		if (result == VK_NOT_READY) {
+			break;
+		}
+		if (result != VK_SUCCESS) {
+			throw std::runtime_error(UTIL_EXC_MSG_EX("Waiting for an upload batch failed", result));
+		}
+
+		m_pendingBatches.pop_front();
+		wait = false;
+	}
+}
+
+void VulkanApp::CVulkanUploader::Release() {
+	const VkDevice device = m_pCore->GetVkLogicalDevice();
+
+	for (auto &semaphore : m_semaphores) {
+		if (semaphore != VK_NULL_HANDLE) {
+			vkDestroySemaphore(device, semaphore, nullptr);
+			semaphore = VK_NULL_HANDLE;
+		}
+	}
+
+	for (auto &batch : m_batches) {
+		if (batch.m_vkFence != VK_NULL_HANDLE) {
+			vkDestroyFence(device, batch.m_vkFence, nullptr);
+			batch.m_vkFence = VK_NULL_HANDLE;
+		}
+
+		if (batch.m_vkCommandPool != VK_NULL_HANDLE) {
+			vkDestroyCommandPool(device, batch.m_vkCommandPool, nullptr);
+			batch.m_vkCommandPool = VK_NULL_HANDLE;
+			batch.m_vkCommandBuffer = VK_NULL_HANDLE;
+		}
+	}
+
+	if (m_vkStagingBuffer != VK_NULL_HANDLE) {
+		vkDestroyBuffer(device, m_vkStagingBuffer, nullptr);
+		m_vkStagingBuffer = VK_NULL_HANDLE;
+	}
+
+	m_pCore->GetAllocator()->Free(m_stagingAllocation);
+}
@@ -0,0 +1,216 @@
+#ifdef _WIN32
+
+#include <CWin32Window.h>
+
+#define VK_USE_PLATFORM_WIN32_KHR
+#include <vulkan/vulkan.h>
+
+#include <stdexcept>
+
+namespace {
+	WindowEvent MouseEvent(const WindowEventType type, const uint32_t button, const LPARAM lParam) {
+		WindowEvent event;
+		event.m_type = type;
+		event.m_code = button;
+		event.m_x = static_cast<int32_t>(static_cast<int16_t>(LOWORD(lParam)));
+		event.m_y = static_cast<int32_t>(static_cast<int16_t>(HIWORD(lParam)));
+		return event;
+	}
+}
+
+LRESULT CALLBACK CWin32Window::WindowProc(HWND hWnd, UINT Msg, WPARAM wParam, LPARAM lParam) {
+
+	// The window object travels with WM_NCCREATE and is kept in the user data from then on
+	if (Msg == WM_NCCREATE) {
+		const CREATESTRUCTW *pCreateStruct = reinterpret_cast<const CREATESTRUCTW*>(lParam);
+		SetWindowLongPtrW(hWnd, GWLP_USERDATA, reinterpret_cast<LONG_PTR>(pCreateStruct->lpCreateParams));
+	}
+
+	CWin32Window *pWindow = reinterpret_cast<CWin32Window*>(GetWindowLongPtrW(hWnd, GWLP_USERDATA));
+	if (pWindow == nullptr) {
+		return DefWindowProcW(hWnd, Msg, wParam, lParam);
+	}
+
+	WindowEvent event;
+	switch (Msg)
+	{
+	case WM_CREATE:
+		event.m_type = WindowEventType::Create;
+		pWindow->PushEvent(event);
+		break;
+
+	case WM_PAINT:
+		// Validated here, otherwise the region stays dirty and the queue never runs empty
+		ValidateRect(hWnd, NULL);
+		event.m_type = WindowEventType::Paint;
+		pWindow->PushEvent(event);
+		return 0;
+
+	case WM_DESTROY:
+		event.m_type = WindowEventType::Destroy;
+		pWindow->PushEvent(event);
+		break;
+
+	case WM_ENTERSIZEMOVE:
+		pWindow->m_inSizeMove = true;
+		event.m_type = WindowEventType::MoveEnter;
+		pWindow->PushEvent(event);
+		pWindow->DispatchPendingEvents();
+		break;
+
+	case WM_EXITSIZEMOVE:
+		pWindow->m_inSizeMove = false;
+		event.m_type = WindowEventType::MoveExit;
+		pWindow->PushEvent(event);
+		break;
+
+	case WM_CLOSE:
+		// The listeners decide, the window is not destroyed here
+		event.m_type = WindowEventType::Close;
+		pWindow->PushEvent(event);
+		return 0;
+
+	case WM_SIZE:
+		event.m_type = WindowEventType::Resize;
+		if (wParam != SIZE_MINIMIZED) {
+			event.m_width = LOWORD(lParam);
+			event.m_height = HIWORD(lParam);
+		}
+		pWindow->PushEvent(event);
+		// Dragging runs a modal loop inside DispatchMessage, the listeners would not hear of the size until it ends
+		if (pWindow->m_inSizeMove) {
+			pWindow->DispatchPendingEvents();
+		}
+		break;
+
+	case WM_KEYDOWN:
+	case WM_KEYUP:
+		event.m_type = Msg == WM_KEYDOWN ? WindowEventType::KeyDown : WindowEventType::KeyUp;
+		event.m_code = static_cast<uint32_t>(wParam);
+		pWindow->PushEvent(event);
+		break;
+
+	case WM_MOUSEMOVE:
+		pWindow->PushEvent(MouseEvent(WindowEventType::MouseMove, 0u, lParam));
+		break;
+
+	case WM_LBUTTONDOWN:
+	case WM_LBUTTONUP:
+		pWindow->PushEvent(MouseEvent(Msg == WM_LBUTTONDOWN ? WindowEventType::MouseButtonDown : WindowEventType::MouseButtonUp, 0u, lParam));
+		break;
+
+	case WM_RBUTTONDOWN:
+	case WM_RBUTTONUP:
+		pWindow->PushEvent(MouseEvent(Msg == WM_RBUTTONDOWN ? WindowEventType::MouseButtonDown : WindowEventType::MouseButtonUp, 1u, lParam));
+		break;
+
+	case WM_MBUTTONDOWN:
+	case WM_MBUTTONUP:
+		pWindow->PushEvent(MouseEvent(Msg == WM_MBUTTONDOWN ? WindowEventType::MouseButtonDown : WindowEventType::MouseButtonUp, 2u, lParam));
+		break;
+	}
+
+	return DefWindowProcW(hWnd, Msg, wParam, lParam);
+}
+
+HWND CWin32Window::CreateSystemWindow(const std::wstring name, const uint32_t windowWidth, const uint32_t windowHeight) {
+
+	HINSTANCE hInstance = GetModuleHandle(nullptr);
+	WNDCLASSEXW wndClassExW = { 0u };
+	const wchar_t windowClassName[] = L"DefaultWindowClass";
+
+	wndClassExW.lpszClassName = windowClassName;
+	wndClassExW.lpfnWndProc = WindowProc;
+	wndClassExW.hInstance = hInstance;
+	wndClassExW.hCursor = NULL;
+	wndClassExW.hIcon = NULL;
+	wndClassExW.hbrBackground = (HBRUSH)(COLOR_BTNTEXT);
+	wndClassExW.lpszMenuName = NULL;
+	wndClassExW.hIconSm = NULL;
+	wndClassExW.style = NULL;
+	wndClassExW.cbClsExtra = NULL;
+	wndClassExW.cbWndExtra = NULL;
+	wndClassExW.cbSize = sizeof(wndClassExW);
+
+	RegisterClassExW(&wndClassExW);
+
+	RECT clientArea = { 0 };
+	clientArea.top = 0u;
+	clientArea.left = 0u;
+	clientArea.bottom = windowHeight;
+	clientArea.right = windowWidth;
+
+	DWORD windowStyle = WS_SYSMENU | WS_MAXIMIZEBOX | WS_MINIMIZEBOX | WS_SIZEBOX;
+
+	AdjustWindowRectEx(&clientArea, windowStyle, TRUE, WS_EX_OVERLAPPEDWINDOW);
+
+	HWND systemWindowHandle = CreateWindowExW(
+		WS_EX_OVERLAPPEDWINDOW,
+		windowClassName,
+		name.c_str(),
+		windowStyle,
+		CW_USEDEFAULT,
+		CW_USEDEFAULT,
+		windowWidth,
+		windowHeight,
+		NULL,
+		NULL,
+		hInstance,
+		this);
+
+	return systemWindowHandle;
+}
+
+CWin32Window::CWin32Window(const std::wstring title, const uint32_t width, const uint32_t height)
+{
+	// Not in the initializer list, CreateWindowExW sends WM_CREATE and WM_SIZE to WindowProc before it returns
+	// and the members it reads have to be initialized by then
+	m_windowHandle = CreateSystemWindow(title, width, height);
+	if (m_windowHandle == NULL) {
+		throw std::runtime_error("[Runtime error] Cannot create the Win32 window");
+	}
+}
+
+CWin32Window::~CWin32Window() {
+	if (m_windowHandle) {
+		// Nothing may reach the object through the user data anymore
+		SetWindowLongPtrW(m_windowHandle, GWLP_USERDATA, 0);
+		DestroyWindow(m_windowHandle);
+	}
+}
+
+void CWin32Window::Show(bool isVisible) {
+	ShowWindow(m_windowHandle, isVisible ? SW_SHOW : SW_HIDE);
+}
+
+VkResult CWin32Window::CreateSurface(const VkInstance instance, VkSurfaceKHR *pSurface) const {
+	VkWin32SurfaceCreateInfoKHR surfaceInfo = {};
+	surfaceInfo.sType = VK_STRUCTURE_TYPE_WIN32_SURFACE_CREATE_INFO_KHR;
+	surfaceInfo.pNext = nullptr;
+	surfaceInfo.hinstance = GetModuleHandle(NULL);
+	surfaceInfo.hwnd = m_windowHandle;
+
+	return vkCreateWin32SurfaceKHR(instance, &surfaceInfo, nullptr, pSurface);
+}
+
+void CWin32Window::DrainSystemEvents() {
+	// Everything queued so far, not one message per frame
+	MSG msg = { 0 };
+	while (PeekMessageW(&msg, NULL, 0, 0, PM_REMOVE)) {
+		if (msg.message == WM_QUIT) {
+			WindowEvent event;
+			event.m_type = WindowEventType::Close;
+			PushEvent(event);
+			continue;
+		}
+		TranslateMessage(&msg);
+		DispatchMessageW(&msg);
+	}
+}
+
+void CWin32Window::WaitSystemEvents(const uint32_t timeoutMs) {
+	// Also wakes for messages which were already in the queue when it was last checked
+	MsgWaitForMultipleObjectsEx(0u, NULL, timeoutMs, QS_ALLINPUT, MWMO_INPUTAVAILABLE);
+}
+
+#endif // _WIN32
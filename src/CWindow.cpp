@@ -1,157 +1,160 @@
 #include <CWindow.h>
-
-LRESULT CWindow::WindowProc(HWND hWnd, UINT Msg, WPARAM wParam, LPARAM lParam) {
-
-	bool wasMsgProcessed = false;
-	for (auto &listener : m_eventListeners) {
-		wasMsgProcessed = true;
-		if (listener.first == hWnd && listener.second != nullptr) {
-			switch (Msg)
-			{
-			case WM_CREATE:
-				listener.second->OnCreate();
-				break;
-
-			case WM_PAINT:
-				listener.second->OnPaint();
-				break;
-
-			case WM_SIZING:
-				break;
-
-			case WM_DESTROY:
-				listener.second->OnDestroy();
-				break;
-
-			case WM_ENTERSIZEMOVE:
-				listener.second->OnMoveEnter();
-				break;
-
-			case WM_EXITSIZEMOVE:
-				listener.second->OnMoveExit();
-				break;
-
-			case WM_CLOSE:
-				listener.second->OnClose();
-				break;
-
-			case WM_SIZE:
-				switch (wParam)
-				{
-				case SIZE_MAXIMIZED:
-					listener.second->OnSizeChanged(LOWORD(lParam), HIWORD(lParam));
-					break;
-				case SIZE_MINIMIZED:
-					listener.second->OnSizeChanged(0u, 0u);
-					break;
-				case SIZE_RESTORED:
-					listener.second->OnSizeChanged(LOWORD(lParam), HIWORD(lParam));
-					break;
-				}
-
-				break;
-
-			default:
-				wasMsgProcessed = false;
-				break;
-			}
+#include <CNullWindow.h>
+
+#ifdef _WIN32
+#include <CWin32Window.h>
+#endif
+
+#if defined(__linux__) && VULKANAPP_XCB
+#include <CXcbWindow.h>
+#endif
+
+#include <algorithm>
+#include <stdexcept>
+
+void CWindow::IEventListener::OnEvents(const WindowEvent *pEvents, const uint32_t eventCount) {
+	for (uint32_t i = 0u; i < eventCount; i++) {
+		const WindowEvent &event = pEvents[i];
+		switch (event.m_type)
+		{
+		case WindowEventType::Create:
+			OnCreate();
+			break;
+
+		case WindowEventType::Close:
+			OnClose();
+			break;
+
+		case WindowEventType::Destroy:
+			OnDestroy();
+			break;
+
+		case WindowEventType::Resize:
+			OnSizeChanged(event.m_width, event.m_height);
+			break;
+
+		case WindowEventType::MoveEnter:
+			OnMoveEnter();
+			break;
+
+		case WindowEventType::MoveExit:
+			OnMoveExit();
+			break;
+
+		case WindowEventType::Paint:
+			OnPaint();
+			break;
+
+		case WindowEventType::KeyDown:
+		case WindowEventType::KeyUp:
+			OnKey(event.m_code, event.m_type == WindowEventType::KeyDown);
+			break;
+
+		case WindowEventType::MouseMove:
+			OnMouseMove(event.m_x, event.m_y);
+			break;
+
+		case WindowEventType::MouseButtonDown:
+		case WindowEventType::MouseButtonUp:
+			OnMouseButton(event.m_code, event.m_type == WindowEventType::MouseButtonDown, event.m_x, event.m_y);
+			break;
 		}
 	}
-	if (wasMsgProcessed) {
-		return 0;
-	}
-	return DefWindowProc(hWnd, Msg, wParam, lParam);
-}
-
-HWND CWindow::CreateSystemWindow(const std::wstring name, const uint32_t windowWidth, const uint32_t windowHeight) {
-
-	HINSTANCE hInstance = GetModuleHandle(nullptr);
-	WNDCLASSEXW wndClassExW = { 0u };
-	const wchar_t windowClassName[] = L"DefaultWindowClass";
-
-	wndClassExW.lpszClassName = windowClassName;
-	wndClassExW.lpfnWndProc = WindowProc;
-	wndClassExW.hInstance = hInstance;
-	wndClassExW.hCursor = NULL;
-	wndClassExW.hIcon = NULL;
-	wndClassExW.hbrBackground = (HBRUSH)(COLOR_BTNTEXT);
-	wndClassExW.lpszMenuName = NULL;
-	wndClassExW.hIconSm = NULL;
-	wndClassExW.style = NULL;
-	wndClassExW.cbClsExtra = NULL;
-	wndClassExW.cbWndExtra = NULL;
-	wndClassExW.cbSize = sizeof(wndClassExW);
-
-	RegisterClassExW(&wndClassExW);
-
-	RECT clientArea = { 0 };
-	clientArea.top = 0u;
-	clientArea.left = 0u;
-	clientArea.bottom = windowHeight;
-	clientArea.right = windowWidth;
-
-	DWORD windowStyle = WS_SYSMENU | WS_MAXIMIZEBOX | WS_MINIMIZEBOX | WS_SIZEBOX;
-
-	AdjustWindowRectEx(&clientArea, windowStyle, TRUE, WS_EX_OVERLAPPEDWINDOW);
-
-	HWND systemWindowHandle = CreateWindowExW(
-		WS_EX_OVERLAPPEDWINDOW,
-		windowClassName,
-		name.c_str(),
-		windowStyle,
-		CW_USEDEFAULT,
-		CW_USEDEFAULT,
-		windowWidth,
-		windowHeight,
-		NULL,
-		NULL,
-		hInstance,
-		NULL);
-
-	return systemWindowHandle;
 }
 
-CWindow::CWindow(const std::wstring title, const uint32_t width, const uint32_t height) 
-	: m_windowHandle(CreateSystemWindow(title, width, height))
-{
+CWindow* CWindow::Create([[maybe_unused]] const std::wstring title, const uint32_t width, const uint32_t height, const WindowBackend backend) {
+	switch (backend)
+	{
+	case WindowBackend::Native:
+#ifdef _WIN32
+		return new CWin32Window(title, width, height);
+#elif defined(__linux__) && VULKANAPP_XCB
+		return new CXcbWindow(title, width, height);
+#else
+		break;
+#endif
+
+	case WindowBackend::Win32:
+#ifdef _WIN32
+		return new CWin32Window(title, width, height);
+#else
+		break;
+#endif
+
+	case WindowBackend::Xcb:
+#if defined(__linux__) && VULKANAPP_XCB
+		return new CXcbWindow(title, width, height);
+#else
+		break;
+#endif
+
+	case WindowBackend::Null:
+		return new CNullWindow(width, height);
+	}
 
+	throw std::runtime_error("[Runtime error] Window backend is not available in this build");
 }
 
-std::vector<std::pair<HWND, CWindow::IEventListener*>> CWindow::m_eventListeners;
-
 bool CWindow::AddEventListener(IEventListener* pListener) {
-	if (m_windowHandle && pListener) {
-		m_eventListeners.push_back({ m_windowHandle, pListener });
-		return true;
+	if (pListener == nullptr || std::find(m_eventListeners.begin(), m_eventListeners.end(), pListener) != m_eventListeners.end()) {
+		return false;
 	}
-	return false;
+	m_eventListeners.push_back(pListener);
+	return true;
 };
 
 bool CWindow::RemoveEventListener(IEventListener* pListener) {
-	bool wasRemoved = false;
-	for (auto &listener : m_eventListeners) {
-		if (listener.second == pListener) {
-			listener.first = nullptr;
-			listener.second = nullptr;
-			wasRemoved = true;
-		}
+	auto itr = std::find(m_eventListeners.begin(), m_eventListeners.end(), pListener);
+	if (itr == m_eventListeners.end()) {
+		return false;
+	}
+	m_eventListeners.erase(itr);
+	return true;
+}
+
+void CWindow::PushEvent(const WindowEvent &event) {
+	// Only the latest size and pointer position matter, the others would be handled for nothing
+	if (!m_pendingEvents.empty() && m_pendingEvents.back().m_type == event.m_type &&
+		(event.m_type == WindowEventType::Resize || event.m_type == WindowEventType::MouseMove)) {
+		m_pendingEvents.back() = event;
+		return;
+	}
+	m_pendingEvents.push_back(event);
+}
+
+uint32_t CWindow::PollEvents() {
+	DrainSystemEvents();
+	return DispatchPendingEvents();
+}
+
+uint32_t CWindow::DispatchPendingEvents() {
+	if (m_pendingEvents.empty()) {
+		return 0u;
+	}
+
+	// Both vectors keep their capacity, a steady stream of events allocates nothing
+	m_dispatchedEvents.clear();
+	m_dispatchedEvents.swap(m_pendingEvents);
+
+	const uint32_t eventCount = static_cast<uint32_t>(m_dispatchedEvents.size());
+	for (auto *pListener : m_eventListeners) {
+		pListener->OnEvents(m_dispatchedEvents.data(), eventCount);
 	}
-	return wasRemoved;
+	return eventCount;
 }
 
-void CWindow::Show(bool isVisible) const {
-	ShowWindow(m_windowHandle, isVisible ? SW_SHOW : SW_HIDE);
+void CWindow::WaitForEvents(const uint32_t timeoutMs) {
+	if (HasPendingEvents()) {
+		return;
+	}
+	WaitSystemEvents(timeoutMs);
 }
 
 bool CWindow::RunMainLoop() {
 	if (!MainLoopProcedure)
 		return false;
 	do {
-		MSG msg = { 0 };
-		if (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE)) {
-			TranslateMessage(&msg);
-			DispatchMessage(&msg);
-		}
+		PollEvents();
 	} while (MainLoopProcedure());
 	return true;
 }
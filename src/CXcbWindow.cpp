@@ -0,0 +1,259 @@
+#if defined(__linux__) && VULKANAPP_XCB
+
+#include <CXcbWindow.h>
+
+#define VK_USE_PLATFORM_XCB_KHR
+#include <vulkan/vulkan.h>
+
+#include <poll.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace {
+	// Window titles are UTF-8 on X11
+	std::string ToUtf8(const std::wstring &text) {
+		std::string result;
+		for (const wchar_t wideChar : text) {
+			const uint32_t codePoint = static_cast<uint32_t>(wideChar);
+			if (codePoint < 0x80u) {
+				result += static_cast<char>(codePoint);
+			}
+			else if (codePoint < 0x800u) {
+				result += static_cast<char>(0xc0u | (codePoint >> 6));
+				result += static_cast<char>(0x80u | (codePoint & 0x3fu));
+			}
+			else if (codePoint < 0x10000u) {
+				result += static_cast<char>(0xe0u | (codePoint >> 12));
+				result += static_cast<char>(0x80u | ((codePoint >> 6) & 0x3fu));
+				result += static_cast<char>(0x80u | (codePoint & 0x3fu));
+			}
+			else {
+				result += static_cast<char>(0xf0u | (codePoint >> 18));
+				result += static_cast<char>(0x80u | ((codePoint >> 12) & 0x3fu));
+				result += static_cast<char>(0x80u | ((codePoint >> 6) & 0x3fu));
+				result += static_cast<char>(0x80u | (codePoint & 0x3fu));
+			}
+		}
+		return result;
+	}
+
+	WindowEvent MouseEvent(const WindowEventType type, const uint32_t button, const int16_t x, const int16_t y) {
+		WindowEvent event;
+		event.m_type = type;
+		event.m_code = button;
+		event.m_x = x;
+		event.m_y = y;
+		return event;
+	}
+}
+
+CXcbWindow::CXcbWindow(const std::wstring title, const uint32_t width, const uint32_t height)
+	: m_width(width), m_height(height) {
+
+	int screenIndex = 0;
+	m_pConnection = xcb_connect(nullptr, &screenIndex);
+	if (xcb_connection_has_error(m_pConnection)) {
+		Release();
+		throw std::runtime_error("[Runtime error] Cannot connect to the X server");
+	}
+
+	xcb_screen_iterator_t screenItr = xcb_setup_roots_iterator(xcb_get_setup(m_pConnection));
+	for (int i = 0; i < screenIndex; i++) {
+		xcb_screen_next(&screenItr);
+	}
+	const xcb_screen_t *pScreen = screenItr.data;
+
+	const uint32_t valueMask = XCB_CW_BACK_PIXEL | XCB_CW_EVENT_MASK;
+	const uint32_t values[] = {
+		pScreen->black_pixel,
+		XCB_EVENT_MASK_EXPOSURE | XCB_EVENT_MASK_STRUCTURE_NOTIFY | XCB_EVENT_MASK_KEY_PRESS | XCB_EVENT_MASK_KEY_RELEASE |
+			XCB_EVENT_MASK_BUTTON_PRESS | XCB_EVENT_MASK_BUTTON_RELEASE | XCB_EVENT_MASK_POINTER_MOTION
+	};
+
+	m_window = xcb_generate_id(m_pConnection);
+	xcb_create_window(m_pConnection, XCB_COPY_FROM_PARENT, m_window, pScreen->root, 0, 0,
+		static_cast<uint16_t>(width), static_cast<uint16_t>(height), 0, XCB_WINDOW_CLASS_INPUT_OUTPUT, pScreen->root_visual, valueMask, values);
+
+	// WM_NAME of type STRING is Latin-1, window managers read the UTF-8 title from _NET_WM_NAME. WM_NAME
+	// gets the same bytes typed as UTF8_STRING for the few that do not.
+	const std::string utf8Title = ToUtf8(title);
+	const xcb_atom_t utf8StringAtom = InternAtom("UTF8_STRING");
+	const xcb_atom_t netNameAtom = InternAtom("_NET_WM_NAME");
+	if (utf8StringAtom != XCB_ATOM_NONE && netNameAtom != XCB_ATOM_NONE) {
+		xcb_change_property(m_pConnection, XCB_PROP_MODE_REPLACE, m_window, netNameAtom, utf8StringAtom, 8,
+			static_cast<uint32_t>(utf8Title.size()), utf8Title.c_str());
+	}
+	xcb_change_property(m_pConnection, XCB_PROP_MODE_REPLACE, m_window, XCB_ATOM_WM_NAME,
+		utf8StringAtom != XCB_ATOM_NONE ? utf8StringAtom : static_cast<xcb_atom_t>(XCB_ATOM_STRING), 8, static_cast<uint32_t>(utf8Title.size()), utf8Title.c_str());
+
+	// Without WM_DELETE_WINDOW the window manager kills the connection on close
+	m_protocolsAtom = InternAtom("WM_PROTOCOLS");
+	m_deleteWindowAtom = InternAtom("WM_DELETE_WINDOW");
+	xcb_change_property(m_pConnection, XCB_PROP_MODE_REPLACE, m_window, m_protocolsAtom, XCB_ATOM_ATOM, 32, 1, &m_deleteWindowAtom);
+
+	xcb_flush(m_pConnection);
+
+	WindowEvent event;
+	event.m_type = WindowEventType::Create;
+	PushEvent(event);
+}
+
+CXcbWindow::~CXcbWindow() {
+	Release();
+}
+
+void CXcbWindow::Show(bool isVisible) {
+	if (isVisible) {
+		xcb_map_window(m_pConnection, m_window);
+	}
+	else {
+		xcb_unmap_window(m_pConnection, m_window);
+	}
+	xcb_flush(m_pConnection);
+}
+
+VkResult CXcbWindow::CreateSurface(const VkInstance instance, VkSurfaceKHR *pSurface) const {
+	VkXcbSurfaceCreateInfoKHR surfaceInfo = {};
+	surfaceInfo.sType = VK_STRUCTURE_TYPE_XCB_SURFACE_CREATE_INFO_KHR;
+	surfaceInfo.pNext = nullptr;
+	surfaceInfo.connection = m_pConnection;
+	surfaceInfo.window = m_window;
+
+	return vkCreateXcbSurfaceKHR(instance, &surfaceInfo, nullptr, pSurface);
+}
+
+xcb_atom_t CXcbWindow::InternAtom(const char *name) const {
+	xcb_intern_atom_cookie_t cookie = xcb_intern_atom(m_pConnection, 0, static_cast<uint16_t>(strlen(name)), name);
+	xcb_intern_atom_reply_t *pReply = xcb_intern_atom_reply(m_pConnection, cookie, nullptr);
+	if (pReply == nullptr) {
+		return XCB_ATOM_NONE;
+	}
+
+	const xcb_atom_t atom = pReply->atom;
+	free(pReply);
+	return atom;
+}
+
+void CXcbWindow::DrainSystemEvents() {
+	// xcb_poll_for_event never blocks, everything queued so far is taken
+	xcb_generic_event_t *pEvent = nullptr;
+	while ((pEvent = xcb_poll_for_event(m_pConnection)) != nullptr) {
+		WindowEvent event;
+		switch (pEvent->response_type & 0x7f)
+		{
+		case XCB_EXPOSE:
+			event.m_type = WindowEventType::Paint;
+			PushEvent(event);
+			break;
+
+		case XCB_CONFIGURE_NOTIFY: {
+			// Also sent for moves, only size changes are passed on
+			const xcb_configure_notify_event_t *pConfigure = reinterpret_cast<const xcb_configure_notify_event_t*>(pEvent);
+			if (pConfigure->width != m_width || pConfigure->height != m_height) {
+				m_width = pConfigure->width;
+				m_height = pConfigure->height;
+				event.m_type = WindowEventType::Resize;
+				event.m_width = m_width;
+				event.m_height = m_height;
+				PushEvent(event);
+			}
+			break;
+		}
+
+		case XCB_UNMAP_NOTIFY:
+			// Minimized or hidden, reported like a minimized Win32 window
+			event.m_type = WindowEventType::Resize;
+			PushEvent(event);
+			break;
+
+		case XCB_MAP_NOTIFY:
+			event.m_type = WindowEventType::Resize;
+			event.m_width = m_width;
+			event.m_height = m_height;
+			PushEvent(event);
+			break;
+
+		case XCB_CLIENT_MESSAGE: {
+			const xcb_client_message_event_t *pMessage = reinterpret_cast<const xcb_client_message_event_t*>(pEvent);
+			// Other client messages can carry the same value in their first word
+			if (pMessage->type == m_protocolsAtom && pMessage->data.data32[0] == m_deleteWindowAtom) {
+				event.m_type = WindowEventType::Close;
+				PushEvent(event);
+			}
+			break;
+		}
+
+		case XCB_DESTROY_NOTIFY:
+			event.m_type = WindowEventType::Destroy;
+			PushEvent(event);
+			break;
+
+		case XCB_KEY_PRESS:
+		case XCB_KEY_RELEASE: {
+			const xcb_key_press_event_t *pKey = reinterpret_cast<const xcb_key_press_event_t*>(pEvent);
+			event.m_type = (pEvent->response_type & 0x7f) == XCB_KEY_PRESS ? WindowEventType::KeyDown : WindowEventType::KeyUp;
+			event.m_code = pKey->detail;
+			PushEvent(event);
+			break;
+		}
+
+		case XCB_MOTION_NOTIFY: {
+			const xcb_motion_notify_event_t *pMotion = reinterpret_cast<const xcb_motion_notify_event_t*>(pEvent);
+			PushEvent(MouseEvent(WindowEventType::MouseMove, 0u, pMotion->event_x, pMotion->event_y));
+			break;
+		}
+
+		case XCB_BUTTON_PRESS:
+		case XCB_BUTTON_RELEASE: {
+			// X11 counts buttons from 1 with the middle one second, 4 and up are wheel steps
+			const xcb_button_press_event_t *pButton = reinterpret_cast<const xcb_button_press_event_t*>(pEvent);
+			static constexpr uint32_t cexp_buttons[] = { 0u, 2u, 1u };
+			if (pButton->detail >= 1u && pButton->detail <= 3u) {
+				const bool pressed = (pEvent->response_type & 0x7f) == XCB_BUTTON_PRESS;
+				PushEvent(MouseEvent(pressed ? WindowEventType::MouseButtonDown : WindowEventType::MouseButtonUp,
+					cexp_buttons[pButton->detail - 1u], pButton->event_x, pButton->event_y));
+			}
+			break;
+		}
+		}
+		free(pEvent);
+	}
+
+	// A lost connection cannot deliver a close request anymore
+	if (!m_connectionLost && xcb_connection_has_error(m_pConnection)) {
+		m_connectionLost = true;
+		WindowEvent event;
+		event.m_type = WindowEventType::Close;
+		PushEvent(event);
+	}
+}
+
+void CXcbWindow::WaitSystemEvents(const uint32_t timeoutMs) {
+	// Events xcb has already read from the socket would not wake poll(), they are taken first
+	DrainSystemEvents();
+	if (HasPendingEvents() || m_connectionLost) {
+		return;
+	}
+
+	pollfd socket = {};
+	socket.fd = xcb_get_file_descriptor(m_pConnection);
+	socket.events = POLLIN;
+	poll(&socket, 1u, static_cast<int>(timeoutMs));
+}
+
+void CXcbWindow::Release() {
+	if (m_pConnection) {
+		if (m_window && !xcb_connection_has_error(m_pConnection)) {
+			xcb_destroy_window(m_pConnection, m_window);
+			xcb_flush(m_pConnection);
+		}
+		xcb_disconnect(m_pConnection);
+		m_pConnection = nullptr;
+	}
+	m_window = 0u;
+}
+
+#endif // __linux__ && VULKANAPP_XCB
@@ -0,0 +1,147 @@
+#include <DeviceCaps.h>
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include <Utilities.h>
+
+namespace {
+	// Names in the property structs are fixed size arrays, terminated unless they fill the whole array
+	template <size_t N>
+	uint64_t HashName(const char (&name)[N]) {
+		return VulkanApp::Hash64(name, strnlen(name, N));
+	}
+
+	bool ContainsName(const std::vector<uint64_t> &sortedHashes, const std::string_view name) {
+		return std::binary_search(sortedHashes.cbegin(), sortedHashes.cend(), VulkanApp::Hash64(name.data(), name.size()));
+	}
+
+	std::vector<uint64_t> HashExtensionNames(const std::vector<VkExtensionProperties> &extensions) {
+		std::vector<uint64_t> hashes;
+		hashes.reserve(extensions.size());
+		for (const auto &extension : extensions) {
+			hashes.push_back(HashName(extension.extensionName));
+		}
+		std::sort(hashes.begin(), hashes.end());
+		return hashes;
+	}
+}
+
+void VulkanApp::DeviceCaps::QueryInstance() {
+	uint32_t layerCount = 0u;
+	vkEnumerateInstanceLayerProperties(&layerCount, nullptr);
+	std::vector<VkLayerProperties> layers(layerCount);
+	vkEnumerateInstanceLayerProperties(&layerCount, layers.data());
+	layers.resize(layerCount);
+
+	m_instanceLayers.clear();
+	for (const auto &layer : layers) {
+		m_instanceLayers.push_back(HashName(layer.layerName));
+	}
+	std::sort(m_instanceLayers.begin(), m_instanceLayers.end());
+
+	uint32_t extensionCount = 0u;
+	vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, nullptr);
+	std::vector<VkExtensionProperties> extensions(extensionCount);
+	vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, extensions.data());
+	extensions.resize(extensionCount);
+	m_instanceExtensions = HashExtensionNames(extensions);
+}
+
+void VulkanApp::DeviceCaps::QueryDevice(const VkPhysicalDevice physicalDevice) {
+	m_vkPhysicalDevice = physicalDevice;
+	vkGetPhysicalDeviceProperties(physicalDevice, &m_properties);
+	vkGetPhysicalDeviceFeatures(physicalDevice, &m_features);
+	vkGetPhysicalDeviceMemoryProperties(physicalDevice, &m_memoryProperties);
+
+	uint32_t familyCount = 0u;
+	vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, nullptr);
+	m_queueFamilies.resize(familyCount);
+	vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, m_queueFamilies.data());
+	m_queueFamilies.resize(familyCount);
+
+	uint32_t extensionCount = 0u;
+	vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
+	std::vector<VkExtensionProperties> extensions(extensionCount);
+	vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, extensions.data());
+	extensions.resize(extensionCount);
+	m_deviceExtensions = HashExtensionNames(extensions);
+}
+
+bool VulkanApp::DeviceCaps::HasInstanceLayer(const std::string_view name) const {
+	return ContainsName(m_instanceLayers, name);
+}
+
+bool VulkanApp::DeviceCaps::HasInstanceExtension(const std::string_view name) const {
+	return ContainsName(m_instanceExtensions, name);
+}
+
+bool VulkanApp::DeviceCaps::HasDeviceExtension(const std::string_view name) const {
+	return ContainsName(m_deviceExtensions, name);
+}
+
+uint32_t VulkanApp::DeviceCaps::FindQueueFamily(const VkQueueFlags queueFlags, const VkQueueFlags excludedFlags, const uint32_t firstFamily) const {
+	for (uint32_t i = firstFamily; i < GetQueueFamilyCount(); i++) {
+		if ((m_queueFamilies[i].queueFlags & queueFlags) == queueFlags && (m_queueFamilies[i].queueFlags & excludedFlags) == 0u) {
+			return i;
+		}
+	}
+	return UINT32_MAX;
+}
+
+void VulkanApp::SurfaceCaps::Query(const VkPhysicalDevice physicalDevice, const VkSurfaceKHR surface) {
+	m_vkSurface = surface;
+	const VkResult result = RefreshCapabilities(physicalDevice);
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error(UTIL_EXC_MSG_EX("Cannot query surface capabilities", result));
+	}
+
+	uint32_t modeCount = 0u;
+	vkGetPhysicalDeviceSurfacePresentModesKHR(physicalDevice, surface, &modeCount, nullptr);
+	std::vector<VkPresentModeKHR> modes(modeCount);
+	vkGetPhysicalDeviceSurfacePresentModesKHR(physicalDevice, surface, &modeCount, modes.data());
+	modes.resize(modeCount);
+
+	m_presentModes = 0u;
+	for (const VkPresentModeKHR mode : modes) {
+		// Shared present modes have extension values, they are never selected here
+		if (static_cast<uint32_t>(mode) < 32u) {
+			m_presentModes |= 1u << static_cast<uint32_t>(mode);
+		}
+	}
+
+	uint32_t formatCount = 0u;
+	vkGetPhysicalDeviceSurfaceFormatsKHR(physicalDevice, surface, &formatCount, nullptr);
+	m_formats.resize(formatCount);
+	vkGetPhysicalDeviceSurfaceFormatsKHR(physicalDevice, surface, &formatCount, m_formats.data());
+	m_formats.resize(formatCount);
+
+	m_srgbFormats.reset();
+	for (const auto &format : m_formats) {
+		if (format.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR && static_cast<uint32_t>(format.format) < cexp_formatBits) {
+			m_srgbFormats.set(static_cast<size_t>(format.format));
+		}
+	}
+}
+
+VkResult VulkanApp::SurfaceCaps::RefreshCapabilities(const VkPhysicalDevice physicalDevice) {
+	return vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physicalDevice, m_vkSurface, &m_capabilities);
+}
+
+bool VulkanApp::SurfaceCaps::HasFormat(const VkSurfaceFormatKHR surfaceFormat) const {
+	if (surfaceFormat.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR && static_cast<uint32_t>(surfaceFormat.format) < cexp_formatBits) {
+		return m_srgbFormats.test(static_cast<size_t>(surfaceFormat.format));
+	}
+
+	return std::any_of(m_formats.cbegin(), m_formats.cend(), [&surfaceFormat](const VkSurfaceFormatKHR &format) {
+		return format.format == surfaceFormat.format && format.colorSpace == surfaceFormat.colorSpace;
+	});
+}
+
+bool VulkanApp::SurfaceCaps::IsExtentSupported(const uint32_t width, const uint32_t height) const {
+	return width <= m_capabilities.maxImageExtent.width &&
+		height <= m_capabilities.maxImageExtent.height &&
+		width >= m_capabilities.minImageExtent.width &&
+		height >= m_capabilities.minImageExtent.height;
+}
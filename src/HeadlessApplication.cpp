@@ -0,0 +1,257 @@
+#include <HeadlessApplication.h>
+#include <CVulkanPass.h>
+#include <CVulkanPipeline.h>
+#include <CVulkanShaderCache.h>
+#include <EmbeddedShaders.h>
+#include <CVulkanFrameRing.h>
+#include <CVulkanUploader.h>
+#include <CVulkanGpuProfiler.h>
+#include <CVulkanDrawList.h>
+#include <SampleVertex.h>
+#include <CVulkanOffscreenTarget.h>
+#include <Utilities.h>
+#include <CTracer.h>
+
+#include <chrono>
+#include <cmath>
+#include <vector>
+#include <iostream>
+#include <fstream>
+#include <stdexcept>
+
+VulkanApp::HeadlessApplication::HeadlessApplication(const uint32_t width, const uint32_t height, const uint32_t framesInFlight, const bool readback,
+	const uint32_t instanceCount)
+	: m_tracePath(CTracer::EnableFromEnvironment()), m_core("VulkanApp", true) {
+
+	TRACE_SCOPE("HeadlessApplication::Create");
+
+	// The pass leaves the image ready to be copied instead of presented
+	m_pPass = new CVulkanPass(&m_core, cexp_targetFormat, readback ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+
+	// Initialize shaders, the SPIR-V is embedded at build time and the core owns the modules
+	CVulkanShaderCache *pShaderCache = m_core.GetShaderCache();
+	m_shaderStageCI[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	m_shaderStageCI[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+	m_shaderStageCI[0].module = pShaderCache->Create(EmbeddedShaders::cexp_vertexShader, sizeof(EmbeddedShaders::cexp_vertexShader));
+	m_shaderStageCI[0].pName = "main";
+
+	m_shaderStageCI[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	m_shaderStageCI[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+	m_shaderStageCI[1].module = pShaderCache->Create(EmbeddedShaders::cexp_fragmentShader, sizeof(EmbeddedShaders::cexp_fragmentShader));
+	m_shaderStageCI[1].pName = "main";
+
+	// The UNORM target stores the output as it is, encoding it keeps the readback equal to the window
+	m_fragmentConstants.Set(SampleFragmentConstants::cexp_encodeSrgb, !IsSrgbFormat(cexp_targetFormat));
+	m_shaderStageCI[1].pSpecializationInfo = m_fragmentConstants.GetInfo();
+
+	// Mesh vertices in binding 0, one offset and scale per instance in binding 1
+	m_pPipeline = new CVulkanPipeline(&m_core, m_pPass, m_shaderStageCI, SampleVertexLayout::cexp_inputState);
+
+	m_pFrameRing = new CVulkanFrameRing(&m_core, framesInFlight, 0u);
+
+	// One target image per frame slot, so a slot never waits for another one
+	m_pTarget = new CVulkanOffscreenTarget(&m_core, m_pPass->GetHandle(), cexp_targetFormat, width, height,
+		m_pFrameRing->GetFramesInFlight(), readback);
+	m_pFrameRing->SetImageCount(m_pTarget->GetImageCount());
+
+	m_pGpuProfiler = new CVulkanGpuProfiler(&m_core, m_pFrameRing->GetFramesInFlight());
+	m_pDrawList = new CVulkanDrawList(&m_core, m_pFrameRing->GetFramesInFlight());
+
+	// Create vertex buffer
+	const SampleVertex vertices[] = {
+		{ {  0.0f,-1.0f, 0.0f }, { 1.0f, 0.5f, 0.5f } },
+		{ {  1.0f, 1.0f, 0.0f }, { 0.1f, 1.0f, 0.4f } },
+		{ { -1.0f, 1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f } } };
+
+	m_pVertexBuffer = new CVulkanBuffer(&m_core, vertices, sizeof(vertices),
+		{ VkBufferUsageFlagBits::VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, BufferMemory::DeviceLocal });
+
+	const uint32_t indices[] = { 0, 1, 2 };
+	m_pIndexBuffer = new CVulkanIndexBuffer(&m_core, indices, 3u, 3u);
+
+	// Instances tile the target in a square grid, each one scaled down to its cell
+	m_instanceCount = std::max(instanceCount, 1u);
+	const uint32_t gridSide = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(m_instanceCount))));
+	const float cellSize = 2.0f / static_cast<float>(gridSide);
+
+	std::vector<SampleInstance> instances(m_instanceCount);
+	for (uint32_t i = 0; i < m_instanceCount; i++) {
+		instances[i].m_transform[0] = -1.0f + cellSize * (static_cast<float>(i % gridSide) + 0.5f);
+		instances[i].m_transform[1] = -1.0f + cellSize * (static_cast<float>(i / gridSide) + 0.5f);
+		instances[i].m_transform[2] = 1.0f / static_cast<float>(gridSide);
+		instances[i].m_transform[3] = 0.0f;
+	}
+
+	m_pInstanceBuffer = new CVulkanBuffer(&m_core, instances.data(), m_instanceCount * SampleVertexLayout::GetByteSize(1),
+		{ VkBufferUsageFlagBits::VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, BufferMemory::DeviceLocal });
+}
+
+VulkanApp::HeadlessApplication::~HeadlessApplication() {
+	if (!m_tracePath.empty()) {
+		CTracer::SetEnabled(false);
+		if (CTracer::WriteChromeTrace(m_tracePath, cexp_traceFrameCount)) {
+			std::cout << "[TRACE] last " << cexp_traceFrameCount << " frames written to " << m_tracePath << "\n";
+		}
+	}
+
+	// Cleanup created Vulkan resources
+	vkDeviceWaitIdle(m_core.GetVkLogicalDevice());
+
+	if (m_pGpuProfiler) {
+		delete m_pGpuProfiler;
+	}
+
+	if (m_pDrawList) {
+		delete m_pDrawList;
+	}
+
+	if (m_pFrameRing) {
+		delete m_pFrameRing;
+	}
+
+	if (m_pVertexBuffer) {
+		delete m_pVertexBuffer;
+	}
+
+	if (m_pIndexBuffer) {
+		delete m_pIndexBuffer;
+	}
+
+	if (m_pInstanceBuffer) {
+		delete m_pInstanceBuffer;
+	}
+
+	if (m_pTarget) {
+		delete m_pTarget;
+	}
+
+	if (m_pPipeline) {
+		delete m_pPipeline;
+	}
+
+	if (m_pPass) {
+		delete m_pPass;
+	}
+}
+
+bool VulkanApp::HeadlessApplication::RenderFrame() {
+	TRACE_NEXT_FRAME();
+	TRACE_SCOPE("RenderFrame");
+	try
+	{
+		const auto frameStart = std::chrono::steady_clock::now();
+
+		FrameContext &frame = m_pFrameRing->BeginFrame();
+
+		// Target images are bound to frame slots, there is nothing to acquire
+		const uint32_t slot = m_pFrameRing->GetCurrentSlot();
+		m_pFrameRing->SetImageIndex(slot);
+
+		DrawPacket triangle;
+		triangle.m_pipeline = m_pPipeline->GetHandle();
+		triangle.SetVertexBuffer(0u, m_pVertexBuffer->GetHandle());
+		triangle.SetVertexBuffer(1u, m_pInstanceBuffer->GetHandle());
+		triangle.m_indexBuffer = m_pIndexBuffer->GetHandle();
+		triangle.m_indexType = m_pIndexBuffer->GetIndexType();
+		triangle.m_count = m_pIndexBuffer->GetIndexCount();
+		triangle.m_instanceCount = m_instanceCount;
+
+		m_pDrawList->Clear();
+		m_pDrawList->Add(triangle);
+		m_pDrawList->Build(slot);
+
+		VkSemaphore uploadSem = m_core.GetUploader()->Flush(slot);
+
+		{
+			TRACE_SCOPE("Record");
+
+			VkCommandBufferBeginInfo beginInfoCI = {};
+			beginInfoCI.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+			beginInfoCI.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+			VkResult result = vkBeginCommandBuffer(frame.m_vkCommandBuffer, &beginInfoCI);
+			if (result != VK_SUCCESS) {
+				throw std::runtime_error(UTIL_EXC_MSG_EX("Failed to begin a command buffer", result));
+			}
+
+			m_pPass->RecordWorkload(
+				frame.m_vkCommandBuffer,
+				*m_pDrawList,
+				m_pTarget->GetFramebuffer(slot),
+				{ {0,0}, m_pTarget->GetExtent() },
+				m_pGpuProfiler,
+				slot);
+
+			m_pTarget->RecordReadback(frame.m_vkCommandBuffer, slot);
+
+			result = vkEndCommandBuffer(frame.m_vkCommandBuffer);
+			if (result != VK_SUCCESS) {
+				throw std::runtime_error(UTIL_EXC_MSG_EX("Failed to end a command buffer", result));
+			}
+		}
+
+		{
+			TRACE_SCOPE("Submit");
+			CVulkanPass::SubmitCommandBuffer(m_core.m_vkQueue, frame.m_vkCommandBuffer, VK_NULL_HANDLE, uploadSem, VK_NULL_HANDLE, frame.m_vkInFlightFence);
+		}
+
+		m_lastImageIndex = slot;
+		m_pFrameRing->EndFrame();
+
+		m_frameTimes.Add(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frameStart).count());
+		return true;
+	}
+	catch (const std::exception &e)
+	{
+		std::cout << e.what();
+		return false;
+	}
+}
+
+VulkanApp::HeadlessStatistics VulkanApp::HeadlessApplication::RunBatch(const uint32_t frameCount) {
+	HeadlessStatistics statistics;
+
+	const auto batchStart = std::chrono::steady_clock::now();
+	for (uint32_t i = 0u; i < frameCount; i++) {
+		if (!RenderFrame()) {
+			break;
+		}
+		statistics.m_frameCount++;
+	}
+
+	// Throughput includes the GPU work of the frames still in flight
+	m_pFrameRing->WaitIdle();
+
+	statistics.m_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - batchStart).count();
+	statistics.m_framesPerSecond = statistics.m_seconds > 0.0 ? statistics.m_frameCount / statistics.m_seconds : 0.0;
+	return statistics;
+}
+
+bool VulkanApp::HeadlessApplication::WriteLastFrame(const std::string &filePath) {
+	if (!m_pTarget->HasReadback() || m_lastImageIndex == UINT32_MAX) {
+		return false;
+	}
+
+	m_pFrameRing->WaitIdle();
+
+	const uint8_t *pixels = static_cast<const uint8_t*>(m_pTarget->GetReadbackData(m_lastImageIndex));
+	if (pixels == nullptr) {
+		return false;
+	}
+
+	std::ofstream file(filePath, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!file.is_open()) {
+		return false;
+	}
+
+	const VkExtent2D extent = m_pTarget->GetExtent();
+	file << "P6\n" << extent.width << " " << extent.height << "\n255\n";
+
+	// RGBA to RGB
+	const size_t pixelCount = static_cast<size_t>(extent.width) * extent.height;
+	for (size_t i = 0u; i < pixelCount; i++) {
+		file.write(reinterpret_cast<const char*>(pixels + i * 4u), 3);
+	}
+
+	return file.good();
+}
@@ -2,12 +2,9 @@
 
 std::string VulkanApp::CreateExceptionMessage(const std::string msg, VkResult code, const std::string file, uint32_t line) {
 
-	auto ritr = file.rbegin();
-	while (*(++ritr) != '\\');
-
-	std::string fileTruncated;
-	if (ritr.base() != file.begin())
-		std::copy(ritr.base(), file.cend(), std::back_inserter(fileTruncated));
+	// __FILE__ uses either separator depending on the compiler
+	const size_t separator = file.find_last_of("\\/");
+	const std::string fileTruncated = (separator != std::string::npos) ? file.substr(separator + 1u) : file;
 
 	std::stringstream stream;
 	stream << "[EXCEPTION MESSAGE] " << msg << "\n";
@@ -20,6 +17,30 @@ std::string VulkanApp::CreateExceptionMessage(const std::string msg, VkResult co
 	return stream.str();
 }
 
+uint64_t VulkanApp::Hash64(const void* data, const size_t byteSize, const uint64_t seed) {
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+	uint64_t hash = seed;
+	for (size_t i = 0; i < byteSize; i++) {
+		hash ^= bytes[i];
+		hash *= 0x100000001b3ull;
+	}
+	return hash;
+}
+
+bool VulkanApp::IsSrgbFormat(const VkFormat format) {
+	switch (format) {
+	case VK_FORMAT_R8_SRGB:
+	case VK_FORMAT_R8G8_SRGB:
+	case VK_FORMAT_R8G8B8_SRGB:
+	case VK_FORMAT_B8G8R8_SRGB:
+	case VK_FORMAT_R8G8B8A8_SRGB:
+	case VK_FORMAT_B8G8R8A8_SRGB:
+	case VK_FORMAT_A8B8G8R8_SRGB_PACK32:
+		return true;
+	default:
+		return false;
+	}
+}
 
 std::vector<std::string> VulkanApp::CapsInfo::GetSupportedExtenstions() {
 
@@ -58,11 +79,14 @@ std::vector<std::string> VulkanApp::CapsInfo::GetAvailableDevices(const VkInstan
 
 	std::vector<std::string> deviceList;
 
-	if (devicesCount == 0)
+	if (result != VK_SUCCESS || devicesCount == 0)
 		return deviceList;
 
 	std::vector<VkPhysicalDevice> physicalDevices(devicesCount);
 	result = vkEnumeratePhysicalDevices(instance, &devicesCount, physicalDevices.data());
+	if (result != VK_SUCCESS && result != VK_INCOMPLETE)
+		return deviceList;
+	physicalDevices.resize(devicesCount);
 
 	for (auto& device : physicalDevices) {
 		VkPhysicalDeviceProperties properties;
@@ -192,11 +216,14 @@ std::vector<std::string> VulkanApp::CapsInfo::GetSupportedExtensions(const VkPhy
 
 	std::vector<std::string> extensionList;
 
-	if (!extensionCount)
+	if (result != VK_SUCCESS || !extensionCount)
 		return extensionList;
 
 	std::vector<VkExtensionProperties> extensionProperties(extensionCount);
 	result = vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, extensionProperties.data());
+	if (result != VK_SUCCESS && result != VK_INCOMPLETE)
+		return extensionList;
+	extensionProperties.resize(extensionCount);
 
 	for (auto& itr : extensionProperties)
 		extensionList.push_back(itr.extensionName);
@@ -1,21 +1,108 @@
 #include <iostream>
+#include <string>
+#include <cstdlib>
+#include <cstring>
+#include <HeadlessApplication.h>
+#include <CVulkanGpuProfiler.h>
 #include <Application.h>
+#include <CWindow.h>
 
-int main() {
+// Usage: VulkanApp [--headless <frames> [--size <width> <height>] [--instances <count>] [--readback <file.ppm>]]
+static int RunHeadless(int argc, char *argv[]) {
+	uint32_t frameCount = 1000u;
+	uint32_t width = 700u;
+	uint32_t height = 500u;
+	uint32_t instanceCount = 1u;
+	std::string readbackPath;
 
-	CWindow mainWindow(L"VulkanApp", 700, 500);
+	for (int i = 1; i < argc; i++) {
+		if (std::strcmp(argv[i], "--headless") == 0 && i + 1 < argc && argv[i + 1][0] != '-') {
+			frameCount = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+		}
+		else if (std::strcmp(argv[i], "--size") == 0 && i + 2 < argc) {
+			width = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+			height = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+		}
+		else if (std::strcmp(argv[i], "--instances") == 0 && i + 1 < argc) {
+			instanceCount = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+		}
+		else if (std::strcmp(argv[i], "--readback") == 0 && i + 1 < argc) {
+			readbackPath = argv[++i];
+		}
+	}
+
+	try
+	{
+		VulkanApp::HeadlessApplication headlessApp(width, height, 2u, !readbackPath.empty(), instanceCount);
+		const VulkanApp::HeadlessStatistics statistics = headlessApp.RunBatch(frameCount);
+
+		const VulkanApp::CRollingStats &frameTimes = headlessApp.GetFrameTimes();
+		std::cout << "[HEADLESS] " << statistics.m_frameCount << " frames in " << statistics.m_seconds << " s, "
+			<< statistics.m_framesPerSecond << " fps\n";
+		std::cout << "[HEADLESS] CPU frame time avg " << frameTimes.GetAverage() << " ms, p99 "
+			<< frameTimes.GetPercentile(99.0) << " ms\n";
+
+		for (const auto &scope : headlessApp.GetGpuProfiler()->GetStatistics()) {
+			std::cout << "[GPU PROFILER] " << scope.first << " min " << scope.second.GetMin() << " ms, avg "
+				<< scope.second.GetAverage() << " ms, p99 " << scope.second.GetPercentile(99.0) << " ms\n";
+		}
+
+		if (!readbackPath.empty() && !headlessApp.WriteLastFrame(readbackPath)) {
+			std::cout << "[HEADLESS] Cannot write " << readbackPath << "\n";
+			return 1;
+		}
+	}
+	catch (const std::exception &e)
+	{
+		std::cout << e.what();
+		return 1;
+	}
+
+	return 0;
+}
+
+int main(int argc, char *argv[]) {
+
+	for (int i = 1; i < argc; i++) {
+		if (std::strcmp(argv[i], "--headless") == 0) {
+			return RunHeadless(argc, argv);
+		}
+	}
+
+	CWindow *pMainWindow = nullptr;
 	try
 	{
-		VulkanApp::Application vulkanApp(mainWindow.GetHandle());
-		mainWindow.AddEventListener(&vulkanApp);
-		mainWindow.MainLoopProcedure = std::bind(&VulkanApp::Application::RenderFrame, &vulkanApp);
-		mainWindow.Show(true);
-		mainWindow.RunMainLoop();
+		pMainWindow = CWindow::Create(L"VulkanApp", 700, 500);
+	}
+	catch (const std::exception &e)
+	{
+		std::cout << e.what() << "\n";
+		std::cout << "Only --headless rendering is available on this platform\n";
+		return 1;
+	}
+
+	try
+	{
+		VulkanApp::Application vulkanApp(*pMainWindow);
+		pMainWindow->AddEventListener(&vulkanApp);
+
+		// This thread only waits for window events and forwards them, frames are rendered by the application.
+		// The timeout notices a render thread which stopped on its own.
+		pMainWindow->MainLoopProcedure = [pMainWindow, &vulkanApp]() {
+			pMainWindow->WaitForEvents(50u);
+			return vulkanApp.IsRunning();
+		};
+		pMainWindow->Show(true);
+		vulkanApp.Start();
+		pMainWindow->RunMainLoop();
+		vulkanApp.Stop();
+		pMainWindow->RemoveEventListener(&vulkanApp);
 	}
 	catch (const std::exception &e)
 	{
 		std::cout << e.what();
 	}
 
+	delete pMainWindow;
 	return 0;
 }
\ No newline at end of file